@@ -0,0 +1,188 @@
+// Fuzz target for the radio-facing decoder stages: WmBusHandler -> PriosHandler -> IzarHandler.
+// Built as a libFuzzer target with clang (izar-fuzz) or linked against the standalone driver in fuzz_main.cpp.
+
+#include <Arduino.h>
+#include <memory>
+#include "izar_encoder.h"
+
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t maxSize);
+
+namespace {
+// Largest decoded frame whose 3-out-of-6 encoding still fits the raw buffer
+const uint8_t kMaxDecodedLength = WM_BUS_MAX_PAYLOAD * 2 / 3;
+const uint8_t kTplOffset = WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE;
+
+bool callbackChainDecoded = false;
+IzarReading callbackChainReading;
+
+void izarDataCallback(const IzarReading* reading) {
+    callbackChainDecoded = true;
+    callbackChainReading = *reading;
+}
+
+void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                         uint8_t* tplData, uint8_t tplDataLen, int16_t rssi) {
+    priosHandler.processPayload(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
+}
+
+// Exact-size heap copy, so that AddressSanitizer flags reads past the announced length
+std::unique_ptr<uint8_t[]> copyExact(const uint8_t* data, size_t size) {
+    std::unique_ptr<uint8_t[]> copy(new uint8_t[size ? size : 1]);
+    if (size > 0) {
+        memcpy(copy.get(), data, size);
+    }
+    return copy;
+}
+
+// Stateless chain as used by BatchDecoder, each stage on an exact-size buffer
+bool decodeStateless(const uint8_t* raw, uint8_t rawLength, IzarReading* reading) {
+    WmBusFrame frame;
+    if (WmBusHandler::decodeFrame(raw, rawLength, &frame) != WmBusDecodeStatus::OK) {
+        return false;
+    }
+    if (frame.length != frame.header.lField + 1 + 2 * WM_BUS_HEADER_CRC_SIZE ||
+        frame.tplDataLen + kTplOffset + WM_BUS_HEADER_CRC_SIZE != frame.length) {
+        abort(); // Decoded lengths must agree with the L-field
+    }
+
+    std::unique_ptr<uint8_t[]> full = copyExact(frame.data, frame.length);
+    uint8_t* tplData = full.get() + kTplOffset;
+    return PriosHandler::decryptPayload(full.get(), frame.length, tplData, frame.tplDataLen) &&
+           IzarHandler::parseReading(frame.header.meterId, tplData, frame.tplDataLen, 0, reading);
+}
+
+// PRIOS and IZAR stages on their own: the first byte selects how much of the rest is the frame header,
+// the remainder is the TPL payload in a separate buffer
+void decryptAndParse(const uint8_t* data, size_t size) {
+    if (size < 2) {
+        return;
+    }
+    size_t frameLength = data[0] % size;
+    std::unique_ptr<uint8_t[]> frame = copyExact(data + 1, frameLength);
+    size_t payloadLength = size - 1 - frameLength;
+    if (payloadLength > UINT8_MAX) {
+        return;
+    }
+    std::unique_ptr<uint8_t[]> payload = copyExact(data + 1 + frameLength, payloadLength);
+
+    IzarReading reading;
+    if (PriosHandler::decryptPayload(frame.get(), frameLength, payload.get(), payloadLength)) {
+        IzarHandler::parseReading("fuzz", payload.get(), payloadLength, 0, &reading);
+    }
+}
+
+bool sameReading(const IzarReading& a, const IzarReading& b) {
+    return strcmp(a.meterId, b.meterId) == 0 && a.current_reading == b.current_reading &&
+           a.h0_reading == b.h0_reading && a.h0_year == b.h0_year && a.h0_month == b.h0_month &&
+           a.h0_day == b.h0_day && memcmp(&a.alarms, &b.alarms, sizeof(a.alarms)) == 0;
+}
+
+// Decode the L-field and as many raw bytes as it announces; false if the input is not a 3-out-of-6 frame
+bool liftFrame(const uint8_t* raw, size_t rawLength, uint8_t* decoded, uint8_t* decodedLength) {
+    uint8_t lField;
+    uint8_t lFieldLength;
+    if (rawLength < 2 || !WmBusHandler::decode3outof6(raw, 2, &lField, &lFieldLength)) {
+        return false;
+    }
+    uint16_t expected = lField + 1 + 2 * WM_BUS_HEADER_CRC_SIZE;
+    uint16_t required = (expected * 3 + 1) / 2;
+    if (expected < kTplOffset + WM_BUS_HEADER_CRC_SIZE || expected > kMaxDecodedLength || required > rawLength ||
+        !WmBusHandler::decode3outof6(raw, required, decoded, decodedLength)) {
+        return false;
+    }
+    *decodedLength = expected;
+    return true;
+}
+
+// Keystream over the encrypted part of the TPL data, if the frame is long enough to have one
+void applyKeystream(uint8_t* decoded, uint8_t decodedLength) {
+    uint8_t tplDataLength = decodedLength - kTplOffset - WM_BUS_HEADER_CRC_SIZE;
+    if (decodedLength >= PRIOS_MIN_FRAME_LENGTH && tplDataLength > PRIOS_OFFSET_ENCRYPTED_DATA) {
+        const uint8_t key[PRIOS_KEY_SIZE] = PRIOS_DEFAULT_KEY;
+        PriosHandler::applyKeystream(key, decoded + kTplOffset + PRIOS_OFFSET_ENCRYPTED_DATA,
+                                     tplDataLength - PRIOS_OFFSET_ENCRYPTED_DATA, decoded);
+    }
+}
+
+void writeCrc(uint8_t* data, uint8_t length) {
+    uint16_t crc = WmBusHandler::calculateCRC16(data, length);
+    data[length] = crc >> 8;
+    data[length + 1] = crc & 0xFF;
+}
+} // namespace
+
+extern "C" int LLVMFuzzerInitialize(int*, char***) {
+    Serial.end();
+    wmBusHandler.setPacketCallback(wmBusPacketCallback);
+    izarHandler.setDataCallback(izarDataCallback);
+    return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    if (size > UINT8_MAX) {
+        return -1;
+    }
+    uint8_t rawLength = static_cast<uint8_t>(size);
+    std::unique_ptr<uint8_t[]> raw = copyExact(data, size);
+
+    // Firmware callback chain
+    callbackChainDecoded = false;
+    wmBusHandler.processRawPacket(raw.get(), rawLength, -80);
+
+    // Both chains must agree on every frame
+    IzarReading reading;
+    bool decoded = decodeStateless(raw.get(), rawLength, &reading);
+    if (decoded != callbackChainDecoded || (decoded && !sameReading(reading, callbackChainReading))) {
+        abort();
+    }
+
+    decryptAndParse(data, size);
+    return 0;
+}
+
+// Structure-aware mutation: lift the raw frame to its decoded, decrypted form, mutate that, then re-encrypt and
+// repair the L-field, marker byte and CRCs so most mutants reach PRIOS and IZAR. Each repair is skipped now and
+// then so the rejection paths stay covered. Inputs that are not frames get plain byte-level mutations.
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t maxSize, unsigned int seed) {
+    uint32_t state = seed ? seed : 1;
+    uint8_t decoded[WM_BUS_MAX_PAYLOAD];
+    uint8_t decodedLength;
+    if (maxSize < WM_BUS_MAX_PAYLOAD || IzarEncoder::nextRandom(state) % 16 == 0 ||
+        !liftFrame(data, size, decoded, &decodedLength)) {
+        return LLVMFuzzerMutate(data, size, maxSize);
+    }
+
+    applyKeystream(decoded, decodedLength);
+    uint32_t repairs = IzarEncoder::nextRandom(state);
+    // Mutate the header or the plain TPL data, keeping the frame within the raw buffer
+    if (repairs & 0x10000) {
+        size_t tplLength = LLVMFuzzerMutate(decoded + kTplOffset, decodedLength - kTplOffset,
+                                            kMaxDecodedLength - kTplOffset);
+        decodedLength = static_cast<uint8_t>(kTplOffset + tplLength);
+    } else {
+        LLVMFuzzerMutate(decoded, WM_BUS_HEADER_SIZE, WM_BUS_HEADER_SIZE);
+    }
+    if (decodedLength < kTplOffset + WM_BUS_HEADER_CRC_SIZE) {
+        decodedLength = kTplOffset + WM_BUS_HEADER_CRC_SIZE;
+    }
+
+    uint8_t tplDataLength = decodedLength - kTplOffset - WM_BUS_HEADER_CRC_SIZE;
+    if (repairs & 0x0F) {
+        decoded[WM_BUS_OFFSET_L_FIELD] = decodedLength - 1 - 2 * WM_BUS_HEADER_CRC_SIZE;
+    }
+    if ((repairs & 0xF0) && tplDataLength > IZAR_OFFSET_MAGIC_BYTE) {
+        decoded[kTplOffset + IZAR_OFFSET_MAGIC_BYTE] = 0x4B;
+    }
+    applyKeystream(decoded, decodedLength);
+    if (repairs & 0x0F00) {
+        writeCrc(decoded, WM_BUS_HEADER_SIZE);
+    }
+    if (repairs & 0xF000) {
+        writeCrc(decoded + kTplOffset, tplDataLength);
+    }
+
+    // Zero padding to the fixed receive length, like the SX1262 delivers it
+    uint8_t rawLength = IzarEncoder::encode3outof6(decoded, decodedLength, data);
+    memset(data + rawLength, 0, WM_BUS_MAX_PAYLOAD - rawLength);
+    return WM_BUS_MAX_PAYLOAD;
+}
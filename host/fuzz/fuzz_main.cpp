@@ -0,0 +1,252 @@
+// Standalone driver for the decoder fuzz target, for compilers without libFuzzer (GCC) and for replaying the
+// regression corpus. Replays every file given (directories are read one level deep), then optionally
+// runs random mutations of that corpus through the target's structure-aware mutator. No coverage feedback;
+// build with clang and -DIZAR_HOST_FUZZ=ON for the coverage-guided izar-fuzz binary.
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <vector>
+#if defined(__SANITIZE_ADDRESS__)
+#define IZAR_FUZZ_SANITIZER_CALLBACK 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define IZAR_FUZZ_SANITIZER_CALLBACK 1
+#endif
+#endif
+#ifdef IZAR_FUZZ_SANITIZER_CALLBACK
+#include <sanitizer/common_interface_defs.h>
+#endif
+
+extern "C" int LLVMFuzzerInitialize(int* argc, char*** argv);
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+extern "C" size_t LLVMFuzzerCustomMutator(uint8_t* data, size_t size, size_t maxSize, unsigned int seed);
+
+namespace {
+typedef std::vector<uint8_t> Input;
+
+uint32_t randomState = 1;
+
+uint32_t nextRandom() {
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState;
+}
+
+// Input under test, written out by the crash handlers
+uint8_t currentInput[UINT8_MAX];
+size_t currentSize = 0;
+char crashPath[512] = "crash-input";
+
+void saveCurrentInput() {
+    int fd = open(crashPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+        ssize_t written = write(fd, currentInput, currentSize);
+        (void)written;
+        close(fd);
+    }
+    const char message[] = "\n== Input that triggered the failure written to ";
+    ssize_t written = write(STDERR_FILENO, message, sizeof(message) - 1);
+    written = write(STDERR_FILENO, crashPath, strlen(crashPath));
+    written = write(STDERR_FILENO, "\n", 1);
+    (void)written;
+}
+
+void crashSignalHandler(int signal) {
+    saveCurrentInput();
+    ::signal(signal, SIG_DFL);
+    raise(signal);
+}
+
+void installCrashHandlers() {
+    for (int signal : {SIGABRT, SIGSEGV, SIGBUS, SIGFPE, SIGILL}) {
+        ::signal(signal, crashSignalHandler);
+    }
+#ifdef IZAR_FUZZ_SANITIZER_CALLBACK
+    __sanitizer_set_death_callback(saveCurrentInput);
+#endif
+}
+
+void run(const uint8_t* data, size_t size) {
+    currentSize = std::min(size, sizeof(currentInput));
+    if (currentSize > 0) {
+        memcpy(currentInput, data, currentSize);
+    }
+    LLVMFuzzerTestOneInput(data, size);
+}
+
+bool readFile(const std::string& path, Input& input) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot read %s\n", path.c_str());
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t n;
+    input.clear();
+    while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        input.insert(input.end(), buffer, buffer + n);
+    }
+    fclose(file);
+    return true;
+}
+
+bool collectInputs(const std::string& path, std::vector<std::string>& files) {
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    if (!S_ISDIR(info.st_mode)) {
+        files.push_back(path);
+        return true;
+    }
+    DIR* dir = opendir(path.c_str());
+    if (!dir) {
+        fprintf(stderr, "Cannot open %s\n", path.c_str());
+        return false;
+    }
+    std::vector<std::string> entries;
+    while (dirent* entry = readdir(dir)) {
+        std::string child = path + "/" + entry->d_name;
+        if (entry->d_name[0] != '.' && stat(child.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+            entries.push_back(child);
+        }
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end());
+    files.insert(files.end(), entries.begin(), entries.end());
+    return true;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options] FILE|DIR...\n"
+            "  -r, --runs N            After the replay, run N mutated inputs (default 0: replay only)\n"
+            "  -s, --seed N            Mutation seed (default 1)\n"
+            "  -o, --crash FILE        Where to write an input that crashes (default crash-input)\n",
+            program);
+}
+} // namespace
+
+// Byte-level mutations used by the custom mutator for inputs it cannot lift into a frame
+// (libFuzzer provides its own implementation)
+extern "C" size_t LLVMFuzzerMutate(uint8_t* data, size_t size, size_t maxSize) {
+    static const uint8_t kInteresting[] = {0x00, 0x01, 0x0D, 0x16, 0x29, 0x3F, 0x4B, 0x7F, 0x80, 0xFF};
+    size_t depth = 1 + nextRandom() % 4;
+    for (size_t i = 0; i < depth; i++) {
+        uint32_t choice = nextRandom();
+        size_t pos = size ? nextRandom() % size : 0;
+        switch (choice % 5) {
+        case 0: // Flip a bit
+            if (size) {
+                data[pos] ^= 1 << (choice >> 8) % 8;
+            }
+            break;
+        case 1: // Random byte
+            if (size) {
+                data[pos] = static_cast<uint8_t>(choice >> 8);
+            }
+            break;
+        case 2: // Interesting value
+            if (size) {
+                data[pos] = kInteresting[(choice >> 8) % sizeof(kInteresting)];
+            }
+            break;
+        case 3: // Insert a byte
+            if (size < maxSize) {
+                memmove(data + pos + 1, data + pos, size - pos);
+                data[pos] = static_cast<uint8_t>(choice >> 8);
+                size++;
+            }
+            break;
+        default: // Erase a byte
+            if (size > 1) {
+                memmove(data + pos, data + pos + 1, size - pos - 1);
+                size--;
+            }
+            break;
+        }
+    }
+    return size;
+}
+
+int main(int argc, char** argv) {
+    static const option longOptions[] = {{"runs", required_argument, nullptr, 'r'},
+                                         {"seed", required_argument, nullptr, 's'},
+                                         {"crash", required_argument, nullptr, 'o'},
+                                         {"help", no_argument, nullptr, 'h'},
+                                         {nullptr, 0, nullptr, 0}};
+
+    size_t runs = 0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "r:s:o:h", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 'r':
+            runs = strtoul(optarg, nullptr, 10);
+            break;
+        case 's':
+            randomState = static_cast<uint32_t>(strtoul(optarg, nullptr, 10));
+            randomState = randomState ? randomState : 1;
+            break;
+        case 'o':
+            strlcpy(crashPath, optarg, sizeof(crashPath));
+            break;
+        default:
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (optind >= argc) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<std::string> files;
+    for (int i = optind; i < argc; i++) {
+        if (!collectInputs(argv[i], files)) {
+            return 1;
+        }
+    }
+
+    LLVMFuzzerInitialize(&argc, &argv);
+    installCrashHandlers();
+
+    std::vector<Input> corpus;
+    for (const std::string& file : files) {
+        Input input;
+        if (!readFile(file, input)) {
+            return 1;
+        }
+        run(input.data(), input.size());
+        corpus.push_back(input);
+    }
+    printf("Replayed %zu inputs\n", corpus.size());
+    if (runs == 0) {
+        return 0;
+    }
+    if (corpus.empty()) {
+        corpus.push_back(Input());
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint8_t buffer[UINT8_MAX];
+    for (size_t i = 0; i < runs; i++) {
+        const Input& base = corpus[nextRandom() % corpus.size()];
+        size_t size = std::min(base.size(), sizeof(buffer));
+        std::copy(base.begin(), base.begin() + size, buffer);
+        size = LLVMFuzzerCustomMutator(buffer, size, sizeof(buffer), nextRandom());
+        run(buffer, size);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    printf("%zu mutated inputs in %.1f s (%.0f execs/s)\n", runs, seconds, runs / seconds);
+    return 0;
+}
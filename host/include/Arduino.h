@@ -0,0 +1,108 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Thin Arduino portability layer for the host (Linux) build.
+// Provides just enough of the Arduino core for the decoding pipeline (wM-Bus, PRIOS, IZAR handlers and
+// WebLogger) to compile unchanged outside the ESP32 toolchain.
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define IZAR_HOST_BUILD 1
+
+#define PROGMEM
+#define IRAM_ATTR
+
+typedef uint8_t byte;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+
+// glibc only gained strlcpy in 2.38 (macOS and musl always had it)
+#if defined(__GLIBC__)
+#if !__GLIBC_PREREQ(2, 38)
+#define HOST_NEEDS_STRLCPY 1
+#endif
+#endif
+
+#ifdef HOST_NEEDS_STRLCPY
+size_t strlcpy(char* dest, const char* src, size_t destSize);
+#endif
+
+// Minimal Arduino String (only the operations used by the shared sources)
+class String {
+  public:
+    String() = default;
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    String(float number, unsigned int decimalPlaces) {
+        char text[48];
+        snprintf(text, sizeof(text), "%.*f", static_cast<int>(decimalPlaces), number);
+        value = text;
+    }
+
+    const char* c_str() const { return value.c_str(); }
+    unsigned int length() const { return static_cast<unsigned int>(value.size()); }
+    void reserve(unsigned int size) { value.reserve(size); }
+    bool concat(const char* text, unsigned int len) {
+        value.append(text, len);
+        return true;
+    }
+
+    String& operator+=(const String& rhs) {
+        value += rhs.value;
+        return *this;
+    }
+    String& operator+=(const char* rhs) {
+        value += rhs;
+        return *this;
+    }
+    String& operator+=(char rhs) {
+        value += rhs;
+        return *this;
+    }
+    String& operator+=(unsigned char rhs) { return appendNumber(static_cast<unsigned long>(rhs)); }
+    String& operator+=(int rhs) { return appendNumber(static_cast<long>(rhs)); }
+    String& operator+=(unsigned int rhs) { return appendNumber(static_cast<unsigned long>(rhs)); }
+    String& operator+=(long rhs) { return appendNumber(rhs); }
+    String& operator+=(unsigned long rhs) { return appendNumber(rhs); }
+
+    bool operator==(const String& rhs) const { return value == rhs.value; }
+    bool operator!=(const String& rhs) const { return value != rhs.value; }
+
+  private:
+    std::string value;
+
+    String& appendNumber(long number) {
+        value += std::to_string(number);
+        return *this;
+    }
+    String& appendNumber(unsigned long number) {
+        value += std::to_string(number);
+        return *this;
+    }
+};
+
+// Serial sink writing to stderr, so stdout stays free for tool output
+class HostSerial {
+  public:
+    void begin(unsigned long) { enabled = true; }
+    void end() { enabled = false; } // Mutes output, e.g. for fuzzing with logging compiled in
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char* text);
+    size_t println(const char* text = "");
+    operator bool() const { return true; }
+
+  private:
+    bool enabled = true;
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,61 @@
+#ifndef HOST_BATCH_DECODER_H
+#define HOST_BATCH_DECODER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "izar_handler.h"
+#include "wm_bus_handler.h"
+#include "work_stealing_pool.h"
+
+// Outcome of one frame in a batch, in pipeline order
+enum class BatchFrameResult : uint8_t {
+    DECODED,        // Reading available
+    WMBUS_REJECTED, // 3-out-of-6 or CRC stage failed, see wmBusStatus
+    NO_PAYLOAD,     // Valid wM-Bus frame without PRIOS payload
+    DECRYPT_FAILED, // PRIOS decryption did not produce the 0x4B marker
+    PARSE_FAILED    // IZAR payload too short or inconsistent
+};
+
+// Structure-of-arrays batch output, index i belongs to input frame i.
+// Workers write disjoint index ranges, so the arrays are the only shared state and need no locking.
+struct BatchDecodeResults {
+    std::vector<BatchFrameResult> result;
+    std::vector<WmBusDecodeStatus> wmBusStatus;
+    std::vector<uint8_t> frames; // Decoded wM-Bus frames, WM_BUS_MAX_PAYLOAD bytes per entry
+    std::vector<uint8_t> frameLengths;
+    std::vector<uint64_t> meterKeys; // M-field and A-field (frame bytes 2-9) as a little-endian integer
+    std::vector<IzarReading> readings;
+
+    void resize(size_t count);
+    size_t size() const { return result.size(); }
+    const uint8_t* frame(size_t index) const { return frames.data() + index * WM_BUS_MAX_PAYLOAD; }
+};
+
+// Decodes batches of raw 3-out-of-6 frames through the wM-Bus, PRIOS and IZAR stages on a work-stealing pool.
+// Uses only the stateless stage functions; the global handlers and their callbacks are not involved.
+class BatchDecoder {
+  public:
+    // threadCount includes the calling thread; 0 selects std::thread::hardware_concurrency()
+    explicit BatchDecoder(unsigned threadCount = 0);
+
+    unsigned getThreadCount() const { return pool.getThreadCount(); }
+
+    // rawFrames holds count records of rawStride bytes, rawLengths/rssi one entry per record (rssi may be null)
+    void decode(const uint8_t* rawFrames, size_t rawStride, const uint8_t* rawLengths, const int16_t* rssi,
+                size_t count, BatchDecodeResults& results);
+
+  private:
+    // Per-worker scratch, padded to a cache line multiple so neighbours never share one
+    struct alignas(64) Scratch {
+        WmBusFrame frame;
+    };
+
+    WorkStealingPool pool;
+    std::vector<Scratch> scratch;
+
+    static void decodeRange(const uint8_t* rawFrames, size_t rawStride, const uint8_t* rawLengths,
+                            const int16_t* rssi, size_t begin, size_t end, Scratch& scratch,
+                            BatchDecodeResults& results);
+};
+
+#endif // HOST_BATCH_DECODER_H
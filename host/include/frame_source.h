@@ -0,0 +1,55 @@
+#ifndef HOST_FRAME_SOURCE_H
+#define HOST_FRAME_SOURCE_H
+
+#include <Arduino.h>
+#include <deque>
+#include <memory>
+#include <string>
+#include "config.h"
+#include "fsk_demodulator.h"
+
+// One raw 3-out-of-6 encoded frame as the SX1262 delivers it
+struct RawFrame {
+    uint8_t data[FSK_MODEM_RX_MAX_LENGTH];
+    uint8_t length;
+    int16_t rssi;
+};
+
+// Frame stream encoding
+enum class FrameFormat {
+    HEX,   // One frame per line: <hex bytes> [rssi]; blank lines and '#' comments are skipped
+    BINARY, // Fixed FSK_MODEM_RX_MAX_LENGTH byte records, no RSSI
+    IQ_U8,  // Complex baseband, unsigned 8-bit I/Q (rtl_sdr), demodulated in software
+    IQ_F32  // Complex baseband, 32-bit float I/Q, demodulated in software
+};
+
+enum class FrameReadResult { FRAME, TIMEOUT, END };
+
+// Reads raw frames from stdin, a file, a serial TTY or a TCP socket
+class FrameSource {
+  public:
+    ~FrameSource();
+
+    // spec: "-" / "stdin", "file:PATH", "tty:DEVICE[@BAUD]" or "tcp:HOST:PORT"
+    // sampleRate only applies to the IQ formats
+    bool open(const std::string& spec, FrameFormat format, float sampleRate = 1000000.0f);
+    void close();
+
+    FrameReadResult read(RawFrame& frame, int timeoutMs);
+
+  private:
+    int fd = -1;
+    bool ownsFd = false;
+    FrameFormat format = FrameFormat::HEX;
+    std::string pending; // Bytes read but not yet consumed
+    bool eof = false;
+    std::unique_ptr<FskDemodulator> demodulator; // IQ formats only
+    std::deque<RawFrame> demodulated;            // Frames found by the demodulator, not yet returned
+
+    bool openTty(const std::string& device, unsigned long baud);
+    bool openTcp(const std::string& host, const std::string& port);
+    bool extractFrame(RawFrame& frame);
+    static bool parseHexLine(const std::string& line, RawFrame& frame);
+};
+
+#endif // HOST_FRAME_SOURCE_H
@@ -0,0 +1,87 @@
+#ifndef HOST_FSK_DEMODULATOR_H
+#define HOST_FSK_DEMODULATOR_H
+
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+#include "config.h"
+
+// Complex baseband sample encodings
+enum class IqFormat {
+    U8, // Interleaved unsigned 8-bit I/Q centred on 127.5 (rtl_sdr .cu8)
+    F32 // Interleaved 32-bit float I/Q (.cf32)
+};
+
+struct FskDemodulatorConfig {
+    float sampleRate = 1000000.0f;                 // Samples per second, at least 4 samples per bit
+    float bitRate = FSK_MODEM_BIT_RATE * 1000.0f;  // Bits per second (T1: 100 kbps)
+    uint8_t syncMaxBitErrors = 1;                  // Tolerated bit errors in the 32-bit preamble + sync pattern
+    uint8_t frameLength = FSK_MODEM_RX_MAX_LENGTH; // Bytes delivered per sync, like the SX1262 fixed length mode
+};
+
+// Raw frame callback: same bytes the SX1262 would deliver after its sync word; rssi is the mean signal power
+// over the frame in dBFS (not dBm)
+typedef std::function<void(const uint8_t* frame, uint8_t length, int16_t rssi)> FskFrameCallback;
+
+// Software T1-mode 2-FSK receiver: FM discriminator, one-bit boxcar matched filter, zero-crossing clock recovery,
+// correlation against FSK_MODEM_SYNC_WORD (either polarity) and bit slicing into fixed-length raw frames.
+// The discriminator runs on AVX2, SSE2 or NEON when the compiler targets them, with a scalar fallback.
+class FskDemodulator {
+  public:
+    explicit FskDemodulator(const FskDemodulatorConfig& config = FskDemodulatorConfig());
+
+    void setFrameCallback(FskFrameCallback callback) { frameCallback = std::move(callback); }
+
+    // Feed samples; state carries over between calls so buffers may be split anywhere on a sample boundary
+    void process(const uint8_t* iq, size_t sampleCount);
+    void process(const float* iq, size_t sampleCount);
+
+    void reset();
+
+    uint32_t getFrameCount() const { return frameCount; }
+
+    // Name of the discriminator kernel selected at compile time ("avx2", "sse2", "neon" or "scalar")
+    static const char* getKernelName();
+
+  private:
+    enum class State { SEARCH, RECEIVE };
+
+    static constexpr size_t kBlockSize = 4096;
+
+    FskDemodulatorConfig config;
+    FskFrameCallback frameCallback;
+
+    // Block buffers, index 0 holds the last sample of the previous block
+    std::vector<float> blockI;
+    std::vector<float> blockQ;
+    std::vector<float> frequency;
+    std::vector<float> power;
+
+    // Matched filter
+    std::vector<float> history;
+    size_t historyPos = 0;
+    float filterSum = 0.0f;
+    float lastFiltered = 0.0f;
+    float dcOffset = 0.0f;
+    float dcAlpha;
+
+    // Clock recovery, phase in bits: a bit is sliced whenever it wraps past 1.0
+    float bitStep;
+    float clockPhase = 0.0f;
+
+    // Framing
+    State state = State::SEARCH;
+    uint32_t syncPattern;
+    uint32_t shiftRegister = 0;
+    bool inverted = false;
+    uint16_t bitsReceived = 0;
+    uint8_t frame[UINT8_MAX];
+    double framePower = 0.0;
+    uint32_t frameSamples = 0;
+    uint32_t frameCount = 0;
+
+    void processBlock(size_t sampleCount);
+    void sliceBit(bool bit);
+};
+
+#endif // HOST_FSK_DEMODULATOR_H
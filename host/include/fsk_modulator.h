@@ -0,0 +1,43 @@
+#ifndef HOST_FSK_MODULATOR_H
+#define HOST_FSK_MODULATOR_H
+
+#include <Arduino.h>
+#include <random>
+#include <vector>
+#include "config.h"
+
+struct FskModulatorConfig {
+    float sampleRate = 1000000.0f;                          // Samples per second
+    float bitRate = FSK_MODEM_BIT_RATE * 1000.0f;           // Bits per second (T1: 100 kbps)
+    float deviation = FSK_MODEM_FREQUENCY_DEVIATION * 1000; // Hz, '1' is sent at +deviation
+    float carrierOffset = 0.0f;                             // Hz, models transmitter crystal error
+    float amplitude = 0.5f;                                 // Peak amplitude relative to full scale
+};
+
+// Synthesizes T1-mode bursts (preamble, sync word, raw frame bytes) as phase-continuous 2-FSK complex baseband,
+// the inverse of FskDemodulator. Used to build IQ test corpora at a controlled SNR.
+class FskModulator {
+  public:
+    explicit FskModulator(const FskModulatorConfig& config = FskModulatorConfig(), uint32_t seed = 1);
+
+    // Append one burst to interleaved float I/Q
+    void appendFrame(const uint8_t* frame, uint8_t length, std::vector<float>& iq);
+    // Append an unmodulated gap (zero signal, noise is added separately)
+    void appendGap(size_t sampleCount, std::vector<float>& iq);
+
+    // Add complex white Gaussian noise; snrDb relates the burst power to the noise power over the whole sampled
+    // bandwidth, so the SNR after the one-bit matched filter is about 10*log10(sampleRate / bitRate) dB higher
+    void addNoise(std::vector<float>& iq, float snrDb);
+
+    // Quantise to rtl_sdr style unsigned 8-bit I/Q
+    static void toU8(const std::vector<float>& iq, std::vector<uint8_t>& out);
+
+  private:
+    FskModulatorConfig config;
+    std::mt19937 random;
+    double phase = 0.0;
+
+    void appendBits(const uint8_t* bits, size_t bitCount, std::vector<float>& iq);
+};
+
+#endif // HOST_FSK_MODULATOR_H
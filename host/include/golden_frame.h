@@ -0,0 +1,26 @@
+#ifndef GOLDEN_FRAME_H
+#define GOLDEN_FRAME_H
+
+#include <Arduino.h>
+#include "wm_bus_handler.h"
+
+// Golden vectors, written out by hand so they do not depend on IzarEncoder: meter O05FS649426 reporting
+// 12.345 m3 (H0 10.000 m3 on 2024-12-31), 32 s interval, 6 years of battery, previous leakage alarm.
+// Shared by izar-stage-bench and the unit tests.
+const uint8_t kGoldenRaw[] = {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x34, 0xE2, 0xDC, 0x65, 0xA6, 0x96, 0x96, 0x65, 0x93,
+                              0xD1, 0x36, 0x72, 0x98, 0xD5, 0x8B, 0x73, 0x45, 0x96, 0x34, 0xB2, 0xF1, 0x2C, 0xB7, 0x31,
+                              0x99, 0x69, 0x65, 0x68, 0xD9, 0x53, 0xB2, 0xC9, 0xA9, 0xC9, 0x9B, 0x2C, 0x8D, 0x3D, 0x0E};
+const uint8_t kGoldenDecoded[] = {0x19, 0x44, 0x30, 0x4C, 0x12, 0x34, 0x56, 0x60, 0x9A, 0x07,
+                                  0xC7, 0x5E, 0xA1, 0x03, 0x4C, 0x00, 0x13, 0x3D, 0x33, 0x4D,
+                                  0xA0, 0x99, 0x61, 0x97, 0x88, 0xAF, 0xE5, 0x88, 0xB7, 0xC2};
+const uint8_t kGoldenPlainTpl[] = {0xA1, 0x03, 0x4C, 0x00, 0x13, 0x4B, 0x39, 0x30,
+                                   0x00, 0x00, 0x10, 0x27, 0x00, 0x00, 0x1F, 0x3C};
+const char kGoldenMeterId[] = "O05FS649426";
+// CRC-16/EN-13757 check value from the CRC catalogue
+const uint8_t kCrcCheckInput[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+const uint16_t kCrcCheckValue = 0xC2B7;
+
+const uint8_t kTplOffset = WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE;
+const uint8_t kTplLength = sizeof(kGoldenPlainTpl);
+
+#endif // GOLDEN_FRAME_H
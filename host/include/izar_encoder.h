@@ -0,0 +1,49 @@
+#ifndef HOST_IZAR_ENCODER_H
+#define HOST_IZAR_ENCODER_H
+
+#include <Arduino.h>
+#include "izar_handler.h"
+#include "prios_handler.h"
+#include "wm_bus_handler.h"
+
+#define IZAR_ENCODER_CI_FIELD 0xA1      // CI field of IZAR telegrams
+#define IZAR_ENCODER_C_FIELD 0x44       // SND_NR
+#define IZAR_ENCODER_MANUFACTURER "SAP" // Sappel / Diehl Metering
+#define IZAR_ENCODER_DECODED_LENGTH 30  // DLL header + CRC, IZAR_MIN_DATA_LENGTH TPL bytes + CRC
+#define IZAR_ENCODER_RAW_LENGTH 45      // IZAR_ENCODER_DECODED_LENGTH after 3-out-of-6 encoding
+
+// Encoding choices that IzarReading does not carry
+struct IzarEncodeOptions {
+    uint8_t key[PRIOS_KEY_SIZE] = PRIOS_DEFAULT_KEY;
+    const char* manufacturer = IZAR_ENCODER_MANUFACTURER;
+    int8_t multiplierExponent = -3;              // Readings are sent in units of 10^exp m3 (-3: litres)
+    uint8_t rawLength = FSK_MODEM_RX_MAX_LENGTH; // Zero-padded like the SX1262 fixed length mode
+};
+
+// Inverse of the IZAR receive pipeline: IzarReading -> IZAR payload -> PRIOS encryption -> TPL/DLL CRCs ->
+// 3-out-of-6 raw bytes as the SX1262 would deliver them. Used for test vectors and load generation.
+class IzarEncoder {
+  public:
+    // Encode a reading (meterId in the printed format, e.g. "O05FS649426") into raw bytes.
+    // Returns the raw length written (options.rawLength), or 0 if the reading cannot be represented.
+    static uint8_t encode(const IzarReading& reading, const IzarEncodeOptions& options, uint8_t* raw,
+                          uint8_t rawCapacity);
+
+    // Individual stages, exposed for tests and tools
+    // 6-byte A-field (frame bytes 4-9) from the printed meter ID
+    static bool encodeAddress(const char* meterId, uint8_t* address);
+    // Plain IZAR_MIN_DATA_LENGTH byte TPL payload, before PRIOS encryption
+    static bool buildPayload(const IzarReading& reading, int8_t multiplierExponent, uint8_t* payload);
+    // Decoded frame with both CRCs and encrypted payload, IZAR_ENCODER_DECODED_LENGTH bytes
+    static bool buildFrame(const IzarReading& reading, const IzarEncodeOptions& options, uint8_t* frame);
+    // Returns the encoded length (decodedLen * 3 / 2, rounded up)
+    static uint8_t encode3outof6(const uint8_t* decoded, uint8_t decodedLen, uint8_t* encoded);
+
+    // Fault injection for decoder tests; state is a caller-owned xorshift32 seed (non-zero)
+    static void injectBitErrors(uint8_t* raw, uint8_t length, uint8_t bitErrors, uint32_t& state);
+    static uint8_t truncate(uint8_t length, uint32_t& state); // Random length in [1, length)
+
+    static uint32_t nextRandom(uint32_t& state);
+};
+
+#endif // HOST_IZAR_ENCODER_H
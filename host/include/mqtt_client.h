@@ -0,0 +1,45 @@
+#ifndef HOST_MQTT_CLIENT_H
+#define HOST_MQTT_CLIENT_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// Connection settings for the host MQTT client
+struct MqttClientOptions {
+    std::string host = "localhost";
+    uint16_t port = 1883;
+    std::string clientId;
+    std::string username;
+    std::string password;
+    std::string willTopic;
+    std::string willMessage;
+    uint16_t keepAliveSeconds = 30;
+};
+
+// Minimal blocking MQTT 3.1.1 publisher (QoS 0) over POSIX sockets for the Linux bridge daemon
+class MqttClient {
+  public:
+    ~MqttClient();
+
+    bool connect(const MqttClientOptions& options);
+    bool isConnected() const { return fd >= 0; }
+    void disconnect();
+
+    // Send keepalive pings and drain anything the broker sends us
+    void handle();
+
+    bool publish(const char* topic, const uint8_t* payload, size_t length, bool retain = false);
+    bool publish(const char* topic, const char* payload, bool retain = false);
+
+  private:
+    int fd = -1;
+    uint16_t keepAliveSeconds = 30;
+    unsigned long lastSendTime = 0;
+
+    bool sendPacket(uint8_t header, const std::vector<uint8_t>& body);
+    void closeSocket();
+    static void appendString(std::vector<uint8_t>& out, const std::string& text);
+};
+
+#endif // HOST_MQTT_CLIENT_H
@@ -0,0 +1,62 @@
+#ifndef HOST_WORK_STEALING_POOL_H
+#define HOST_WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent thread pool for data-parallel loops. Each worker owns a deque of index ranges: it pops from the back
+// of its own deque and, once empty, steals from the front of the others, so uneven ranges balance out.
+class WorkStealingPool {
+  public:
+    // Range body: process indices [begin, end) on worker `worker` (0 = calling thread)
+    using RangeFunction = std::function<void(size_t begin, size_t end, unsigned worker)>;
+
+    // threadCount includes the calling thread; 0 selects std::thread::hardware_concurrency()
+    explicit WorkStealingPool(unsigned threadCount = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    unsigned getThreadCount() const { return static_cast<unsigned>(queues.size()); }
+
+    // Split [0, count) into ranges of `grain` indices and block until all of them ran
+    void parallelFor(size_t count, size_t grain, const RangeFunction& function);
+
+  private:
+    struct Range {
+        size_t begin;
+        size_t end;
+    };
+
+    // One cache line per queue so owners do not false-share their locks
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    std::vector<Queue> queues;
+    std::vector<std::thread> threads;
+    const RangeFunction* task = nullptr;
+    std::atomic<size_t> remainingRanges{0};
+
+    std::mutex controlMutex;
+    std::condition_variable wakeup;
+    std::condition_variable finished;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    void workerLoop(unsigned worker);
+    void runRanges(unsigned worker);
+    bool popLocal(unsigned worker, Range& range);
+    bool steal(unsigned worker, Range& range);
+};
+
+#endif // HOST_WORK_STEALING_POOL_H
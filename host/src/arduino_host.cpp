@@ -0,0 +1,62 @@
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+
+HostSerial Serial;
+
+namespace {
+const std::chrono::steady_clock::time_point kStartTime = std::chrono::steady_clock::now();
+}
+
+unsigned long millis() {
+    return static_cast<unsigned long>(
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - kStartTime).count());
+}
+
+unsigned long micros() {
+    return static_cast<unsigned long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - kStartTime).count());
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+#ifdef HOST_NEEDS_STRLCPY
+size_t strlcpy(char* dest, const char* src, size_t destSize) {
+    size_t srcLen = strlen(src);
+    if (destSize > 0) {
+        size_t copyLen = srcLen < destSize - 1 ? srcLen : destSize - 1;
+        memcpy(dest, src, copyLen);
+        dest[copyLen] = '\0';
+    }
+    return srcLen;
+}
+#endif
+
+size_t HostSerial::printf(const char* format, ...) {
+    if (!enabled) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, format);
+    int written = vfprintf(stderr, format, args);
+    va_end(args);
+    return written > 0 ? static_cast<size_t>(written) : 0;
+}
+
+size_t HostSerial::print(const char* text) {
+    if (!enabled) {
+        return 0;
+    }
+    return fputs(text, stderr) >= 0 ? strlen(text) : 0;
+}
+
+size_t HostSerial::println(const char* text) {
+    if (!enabled) {
+        return 0;
+    }
+    size_t written = print(text);
+    fputc('\n', stderr);
+    return written + 1;
+}
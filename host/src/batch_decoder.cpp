@@ -0,0 +1,67 @@
+#include "batch_decoder.h"
+#include "prios_handler.h"
+
+namespace {
+// Frames per stolen range: large enough to amortise the queue lock, small enough to balance the tail
+constexpr size_t kBatchGrain = 1024;
+} // namespace
+
+void BatchDecodeResults::resize(size_t count) {
+    result.resize(count);
+    wmBusStatus.resize(count);
+    frames.resize(count * WM_BUS_MAX_PAYLOAD);
+    frameLengths.resize(count);
+    meterKeys.resize(count);
+    readings.resize(count);
+}
+
+BatchDecoder::BatchDecoder(unsigned threadCount) : pool(threadCount), scratch(pool.getThreadCount()) {}
+
+void BatchDecoder::decode(const uint8_t* rawFrames, size_t rawStride, const uint8_t* rawLengths,
+                          const int16_t* rssi, size_t count, BatchDecodeResults& results) {
+    results.resize(count);
+    pool.parallelFor(count, kBatchGrain, [&](size_t begin, size_t end, unsigned worker) {
+        decodeRange(rawFrames, rawStride, rawLengths, rssi, begin, end, scratch[worker], results);
+    });
+}
+
+void BatchDecoder::decodeRange(const uint8_t* rawFrames, size_t rawStride, const uint8_t* rawLengths,
+                               const int16_t* rssi, size_t begin, size_t end, Scratch& scratch,
+                               BatchDecodeResults& results) {
+    WmBusFrame& frame = scratch.frame;
+    for (size_t i = begin; i < end; i++) {
+        WmBusDecodeStatus status = WmBusHandler::decodeFrame(rawFrames + i * rawStride, rawLengths[i], &frame);
+        results.wmBusStatus[i] = status;
+        if (status != WmBusDecodeStatus::OK) {
+            results.result[i] = BatchFrameResult::WMBUS_REJECTED;
+            results.frameLengths[i] = 0;
+            results.meterKeys[i] = 0;
+            continue;
+        }
+
+        uint64_t meterKey = 0;
+        for (uint8_t b = 0; b < 8; b++) {
+            meterKey |= static_cast<uint64_t>(frame.data[WM_BUS_OFFSET_M_FIELD + b]) << (8 * b);
+        }
+        results.meterKeys[i] = meterKey;
+
+        // Keep the frame as received; decryption below works in-place on the scratch copy
+        memcpy(results.frames.data() + i * WM_BUS_MAX_PAYLOAD, frame.data, frame.length);
+        results.frameLengths[i] = frame.length;
+
+        if (frame.tplDataLen == 0) {
+            results.result[i] = BatchFrameResult::NO_PAYLOAD;
+            continue;
+        }
+        if (!PriosHandler::decryptPayload(frame.data, frame.length, frame.tplData(), frame.tplDataLen)) {
+            results.result[i] = BatchFrameResult::DECRYPT_FAILED;
+            continue;
+        }
+        if (!IzarHandler::parseReading(frame.header.meterId, frame.tplData(), frame.tplDataLen,
+                                       rssi ? rssi[i] : 0, &results.readings[i])) {
+            results.result[i] = BatchFrameResult::PARSE_FAILED;
+            continue;
+        }
+        results.result[i] = BatchFrameResult::DECODED;
+    }
+}
@@ -0,0 +1,278 @@
+#include "frame_source.h"
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+speed_t baudToSpeed(unsigned long baud) {
+    switch (baud) {
+    case 9600:
+        return B9600;
+    case 19200:
+        return B19200;
+    case 38400:
+        return B38400;
+    case 57600:
+        return B57600;
+    case 230400:
+        return B230400;
+    case 460800:
+        return B460800;
+    case 921600:
+        return B921600;
+    default:
+        return B115200;
+    }
+}
+} // namespace
+
+FrameSource::~FrameSource() {
+    close();
+}
+
+bool FrameSource::open(const std::string& spec, FrameFormat frameFormat, float sampleRate) {
+    close();
+    format = frameFormat;
+    pending.clear();
+    demodulated.clear();
+    eof = false;
+
+    demodulator.reset();
+    if (format == FrameFormat::IQ_U8 || format == FrameFormat::IQ_F32) {
+        FskDemodulatorConfig config;
+        config.sampleRate = sampleRate;
+        demodulator.reset(new FskDemodulator(config));
+        demodulator->setFrameCallback([this](const uint8_t* data, uint8_t length, int16_t rssi) {
+            RawFrame frame;
+            frame.length = length < sizeof(frame.data) ? length : sizeof(frame.data);
+            memcpy(frame.data, data, frame.length);
+            frame.rssi = rssi;
+            demodulated.push_back(frame);
+        });
+        LOG_INFO("Source", "Demodulating %s I/Q at %.0f samples/s (%s kernel)",
+                 format == FrameFormat::IQ_U8 ? "8-bit" : "float", sampleRate, FskDemodulator::getKernelName());
+    }
+
+    if (spec.empty() || spec == "-" || spec == "stdin") {
+        fd = STDIN_FILENO;
+        ownsFd = false;
+        return true;
+    }
+
+    ownsFd = true;
+    if (spec.compare(0, 5, "file:") == 0) {
+        fd = ::open(spec.c_str() + 5, O_RDONLY);
+    } else if (spec.compare(0, 4, "tty:") == 0) {
+        std::string device = spec.substr(4);
+        unsigned long baud = 115200;
+        size_t at = device.find('@');
+        if (at != std::string::npos) {
+            baud = strtoul(device.c_str() + at + 1, nullptr, 10);
+            device.resize(at);
+        }
+        return openTty(device, baud);
+    } else if (spec.compare(0, 4, "tcp:") == 0) {
+        std::string address = spec.substr(4);
+        size_t colon = address.rfind(':');
+        if (colon == std::string::npos) {
+            LOG_ERROR("Source", "TCP source needs HOST:PORT, got %s", address.c_str());
+            return false;
+        }
+        return openTcp(address.substr(0, colon), address.substr(colon + 1));
+    } else {
+        fd = ::open(spec.c_str(), O_RDONLY);
+    }
+
+    if (fd < 0) {
+        LOG_ERROR("Source", "Cannot open %s", spec.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool FrameSource::openTty(const std::string& device, unsigned long baud) {
+    fd = ::open(device.c_str(), O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        LOG_ERROR("Source", "Cannot open TTY %s", device.c_str());
+        return false;
+    }
+
+    termios tty{};
+    if (tcgetattr(fd, &tty) != 0) {
+        LOG_ERROR("Source", "%s is not a TTY", device.c_str());
+        close();
+        return false;
+    }
+    cfmakeraw(&tty);
+    cfsetispeed(&tty, baudToSpeed(baud));
+    cfsetospeed(&tty, baudToSpeed(baud));
+    tty.c_cflag |= CLOCAL | CREAD;
+    tcsetattr(fd, TCSANOW, &tty);
+
+    LOG_INFO("Source", "Reading frames from %s at %lu baud", device.c_str(), baud);
+    return true;
+}
+
+bool FrameSource::openTcp(const std::string& host, const std::string& port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &result) != 0) {
+        LOG_ERROR("Source", "Cannot resolve %s", host.c_str());
+        return false;
+    }
+
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0) {
+        LOG_ERROR("Source", "Connection to %s:%s failed", host.c_str(), port.c_str());
+        return false;
+    }
+
+    LOG_INFO("Source", "Reading frames from tcp://%s:%s", host.c_str(), port.c_str());
+    return true;
+}
+
+void FrameSource::close() {
+    if (fd >= 0 && ownsFd) {
+        ::close(fd);
+    }
+    fd = -1;
+    ownsFd = false;
+}
+
+FrameReadResult FrameSource::read(RawFrame& frame, int timeoutMs) {
+    while (true) {
+        if (extractFrame(frame)) {
+            return FrameReadResult::FRAME;
+        }
+        if (eof || fd < 0) {
+            return FrameReadResult::END;
+        }
+
+        pollfd pfd{fd, POLLIN, 0};
+        int ready = poll(&pfd, 1, timeoutMs);
+        if (ready == 0) {
+            return FrameReadResult::TIMEOUT;
+        }
+
+        char buffer[4096];
+        ssize_t received = ready > 0 ? ::read(fd, buffer, sizeof(buffer)) : -1;
+        if (received <= 0) {
+            eof = true;
+            // Treat an unterminated last line as a complete one
+            if (format == FrameFormat::HEX && !pending.empty()) {
+                pending.push_back('\n');
+            }
+            continue;
+        }
+        pending.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+bool FrameSource::extractFrame(RawFrame& frame) {
+    if (demodulator) {
+        // Run every complete sample through the demodulator, keep a trailing partial sample for the next read
+        size_t sampleSize = format == FrameFormat::IQ_U8 ? 2 : 2 * sizeof(float);
+        size_t sampleCount = pending.size() / sampleSize;
+        if (sampleCount > 0) {
+            if (format == FrameFormat::IQ_U8) {
+                demodulator->process(reinterpret_cast<const uint8_t*>(pending.data()), sampleCount);
+            } else {
+                std::vector<float> samples(2 * sampleCount);
+                memcpy(samples.data(), pending.data(), sampleCount * sampleSize);
+                demodulator->process(samples.data(), sampleCount);
+            }
+            pending.erase(0, sampleCount * sampleSize);
+        }
+        if (demodulated.empty()) {
+            return false;
+        }
+        frame = demodulated.front();
+        demodulated.pop_front();
+        return true;
+    }
+
+    if (format == FrameFormat::BINARY) {
+        if (pending.size() < FSK_MODEM_RX_MAX_LENGTH) {
+            return false;
+        }
+        memcpy(frame.data, pending.data(), FSK_MODEM_RX_MAX_LENGTH);
+        frame.length = FSK_MODEM_RX_MAX_LENGTH;
+        frame.rssi = 0;
+        pending.erase(0, FSK_MODEM_RX_MAX_LENGTH);
+        return true;
+    }
+
+    size_t newline;
+    while ((newline = pending.find('\n')) != std::string::npos) {
+        std::string line = pending.substr(0, newline);
+        pending.erase(0, newline + 1);
+        if (parseHexLine(line, frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FrameSource::parseHexLine(const std::string& line, RawFrame& frame) {
+    size_t pos = line.find_first_not_of(" \t\r");
+    if (pos == std::string::npos || line[pos] == '#') {
+        return false;
+    }
+    if (line.compare(pos, 2, "0x") == 0 || line.compare(pos, 2, "0X") == 0) {
+        pos += 2;
+    }
+
+    frame.length = 0;
+    frame.rssi = 0;
+    while (pos + 1 < line.size() && frame.length < FSK_MODEM_RX_MAX_LENGTH) {
+        int high = hexValue(line[pos]);
+        int low = hexValue(line[pos + 1]);
+        if (high < 0 || low < 0) {
+            break;
+        }
+        frame.data[frame.length++] = static_cast<uint8_t>((high << 4) | low);
+        pos += 2;
+    }
+
+    // Optional RSSI after the hex bytes
+    pos = line.find_first_of(" \t", pos);
+    if (pos != std::string::npos) {
+        frame.rssi = static_cast<int16_t>(strtol(line.c_str() + pos, nullptr, 10));
+    }
+
+    if (frame.length == 0) {
+        LOG_WARN("Source", "Skipping malformed line: %s", line.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,339 @@
+#include "fsk_demodulator.h"
+#include <algorithm>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define FSK_KERNEL_AVX2 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define FSK_KERNEL_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define FSK_KERNEL_NEON 1
+#endif
+
+namespace {
+constexpr float kU8Offset = 127.5f;
+constexpr float kU8Scale = 1.0f / 127.5f;
+constexpr float kPowerFloor = 1e-9f; // Keeps the discriminator finite on all-zero input
+
+// Clock recovery loop gains: fast while locking onto the preamble, gentle once a frame is being sliced
+constexpr float kClockGainSearch = 0.4f;
+constexpr float kClockGainReceive = 0.15f;
+
+// DC (carrier offset) tracking time constants in bits
+constexpr float kDcBitsSearch = 8.0f;
+constexpr float kDcBitsReceive = 64.0f;
+
+// ---- u8 I/Q to float, deinterleaved ----
+
+void convertU8Scalar(const uint8_t* iq, size_t count, float* outI, float* outQ) {
+    for (size_t n = 0; n < count; n++) {
+        outI[n] = (iq[2 * n] - kU8Offset) * kU8Scale;
+        outQ[n] = (iq[2 * n + 1] - kU8Offset) * kU8Scale;
+    }
+}
+
+void convertU8(const uint8_t* iq, size_t count, float* outI, float* outQ) {
+    size_t n = 0;
+#if defined(FSK_KERNEL_AVX2)
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    const __m256 offset = _mm256_set1_ps(kU8Offset);
+    const __m256 scale = _mm256_set1_ps(kU8Scale);
+    for (; n + 16 <= count; n += 16) {
+        __m256i raw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(iq + 2 * n));
+        __m256i i16 = _mm256_and_si256(raw, lowBytes);
+        __m256i q16 = _mm256_srli_epi16(raw, 8);
+        __m256 i0 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(i16)));
+        __m256 i1 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(i16, 1)));
+        __m256 q0 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(q16)));
+        __m256 q1 = _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(q16, 1)));
+        _mm256_storeu_ps(outI + n, _mm256_mul_ps(_mm256_sub_ps(i0, offset), scale));
+        _mm256_storeu_ps(outI + n + 8, _mm256_mul_ps(_mm256_sub_ps(i1, offset), scale));
+        _mm256_storeu_ps(outQ + n, _mm256_mul_ps(_mm256_sub_ps(q0, offset), scale));
+        _mm256_storeu_ps(outQ + n + 8, _mm256_mul_ps(_mm256_sub_ps(q1, offset), scale));
+    }
+#elif defined(FSK_KERNEL_SSE2)
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 offset = _mm_set1_ps(kU8Offset);
+    const __m128 scale = _mm_set1_ps(kU8Scale);
+    for (; n + 8 <= count; n += 8) {
+        __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(iq + 2 * n));
+        __m128i i16 = _mm_and_si128(raw, lowBytes);
+        __m128i q16 = _mm_srli_epi16(raw, 8);
+        __m128 i0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(i16, zero));
+        __m128 i1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(i16, zero));
+        __m128 q0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q16, zero));
+        __m128 q1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(q16, zero));
+        _mm_storeu_ps(outI + n, _mm_mul_ps(_mm_sub_ps(i0, offset), scale));
+        _mm_storeu_ps(outI + n + 4, _mm_mul_ps(_mm_sub_ps(i1, offset), scale));
+        _mm_storeu_ps(outQ + n, _mm_mul_ps(_mm_sub_ps(q0, offset), scale));
+        _mm_storeu_ps(outQ + n + 4, _mm_mul_ps(_mm_sub_ps(q1, offset), scale));
+    }
+#elif defined(FSK_KERNEL_NEON)
+    const float32x4_t offset = vdupq_n_f32(kU8Offset);
+    for (; n + 16 <= count; n += 16) {
+        uint8x16x2_t raw = vld2q_u8(iq + 2 * n); // Deinterleaves I and Q
+        for (int c = 0; c < 2; c++) {
+            float* out = (c == 0 ? outI : outQ) + n;
+            uint16x8_t low = vmovl_u8(vget_low_u8(raw.val[c]));
+            uint16x8_t high = vmovl_u8(vget_high_u8(raw.val[c]));
+            vst1q_f32(out, vmulq_n_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(low))), offset), kU8Scale));
+            vst1q_f32(out + 4,
+                      vmulq_n_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(low))), offset), kU8Scale));
+            vst1q_f32(out + 8,
+                      vmulq_n_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_low_u16(high))), offset), kU8Scale));
+            vst1q_f32(out + 12,
+                      vmulq_n_f32(vsubq_f32(vcvtq_f32_u32(vmovl_u16(vget_high_u16(high))), offset), kU8Scale));
+        }
+    }
+#endif
+    convertU8Scalar(iq + 2 * n, count - n, outI + n, outQ + n);
+}
+
+// ---- float I/Q, deinterleaved ----
+
+void convertF32(const float* iq, size_t count, float* outI, float* outQ) {
+    size_t n = 0;
+#if defined(FSK_KERNEL_AVX2) || defined(FSK_KERNEL_SSE2)
+    for (; n + 4 <= count; n += 4) {
+        __m128 a = _mm_loadu_ps(iq + 2 * n);
+        __m128 b = _mm_loadu_ps(iq + 2 * n + 4);
+        _mm_storeu_ps(outI + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        _mm_storeu_ps(outQ + n, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+    }
+#elif defined(FSK_KERNEL_NEON)
+    for (; n + 4 <= count; n += 4) {
+        float32x4x2_t raw = vld2q_f32(iq + 2 * n);
+        vst1q_f32(outI + n, raw.val[0]);
+        vst1q_f32(outQ + n, raw.val[1]);
+    }
+#endif
+    for (; n < count; n++) {
+        outI[n] = iq[2 * n];
+        outQ[n] = iq[2 * n + 1];
+    }
+}
+
+// ---- FM discriminator ----
+// frequency[n] = Im(x[n+1] * conj(x[n])) / mean(|x[n]|^2, |x[n+1]|^2), about sin() of the phase step;
+// power[n] = |x[n+1]|^2. i and q hold count + 1 samples, the first one being the previous block's last sample.
+
+void discriminateScalar(const float* i, const float* q, size_t count, float* frequency, float* power) {
+    float previousPower = i[0] * i[0] + q[0] * q[0];
+    for (size_t n = 0; n < count; n++) {
+        float currentPower = i[n + 1] * i[n + 1] + q[n + 1] * q[n + 1];
+        float cross = i[n] * q[n + 1] - q[n] * i[n + 1];
+        frequency[n] = cross / (0.5f * (previousPower + currentPower) + kPowerFloor);
+        power[n] = currentPower;
+        previousPower = currentPower;
+    }
+}
+
+void discriminate(const float* i, const float* q, size_t count, float* frequency, float* power) {
+    size_t n = 0;
+#if defined(FSK_KERNEL_AVX2)
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 powerFloor = _mm256_set1_ps(kPowerFloor);
+    for (; n + 8 <= count; n += 8) {
+        __m256 i0 = _mm256_loadu_ps(i + n);
+        __m256 q0 = _mm256_loadu_ps(q + n);
+        __m256 i1 = _mm256_loadu_ps(i + n + 1);
+        __m256 q1 = _mm256_loadu_ps(q + n + 1);
+        __m256 p0 = _mm256_add_ps(_mm256_mul_ps(i0, i0), _mm256_mul_ps(q0, q0));
+        __m256 p1 = _mm256_add_ps(_mm256_mul_ps(i1, i1), _mm256_mul_ps(q1, q1));
+        __m256 cross = _mm256_sub_ps(_mm256_mul_ps(i0, q1), _mm256_mul_ps(q0, i1));
+        __m256 norm = _mm256_add_ps(_mm256_mul_ps(half, _mm256_add_ps(p0, p1)), powerFloor);
+        _mm256_storeu_ps(frequency + n, _mm256_div_ps(cross, norm));
+        _mm256_storeu_ps(power + n, p1);
+    }
+#elif defined(FSK_KERNEL_SSE2)
+    const __m128 half = _mm_set1_ps(0.5f);
+    const __m128 powerFloor = _mm_set1_ps(kPowerFloor);
+    for (; n + 4 <= count; n += 4) {
+        __m128 i0 = _mm_loadu_ps(i + n);
+        __m128 q0 = _mm_loadu_ps(q + n);
+        __m128 i1 = _mm_loadu_ps(i + n + 1);
+        __m128 q1 = _mm_loadu_ps(q + n + 1);
+        __m128 p0 = _mm_add_ps(_mm_mul_ps(i0, i0), _mm_mul_ps(q0, q0));
+        __m128 p1 = _mm_add_ps(_mm_mul_ps(i1, i1), _mm_mul_ps(q1, q1));
+        __m128 cross = _mm_sub_ps(_mm_mul_ps(i0, q1), _mm_mul_ps(q0, i1));
+        __m128 norm = _mm_add_ps(_mm_mul_ps(half, _mm_add_ps(p0, p1)), powerFloor);
+        _mm_storeu_ps(frequency + n, _mm_div_ps(cross, norm));
+        _mm_storeu_ps(power + n, p1);
+    }
+#elif defined(FSK_KERNEL_NEON)
+    const float32x4_t powerFloor = vdupq_n_f32(kPowerFloor);
+    for (; n + 4 <= count; n += 4) {
+        float32x4_t i0 = vld1q_f32(i + n);
+        float32x4_t q0 = vld1q_f32(q + n);
+        float32x4_t i1 = vld1q_f32(i + n + 1);
+        float32x4_t q1 = vld1q_f32(q + n + 1);
+        float32x4_t p0 = vmlaq_f32(vmulq_f32(i0, i0), q0, q0);
+        float32x4_t p1 = vmlaq_f32(vmulq_f32(i1, i1), q1, q1);
+        float32x4_t cross = vmlsq_f32(vmulq_f32(i0, q1), q0, i1);
+        float32x4_t norm = vaddq_f32(vmulq_n_f32(vaddq_f32(p0, p1), 0.5f), powerFloor);
+        // Reciprocal estimate refined by two Newton-Raphson steps (32-bit NEON has no divide)
+        float32x4_t reciprocal = vrecpeq_f32(norm);
+        reciprocal = vmulq_f32(vrecpsq_f32(norm, reciprocal), reciprocal);
+        reciprocal = vmulq_f32(vrecpsq_f32(norm, reciprocal), reciprocal);
+        vst1q_f32(frequency + n, vmulq_f32(cross, reciprocal));
+        vst1q_f32(power + n, p1);
+    }
+#endif
+    discriminateScalar(i + n, q + n, count - n, frequency + n, power + n);
+}
+
+uint32_t buildSyncPattern() {
+    static const uint8_t syncWord[] = FSK_MODEM_SYNC_WORD;
+    static_assert(sizeof(syncWord) == sizeof(uint32_t), "Sync correlator expects a 32-bit FSK_MODEM_SYNC_WORD");
+    return (static_cast<uint32_t>(syncWord[0]) << 24) | (static_cast<uint32_t>(syncWord[1]) << 16) |
+           (static_cast<uint32_t>(syncWord[2]) << 8) | syncWord[3];
+}
+} // namespace
+
+FskDemodulator::FskDemodulator(const FskDemodulatorConfig& demodulatorConfig)
+    : config(demodulatorConfig), blockI(kBlockSize + 1), blockQ(kBlockSize + 1), frequency(kBlockSize),
+      power(kBlockSize), syncPattern(buildSyncPattern()) {
+    float samplesPerBit = config.sampleRate / config.bitRate;
+    if (samplesPerBit < 4.0f) {
+        LOG_WARN("FSK Demod", "%.1f samples per bit is too few for reliable clock recovery", samplesPerBit);
+    }
+    if (config.frameLength == 0) {
+        config.frameLength = FSK_MODEM_RX_MAX_LENGTH;
+    }
+    bitStep = 1.0f / samplesPerBit;
+    history.resize(samplesPerBit >= 1.0f ? static_cast<size_t>(samplesPerBit + 0.5f) : 1);
+    reset();
+}
+
+const char* FskDemodulator::getKernelName() {
+#if defined(FSK_KERNEL_AVX2)
+    return "avx2";
+#elif defined(FSK_KERNEL_SSE2)
+    return "sse2";
+#elif defined(FSK_KERNEL_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+void FskDemodulator::reset() {
+    blockI[0] = 0.0f;
+    blockQ[0] = 0.0f;
+    std::fill(history.begin(), history.end(), 0.0f);
+    historyPos = 0;
+    filterSum = 0.0f;
+    lastFiltered = 0.0f;
+    dcOffset = 0.0f;
+    dcAlpha = bitStep / kDcBitsSearch;
+    clockPhase = 0.0f;
+    state = State::SEARCH;
+    shiftRegister = 0;
+    bitsReceived = 0;
+}
+
+void FskDemodulator::process(const uint8_t* iq, size_t sampleCount) {
+    while (sampleCount > 0) {
+        size_t count = sampleCount < kBlockSize ? sampleCount : kBlockSize;
+        convertU8(iq, count, blockI.data() + 1, blockQ.data() + 1);
+        processBlock(count);
+        iq += 2 * count;
+        sampleCount -= count;
+    }
+}
+
+void FskDemodulator::process(const float* iq, size_t sampleCount) {
+    while (sampleCount > 0) {
+        size_t count = sampleCount < kBlockSize ? sampleCount : kBlockSize;
+        convertF32(iq, count, blockI.data() + 1, blockQ.data() + 1);
+        processBlock(count);
+        iq += 2 * count;
+        sampleCount -= count;
+    }
+}
+
+void FskDemodulator::processBlock(size_t sampleCount) {
+    discriminate(blockI.data(), blockQ.data(), sampleCount, frequency.data(), power.data());
+    blockI[0] = blockI[sampleCount];
+    blockQ[0] = blockQ[sampleCount];
+
+    const size_t historyLength = history.size();
+    for (size_t n = 0; n < sampleCount; n++) {
+        // One-bit boxcar: the integrate-and-dump matched filter for rectangular NRZ symbols
+        filterSum += frequency[n] - history[historyPos];
+        history[historyPos] = frequency[n];
+        if (++historyPos == historyLength) {
+            historyPos = 0;
+        }
+
+        // Carrier offset shows up as DC after the discriminator; 3-out-of-6 coding keeps the data DC-free
+        dcOffset += dcAlpha * (filterSum - dcOffset);
+        float filtered = filterSum - dcOffset;
+
+        if (state == State::RECEIVE) {
+            framePower += power[n];
+            frameSamples++;
+        }
+
+        // The filtered signal crosses zero half a bit before the ideal slicing instant
+        float previousPhase = clockPhase;
+        clockPhase += bitStep;
+        if ((filtered >= 0.0f) != (lastFiltered >= 0.0f)) {
+            float fraction = lastFiltered / (lastFiltered - filtered);
+            float error = 0.5f - (previousPhase + fraction * bitStep);
+            if (error < -0.5f) {
+                error += 1.0f;
+            }
+            clockPhase += (state == State::SEARCH ? kClockGainSearch : kClockGainReceive) * error;
+        }
+        lastFiltered = filtered;
+
+        if (clockPhase >= 1.0f) {
+            clockPhase -= 1.0f;
+            sliceBit(filtered > 0.0f);
+        }
+    }
+}
+
+void FskDemodulator::sliceBit(bool bit) {
+    if (state == State::SEARCH) {
+        shiftRegister = (shiftRegister << 1) | (bit ? 1u : 0u);
+        int errors = __builtin_popcount(shiftRegister ^ syncPattern);
+        if (errors <= config.syncMaxBitErrors) {
+            inverted = false;
+        } else if (32 - errors <= config.syncMaxBitErrors) {
+            inverted = true; // Spectrum inverted (I/Q swapped or high-side LO)
+        } else {
+            return;
+        }
+
+        state = State::RECEIVE;
+        dcAlpha = bitStep / kDcBitsReceive;
+        bitsReceived = 0;
+        memset(frame, 0, config.frameLength);
+        framePower = 0.0;
+        frameSamples = 0;
+        return;
+    }
+
+    if (bit != inverted) {
+        frame[bitsReceived / 8] |= 0x80 >> (bitsReceived % 8);
+    }
+    if (++bitsReceived < config.frameLength * 8) {
+        return;
+    }
+
+    frameCount++;
+    if (frameCallback) {
+        double meanPower = frameSamples > 0 ? framePower / frameSamples : 0.0;
+        int16_t rssi = meanPower > 0.0 ? static_cast<int16_t>(lround(10.0 * log10(meanPower))) : INT16_MIN;
+        frameCallback(frame, config.frameLength, rssi);
+    }
+
+    state = State::SEARCH;
+    dcAlpha = bitStep / kDcBitsSearch;
+    shiftRegister = 0;
+}
@@ -0,0 +1,74 @@
+#include "fsk_modulator.h"
+
+namespace {
+// EN 13757-4 T1 preamble: 19 "01" chip pairs followed by the 10-bit sync 0000111101 (the tail of
+// FSK_MODEM_SYNC_WORD, which the SX1262 correlates against)
+constexpr size_t kPreamblePairs = 19;
+constexpr uint8_t kSyncBits[] = {0, 0, 0, 0, 1, 1, 1, 1, 0, 1};
+constexpr double kTwoPi = 6.283185307179586;
+} // namespace
+
+FskModulator::FskModulator(const FskModulatorConfig& modulatorConfig, uint32_t seed)
+    : config(modulatorConfig), random(seed) {}
+
+void FskModulator::appendFrame(const uint8_t* frame, uint8_t length, std::vector<float>& iq) {
+    std::vector<uint8_t> bits;
+    bits.reserve(2 * kPreamblePairs + sizeof(kSyncBits) + 8 * length + 2);
+    for (size_t i = 0; i < kPreamblePairs; i++) {
+        bits.push_back(0);
+        bits.push_back(1);
+    }
+    bits.insert(bits.end(), kSyncBits, kSyncBits + sizeof(kSyncBits));
+    for (uint8_t i = 0; i < length; i++) {
+        for (int b = 7; b >= 0; b--) {
+            bits.push_back((frame[i] >> b) & 1);
+        }
+    }
+    // Two postamble bits so the receiver's matched filter can settle on the last data bit
+    bits.push_back(0);
+    bits.push_back(1);
+
+    // Random starting phase, as from an unsynchronised transmitter
+    phase = std::uniform_real_distribution<double>(0.0, kTwoPi)(random);
+    appendBits(bits.data(), bits.size(), iq);
+}
+
+void FskModulator::appendBits(const uint8_t* bits, size_t bitCount, std::vector<float>& iq) {
+    double samplesPerBit = config.sampleRate / config.bitRate;
+    size_t sampleCount = static_cast<size_t>(bitCount * samplesPerBit);
+    iq.reserve(iq.size() + 2 * sampleCount);
+
+    for (size_t n = 0; n < sampleCount; n++) {
+        size_t bit = static_cast<size_t>(n / samplesPerBit);
+        double frequency = config.carrierOffset + (bits[bit] ? config.deviation : -config.deviation);
+        phase += kTwoPi * frequency / config.sampleRate;
+        if (phase > kTwoPi) {
+            phase -= kTwoPi;
+        } else if (phase < 0.0) {
+            phase += kTwoPi;
+        }
+        iq.push_back(static_cast<float>(config.amplitude * cos(phase)));
+        iq.push_back(static_cast<float>(config.amplitude * sin(phase)));
+    }
+}
+
+void FskModulator::appendGap(size_t sampleCount, std::vector<float>& iq) {
+    iq.insert(iq.end(), 2 * sampleCount, 0.0f);
+}
+
+void FskModulator::addNoise(std::vector<float>& iq, float snrDb) {
+    // Burst power is amplitude^2; split the noise power evenly between I and Q
+    double noisePower = config.amplitude * config.amplitude / pow(10.0, snrDb / 10.0);
+    std::normal_distribution<float> noise(0.0f, static_cast<float>(sqrt(noisePower / 2.0)));
+    for (float& value : iq) {
+        value += noise(random);
+    }
+}
+
+void FskModulator::toU8(const std::vector<float>& iq, std::vector<uint8_t>& out) {
+    out.resize(iq.size());
+    for (size_t i = 0; i < iq.size(); i++) {
+        float value = iq[i] * 127.5f + 127.5f;
+        out[i] = static_cast<uint8_t>(value < 0.0f ? 0.0f : (value > 255.0f ? 255.0f : value + 0.5f));
+    }
+}
@@ -0,0 +1,265 @@
+// Linux bridge daemon: raw 3-out-of-6 frames in, IZAR readings out to MQTT (same topic schema as the firmware)
+
+#include <Arduino.h>
+#include <getopt.h>
+#include <csignal>
+#include <map>
+#include <string>
+#include "config.h"
+#include "frame_source.h"
+#include "mqtt_client.h"
+#include "wm_bus_handler.h"
+#include "prios_handler.h"
+#include "izar_handler.h"
+
+namespace {
+struct BridgeOptions {
+    std::string input = "stdin";
+    FrameFormat format = FrameFormat::HEX;
+    float sampleRate = 1000000.0f;
+    MqttClientOptions mqtt;
+    std::string baseTopic = MQTT_BASE_TOPIC_DEFAULT;
+    std::string meterFilter;
+    bool dryRun = false;
+};
+
+// Sliding window used for the flow rate estimate, one per meter
+struct FlowWindow {
+    static constexpr size_t kSize = 9;
+    float readings[kSize]{};
+    unsigned long times[kSize]{};
+    size_t count = 0;
+    size_t head = 0;
+};
+
+BridgeOptions options;
+MqttClient mqtt;
+std::string topicStatus;
+std::string topicReading;
+std::map<std::string, FlowWindow> flowWindows;
+unsigned long lastReconnectAttempt = 0;
+volatile sig_atomic_t stopRequested = 0;
+
+void handleSignal(int) {
+    stopRequested = 1;
+}
+
+bool ensureMqttConnected() {
+    if (options.dryRun || mqtt.isConnected()) {
+        return true;
+    }
+
+    unsigned long now = millis();
+    if (lastReconnectAttempt != 0 && now - lastReconnectAttempt < MQTT_RECONNECT_INTERVAL) {
+        return false;
+    }
+    lastReconnectAttempt = now;
+
+    if (!mqtt.connect(options.mqtt)) {
+        return false;
+    }
+    mqtt.publish(topicStatus.c_str(), "online", true);
+    return true;
+}
+
+float updateFlowRate(const IzarReading* reading) {
+    FlowWindow& window = flowWindows[reading->meterId];
+    unsigned long now = millis();
+    window.readings[window.head] = reading->current_reading;
+    window.times[window.head] = now;
+    window.head = (window.head + 1) % FlowWindow::kSize;
+    if (window.count < FlowWindow::kSize) {
+        window.count++;
+    }
+
+    if (window.count < 2) {
+        return 0.0f;
+    }
+
+    size_t oldestIndex = (window.head + FlowWindow::kSize - window.count) % FlowWindow::kSize;
+    size_t newestIndex = (window.head + FlowWindow::kSize - 1) % FlowWindow::kSize;
+    float deltaLiters = (window.readings[newestIndex] - window.readings[oldestIndex]) * 1000.0f;
+    unsigned long deltaMs = window.times[newestIndex] - window.times[oldestIndex];
+    if (deltaMs > 0 && deltaLiters >= 1.0f) {
+        return (deltaLiters * 3600000.0f) / static_cast<float>(deltaMs);
+    }
+    return 0.0f;
+}
+
+void izarDataCallback(const IzarReading* reading) {
+    const IzarAlarms& alarms = reading->alarms;
+    char json[MQTT_MAX_PACKET_SIZE];
+    snprintf(json, sizeof(json),
+             "{\"meter_id\":\"%s\",\"current_reading\":%.3f,\"h0_reading\":%.3f,\"unit\":\"%s\","
+             "\"battery_years\":%.1f,\"radio_interval\":%u,\"meter_rssi\":%d,\"flow_rate\":%.2f,"
+             "\"h0_date\":\"%04u-%02u-%02u\",\"alarms\":{\"general\":%s,\"leakage_current\":%s,"
+             "\"leakage_previous\":%s,\"meter_blocked\":%s,\"back_flow\":%s,\"underflow\":%s,\"overflow\":%s,"
+             "\"submarine\":%s,\"sensor_fraud_current\":%s,\"sensor_fraud_previous\":%s,"
+             "\"mechanical_fraud_current\":%s,\"mechanical_fraud_previous\":%s}}",
+             reading->meterId, reading->current_reading, reading->h0_reading,
+             reading->unit_type == VOLUME_CUBIC_METER ? "m3" : "unknown", reading->remaining_battery_life,
+             reading->radio_interval, reading->rssi, updateFlowRate(reading), reading->h0_year, reading->h0_month,
+             reading->h0_day, alarms.general_alarm ? "true" : "false", alarms.leakage_currently ? "true" : "false",
+             alarms.leakage_previously ? "true" : "false", alarms.meter_blocked ? "true" : "false",
+             alarms.back_flow ? "true" : "false", alarms.underflow ? "true" : "false",
+             alarms.overflow ? "true" : "false", alarms.submarine ? "true" : "false",
+             alarms.sensor_fraud_currently ? "true" : "false", alarms.sensor_fraud_previously ? "true" : "false",
+             alarms.mechanical_fraud_currently ? "true" : "false",
+             alarms.mechanical_fraud_previously ? "true" : "false");
+
+    if (options.dryRun) {
+        printf("%s\n", json);
+        fflush(stdout);
+        return;
+    }
+
+    if (ensureMqttConnected()) {
+        mqtt.publish(topicReading.c_str(), json);
+    }
+}
+
+void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                         uint8_t* tplData, uint8_t tplDataLen, int16_t rssi) {
+    if (!options.meterFilter.empty() && options.meterFilter != meterId) {
+        return;
+    }
+
+    if (tplDataLen > 0 && fullwMBusFrameLen >= PRIOS_MIN_FRAME_LENGTH) {
+        priosHandler.processPayload(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
+    }
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -i, --input SPEC        stdin (default), file:PATH, tty:DEVICE[@BAUD] or tcp:HOST:PORT\n"
+            "  -f, --format FORMAT     hex (default, one frame per line: <hex> [rssi]), binary (%d-byte records),\n"
+            "                          cu8 (rtl_sdr 8-bit I/Q) or cf32 (float I/Q), I/Q is demodulated in software\n"
+            "  -s, --sample-rate SPS   I/Q sample rate (default 1000000)\n"
+            "  -H, --mqtt-host HOST    MQTT broker (default localhost)\n"
+            "  -p, --mqtt-port PORT    MQTT port (default %d)\n"
+            "  -u, --mqtt-user USER    MQTT username\n"
+            "  -P, --mqtt-password PW  MQTT password\n"
+            "  -c, --client-id ID      MQTT client ID (default %s)\n"
+            "  -t, --base-topic TOPIC  Base topic (default %s)\n"
+            "  -m, --meter ID          Only publish readings for this meter\n"
+            "  -n, --dry-run           Print readings as JSON on stdout instead of publishing\n",
+            program, FSK_MODEM_RX_MAX_LENGTH, MQTT_PORT_DEFAULT, MQTT_CLIENT_ID_DEFAULT, MQTT_BASE_TOPIC_DEFAULT);
+}
+
+bool parseArguments(int argc, char** argv) {
+    static const option longOptions[] = {
+        {"input", required_argument, nullptr, 'i'},         {"format", required_argument, nullptr, 'f'},
+        {"sample-rate", required_argument, nullptr, 's'},   {"mqtt-host", required_argument, nullptr, 'H'},
+        {"mqtt-port", required_argument, nullptr, 'p'},     {"mqtt-user", required_argument, nullptr, 'u'},
+        {"mqtt-password", required_argument, nullptr, 'P'}, {"client-id", required_argument, nullptr, 'c'},
+        {"base-topic", required_argument, nullptr, 't'},    {"meter", required_argument, nullptr, 'm'},
+        {"dry-run", no_argument, nullptr, 'n'},             {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    options.mqtt.port = MQTT_PORT_DEFAULT;
+    options.mqtt.clientId = MQTT_CLIENT_ID_DEFAULT;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "i:f:s:H:p:u:P:c:t:m:nh", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 'i':
+            options.input = optarg;
+            break;
+        case 'f':
+            if (strcmp(optarg, "binary") == 0) {
+                options.format = FrameFormat::BINARY;
+            } else if (strcmp(optarg, "cu8") == 0) {
+                options.format = FrameFormat::IQ_U8;
+            } else if (strcmp(optarg, "cf32") == 0) {
+                options.format = FrameFormat::IQ_F32;
+            } else if (strcmp(optarg, "hex") != 0) {
+                fprintf(stderr, "Unknown format: %s\n", optarg);
+                return false;
+            }
+            break;
+        case 's':
+            options.sampleRate = strtof(optarg, nullptr);
+            break;
+        case 'H':
+            options.mqtt.host = optarg;
+            break;
+        case 'p':
+            options.mqtt.port = static_cast<uint16_t>(atoi(optarg));
+            break;
+        case 'u':
+            options.mqtt.username = optarg;
+            break;
+        case 'P':
+            options.mqtt.password = optarg;
+            break;
+        case 'c':
+            options.mqtt.clientId = optarg;
+            break;
+        case 't':
+            options.baseTopic = optarg;
+            break;
+        case 'm':
+            options.meterFilter = optarg;
+            break;
+        case 'n':
+            options.dryRun = true;
+            break;
+        default:
+            return false;
+        }
+    }
+
+    while (!options.baseTopic.empty() && options.baseTopic.back() == '/') {
+        options.baseTopic.pop_back();
+    }
+    topicStatus = options.baseTopic + "/status";
+    topicReading = options.baseTopic + "/reading";
+    options.mqtt.willTopic = topicStatus;
+    options.mqtt.willMessage = "offline";
+    return true;
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    if (!parseArguments(argc, argv)) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    signal(SIGINT, handleSignal);
+    signal(SIGTERM, handleSignal);
+
+    wmBusHandler.init();
+    wmBusHandler.setPacketCallback(wmBusPacketCallback);
+    priosHandler.init();
+    izarHandler.init();
+    izarHandler.setDataCallback(izarDataCallback);
+
+    FrameSource source;
+    if (!source.open(options.input, options.format, options.sampleRate)) {
+        return 1;
+    }
+    ensureMqttConnected();
+
+    RawFrame frame;
+    while (!stopRequested) {
+        FrameReadResult result = source.read(frame, 1000);
+        if (result == FrameReadResult::END) {
+            break;
+        }
+        if (result == FrameReadResult::FRAME) {
+            wmBusHandler.processRawPacket(frame.data, frame.length, frame.rssi);
+        }
+        if (!options.dryRun) {
+            mqtt.handle();
+            ensureMqttConnected();
+        }
+    }
+
+    if (mqtt.isConnected()) {
+        mqtt.publish(topicStatus.c_str(), "offline", true);
+        mqtt.disconnect();
+    }
+    return 0;
+}
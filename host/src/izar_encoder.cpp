@@ -0,0 +1,198 @@
+#include "izar_encoder.h"
+
+namespace {
+// 3-out-of-6 code words, inverse of WmBusHandler::decode3outof6Nibble
+const uint8_t kEncode3outof6[16] = {0x16, 0x0D, 0x0E, 0x0B, 0x1C, 0x19, 0x1A, 0x13,
+                                    0x2C, 0x25, 0x26, 0x23, 0x34, 0x31, 0x32, 0x29};
+
+inline void writeUint32LE(uint8_t* data, uint32_t value) {
+    data[0] = value & 0xFF;
+    data[1] = (value >> 8) & 0xFF;
+    data[2] = (value >> 16) & 0xFF;
+    data[3] = (value >> 24) & 0xFF;
+}
+
+// Letters in IZAR meter IDs and manufacturer codes are 5-bit values offset from '@'
+inline bool isCode5(char c) {
+    return c >= '@' && c <= '_';
+}
+
+// Scale a reading to the integer units sent on air, false if it does not fit 32 bits
+bool toCounts(float value, int8_t exponent, uint32_t* counts) {
+    double scaled = value / pow(10.0, exponent);
+    if (!(scaled >= 0.0) || scaled > 4294967295.0) {
+        return false;
+    }
+    *counts = static_cast<uint32_t>(llround(scaled));
+    return true;
+}
+} // namespace
+
+uint32_t IzarEncoder::nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Inverse of the meter ID decoding in WmBusHandler::parseDataLinkLayerHeader()
+bool IzarEncoder::encodeAddress(const char* meterId, uint8_t* address) {
+    if (!meterId || strlen(meterId) != 11 || !isCode5(meterId[0]) || !isCode5(meterId[3]) || !isCode5(meterId[4])) {
+        return false;
+    }
+    uint32_t number = 0;
+    for (int i : {1, 2, 5, 6, 7, 8, 9, 10}) {
+        if (meterId[i] < '0' || meterId[i] > '9') {
+            return false;
+        }
+        number = number * 10 + (meterId[i] - '0');
+    }
+    // Year and serial share a 26-bit field, so years above 67 cannot be represented
+    if (number >= (1UL << 26)) {
+        return false;
+    }
+
+    uint8_t supplier = meterId[0] - '@';
+    uint8_t meterType = meterId[3] - '@';
+    uint8_t diameter = meterId[4] - '@';
+
+    address[0] = number & 0xFF;
+    address[1] = (number >> 8) & 0xFF;
+    address[2] = (number >> 16) & 0xFF;
+    address[3] = ((number >> 24) & 0x03) | ((diameter & 0x07) << 5);
+    address[4] = ((supplier & 0x01) << 7) | ((meterType & 0x1F) << 2) | ((diameter >> 3) & 0x03); // Version
+    address[5] = (supplier >> 1) & 0x0F;                                                          // Device type
+    return true;
+}
+
+// Inverse of IzarHandler::parseReading(): CI, three status bytes, units, then the 0x4B marker, current and H0
+// readings and H0 date (the part PRIOS encrypts)
+bool IzarEncoder::buildPayload(const IzarReading& reading, int8_t multiplierExponent, uint8_t* payload) {
+    if (multiplierExponent < -6 || multiplierExponent > 1) {
+        return false;
+    }
+
+    // Radio interval is sent as a power of two exponent; parseReading() keeps it in a uint8_t
+    uint8_t intervalCode = 0;
+    while (intervalCode < 16 && static_cast<uint8_t>(1 << (intervalCode + 2)) != reading.radio_interval) {
+        intervalCode++;
+    }
+    if (intervalCode == 16) {
+        return false;
+    }
+
+    uint32_t current;
+    uint32_t h0;
+    if (!toCounts(reading.current_reading, multiplierExponent, &current) ||
+        !toCounts(reading.h0_reading, multiplierExponent, &h0)) {
+        return false;
+    }
+
+    // Two-digit year: 81-99 decode as 19xx, 00-80 as 20xx; seven bits on air
+    if (reading.h0_year < 1981 || reading.h0_year > 2080 || reading.h0_month > 15 || reading.h0_day > 31) {
+        return false;
+    }
+    uint8_t year = reading.h0_year % 100;
+
+    uint8_t battery = static_cast<uint8_t>(lroundf(reading.remaining_battery_life * 2.0f));
+    const IzarAlarms& alarms = reading.alarms;
+
+    payload[0] = IZAR_ENCODER_CI_FIELD;
+    payload[IZAR_OFFSET_STATUS_0] =
+        (alarms.general_alarm << 7) | ((reading.random_generator & 0x03) << 4) | (intervalCode & 0x0F);
+    payload[IZAR_OFFSET_STATUS_1] = (alarms.leakage_currently << 7) | (alarms.leakage_previously << 6) |
+                                    (alarms.meter_blocked << 5) | (battery & 0x1F);
+    payload[IZAR_OFFSET_STATUS_2] = (alarms.back_flow << 7) | (alarms.underflow << 6) | (alarms.overflow << 5) |
+                                    (alarms.submarine << 4) | (alarms.sensor_fraud_currently << 3) |
+                                    (alarms.sensor_fraud_previously << 2) | (alarms.mechanical_fraud_currently << 1) |
+                                    alarms.mechanical_fraud_previously;
+    payload[IZAR_OFFSET_UNITS] =
+        ((reading.unit_type == VOLUME_CUBIC_METER ? 0x02 : 0x00) << 3) | ((multiplierExponent + 6) & 0x07);
+    payload[IZAR_OFFSET_MAGIC_BYTE] = 0x4B;
+    writeUint32LE(payload + IZAR_OFFSET_CURRENT_READING, current);
+    writeUint32LE(payload + IZAR_OFFSET_H0_READING, h0);
+    payload[IZAR_OFFSET_H0_DATE_DAY] = (reading.h0_day & 0x1F) | ((year & 0x07) << 5);
+    payload[IZAR_OFFSET_H0_DATE_MONTH] = (reading.h0_month & 0x0F) | (((year >> 3) & 0x0F) << 4);
+    return true;
+}
+
+bool IzarEncoder::buildFrame(const IzarReading& reading, const IzarEncodeOptions& options, uint8_t* frame) {
+    const char* manufacturer = options.manufacturer;
+    if (!manufacturer || strlen(manufacturer) != 3 || !isCode5(manufacturer[0]) || !isCode5(manufacturer[1]) ||
+        !isCode5(manufacturer[2])) {
+        return false;
+    }
+
+    uint16_t mField = ((manufacturer[0] - '@') << 10) | ((manufacturer[1] - '@') << 5) | (manufacturer[2] - '@');
+    frame[WM_BUS_OFFSET_L_FIELD] = IZAR_ENCODER_DECODED_LENGTH - 1 - 2 * WM_BUS_HEADER_CRC_SIZE;
+    frame[WM_BUS_OFFSET_C_FIELD] = IZAR_ENCODER_C_FIELD;
+    frame[WM_BUS_OFFSET_M_FIELD] = mField & 0xFF;
+    frame[WM_BUS_OFFSET_M_FIELD + 1] = mField >> 8;
+    if (!encodeAddress(reading.meterId, frame + WM_BUS_OFFSET_A_FIELD)) {
+        return false;
+    }
+    uint16_t dllCrc = WmBusHandler::calculateCRC16(frame, WM_BUS_HEADER_SIZE);
+    frame[WM_BUS_OFFSET_CRC] = dllCrc >> 8;
+    frame[WM_BUS_OFFSET_CRC + 1] = dllCrc & 0xFF;
+
+    uint8_t* payload = frame + WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE;
+    if (!buildPayload(reading, options.multiplierExponent, payload)) {
+        return false;
+    }
+    // The keystream depends on the plain CI and status bytes (frame bytes 12-15), which are already in place
+    PriosHandler::applyKeystream(options.key, payload + PRIOS_OFFSET_ENCRYPTED_DATA,
+                                 IZAR_MIN_DATA_LENGTH - PRIOS_OFFSET_ENCRYPTED_DATA, frame);
+
+    uint16_t tplCrc = WmBusHandler::calculateCRC16(payload, IZAR_MIN_DATA_LENGTH);
+    payload[IZAR_MIN_DATA_LENGTH] = tplCrc >> 8;
+    payload[IZAR_MIN_DATA_LENGTH + 1] = tplCrc & 0xFF;
+    return true;
+}
+
+// Each nibble becomes a 6-bit code word, MSB first; a trailing partial byte is zero-padded
+uint8_t IzarEncoder::encode3outof6(const uint8_t* decoded, uint8_t decodedLen, uint8_t* encoded) {
+    uint32_t bitBuffer = 0;
+    uint8_t bitsInBuffer = 0;
+    uint8_t encodedLen = 0;
+    for (uint8_t i = 0; i < decodedLen; i++) {
+        bitBuffer = (bitBuffer << 12) | (kEncode3outof6[decoded[i] >> 4] << 6) | kEncode3outof6[decoded[i] & 0x0F];
+        bitsInBuffer += 12;
+        while (bitsInBuffer >= 8) {
+            encoded[encodedLen++] = (bitBuffer >> (bitsInBuffer - 8)) & 0xFF;
+            bitsInBuffer -= 8;
+        }
+    }
+    if (bitsInBuffer > 0) {
+        encoded[encodedLen++] = (bitBuffer << (8 - bitsInBuffer)) & 0xFF;
+    }
+    return encodedLen;
+}
+
+uint8_t IzarEncoder::encode(const IzarReading& reading, const IzarEncodeOptions& options, uint8_t* raw,
+                            uint8_t rawCapacity) {
+    if (options.rawLength < IZAR_ENCODER_RAW_LENGTH || options.rawLength > rawCapacity) {
+        return 0;
+    }
+
+    uint8_t frame[IZAR_ENCODER_DECODED_LENGTH];
+    if (!buildFrame(reading, options, frame)) {
+        return 0;
+    }
+    uint8_t encodedLen = encode3outof6(frame, sizeof(frame), raw);
+    memset(raw + encodedLen, 0, options.rawLength - encodedLen);
+    return options.rawLength;
+}
+
+void IzarEncoder::injectBitErrors(uint8_t* raw, uint8_t length, uint8_t bitErrors, uint32_t& state) {
+    if (length == 0) {
+        return;
+    }
+    for (uint8_t i = 0; i < bitErrors; i++) {
+        uint32_t bit = nextRandom(state) % (length * 8u);
+        raw[bit / 8] ^= 0x80 >> (bit % 8);
+    }
+}
+
+uint8_t IzarEncoder::truncate(uint8_t length, uint32_t& state) {
+    return length > 1 ? 1 + nextRandom(state) % (length - 1) : length;
+}
@@ -0,0 +1,212 @@
+#include "mqtt_client.h"
+#include "config.h"
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+constexpr uint8_t kPacketConnect = 0x10;
+constexpr uint8_t kPacketConnack = 0x20;
+constexpr uint8_t kPacketPublish = 0x30;
+constexpr uint8_t kPacketPingreq = 0xC0;
+constexpr uint8_t kPacketDisconnect = 0xE0;
+
+constexpr uint8_t kFlagUsername = 0x80;
+constexpr uint8_t kFlagPassword = 0x40;
+constexpr uint8_t kFlagWillRetain = 0x20;
+constexpr uint8_t kFlagWillQos1 = 0x08;
+constexpr uint8_t kFlagWill = 0x04;
+constexpr uint8_t kFlagCleanSession = 0x02;
+
+bool readExact(int fd, uint8_t* out, size_t len) {
+    while (len > 0) {
+        ssize_t received = recv(fd, out, len, 0);
+        if (received <= 0) {
+            return false;
+        }
+        out += received;
+        len -= static_cast<size_t>(received);
+    }
+    return true;
+}
+} // namespace
+
+MqttClient::~MqttClient() {
+    disconnect();
+}
+
+void MqttClient::appendString(std::vector<uint8_t>& out, const std::string& text) {
+    out.push_back(static_cast<uint8_t>(text.size() >> 8));
+    out.push_back(static_cast<uint8_t>(text.size() & 0xFF));
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+bool MqttClient::connect(const MqttClientOptions& options) {
+    closeSocket();
+    keepAliveSeconds = options.keepAliveSeconds;
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    std::string port = std::to_string(options.port);
+    if (getaddrinfo(options.host.c_str(), port.c_str(), &hints, &result) != 0) {
+        LOG_ERROR("MQTT", "Cannot resolve %s", options.host.c_str());
+        return false;
+    }
+
+    for (addrinfo* ai = result; ai != nullptr; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) == 0) {
+            break;
+        }
+        ::close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+
+    if (fd < 0) {
+        LOG_ERROR("MQTT", "Connection to %s:%u failed", options.host.c_str(), options.port);
+        return false;
+    }
+
+    timeval timeout{5, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    uint8_t flags = kFlagCleanSession;
+    std::vector<uint8_t> body;
+    appendString(body, "MQTT");
+    body.push_back(4); // Protocol level 3.1.1
+    if (!options.willTopic.empty()) {
+        flags |= kFlagWill | kFlagWillQos1 | kFlagWillRetain;
+    }
+    if (!options.username.empty()) {
+        flags |= kFlagUsername;
+        if (!options.password.empty()) {
+            flags |= kFlagPassword;
+        }
+    }
+    body.push_back(flags);
+    body.push_back(static_cast<uint8_t>(keepAliveSeconds >> 8));
+    body.push_back(static_cast<uint8_t>(keepAliveSeconds & 0xFF));
+    appendString(body, options.clientId);
+    if (flags & kFlagWill) {
+        appendString(body, options.willTopic);
+        appendString(body, options.willMessage);
+    }
+    if (flags & kFlagUsername) {
+        appendString(body, options.username);
+    }
+    if (flags & kFlagPassword) {
+        appendString(body, options.password);
+    }
+
+    uint8_t connack[4];
+    if (!sendPacket(kPacketConnect, body) || !readExact(fd, connack, sizeof(connack)) ||
+        connack[0] != kPacketConnack) {
+        LOG_ERROR("MQTT", "No CONNACK from broker");
+        closeSocket();
+        return false;
+    }
+    if (connack[3] != 0) {
+        LOG_ERROR("MQTT", "Connection refused, rc=%d", connack[3]);
+        closeSocket();
+        return false;
+    }
+
+    LOG_INFO("MQTT", "Connected to %s:%u", options.host.c_str(), options.port);
+    return true;
+}
+
+void MqttClient::disconnect() {
+    if (fd >= 0) {
+        sendPacket(kPacketDisconnect, {});
+        closeSocket();
+    }
+}
+
+void MqttClient::closeSocket() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void MqttClient::handle() {
+    if (fd < 0) {
+        return;
+    }
+
+    // Drain PINGRESP and anything else the broker sends (we never subscribe)
+    pollfd pfd{fd, POLLIN, 0};
+    while (poll(&pfd, 1, 0) > 0) {
+        uint8_t buffer[256];
+        ssize_t received = recv(fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received <= 0) {
+            LOG_WARN("MQTT", "Broker closed the connection");
+            closeSocket();
+            return;
+        }
+    }
+
+    if (millis() - lastSendTime >= keepAliveSeconds * 1000UL / 2) {
+        sendPacket(kPacketPingreq, {});
+    }
+}
+
+bool MqttClient::publish(const char* topic, const uint8_t* payload, size_t length, bool retain) {
+    if (fd < 0) {
+        return false;
+    }
+
+    std::vector<uint8_t> body;
+    body.reserve(2 + strlen(topic) + length);
+    appendString(body, topic);
+    body.insert(body.end(), payload, payload + length);
+
+    bool result = sendPacket(kPacketPublish | (retain ? 0x01 : 0x00), body);
+    if (result) {
+        LOG_DEBUG("MQTT", "Published %u bytes to %s", static_cast<unsigned>(length), topic);
+    } else {
+        LOG_ERROR("MQTT", "Failed to publish to %s", topic);
+    }
+    return result;
+}
+
+bool MqttClient::publish(const char* topic, const char* payload, bool retain) {
+    return publish(topic, reinterpret_cast<const uint8_t*>(payload), strlen(payload), retain);
+}
+
+bool MqttClient::sendPacket(uint8_t header, const std::vector<uint8_t>& body) {
+    std::vector<uint8_t> packet;
+    packet.reserve(body.size() + 5);
+    packet.push_back(header);
+
+    // Remaining length: 7 bits per byte, MSB flags continuation
+    size_t remaining = body.size();
+    do {
+        uint8_t encoded = remaining & 0x7F;
+        remaining >>= 7;
+        if (remaining > 0) {
+            encoded |= 0x80;
+        }
+        packet.push_back(encoded);
+    } while (remaining > 0);
+    packet.insert(packet.end(), body.begin(), body.end());
+
+    size_t sent = 0;
+    while (sent < packet.size()) {
+        ssize_t written = send(fd, packet.data() + sent, packet.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0) {
+            closeSocket();
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    lastSendTime = millis();
+    return true;
+}
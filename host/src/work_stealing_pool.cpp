@@ -0,0 +1,111 @@
+#include "work_stealing_pool.h"
+
+WorkStealingPool::WorkStealingPool(unsigned threadCount)
+    : queues(threadCount > 0 ? threadCount : (std::thread::hardware_concurrency() > 0
+                                                  ? std::thread::hardware_concurrency()
+                                                  : 1)) {
+    // Worker 0 is the thread calling parallelFor(), the others are started once and parked between loops
+    for (unsigned worker = 1; worker < queues.size(); worker++) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, worker);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        stopping = true;
+    }
+    wakeup.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::parallelFor(size_t count, size_t grain, const RangeFunction& function) {
+    if (count == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = 1;
+    }
+
+    // Deal contiguous blocks of ranges to the workers so each starts on its own slice of the input
+    size_t rangeCount = (count + grain - 1) / grain;
+    size_t workers = queues.size();
+    task = &function;
+    remainingRanges.store(rangeCount, std::memory_order_release);
+    for (size_t worker = 0; worker < workers; worker++) {
+        size_t firstRange = rangeCount * worker / workers;
+        size_t lastRange = rangeCount * (worker + 1) / workers;
+        std::lock_guard<std::mutex> lock(queues[worker].mutex);
+        for (size_t r = firstRange; r < lastRange; r++) {
+            size_t begin = r * grain;
+            size_t end = begin + grain < count ? begin + grain : count;
+            queues[worker].ranges.push_back({begin, end});
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(controlMutex);
+        generation++;
+    }
+    wakeup.notify_all();
+
+    runRanges(0);
+
+    std::unique_lock<std::mutex> lock(controlMutex);
+    finished.wait(lock, [this] { return remainingRanges.load(std::memory_order_acquire) == 0; });
+    task = nullptr;
+}
+
+void WorkStealingPool::workerLoop(unsigned worker) {
+    uint64_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(controlMutex);
+            wakeup.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+        }
+        runRanges(worker);
+    }
+}
+
+void WorkStealingPool::runRanges(unsigned worker) {
+    // No ranges are added while a loop runs, so once every queue is empty this worker is done
+    Range range;
+    while (popLocal(worker, range) || steal(worker, range)) {
+        (*task)(range.begin, range.end, worker);
+        if (remainingRanges.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(controlMutex);
+            finished.notify_all();
+        }
+    }
+}
+
+bool WorkStealingPool::popLocal(unsigned worker, Range& range) {
+    Queue& queue = queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) {
+        return false;
+    }
+    range = queue.ranges.back();
+    queue.ranges.pop_back();
+    return true;
+}
+
+bool WorkStealingPool::steal(unsigned worker, Range& range) {
+    size_t workers = queues.size();
+    for (size_t offset = 1; offset < workers; offset++) {
+        Queue& victim = queues[(worker + offset) % workers];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.ranges.empty()) {
+            range = victim.ranges.front();
+            victim.ranges.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
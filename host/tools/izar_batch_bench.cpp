@@ -0,0 +1,195 @@
+// Batch decoder throughput: frames/s per thread count on a corpus of raw 3-out-of-6 frames
+
+#include <Arduino.h>
+#include <getopt.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "batch_decoder.h"
+#include "izar_encoder.h"
+
+namespace {
+struct Corpus {
+    std::vector<uint8_t> frames; // FSK_MODEM_RX_MAX_LENGTH bytes per record
+    std::vector<uint8_t> lengths;
+    std::vector<int16_t> rssi;
+};
+
+// Synthetic corpus: eight meters round-robin, one frame in eight with a flipped bit so the rejection paths are
+// part of the mix
+Corpus buildCorpus(size_t count) {
+    Corpus corpus;
+    corpus.frames.assign(count * FSK_MODEM_RX_MAX_LENGTH, 0);
+    corpus.lengths.assign(count, FSK_MODEM_RX_MAX_LENGTH);
+    corpus.rssi.resize(count);
+
+    IzarReading meters[8] = {};
+    for (size_t m = 0; m < 8; m++) {
+        snprintf(meters[m].meterId, sizeof(meters[m].meterId), "O%02uFS%06u", static_cast<unsigned>(10 + m),
+                 static_cast<unsigned>(649426 + 1111 * m));
+        meters[m].current_reading = 12.345f * (m + 1);
+        meters[m].unit_type = VOLUME_CUBIC_METER;
+        meters[m].radio_interval = 32;
+        meters[m].remaining_battery_life = 6.0f;
+        meters[m].h0_year = 2024;
+        meters[m].h0_month = 12;
+        meters[m].h0_day = 31;
+    }
+
+    IzarEncodeOptions options;
+    uint32_t state = 0x2545F491;
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* frame = corpus.frames.data() + i * FSK_MODEM_RX_MAX_LENGTH;
+        IzarReading& reading = meters[i % 8];
+        reading.current_reading += 0.001f;
+        IzarEncoder::encode(reading, options, frame, FSK_MODEM_RX_MAX_LENGTH);
+
+        uint32_t random = IzarEncoder::nextRandom(state);
+        corpus.rssi[i] = static_cast<int16_t>(-40 - static_cast<int16_t>(random % 60));
+        if (random % 8 == 0) {
+            IzarEncoder::injectBitErrors(frame, IZAR_ENCODER_RAW_LENGTH, 1, state);
+        }
+    }
+    return corpus;
+}
+
+// Corpus written by izar-encode --format binary
+bool loadCorpus(const char* path, Corpus& corpus) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return false;
+    }
+    uint8_t record[FSK_MODEM_RX_MAX_LENGTH];
+    while (fread(record, 1, sizeof(record), file) == sizeof(record)) {
+        corpus.frames.insert(corpus.frames.end(), record, record + sizeof(record));
+        corpus.lengths.push_back(FSK_MODEM_RX_MAX_LENGTH);
+        corpus.rssi.push_back(0);
+    }
+    fclose(file);
+    return !corpus.lengths.empty();
+}
+
+// Position-weighted summary used to check that every thread count produced the same results
+uint64_t checksum(const BatchDecodeResults& results) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        uint64_t value =
+            static_cast<uint64_t>(results.result[i]) | (static_cast<uint64_t>(results.wmBusStatus[i]) << 8);
+        if (results.result[i] == BatchFrameResult::DECODED) {
+            value ^= results.meterKeys[i] ^ static_cast<uint64_t>(results.readings[i].current_reading * 1000.0f);
+        }
+        sum += value * (i + 1);
+    }
+    return sum;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -n, --frames N    Corpus size (default 1000000)\n"
+            "  -t, --threads N   Highest thread count to measure (default: all cores)\n"
+            "  -r, --rounds N    Timed rounds per thread count, best one is reported (default 3)\n"
+            "  -i, --input FILE  Use a corpus from izar-encode --format binary instead of the built-in one\n",
+            program);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    static const option longOptions[] = {{"frames", required_argument, nullptr, 'n'},
+                                         {"threads", required_argument, nullptr, 't'},
+                                         {"rounds", required_argument, nullptr, 'r'},
+                                         {"input", required_argument, nullptr, 'i'},
+                                         {"help", no_argument, nullptr, 'h'},
+                                         {nullptr, 0, nullptr, 0}};
+
+    size_t frameCount = 1000000;
+    unsigned maxThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+    unsigned rounds = 3;
+    const char* input = nullptr;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:t:r:i:h", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 'n':
+            frameCount = strtoul(optarg, nullptr, 10);
+            break;
+        case 't':
+            maxThreads = static_cast<unsigned>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'r':
+            rounds = static_cast<unsigned>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'i':
+            input = optarg;
+            break;
+        default:
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (frameCount == 0 || maxThreads == 0 || rounds == 0) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    Corpus corpus;
+    if (input) {
+        if (!loadCorpus(input, corpus)) {
+            return 1;
+        }
+        frameCount = corpus.lengths.size();
+    } else {
+        corpus = buildCorpus(frameCount);
+    }
+    printf("%zu frames, %u hardware threads\n", frameCount, std::thread::hardware_concurrency());
+    printf("%8s %14s %14s %9s\n", "threads", "frames/s", "frames/s/core", "speedup");
+
+    // 1, 2, 4, ... plus the requested maximum
+    std::vector<unsigned> threadCounts;
+    for (unsigned threads = 1; threads < maxThreads; threads *= 2) {
+        threadCounts.push_back(threads);
+    }
+    threadCounts.push_back(maxThreads);
+
+    BatchDecodeResults results;
+    double singleThreadRate = 0.0;
+    uint64_t referenceChecksum = 0;
+    size_t decodedFrames = 0;
+    for (unsigned threads : threadCounts) {
+        BatchDecoder decoder(threads);
+        decoder.decode(corpus.frames.data(), FSK_MODEM_RX_MAX_LENGTH, corpus.lengths.data(), corpus.rssi.data(),
+                       frameCount, results); // Warm-up, also faults in the result arrays
+
+        double bestSeconds = 0.0;
+        for (unsigned round = 0; round < rounds; round++) {
+            auto start = std::chrono::steady_clock::now();
+            decoder.decode(corpus.frames.data(), FSK_MODEM_RX_MAX_LENGTH, corpus.lengths.data(), corpus.rssi.data(),
+                           frameCount, results);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            if (round == 0 || seconds < bestSeconds) {
+                bestSeconds = seconds;
+            }
+        }
+
+        uint64_t sum = checksum(results);
+        if (threads == threadCounts.front()) {
+            referenceChecksum = sum;
+            for (size_t i = 0; i < results.size(); i++) {
+                decodedFrames += results.result[i] == BatchFrameResult::DECODED;
+            }
+        } else if (sum != referenceChecksum) {
+            fprintf(stderr, "Results with %u threads differ from the single-threaded run\n", threads);
+            return 1;
+        }
+
+        double rate = frameCount / bestSeconds;
+        if (singleThreadRate == 0.0) {
+            singleThreadRate = rate;
+        }
+        printf("%8u %14.0f %14.0f %8.2fx\n", threads, rate, rate / threads, rate / singleThreadRate);
+    }
+
+    printf("%zu of %zu frames decoded to readings\n", decodedFrames, frameCount);
+    return decodedFrames > 0 ? 0 : 1;
+}
@@ -0,0 +1,261 @@
+// Synthetic IZAR frame generator: corpora for benchmarks and izar-bridge, plus round-trip checks of the decoder
+
+#include <Arduino.h>
+#include <getopt.h>
+#include <string>
+#include <vector>
+#include "izar_encoder.h"
+
+namespace {
+struct Options {
+    size_t frameCount = 1000;
+    size_t meterCount = 8;
+    bool binary = false;
+    std::string output;
+    uint8_t bitErrors = 1;
+    double errorRate = 0.0;
+    double truncateRate = 0.0;
+    uint32_t seed = 1;
+    size_t verifyCount = 0;
+};
+
+double nextUnit(uint32_t& state) {
+    return IzarEncoder::nextRandom(state) / 4294967296.0;
+}
+
+// Meter identity of meter `index`, stable for a given seed
+void makeMeterId(size_t index, uint32_t seed, char* meterId, size_t size) {
+    uint32_t state = seed * 2654435761u + static_cast<uint32_t>(index) * 40503u + 1;
+    uint32_t a = IzarEncoder::nextRandom(state);
+    uint32_t b = IzarEncoder::nextRandom(state);
+    snprintf(meterId, size, "%c%02u%c%c%06u", 'A' + a % 26, 10 + (a >> 8) % 50, 'A' + (a >> 16) % 26,
+             'A' + (a >> 24) % 26, static_cast<unsigned>(b % 1000000));
+}
+
+// Fully random reading in the representable range, for the round-trip check
+void randomReading(uint32_t& state, IzarReading* reading) {
+    memset(reading, 0, sizeof(*reading));
+    makeMeterId(IzarEncoder::nextRandom(state), IzarEncoder::nextRandom(state), reading->meterId,
+                sizeof(reading->meterId));
+    // Below 2^24 litres so the float round trip is exact
+    reading->current_reading = (IzarEncoder::nextRandom(state) & 0xFFFFFF) / 1000.0f;
+    reading->h0_reading = (IzarEncoder::nextRandom(state) & 0xFFFFFF) / 1000.0f;
+    reading->unit_type = VOLUME_CUBIC_METER;
+    reading->radio_interval = static_cast<uint8_t>(1 << (2 + IzarEncoder::nextRandom(state) % 6));
+    reading->random_generator = IzarEncoder::nextRandom(state) % 4;
+    reading->remaining_battery_life = (IzarEncoder::nextRandom(state) % 32) / 2.0f;
+    reading->h0_year = 1981 + IzarEncoder::nextRandom(state) % 100;
+    reading->h0_month = 1 + IzarEncoder::nextRandom(state) % 12;
+    reading->h0_day = 1 + IzarEncoder::nextRandom(state) % 31;
+
+    uint32_t flags = IzarEncoder::nextRandom(state);
+    IzarAlarms& alarms = reading->alarms;
+    alarms.general_alarm = (flags >> 0) & 1;
+    alarms.leakage_currently = (flags >> 1) & 1;
+    alarms.leakage_previously = (flags >> 2) & 1;
+    alarms.meter_blocked = (flags >> 3) & 1;
+    alarms.back_flow = (flags >> 4) & 1;
+    alarms.underflow = (flags >> 5) & 1;
+    alarms.overflow = (flags >> 6) & 1;
+    alarms.submarine = (flags >> 7) & 1;
+    alarms.sensor_fraud_currently = (flags >> 8) & 1;
+    alarms.sensor_fraud_previously = (flags >> 9) & 1;
+    alarms.mechanical_fraud_currently = (flags >> 10) & 1;
+    alarms.mechanical_fraud_previously = (flags >> 11) & 1;
+}
+
+// Runs raw bytes through the same stateless stages as the firmware callback chain
+bool decodeReading(const uint8_t* raw, uint8_t length, IzarReading* reading) {
+    WmBusFrame frame;
+    return WmBusHandler::decodeFrame(raw, length, &frame) == WmBusDecodeStatus::OK &&
+           PriosHandler::decryptPayload(frame.data, frame.length, frame.tplData(), frame.tplDataLen) &&
+           IzarHandler::parseReading(frame.header.meterId, frame.tplData(), frame.tplDataLen, 0, reading);
+}
+
+bool sameReading(const IzarReading& a, const IzarReading& b) {
+    return strcmp(a.meterId, b.meterId) == 0 && a.current_reading == b.current_reading &&
+           a.h0_reading == b.h0_reading && a.unit_type == b.unit_type && a.radio_interval == b.radio_interval &&
+           a.random_generator == b.random_generator && a.remaining_battery_life == b.remaining_battery_life &&
+           a.h0_year == b.h0_year && a.h0_month == b.h0_month && a.h0_day == b.h0_day &&
+           memcmp(&a.alarms, &b.alarms, sizeof(a.alarms)) == 0;
+}
+
+// Round-trip properties: every encoded reading decodes to itself; a single flipped bit or a truncation is
+// either rejected or (when it only hits the zero padding) still yields the identical reading
+int verify(const Options& options) {
+    uint32_t state = options.seed ? options.seed : 1;
+    IzarEncodeOptions encodeOptions;
+    size_t failures = 0;
+    size_t corruptedRejected = 0;
+    size_t truncatedRejected = 0;
+
+    for (size_t i = 0; i < options.verifyCount; i++) {
+        IzarReading expected;
+        randomReading(state, &expected);
+        uint8_t raw[FSK_MODEM_RX_MAX_LENGTH];
+        uint8_t length = IzarEncoder::encode(expected, encodeOptions, raw, sizeof(raw));
+
+        IzarReading decoded;
+        if (length == 0 || !decodeReading(raw, length, &decoded) || !sameReading(expected, decoded)) {
+            fprintf(stderr, "Round trip failed for %s (%.3f m3)\n", expected.meterId, expected.current_reading);
+            failures++;
+            continue;
+        }
+
+        uint8_t corrupted[FSK_MODEM_RX_MAX_LENGTH];
+        memcpy(corrupted, raw, length);
+        IzarEncoder::injectBitErrors(corrupted, IZAR_ENCODER_RAW_LENGTH, 1, state);
+        if (!decodeReading(corrupted, length, &decoded)) {
+            corruptedRejected++;
+        } else if (!sameReading(expected, decoded)) {
+            fprintf(stderr, "Single bit error not detected for %s\n", expected.meterId);
+            failures++;
+        }
+
+        uint8_t truncatedLength = IzarEncoder::truncate(length, state);
+        if (!decodeReading(raw, truncatedLength, &decoded)) {
+            truncatedRejected++;
+        } else if (truncatedLength < IZAR_ENCODER_RAW_LENGTH || !sameReading(expected, decoded)) {
+            fprintf(stderr, "Truncation to %u bytes not detected for %s\n", truncatedLength, expected.meterId);
+            failures++;
+        }
+    }
+
+    printf("%zu readings: %zu failures, %zu/%zu bit errors and %zu/%zu truncations rejected\n", options.verifyCount,
+           failures, corruptedRejected, options.verifyCount, truncatedRejected, options.verifyCount);
+    return failures == 0 ? 0 : 1;
+}
+
+int generate(const Options& options) {
+    FILE* out = stdout;
+    if (!options.output.empty()) {
+        out = fopen(options.output.c_str(), options.binary ? "wb" : "w");
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+
+    // Each meter starts at its own reading and advances a few litres per frame
+    std::vector<IzarReading> meters(options.meterCount);
+    uint32_t state = options.seed ? options.seed : 1;
+    for (size_t m = 0; m < meters.size(); m++) {
+        randomReading(state, &meters[m]);
+        makeMeterId(m, options.seed, meters[m].meterId, sizeof(meters[m].meterId));
+        memset(&meters[m].alarms, 0, sizeof(meters[m].alarms));
+        meters[m].radio_interval = 32;
+    }
+
+    IzarEncodeOptions encodeOptions;
+    for (size_t i = 0; i < options.frameCount; i++) {
+        IzarReading& reading = meters[i % meters.size()];
+        reading.current_reading += (IzarEncoder::nextRandom(state) % 16) / 1000.0f;
+
+        uint8_t raw[FSK_MODEM_RX_MAX_LENGTH];
+        uint8_t length = IzarEncoder::encode(reading, encodeOptions, raw, sizeof(raw));
+        if (length == 0) {
+            fprintf(stderr, "Cannot encode reading for %s\n", reading.meterId);
+            return 1;
+        }
+        if (nextUnit(state) < options.errorRate) {
+            IzarEncoder::injectBitErrors(raw, IZAR_ENCODER_RAW_LENGTH, options.bitErrors, state);
+        }
+        if (nextUnit(state) < options.truncateRate) {
+            // Binary records have a fixed size, so a truncated frame is zero-filled after the cut
+            uint8_t cut = IzarEncoder::truncate(IZAR_ENCODER_RAW_LENGTH, state);
+            if (options.binary) {
+                memset(raw + cut, 0, length - cut);
+            } else {
+                length = cut;
+            }
+        }
+
+        if (options.binary) {
+            fwrite(raw, 1, length, out);
+        } else {
+            for (uint8_t b = 0; b < length; b++) {
+                fprintf(out, "%02x", raw[b]);
+            }
+            fprintf(out, " %d\n", -40 - static_cast<int>(IzarEncoder::nextRandom(state) % 60));
+        }
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -n, --frames N          Frames to generate (default 1000)\n"
+            "  -m, --meters N          Distinct meters, frames round-robin over them (default 8)\n"
+            "  -f, --format FORMAT     hex (default, izar-bridge line format) or binary (%d-byte records)\n"
+            "  -o, --output FILE       Output file (default stdout)\n"
+            "  -E, --error-rate P      Fraction of frames with bit errors (default 0)\n"
+            "  -e, --bit-errors N      Bits flipped in each such frame (default 1)\n"
+            "  -T, --truncate-rate P   Fraction of truncated frames (default 0)\n"
+            "  -s, --seed N            Random seed (default 1)\n"
+            "  -V, --verify N          Instead of generating, round-trip N random readings through the decoder\n",
+            program, FSK_MODEM_RX_MAX_LENGTH);
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    static const option longOptions[] = {
+        {"frames", required_argument, nullptr, 'n'},        {"meters", required_argument, nullptr, 'm'},
+        {"format", required_argument, nullptr, 'f'},        {"output", required_argument, nullptr, 'o'},
+        {"error-rate", required_argument, nullptr, 'E'},    {"bit-errors", required_argument, nullptr, 'e'},
+        {"truncate-rate", required_argument, nullptr, 'T'}, {"seed", required_argument, nullptr, 's'},
+        {"verify", required_argument, nullptr, 'V'},        {"help", no_argument, nullptr, 'h'},
+        {nullptr, 0, nullptr, 0}};
+
+    Options options;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "n:m:f:o:E:e:T:s:V:h", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 'n':
+            options.frameCount = strtoul(optarg, nullptr, 10);
+            break;
+        case 'm':
+            options.meterCount = strtoul(optarg, nullptr, 10);
+            break;
+        case 'f':
+            if (strcmp(optarg, "binary") == 0) {
+                options.binary = true;
+            } else if (strcmp(optarg, "hex") != 0) {
+                fprintf(stderr, "Unknown format: %s\n", optarg);
+                return 2;
+            }
+            break;
+        case 'o':
+            options.output = optarg;
+            break;
+        case 'E':
+            options.errorRate = strtod(optarg, nullptr);
+            break;
+        case 'e':
+            options.bitErrors = static_cast<uint8_t>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'T':
+            options.truncateRate = strtod(optarg, nullptr);
+            break;
+        case 's':
+            options.seed = static_cast<uint32_t>(strtoul(optarg, nullptr, 10));
+            break;
+        case 'V':
+            options.verifyCount = strtoul(optarg, nullptr, 10);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.meterCount == 0) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    return options.verifyCount > 0 ? verify(options) : generate(options);
+}
@@ -0,0 +1,367 @@
+// Per-stage decoder cost: ns/op and heap allocations/op for each pipeline stage and the whole chain, after
+// checking every stage against golden vectors. Writes JSON and compares against a previous run.
+
+#include <Arduino.h>
+#include <getopt.h>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <string>
+#include <vector>
+#include "golden_frame.h"
+#include "izar_handler.h"
+#include "prios_handler.h"
+#include "wm_bus_handler.h"
+
+namespace {
+size_t allocationCount = 0;
+
+template <typename T> inline void keep(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct StageResult {
+    std::string name;
+    double nsPerOp = 0.0;
+    double allocsPerOp = 0.0;
+    uint64_t iterations = 0;
+};
+
+// A stage runs its operation `iterations` times per call and returns the elapsed nanoseconds, so the
+// type-erased call only happens once per batch
+struct Stage {
+    const char* name;
+    std::function<double(uint64_t iterations)> runBatch;
+    uint64_t iterations = 0;
+};
+
+template <typename Fn> Stage makeStage(const char* name, Fn fn) {
+    Stage stage;
+    stage.name = name;
+    stage.runBatch = [fn](uint64_t iterations) {
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++) {
+            fn();
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+    return stage;
+}
+
+// Stages are measured in interleaved rounds and each keeps its fastest batch, so a burst of load on the machine
+// slows one batch of every stage rather than all batches of one stage
+const int kRounds = 15;
+
+std::vector<StageResult> measure(std::vector<Stage>& stages, double minSeconds) {
+    double batchNs = minSeconds * 1e9 / kRounds;
+    for (Stage& stage : stages) {
+        uint64_t iterations = 16;
+        double ns;
+        while ((ns = stage.runBatch(iterations)) < batchNs / 8 && iterations < (1ULL << 40)) {
+            iterations *= 8;
+        }
+        stage.iterations = static_cast<uint64_t>(iterations * batchNs / (ns > 0 ? ns : 1)) + 1;
+    }
+
+    std::vector<StageResult> results(stages.size());
+    for (int round = 0; round < kRounds; round++) {
+        for (size_t i = 0; i < stages.size(); i++) {
+            size_t allocationsBefore = allocationCount;
+            double nsPerOp = stages[i].runBatch(stages[i].iterations) / stages[i].iterations;
+            StageResult& r = results[i];
+            r.allocsPerOp += static_cast<double>(allocationCount - allocationsBefore);
+            r.iterations += stages[i].iterations;
+            if (round == 0 || nsPerOp < r.nsPerOp) {
+                r.nsPerOp = nsPerOp;
+            }
+        }
+    }
+    for (size_t i = 0; i < stages.size(); i++) {
+        results[i].name = stages[i].name;
+        results[i].allocsPerOp /= results[i].iterations;
+    }
+    return results;
+}
+
+int checkFailures = 0;
+int checkCount = 0;
+
+void check(bool ok, const char* what) {
+    checkCount++;
+    if (!ok) {
+        fprintf(stderr, "Golden vector mismatch: %s\n", what);
+        checkFailures++;
+    }
+}
+
+// Every stage on the golden frame, plus the rejection of a broken code word and a flipped bit
+bool checkGoldenVectors() {
+    check(WmBusHandler::calculateCRC16(kCrcCheckInput, sizeof(kCrcCheckInput)) == kCrcCheckValue, "CRC check value");
+    check(WmBusHandler::calculateCRC16(kGoldenDecoded, WM_BUS_HEADER_SIZE) == 0xC75E, "DLL CRC");
+    check(WmBusHandler::calculateCRC16(kGoldenDecoded + kTplOffset, kTplLength) == 0xB7C2, "TPL CRC");
+
+    uint8_t decoded[WM_BUS_MAX_PAYLOAD];
+    uint8_t decodedLen = 0;
+    check(WmBusHandler::decode3outof6(kGoldenRaw, sizeof(kGoldenRaw), decoded, &decodedLen) &&
+              decodedLen == sizeof(kGoldenDecoded) && memcmp(decoded, kGoldenDecoded, decodedLen) == 0,
+          "3-out-of-6 decoding");
+    const uint8_t invalidCode[] = {0x36, 0x00};
+    check(!WmBusHandler::decode3outof6(invalidCode, sizeof(invalidCode), decoded, &decodedLen),
+          "invalid 3-out-of-6 code word rejected");
+
+    WmBusDataLinkLayerHeader header;
+    check(WmBusHandler::parseDataLinkLayerHeader(kGoldenDecoded, sizeof(kGoldenDecoded), &header) &&
+              strcmp(header.meterId, kGoldenMeterId) == 0 && strcmp(header.manufacturer, "SAP") == 0 &&
+              header.lField == 0x19 && header.cField == 0x44 && header.crcHeader == 0xC75E,
+          "DLL header");
+
+    uint8_t raw[FSK_MODEM_RX_MAX_LENGTH] = {0};
+    memcpy(raw, kGoldenRaw, sizeof(kGoldenRaw));
+    WmBusFrame frame;
+    check(WmBusHandler::decodeFrame(raw, sizeof(raw), &frame) == WmBusDecodeStatus::OK &&
+              frame.length == sizeof(kGoldenDecoded) && frame.tplDataLen == kTplLength,
+          "frame decoding");
+    raw[20] ^= 0x01;
+    check(WmBusHandler::decodeFrame(raw, sizeof(raw), &frame) != WmBusDecodeStatus::OK, "flipped bit rejected");
+
+    uint8_t tpl[kTplLength];
+    memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+    check(PriosHandler::decryptPayload(kGoldenDecoded, sizeof(kGoldenDecoded), tpl, kTplLength) &&
+              memcmp(tpl, kGoldenPlainTpl, kTplLength) == 0,
+          "PRIOS decryption");
+
+    IzarReading reading;
+    check(IzarHandler::parseReading(kGoldenMeterId, kGoldenPlainTpl, kTplLength, -70, &reading) &&
+              strcmp(reading.meterId, kGoldenMeterId) == 0 && reading.current_reading == 12.345f &&
+              reading.h0_reading == 10.0f && reading.unit_type == VOLUME_CUBIC_METER && reading.h0_year == 2024 &&
+              reading.h0_month == 12 && reading.h0_day == 31 && reading.radio_interval == 32 &&
+              reading.remaining_battery_life == 6.0f && reading.alarms.leakage_previously &&
+              !reading.alarms.leakage_currently && reading.rssi == -70,
+          "IZAR reading");
+
+    return checkFailures == 0;
+}
+
+bool firmwareChainDecoded = false;
+
+void izarDataCallback(const IzarReading* reading) {
+    firmwareChainDecoded = reading->current_reading > 0.0f;
+}
+
+void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                         uint8_t* tplData, uint8_t tplDataLen, int16_t rssi) {
+    priosHandler.processPayload(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
+}
+
+std::vector<StageResult> runStages(double minSeconds) {
+    static uint8_t raw[FSK_MODEM_RX_MAX_LENGTH] = {0};
+    memcpy(raw, kGoldenRaw, sizeof(kGoldenRaw));
+    std::vector<Stage> stages;
+
+    stages.push_back(makeStage("crc16_header", [] {
+        keep(WmBusHandler::calculateCRC16(kGoldenDecoded, WM_BUS_HEADER_SIZE));
+    }));
+    stages.push_back(makeStage("decode_3of6", [] {
+        uint8_t decoded[WM_BUS_MAX_PAYLOAD];
+        uint8_t decodedLen;
+        keep(WmBusHandler::decode3outof6(kGoldenRaw, sizeof(kGoldenRaw), decoded, &decodedLen));
+        keep(decoded);
+    }));
+    stages.push_back(makeStage("parse_dll_header", [] {
+        WmBusDataLinkLayerHeader header;
+        keep(WmBusHandler::parseDataLinkLayerHeader(kGoldenDecoded, sizeof(kGoldenDecoded), &header));
+        keep(header);
+    }));
+    stages.push_back(makeStage("decode_frame", [] {
+        WmBusFrame frame;
+        keep(WmBusHandler::decodeFrame(raw, sizeof(raw), &frame));
+        keep(frame);
+    }));
+    // Decryption is in-place, so each operation includes restoring the 16 encrypted bytes
+    stages.push_back(makeStage("prios_decrypt", [] {
+        uint8_t tpl[kTplLength];
+        memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+        keep(PriosHandler::decryptPayload(kGoldenDecoded, sizeof(kGoldenDecoded), tpl, kTplLength));
+        keep(tpl);
+    }));
+    stages.push_back(makeStage("izar_parse", [] {
+        IzarReading reading;
+        keep(IzarHandler::parseReading(kGoldenMeterId, kGoldenPlainTpl, kTplLength, 0, &reading));
+        keep(reading);
+    }));
+    stages.push_back(makeStage("chain", [] {
+        WmBusFrame frame;
+        IzarReading reading;
+        keep(WmBusHandler::decodeFrame(raw, sizeof(raw), &frame) == WmBusDecodeStatus::OK &&
+             PriosHandler::decryptPayload(frame.data, frame.length, frame.tplData(), frame.tplDataLen) &&
+             IzarHandler::parseReading(frame.header.meterId, frame.tplData(), frame.tplDataLen, 0, &reading));
+        keep(reading);
+    }));
+    // Callback chain as wired in the firmware, including its logging (serial output muted)
+    stages.push_back(makeStage("chain_firmware", [] {
+        keep(wmBusHandler.processRawPacket(raw, sizeof(raw), -70));
+    }));
+    return measure(stages, minSeconds);
+}
+
+bool writeJson(const char* path, const std::vector<StageResult>& results) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write %s\n", path);
+        return false;
+    }
+    fprintf(file, "{\n  \"benchmark\": \"izar-stage-bench\",\n  \"compiler\": \"%s\",\n  \"stages\": [\n", __VERSION__);
+    for (size_t i = 0; i < results.size(); i++) {
+        const StageResult& r = results[i];
+        fprintf(file,
+                "    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"allocs_per_op\": %.3f, \"iterations\": %llu}%s\n",
+                r.name.c_str(), r.nsPerOp, r.allocsPerOp, static_cast<unsigned long long>(r.iterations),
+                i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    return fclose(file) == 0;
+}
+
+// Reads the stage lines of a file written by writeJson()
+bool readJson(const char* path, std::vector<StageResult>& results) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Cannot read %s\n", path);
+        return false;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        const char* entry = strstr(line, "{\"name\"");
+        char name[64];
+        StageResult r;
+        if (entry && sscanf(entry, "{\"name\": \"%63[^\"]\", \"ns_per_op\": %lf, \"allocs_per_op\": %lf", name,
+                            &r.nsPerOp, &r.allocsPerOp) == 3) {
+            r.name = name;
+            results.push_back(r);
+        }
+    }
+    fclose(file);
+    return !results.empty();
+}
+
+// A stage regresses if it got slower by more than maxPercent (and by more than a nanosecond, which is timer
+// noise for the small stages) or allocates more than before
+int compareBaseline(const std::vector<StageResult>& results, const std::vector<StageResult>& baseline,
+                    double maxPercent) {
+    int regressions = 0;
+    printf("\n%-18s %12s %12s %9s\n", "stage", "baseline", "now", "change");
+    for (const StageResult& r : results) {
+        for (const StageResult& b : baseline) {
+            if (b.name != r.name) {
+                continue;
+            }
+            double change = b.nsPerOp > 0 ? 100.0 * (r.nsPerOp - b.nsPerOp) / b.nsPerOp : 0.0;
+            bool slower = change > maxPercent && r.nsPerOp - b.nsPerOp > 1.0;
+            bool allocates = r.allocsPerOp > b.allocsPerOp + 0.001;
+            printf("%-18s %9.1f ns %9.1f ns %+8.1f%%%s%s\n", r.name.c_str(), b.nsPerOp, r.nsPerOp, change,
+                   slower ? "  REGRESSION" : "", allocates ? "  MORE ALLOCATIONS" : "");
+            regressions += (slower || allocates) ? 1 : 0;
+        }
+    }
+    return regressions;
+}
+
+void printUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -t, --time SECONDS      Measuring time per stage (default 0.5)\n"
+            "  -j, --json FILE         Write results as JSON\n"
+            "  -b, --baseline FILE     Compare with a previous --json run, fail on regressions\n"
+            "  -m, --max-regression P  Tolerated slowdown per stage in percent (default 10)\n",
+            program);
+}
+} // namespace
+
+// Counting allocator: every heap allocation in the process goes through here
+void* operator new(size_t size) {
+    allocationCount++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+int main(int argc, char** argv) {
+    static const option longOptions[] = {
+        {"time", required_argument, nullptr, 't'},     {"json", required_argument, nullptr, 'j'},
+        {"baseline", required_argument, nullptr, 'b'}, {"max-regression", required_argument, nullptr, 'm'},
+        {"help", no_argument, nullptr, 'h'},           {nullptr, 0, nullptr, 0}};
+
+    double minSeconds = 0.5;
+    const char* jsonPath = nullptr;
+    const char* baselinePath = nullptr;
+    double maxRegression = 10.0;
+    int opt;
+    while ((opt = getopt_long(argc, argv, "t:j:b:m:h", longOptions, nullptr)) != -1) {
+        switch (opt) {
+        case 't':
+            minSeconds = strtod(optarg, nullptr);
+            break;
+        case 'j':
+            jsonPath = optarg;
+            break;
+        case 'b':
+            baselinePath = optarg;
+            break;
+        case 'm':
+            maxRegression = strtod(optarg, nullptr);
+            break;
+        default:
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (minSeconds <= 0) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<StageResult> baseline;
+    if (baselinePath && !readJson(baselinePath, baseline)) {
+        return 1;
+    }
+
+    if (!checkGoldenVectors()) {
+        return 1;
+    }
+    printf("Golden vectors: %d checks passed\n", checkCount);
+
+    Serial.end();
+    wmBusHandler.setPacketCallback(wmBusPacketCallback);
+    izarHandler.setDataCallback(izarDataCallback);
+    std::vector<StageResult> results = runStages(minSeconds);
+    Serial.begin(115200);
+    if (!firmwareChainDecoded) {
+        fprintf(stderr, "Firmware callback chain did not decode the golden frame\n");
+        return 1;
+    }
+
+    printf("\n%-18s %12s %12s %14s\n", "stage", "ns/op", "allocs/op", "iterations");
+    for (const StageResult& r : results) {
+        printf("%-18s %12.1f %12.3f %14llu\n", r.name.c_str(), r.nsPerOp, r.allocsPerOp,
+               static_cast<unsigned long long>(r.iterations));
+    }
+
+    if (jsonPath && !writeJson(jsonPath, results)) {
+        return 1;
+    }
+    if (!baseline.empty() && compareBaseline(results, baseline, maxRegression) > 0) {
+        fprintf(stderr, "Per-frame cost regressed against %s\n", baselinePath);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,87 @@
+#ifndef BRIDGE_METRICS_H
+#define BRIDGE_METRICS_H
+
+#include <Arduino.h>
+#include <algorithm>
+#include "config.h"
+#include "pipeline_latency.h"
+
+#define METRICS_MAX_METERS 16            // Meters tracked for per-meter RSSI and last-seen metrics
+#define METRICS_LOOP_MAX_WINDOW_MS 60000 // Loop duration maximum covers the current and the previous window
+
+// Last frame seen from one meter (any manufacturer with a valid DLL header)
+struct MeterMetrics {
+    char meterId[16];
+    int16_t rssi;
+    uint32_t frames;
+    unsigned long lastSeenMs;
+};
+
+// Boot progress, in the order the milestones are normally reached
+enum class BootMilestone : uint8_t { RADIO_READY, FIRST_RX, FIRST_PUBLISH, COUNT };
+
+// Runtime counters that no manager owns: loop timing, published readings and the meters in range.
+// Decoder, MQTT and radio counters live in their managers and are read at scrape time.
+class BridgeMetrics {
+  public:
+    void recordLoop(uint32_t durationUs);
+    void recordMeterFrame(const char* meterId, int16_t rssi);
+    void countReadingPublished() { readingsPublished++; }
+    void markBoot(BootMilestone milestone); // Only the first call per milestone counts
+
+    uint32_t getLoopIterations() const { return loopIterations; }
+    uint64_t getLoopTotalUs() const { return loopTotalUs; }
+    uint32_t getLoopMaxUs() const { return std::max(loopMaxUs, previousLoopMaxUs); }
+    uint32_t getReadingsPublished() const { return readingsPublished; }
+    const MeterMetrics& getMeter(size_t index) const { return meters[index]; }
+    uint32_t getBootMs(BootMilestone milestone) const { return bootMs[static_cast<size_t>(milestone)]; } // 0 = not yet
+
+  private:
+    uint32_t loopIterations = 0;
+    uint64_t loopTotalUs = 0;
+    uint32_t loopMaxUs = 0;
+    uint32_t previousLoopMaxUs = 0;
+    unsigned long loopWindowStart = 0;
+    uint32_t readingsPublished = 0;
+    MeterMetrics meters[METRICS_MAX_METERS]{};
+    uint32_t bootMs[static_cast<size_t>(BootMilestone::COUNT)]{};
+};
+
+// Produces the OpenMetrics text exposition a line at a time, for AsyncWebServer chunked responses:
+// a scrape never holds more than one line (and one latency histogram) in memory.
+class MetricsWriter {
+  public:
+    // Fill buffer with the next bytes of the exposition; 0 once "# EOF" has been written
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+  private:
+    static constexpr size_t kLineSize = 255; // One byte short of line[], for the newline
+    char line[kLineSize + 1];
+    size_t lineLength = 0;
+    size_t lineOffset = 0;
+    uint8_t section = 0;
+    uint16_t item = 0;
+#ifdef LATENCY_TRACE_ACTIVE
+    // Latency histogram being written, copied at its first line so its buckets add up
+    LatencyHistogram histogram;
+    uint8_t segment = 0;
+    uint16_t bucket = 0;
+    uint32_t cumulative = 0;
+
+    size_t formatLatencyLine();
+#endif
+
+    bool nextLine();
+    size_t formatLine();
+    size_t finish(int length, size_t offset = 0) const;
+    size_t appendUs(size_t prefix, uint64_t us);
+    size_t formatScalar(const char* name, const char* type, const char* help, const char* suffix, int64_t value);
+    size_t formatSeconds(const char* name, const char* type, const char* help, const char* suffix, uint64_t us);
+    size_t formatMeterLine(const char* name, const char* type, const char* help, const char* suffix);
+    size_t formatSpiHoldLine(const char* name, const char* type, const char* help, const char* suffix);
+    size_t formatBootLine();
+};
+
+extern BridgeMetrics bridgeMetrics;
+
+#endif // BRIDGE_METRICS_H
@@ -0,0 +1,53 @@
+#ifndef BUTTON_ENGINE_H
+#define BUTTON_ENGINE_H
+
+#include <Arduino.h>
+
+// Button event types
+enum class ButtonEvent {
+    BUTTON_EVENT_NONE,
+    BUTTON_EVENT_SHORT_PRESS,
+    BUTTON_EVENT_LONG_PRESS,
+    BUTTON_EVENT_DOUBLE_PRESS
+};
+
+// Debounce and gesture state machine for the user button, independent of the GPIO expander. It is fed the
+// button level after each edge, stamped with the edge time from the interrupt, and needs no I/O in between:
+// a long press is reported once the button has been held long enough, a short press once no second press
+// can follow any more.
+class ButtonEngine {
+  public:
+    static constexpr uint32_t DEBOUNCE_MS = 30;          // Shorter pulses are contact bounce
+    static constexpr uint32_t LONG_PRESS_MS = 2000;      // Held at least this long
+    static constexpr uint32_t DOUBLE_PRESS_GAP_MS = 300; // Longest release between the two presses
+
+    // Level read after an edge; atMs is when the edge happened
+    void onLevel(bool pressed, uint32_t atMs);
+
+    // Timers: long press while held, short press after the double-press gap
+    void poll(uint32_t nowMs);
+
+    // Oldest queued event, BUTTON_EVENT_NONE if there is none
+    ButtonEvent pop();
+
+  private:
+    enum class State : uint8_t {
+        IDLE,
+        PRESSED,        // First press, not yet long
+        RELEASED,       // After a short press, waiting for a second one
+        SECOND_PRESSED, // Second press within the gap
+        WAIT_RELEASE    // Event already reported, ignore the rest of this press
+    };
+    static constexpr uint8_t QUEUE_SIZE = 4;
+
+    State state = State::IDLE;
+    uint32_t pressMs = 0;
+    uint32_t releaseMs = 0;
+    ButtonEvent queue[QUEUE_SIZE]{};
+    uint8_t queueHead = 0;
+    uint8_t queueCount = 0;
+
+    void push(ButtonEvent event); // Drops the event when the queue is full
+};
+
+#endif // BUTTON_ENGINE_H
@@ -12,6 +12,7 @@
 #define WIFI_PASSWORD_DEFAULT "YOUR_PASSWORD"
 #define WIFI_HOSTNAME_DEFAULT "izar-mqtt-bridge"
 #define WIFI_CONNECTION_TIMEOUT 20000 // ms
+#define NTP_SERVER "pool.ntp.org"     // Wall clock for the reading history, set once WiFi is up
 
 // ============ WiFi Access Point Defaults ============
 #define AP_SSID_PREFIX_DEFAULT "izar-mqtt-bridge-config"
@@ -25,6 +26,16 @@
 #define MQTT_PASSWORD_DEFAULT ""
 #define MQTT_BASE_TOPIC_DEFAULT "home/water_meter"
 
+// ============ Raw Frame Forwarding Defaults ============
+#define RAW_FORWARD_MODE_DEFAULT 0      // 0 = off, 1 = hex (rtl_wmbus lines), 2 = binary records
+#define RAW_FORWARD_MAX_BATCH_BYTES 768 // Max payload per MQTT message (must fit MQTT_MAX_PACKET_SIZE)
+#define RAW_FORWARD_MAX_BATCH_FRAMES 16 // Max telegrams per MQTT message
+#define RAW_FORWARD_MAX_LATENCY_MS 2000 // Max time a telegram waits in the batch before publish
+
+// ============ Self-Benchmark ============
+#define SELF_BENCH_DEFAULT_ITERATIONS 200 // Chain runs when /api/bench or the MQTT command gives no count
+#define SELF_BENCH_MAX_ITERATIONS 1000    // Upper bound (4 bytes per stage and iteration of sample buffer)
+
 // ============ IZAR Defaults ============
 #define IZAR_SERIAL_NUMBER_DEFAULT ""
 
@@ -58,7 +69,7 @@
 #define GPIO_EXPANDER_INT_PIN 3        // Interrupt output
 #define GPIO_EXPANDER_RST_PIN -1       // RST (connected to ESP_RST - no GPIO pin needed)
 #define GPIO_EXPANDER_I2C_ADDR 0x43    // I2C address (Unit-C6L specific)
-#define GPIO_EXPANDER_I2C_CLOCK 100000 // I2C clock (100kHz)
+#define GPIO_EXPANDER_I2C_CLOCK 400000 // I2C clock (400kHz, fast mode)
 
 // GPIO Expander Output Pins (E0.Px format)
 #define GPIO_EXPANDER_IO_SYS_KEY1 0  // E0.P0 = SYS_KEY1 (User button)
@@ -76,6 +87,7 @@
 #define DISPLAY_BRIGHTNESS 32        // 0-255
 #define DISPLAY_UPDATE_INTERVAL 1000 // ms
 #define DISPLAY_TIMEOUT 30000        // ms - turn off display after 30 seconds of inactivity
+#define DISPLAY_SPLASH_DURATION 5000 // ms - welcome screen shown at boot
 
 // ============ SPI Configuration ============
 #define SX1262_SSD1306_SPI_FREQUENCY 8000000UL // 8 MHz SPI for display and FSK modem
@@ -98,14 +110,40 @@
 #define ENABLE_FSK_MODEM true // Wireless meter reading via FSK modem
 #define ENABLE_BUZZER true
 #define ENABLE_RGB_LED true
+#ifndef ENABLE_RX_DUTY_CYCLE
+#define ENABLE_RX_DUTY_CYCLE 0 // Bound mode: radio asleep between the meter's predicted frames (1 enables)
+#endif
+#ifndef ENABLE_HISTORY
+#define ENABLE_HISTORY 1 // Readings kept on LittleFS for /api/history (0 leaves the filesystem unmounted)
+#endif
+#ifndef ENABLE_LATENCY_TRACE
+#define ENABLE_LATENCY_TRACE 1 // Per-stage latency histograms, IRQ to MQTT publish (0 compiles them out)
+#endif
+#ifndef ENABLE_SPAN_TRACE
+#define ENABLE_SPAN_TRACE 1 // Loop, pipeline and ISR span ring for /api/trace (0 compiles it out)
+#endif
+#ifndef ENABLE_DEFERRED_LOG
+#define ENABLE_DEFERRED_LOG 1 // Log calls store their arguments, formatted when read (0 formats on every call)
+#endif
 
 // ============ Timing Configuration ============
-#define MQTT_RECONNECT_INTERVAL 5000 // ms
-#define MQTT_PUBLISH_INTERVAL 300000 // ms - publish every 5 minutes
+#define MQTT_RECONNECT_INTERVAL 5000         // ms
+#define MQTT_PUBLISH_INTERVAL 300000         // ms - publish every 5 minutes
+#define LATENCY_PUBLISH_INTERVAL 300000      // ms - latency summary to <base>/latency
+#define SPAN_TRACE_MIN_US 100                // us - shorter loop subsystem spans are not traced
+#define LINK_QUALITY_PUBLISH_INTERVAL 900000 // ms - rejections and per-meter PER to <base>/diagnostics
+#define LOG_SINK_INTERVAL 20                 // ms - log sink task drains the log queue to Serial and the web log
 
 // ============ Memory & Performance ============
 #define MQTT_MAX_PACKET_SIZE 1024
 #define JSON_BUFFER_SIZE 512
+#define SPAN_TRACE_EVENTS 1024 // Span trace ring records (12 bytes each)
+#define LOG_QUEUE_SIZE 4096    // Bytes queued between LOG_* callers and the log sink task (power of two)
+#define LOG_SINK_STACK_SIZE 4096
+
+// Span tracer and log sink (used by the logging macros below)
+#include "span_tracer.h"
+#include "log_sink.h"
 
 // ============ Logging Configuration ============
 // Log levels: 0=NONE, 1=ERROR, 2=WARNING, 3=INFO, 4=DEBUG
@@ -115,58 +153,124 @@
 #define LOG_LEVEL_INFO 3
 #define LOG_LEVEL_DEBUG 4
 
-// Set global log level (change this to control verbosity)
+// Compile-time ceiling: statements above it are compiled out. Below it each tag has a runtime level (see
+// log_levels.h), LOG_LEVEL_DEFAULT until changed from the web log page or over MQTT.
 #ifndef LOG_LEVEL
-#define LOG_LEVEL LOG_LEVEL_INFO
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+#ifndef LOG_LEVEL_DEFAULT
+#ifdef IZAR_HOST_BUILD
+#define LOG_LEVEL_DEFAULT LOG_LEVEL
+#else
+#define LOG_LEVEL_DEFAULT LOG_LEVEL_INFO
+#endif
 #endif
 
-// Logging macros
-#if LOG_LEVEL >= LOG_LEVEL_ERROR
-#define LOG_ERROR(tag, ...)                                                                                            \
+// Per-tag runtime levels (checked by the logging macros below)
+#include "log_levels.h"
+
+// Logging macros. On the device a LOG_* call only queues its record for the log sink task, which prints it to
+// Serial and stores it in the web log. Deferred mode (default) queues the format pointer and the arguments, the
+// line is formatted when the sink or the web log reads it; otherwise the line is formatted by the caller. LOG_ERROR
+// and LOG_WARN wake the sink right away. The host build prints and stores each line immediately.
+#if ENABLE_DEFERRED_LOG && !defined(IZAR_HOST_BUILD)
+#define DEFERRED_LOG_ACTIVE 1
+#endif
+
+// A statement whose tag is below `level` costs one load and branch; its arguments are not evaluated
+#define LOG_ENABLED(tag, level) logLevels.isEnabled(LOG_TAG_ID(tag), level)
+
+#if defined(LOG_SINK_ACTIVE) && defined(DEFERRED_LOG_ACTIVE)
+#define LOG_WRITE(level, label, tag, ...)                                                                              \
+    do {                                                                                                               \
+        if (LOG_ENABLED(tag, level)) {                                                                                 \
+            TRACE_SPAN(LOG);                                                                                           \
+            if (false) {                                                                                               \
+                logFormatCheck(__VA_ARGS__);                                                                           \
+            }                                                                                                          \
+            logSink.logDeferred(level, tag, __VA_ARGS__);                                                              \
+            if (level <= LOG_LEVEL_WARNING) {                                                                          \
+                logSink.wake();                                                                                        \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (0)
+// Bytes as one hex record ("label (n bytes): 0A 1B ..."), copied and formatted when read
+#define LOG_HEX_WRITE(level, label, tag, text, data, length)                                                           \
     do {                                                                                                               \
-        Serial.printf("[ERROR][%s] ", tag);                                                                            \
-        Serial.printf(__VA_ARGS__);                                                                                    \
-        Serial.println();                                                                                              \
-        webLogger.logf(LOG_LEVEL_ERROR, tag, __VA_ARGS__);                                                             \
+        if (LOG_ENABLED(tag, level)) {                                                                                 \
+            TRACE_SPAN(LOG);                                                                                           \
+            logSink.logDeferred(level, tag, text " (%u bytes): %s", static_cast<unsigned>(length),                     \
+                                LogHex{data, static_cast<size_t>(length)});                                            \
+        }                                                                                                              \
     } while (0)
+#elif defined(LOG_SINK_ACTIVE)
+#define LOG_WRITE(level, label, tag, ...)                                                                              \
+    do {                                                                                                               \
+        if (LOG_ENABLED(tag, level)) {                                                                                 \
+            TRACE_SPAN(LOG);                                                                                           \
+            logSink.logf(level, tag, __VA_ARGS__);                                                                     \
+            if (level <= LOG_LEVEL_WARNING) {                                                                          \
+                logSink.wake();                                                                                        \
+            }                                                                                                          \
+        }                                                                                                              \
+    } while (0)
+#define LOG_HEX_WRITE(level, label, tag, text, data, length)                                                           \
+    do {                                                                                                               \
+        if (LOG_ENABLED(tag, level)) {                                                                                 \
+            TRACE_SPAN(LOG);                                                                                           \
+            char logHex_[WEB_LOG_MAX_MESSAGE];                                                                         \
+            formatLogHex(logHex_, sizeof(logHex_), data, length);                                                      \
+            logSink.logf(level, tag, text " (%u bytes): %s", static_cast<unsigned>(length), logHex_);                  \
+        }                                                                                                              \
+    } while (0)
+#else
+#define LOG_WRITE(level, label, tag, ...)                                                                              \
+    do {                                                                                                               \
+        if (LOG_ENABLED(tag, level)) {                                                                                 \
+            TRACE_SPAN(LOG);                                                                                           \
+            Serial.printf("[" label "][%s] ", tag);                                                                    \
+            Serial.printf(__VA_ARGS__);                                                                                \
+            Serial.println();                                                                                          \
+            webLogger.logf(level, tag, __VA_ARGS__);                                                                   \
+        }                                                                                                              \
+    } while (0)
+#define LOG_HEX_WRITE(level, label, tag, text, data, length)                                                           \
+    do {                                                                                                               \
+        if (LOG_ENABLED(tag, level)) {                                                                                 \
+            TRACE_SPAN(LOG);                                                                                           \
+            char logHex_[WEB_LOG_MAX_MESSAGE];                                                                         \
+            formatLogHex(logHex_, sizeof(logHex_), data, length);                                                      \
+            Serial.printf("[" label "][%s] " text " (%u bytes): %s", tag, static_cast<unsigned>(length), logHex_);     \
+            Serial.println();                                                                                          \
+            webLogger.logf(level, tag, text " (%u bytes): %s", static_cast<unsigned>(length), logHex_);                \
+        }                                                                                                              \
+    } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(tag, ...) LOG_WRITE(LOG_LEVEL_ERROR, "ERROR", tag, __VA_ARGS__)
 #else
 #define LOG_ERROR(tag, ...)
 #endif
 
 #if LOG_LEVEL >= LOG_LEVEL_WARNING
-#define LOG_WARN(tag, ...)                                                                                             \
-    do {                                                                                                               \
-        Serial.printf("[WARN][%s] ", tag);                                                                             \
-        Serial.printf(__VA_ARGS__);                                                                                    \
-        Serial.println();                                                                                              \
-        webLogger.logf(LOG_LEVEL_WARNING, tag, __VA_ARGS__);                                                           \
-    } while (0)
+#define LOG_WARN(tag, ...) LOG_WRITE(LOG_LEVEL_WARNING, "WARN", tag, __VA_ARGS__)
 #else
 #define LOG_WARN(tag, ...)
 #endif
 
 #if LOG_LEVEL >= LOG_LEVEL_INFO
-#define LOG_INFO(tag, ...)                                                                                             \
-    do {                                                                                                               \
-        Serial.printf("[INFO][%s] ", tag);                                                                             \
-        Serial.printf(__VA_ARGS__);                                                                                    \
-        Serial.println();                                                                                              \
-        webLogger.logf(LOG_LEVEL_INFO, tag, __VA_ARGS__);                                                              \
-    } while (0)
+#define LOG_INFO(tag, ...) LOG_WRITE(LOG_LEVEL_INFO, "INFO", tag, __VA_ARGS__)
 #else
 #define LOG_INFO(tag, ...)
 #endif
 
 #if LOG_LEVEL >= LOG_LEVEL_DEBUG
-#define LOG_DEBUG(tag, ...)                                                                                            \
-    do {                                                                                                               \
-        Serial.printf("[DEBUG][%s] ", tag);                                                                            \
-        Serial.printf(__VA_ARGS__);                                                                                    \
-        Serial.println();                                                                                              \
-        webLogger.logf(LOG_LEVEL_DEBUG, tag, __VA_ARGS__);                                                             \
-    } while (0)
+#define LOG_DEBUG(tag, ...) LOG_WRITE(LOG_LEVEL_DEBUG, "DEBUG", tag, __VA_ARGS__)
+#define LOG_DEBUG_HEX(tag, text, data, length) LOG_HEX_WRITE(LOG_LEVEL_DEBUG, "DEBUG", tag, text, data, length)
 #else
 #define LOG_DEBUG(tag, ...)
+#define LOG_DEBUG_HEX(tag, text, data, length)
 #endif
 
 // Always print (bypass log level)
@@ -0,0 +1,43 @@
+#ifndef CONFIG_JSON_PARSER_H
+#define CONFIG_JSON_PARSER_H
+
+#include <Arduino.h>
+#include "config_manager.h"
+
+// Incremental parser for the settings object posted by the web portal, {"key":"text" or number,...}. Fed the
+// request body chunk by chunk, it writes each known field straight into a copy of the config, so the body is
+// never buffered. Unknown keys are ignored; nested objects and arrays are rejected. Trivially destructible, so
+// the web server may release it with free().
+class ConfigJsonParser {
+  public:
+    explicit ConfigJsonParser(const Config& base) : config(base) {}
+
+    // False once the input is not valid JSON
+    bool feed(const uint8_t* data, size_t length);
+
+    // True after the closing brace of the object
+    bool isComplete() const { return state == State::DONE; }
+
+    const Config& getConfig() const { return config; }
+
+  private:
+    enum class State : uint8_t { START, KEY_OR_END, STRING, COLON, VALUE, LITERAL, COMMA_OR_END, DONE, ERROR };
+
+    Config config;
+    State state = State::START;
+    bool readingKey = false;
+    bool afterComma = false;
+    uint8_t escape = 0;   // 1 after a backslash, 2-5 while reading the hex digits of \uXXXX
+    uint16_t unicode = 0; // Code point of \uXXXX
+    char key[24]{};
+    size_t keyLength = 0;
+    char value[LOG_LEVELS_SPEC_SIZE]{};
+    size_t valueLength = 0;
+
+    State step(char c);
+    State stepEscape(char c);
+    void append(char c); // To the key or value being read, truncated to fit
+    bool assign(bool isString);
+};
+
+#endif // CONFIG_JSON_PARSER_H
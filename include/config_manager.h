@@ -3,8 +3,23 @@
 
 #include <Arduino.h>
 #include <Preferences.h>
+#include <mutex>
 #include "config.h"
 
+#define CONFIG_APPLY_DELAY 500 // ms - a staged config is applied this long after it was posted (lets the reply go out)
+
+// Groups of settings that differ between two configs, as reported by ConfigManager::applyPending()
+enum ConfigChange : uint8_t {
+    CONFIG_CHANGE_WIFI = 1 << 0,        // SSID or password: re-associate
+    CONFIG_CHANGE_HOSTNAME = 1 << 1,    // mDNS and DHCP hostname
+    CONFIG_CHANGE_MQTT = 1 << 2,        // Broker, port or credentials: reconnect
+    CONFIG_CHANGE_MQTT_TOPICS = 1 << 3, // Base topic or client ID: new topics and discovery
+    CONFIG_CHANGE_METER = 1 << 4,       // Bound meter serial number
+    CONFIG_CHANGE_RAW_FORWARD = 1 << 5, // Raw telegram forwarding mode
+};
+
+// Stored as one binary blob. New fields go at the end: older blobs stay loadable and the missing tail keeps the
+// defaults. Any other layout change needs a new kConfigVersion and a migration in config_manager.cpp.
 struct Config {
     char wifiSSID[33];
     char wifiPassword[65];
@@ -16,24 +31,64 @@ struct Config {
     char mqttPassword[65];
     char mqttClientId[33];
     char mqttBaseTopic[65];
+    uint8_t rawForwardMode; // RawForwardMode: 0 = off, 1 = hex, 2 = binary
 
     char serialNumber[17];
+
+    char logLevels[LOG_LEVELS_SPEC_SIZE]; // Per-tag runtime log levels that differ from LOG_LEVEL_DEFAULT
 };
 
+// Persists Config in NVS as a versioned, CRC-32 checked blob in two slots ("cfg0", "cfg1"). A save writes the
+// slot not holding the newest copy, so a power loss mid-write leaves the previous config readable, and skips
+// the write entirely when nothing changed. The version 1 layout (one key per field) is migrated at boot.
 class ConfigManager {
   public:
     void begin();
     Config& getConfig();
-    void save();
+    // Write the config if it differs from the stored copy; false if unchanged or the write failed
+    bool save();
     void reset();
 
+    // Stage a new config from another task (the web server); the main loop applies it with applyPending().
+    // The portal does not edit log levels, the newest staged or current ones are kept.
+    void requestUpdate(const Config& updated);
+    // Stage new stored log levels from any task, merged into a pending update if there is one
+    void requestLogLevels(const char* spec);
+    // Copy of the config to edit: the staged one while an update is pending
+    Config getSnapshot();
+    // Adopt and save a staged config; returns the ConfigChange bits of what differs from the previous one
+    uint8_t applyPending();
+
   private:
-    void load();
-    void applyDefaults();
+    struct BlobHeader {
+        uint16_t version;
+        uint16_t length;   // Bytes of Config stored
+        uint32_t sequence; // Incremented by every write, the valid slot with the highest one is current
+        uint32_t crc;      // CRC-32 of the Config bytes and the header fields above
+    };
+
+    bool loadBlob();
+    bool readSlot(uint8_t slot, BlobHeader& header, Config& out);
+    void migrateV1();
+    void loadV1();
+    void applyDefaults(Config& out);
     void copyString(char* dest, size_t destSize, const String& src);
+    static void normalize(Config& out); // Zero the bytes after each string terminator
+    // CRC over the header fields and header.length data bytes
+    static uint32_t blobCrc(const BlobHeader& header, const uint8_t* data);
+    static uint8_t compare(const Config& a, const Config& b);
 
     Preferences prefs;
     Config config{};
+    Config stored{};          // Copy last read or written, to skip unchanged writes
+    bool storedValid = false; // stored matches the newest slot byte for byte
+    uint8_t currentSlot = 1;  // Slot holding the newest blob, the next write goes to the other
+    uint32_t sequence = 0;
+
+    std::mutex mutex; // Guards pending and config updates against getSnapshot()
+    Config pending{};
+    volatile bool updatePending = false;
+    unsigned long updateRequested = 0;
 };
 
 extern ConfigManager configManager;
@@ -6,24 +6,36 @@
 #include <M5GFX.h>
 #include "config.h"
 
+// Drawing goes to an off-screen 1 bpp frame; present() compares it with the frame last sent and pushes only the
+// changed columns of each 8-row band (one SSD1306 page), so a static screen costs no SPI traffic at all. Each band
+// is one bounded SPI chunk: the bus is released in between, and the flush stops early when the radio needs it.
 class DisplayManager {
   private:
+    static constexpr int kStride = (DISPLAY_WIDTH + 7) / 8; // Bytes per frame row
+    static constexpr int kBandHeight = 8;
+
     M5GFX display;
+    LGFX_Sprite frame;
+    bool frameReady = false;
+    bool flushPending = false; // present() stopped early for the radio
+    uint8_t shown[DISPLAY_HEIGHT * kStride]{}; // Frame as last pushed to the panel
     SPIClass* spi = nullptr;
     unsigned long lastUpdate = 0;
-
-    // SPI sharing - protect bus access
-    void acquireSPIBus();
-    void releaseSPIBus();
+    bool splashShown = false;
+    unsigned long splashStart = 0;
 
   public:
     DisplayManager();
 
     bool init(SPIClass* sharedSPI);
 
-    void clear();
-    void sleep(); // Turn off display
-    void wake();  // Turn on display
+    void clear();   // Clear the off-screen frame
+    void present(); // Push the regions of the frame that changed since the last call
+    void handle();  // Finish a flush the radio interrupted
+    void sleep();   // Turn off display
+    void wake();    // Turn on display
+
+    bool isSplashShown() const; // Welcome screen still within DISPLAY_SPLASH_DURATION
 
     // Smart print with automatic alignment
     enum class HAlign { LEFT, CENTER, RIGHT };
@@ -32,8 +44,6 @@ class DisplayManager {
     void printAligned(const char* text, HAlign hAlign = HAlign::LEFT, VAlign vAlign = VAlign::TOP,
                       int lineSpacing = -1);
     void drawTimeoutLine(int height); // Draw timeout indicator line (0-48 pixels)
-
-  private:
 };
 
 extern DisplayManager displayManager;
@@ -16,9 +16,15 @@ class FskModemManager {
     SPISettings spiSettings; // SPI configuration
     FskModemCallbackFunction externalCallback = nullptr;
     static volatile bool packetAvailable;
+    static volatile uint32_t packetTimestampUs; // micros() captured in the packet IRQ
     uint8_t packetBuffer[FSK_MODEM_RX_MAX_LENGTH];
     volatile int packetLength = 0;
     int lastRSSI = 0;
+    uint32_t lastPacketTimestampUs = 0;
+    uint32_t packetCount = 0;
+    bool asleep = false;
+    uint32_t sleepStartMs = 0;
+    uint64_t sleepTotalMs = 0;
 
     // Non-static receive handler
     void receive();
@@ -34,6 +40,17 @@ class FskModemManager {
 
     // Callbacks
     void setCallback(FskModemCallbackFunction callback);
+
+    // ISR timestamp (micros) of the packet currently being delivered to the callback
+    uint32_t getLastPacketTimestamp() const { return lastPacketTimestampUs; }
+
+    // Packets read from the SX1262 since boot
+    uint32_t getPacketCount() const { return packetCount; }
+
+    // Put the SX1262 into warm sleep (configuration retained) or back into continuous RX
+    void setListening(bool listening);
+    bool isAsleep() const { return asleep; }
+    uint64_t getSleepTotalMs() const; // Time asleep since boot, including the current sleep
 };
 
 extern FskModemManager fskModemManager;
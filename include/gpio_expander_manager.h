@@ -3,14 +3,12 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "button_engine.h"
 #include "config.h"
 
 // PI4IOE5V6408 I2C GPIO Expander
 // Controls: User Button, SX_LNA_EN, SX_ANT_SW, SX_NRST
 
-// Button event types
-enum class ButtonEvent { BUTTON_EVENT_NONE, BUTTON_EVENT_SHORT_PRESS, BUTTON_EVENT_LONG_PRESS };
-
 class GPIOExpanderManager {
   private:
     uint8_t deviceAddress = GPIO_EXPANDER_I2C_ADDR;
@@ -21,19 +19,18 @@ class GPIOExpanderManager {
 
     // Interrupt handling
     static volatile bool interruptFlag;
+    static volatile uint32_t interruptMs; // Time of the latest edge
     static void IRAM_ATTR handleInterrupt();
 
     // Button state tracking
-    bool buttonPressed = false;
-    unsigned long buttonPressStartTime = 0;
-    static constexpr unsigned long LONG_PRESS_DURATION = 2000; // 2 seconds
+    ButtonEngine button;
 
     // Register addresses for PI4IOE5V6408
     static constexpr uint8_t REG_DEVICE_ID = 0x01;     // Device ID and Control
     static constexpr uint8_t REG_CONFIG = 0x03;        // I/O Direction (0=input, 1=output)
     static constexpr uint8_t REG_OUTPUT = 0x05;        // Output Port Register
     static constexpr uint8_t REG_HIGH_Z = 0x07;        // Output High-Impedance
-    static constexpr uint8_t REG_INPUT_DEFAULT = 0x09; // Input Default State
+    static constexpr uint8_t REG_INPUT_DEFAULT = 0x09; // Input Default State (interrupt while an input differs)
     static constexpr uint8_t REG_PULL_ENABLE = 0x0B;   // Pull-Up/Down Enable
     static constexpr uint8_t REG_PULL_SELECT = 0x0D;   // Pull-Up/Down Select
     static constexpr uint8_t REG_INPUT = 0x0F;         // Input Status (current input levels)
@@ -51,6 +48,7 @@ class GPIOExpanderManager {
 
     bool readRegister(uint8_t reg, uint8_t& value);
     bool writeRegister(uint8_t reg, uint8_t value);
+    bool readButtonLevel(bool& pressed); // Clears the interrupt and re-arms it for the opposite edge
 
   public:
     GPIOExpanderManager();
@@ -59,7 +57,7 @@ class GPIOExpanderManager {
     bool reinit(); // Re-initialize I2C bus
 
     // User Button
-    ButtonEvent getButtonEvent(); // Returns BUTTON_EVENT_NONE, BUTTON_EVENT_SHORT_PRESS, or BUTTON_EVENT_LONG_PRESS
+    ButtonEvent getButtonEvent(); // Next debounced event, BUTTON_EVENT_NONE if there is none; no I2C without an edge
 
     // SX1262 Control Pins
     void setSXLNAEnabled(bool enabled);      // SX_LNA_EN (antenna amplifier)
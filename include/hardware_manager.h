@@ -4,10 +4,16 @@
 #include <Arduino.h>
 #include <SPI.h>
 #include <Adafruit_NeoPixel.h>
+#include <esp_timer.h>
+#include <mutex>
 #include "config.h"
 #include "gpio_expander_manager.h" // For ButtonEvent enum
 
 #define NUM_LEDS 1 // Unit-C6L has single WS2812C LED
+#define EFFECT_QUEUE_SIZE 4
+
+// Buzzer and LED patterns, see kEffects in hardware_manager.cpp
+enum class Effect : uint8_t { SUCCESS, FAILURE, NEW_METER, LEAK_ALARM };
 
 class HardwareManager {
   private:
@@ -15,6 +21,23 @@ class HardwareManager {
     uint32_t rgbColor = 0x000000;
     SPIClass* sharedSPI = nullptr; // Shared SPI bus for display and LoRa
 
+    // Effect sequencer: an esp_timer steps through the pattern, so nothing waits in delay()
+    esp_timer_handle_t effectTimer = nullptr;
+    std::mutex effectMutex; // Guards the effect state and the LED against the esp_timer task
+    bool effectPlaying = false;
+    Effect effect = Effect::SUCCESS;
+    uint8_t effectStep = 0;
+    uint8_t effectRepeat = 0;
+    int64_t effectStepEndUs = 0;
+    Effect effectQueue[EFFECT_QUEUE_SIZE]; // Waiting effects, highest priority first
+    uint8_t effectQueueCount = 0;
+
+    static void onEffectTimer(void* arg);
+    void startEffect(Effect next);
+    void nextEffectStep();
+    void showEffectStep();
+    void showLED(uint32_t color);
+
   public:
     HardwareManager();
 
@@ -25,7 +48,9 @@ class HardwareManager {
 
     // Buzzer control
     void beep(int duration = 100, int frequency = 1000);
-    void beepSuccess();
+
+    // Queue a buzzer and LED pattern. One of higher priority cuts the current one short, others wait their turn.
+    void playEffect(Effect next);
 
     // RGB LED control (WS2812C)
     void setRGBColor(uint8_t r, uint8_t g, uint8_t b);
@@ -33,7 +58,7 @@ class HardwareManager {
     void rgbOff();
 
     // Button
-    ButtonEvent getButtonEvent(); // Returns NONE, SHORT_PRESS, or LONG_PRESS
+    ButtonEvent getButtonEvent(); // Returns NONE, SHORT_PRESS, LONG_PRESS or DOUBLE_PRESS
 };
 
 extern HardwareManager hardwareManager;
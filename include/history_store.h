@@ -0,0 +1,151 @@
+#ifndef HISTORY_STORE_H
+#define HISTORY_STORE_H
+
+#include <Arduino.h>
+#include <stdio.h>
+#include <mutex>
+#include "config.h"
+#include "izar_handler.h"
+
+#define HISTORY_DIR "/littlefs/history"   // LittleFS is mounted at /littlefs, files are accessed through stdio
+#define HISTORY_SEGMENT_SECONDS 604800    // One file per meter and week, the unit of retention
+#define HISTORY_MAX_METERS 4              // Meters with append state in RAM, least recently written replaced
+#define HISTORY_MIN_STEP 60               // s - shortest aggregation step of /api/history
+#define HISTORY_MAX_BUCKETS 2000          // Buckets per /api/history query
+#define HISTORY_MIN_VALID_TIME 1704067200 // 2024-01-01, earlier clocks are not NTP-synced yet
+#define HISTORY_QUEUE_SIZE 32             // Readings held in RAM until the loop writes them
+#define HISTORY_FLUSH_READINGS 16         // Queued readings that trigger a write
+#define HISTORY_FLUSH_MS 300000           // ms - oldest queued reading's age that triggers a write
+
+// One stored reading
+struct HistorySample {
+    uint32_t time;   // Unix seconds
+    uint32_t liters; // Meter counter
+    uint16_t alarms; // IzarAlarms flags, bit 0 = general_alarm ... bit 11 = mechanical_fraud_previously
+};
+
+// Append-only readings, one file per meter and week under HISTORY_DIR. Every file starts with a keyframe
+// (absolute time, counter and alarms); each further reading stores its timestamp as delta-of-delta and its
+// counter as delta, Gorilla-style:
+//   0DDDCCCC                one byte: delta-of-delta DDD - 4 (-4..3 s), counter delta CCCC (0..15 L), same alarms
+//   0xC0 | a, dod, delta    zigzag varints, then the alarms as varint if a = 1
+//   0xE0, time, liters, alarms   keyframe, varints; also written after a reboot
+// Meters on a steady interval cost one byte per reading. The oldest week is deleted once the files exceed
+// the byte budget given to begin(), or at the next write after the last /api/history response has finished.
+// append() only queues the reading; handle() encodes and writes the queue in one pass per meter and file.
+class HistoryStore {
+  public:
+    bool begin(const char* dir, uint32_t budgetBytes);
+
+    // Reading of a decoded meter at unix time, queued in RAM; false while the store is not ready, before NTP
+    // or with the queue full. Call from the loop task, like handle().
+    bool append(const IzarReading& reading, uint32_t time);
+
+    // Writes the queue once HISTORY_FLUSH_READINGS readings are waiting or the oldest is HISTORY_FLUSH_MS old
+    void handle();
+
+    // Writes the queue now
+    void flush();
+
+    bool isReady() const { return ready; }
+    const char* getDir() const { return dir; }
+    uint32_t getUsedBytes() const { return usedBytes; }
+    size_t getQueuedCount() const { return queueCount; }
+
+    // Path of a meter's file for one segment (time / HISTORY_SEGMENT_SECONDS)
+    static void segmentPath(char* out, size_t size, const char* dir, const char* meterId, uint32_t segment);
+
+  private:
+    friend class HistoryWriter;
+
+    struct QueuedSample {
+        char meterId[16];
+        HistorySample sample;
+    };
+
+    // Decoder state at the end of a meter's current file
+    struct Series {
+        char meterId[16];
+        uint32_t segment;
+        HistorySample last;
+        int32_t lastDelta; // Seconds between the last two readings
+        bool open;         // A keyframe was written to this segment since boot
+        uint32_t lastAppendMs;
+    };
+
+    char dir[32]{};
+    bool ready = false;
+    uint32_t budgetBytes = 0;
+    uint32_t usedBytes = 0;
+    Series series[HISTORY_MAX_METERS]{};
+
+    QueuedSample queue[HISTORY_QUEUE_SIZE]{};
+    size_t queueCount = 0;
+    uint32_t firstQueuedMs = 0;
+
+    std::mutex mutex;          // Guards the files: the loop writes and removes while /api/history reads them
+    uint8_t activeReaders = 0; // Open HistoryWriters, eviction waits until they are done
+
+    Series& seriesFor(const char* meterId);
+    size_t encode(Series& entry, const HistorySample& next, uint8_t* out);
+    bool write(Series& entry, const uint8_t* data, size_t length);
+    void enforceBudget(size_t incoming);
+};
+
+// Streams /api/history: the samples of [from, to) aggregated into step-second buckets (min, max and last
+// counter, consumption, alarms seen), decoded from the files a few hundred bytes at a time. Readings still
+// queued in the store are not part of the result.
+class HistoryWriter {
+  public:
+    HistoryWriter(HistoryStore& store, const char* meterId, uint32_t from, uint32_t to, uint32_t step);
+    ~HistoryWriter();
+
+    // Fill buffer with the next bytes of the JSON document; 0 once it is complete
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+  private:
+    static constexpr size_t kLineSize = 160;
+
+    HistoryStore& store;
+    char meterId[16];
+    uint32_t from;
+    uint32_t to;
+    uint32_t step;
+
+    // Input
+    FILE* file = nullptr;
+    uint32_t segment;
+    uint8_t input[128];
+    size_t inputLength = 0;
+    size_t inputOffset = 0;
+    HistorySample sample{};
+    int32_t lastDelta = 0;
+    bool haveSample = false; // sample holds the previous reading, for the consumption of the next one
+
+    // Bucket being aggregated
+    uint32_t bucketStart = 0;
+    uint32_t count = 0;
+    uint32_t minLiters = 0;
+    uint32_t maxLiters = 0;
+    uint32_t lastLiters = 0;
+    uint32_t consumption = 0;
+    uint16_t alarms = 0;
+
+    // Output
+    char line[kLineSize];
+    size_t lineLength = 0;
+    size_t lineOffset = 0;
+    uint8_t stage = 0; // Header, buckets, footer, done
+    bool firstBucket = true;
+
+    bool nextLine();
+    bool nextSample(HistorySample& out, uint32_t& consumed); // false at the end of the range
+    bool nextByte(uint8_t& value);
+    bool nextVarint(uint32_t& value);
+    bool openSegment();
+    size_t formatBucket();
+};
+
+extern HistoryStore historyStore;
+
+#endif // HISTORY_STORE_H
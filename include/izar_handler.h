@@ -68,11 +68,16 @@ class IzarHandler {
     // Set callback for decoded data
     void setDataCallback(IzarDataCallback callback);
 
+    // Parse IZAR meter reading from a decrypted payload; stateless, no error logging
+    static bool parseReading(const char* meterId, const uint8_t* data, uint8_t dataLen, int16_t rssi,
+                             IzarReading* reading);
+
+    // Decrypted payloads rejected by processData(): too short or unparsable
+    uint32_t getParseFailures() const { return parseFailures; }
+
   private:
     IzarDataCallback dataCallback;
-
-    // Parse IZAR meter reading
-    bool parseReading(const char* meterId, const uint8_t* data, uint8_t dataLen, int16_t rssi, IzarReading* reading);
+    uint32_t parseFailures = 0;
 };
 
 // Global IZAR handler instance
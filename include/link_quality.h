@@ -0,0 +1,65 @@
+#ifndef LINK_QUALITY_H
+#define LINK_QUALITY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define LINK_QUALITY_MAX_METERS 16    // Meters tracked, the one heard from least recently is replaced
+#define LINK_QUALITY_WINDOW_MS 600000 // Sliding window length (10 minutes)
+#define LINK_QUALITY_WINDOWS 6        // Windows kept per meter, PER covers the last hour
+#define LINK_QUALITY_MQTT_METERS 3    // Worst meters in <base>/diagnostics, ~165 bytes each at worst (see test)
+
+// Frames heard from one meter in one window
+struct LinkWindow {
+    uint16_t received; // Frames decoded (CRC-valid DLL header), duplicates excluded
+    uint16_t missed;   // Frames expected from radio_interval but never decoded
+    int32_t rssiSum;   // Sum over received frames, for the mean
+};
+
+// One meter in range (any manufacturer with a valid DLL header)
+struct MeterLink {
+    char meterId[16];
+    uint16_t intervalS; // IZAR radio_interval in seconds, 0 while unknown (not an IZAR meter or not decrypted yet)
+    unsigned long lastFrameMs;
+    int16_t lastRssi;
+    LinkWindow windows[LINK_QUALITY_WINDOWS];
+};
+
+// Per-meter packet error rate (PER) estimate. IZAR meters transmit every radio_interval seconds (plus a little
+// jitter), so the gap between two decoded frames tells how many were lost in between:
+// missed = round(gap / interval) - 1. Frames and misses are counted in LINK_QUALITY_WINDOWS sliding windows,
+// and PER = missed / (received + missed) over all of them, including the gap still open since the last frame.
+class LinkQuality {
+  public:
+    // Every CRC-valid frame; decrypts a copy of the TPL data with the default PRIOS key to learn radio_interval
+    void recordFrame(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                     const uint8_t* tplData, uint8_t tplDataLen, int16_t rssi);
+
+    // Start a new measurement (after moving the antenna), applied by the next handle() call
+    void requestReset() { resetPending = true; }
+
+    // Rotate windows, publish to <base>/diagnostics every LINK_QUALITY_PUBLISH_INTERVAL
+    void handle();
+
+    // Rejection counters per pipeline stage, overall PER and mean RSSI (the placement score) and up to maxMeters
+    // meters ranked worst first
+    String getJSON(size_t maxMeters) const;
+
+  private:
+    MeterLink meters[LINK_QUALITY_MAX_METERS]{};
+    uint8_t currentWindow = 0;
+    unsigned long windowStart = 0;
+    unsigned long measurementStart = 0;
+    unsigned long lastPublish = 0;
+    volatile bool resetPending = false;
+
+    MeterLink* findMeter(const char* meterId);
+    void reset();
+    void rotateWindows();
+    // Received and missed frames over all windows, the open gap since the last frame included
+    void getTotals(const MeterLink& meter, uint32_t& received, uint32_t& missed, int32_t& rssiSum) const;
+};
+
+extern LinkQuality linkQuality;
+
+#endif // LINK_QUALITY_H
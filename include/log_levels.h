@@ -0,0 +1,68 @@
+#ifndef LOG_LEVELS_H
+#define LOG_LEVELS_H
+
+#include <Arduino.h>
+#include <type_traits>
+#include "config.h"
+
+#define LOG_LEVELS_SPEC_SIZE 128 // Stored "tag=level,..." list of the levels that differ from LOG_LEVEL_DEFAULT
+
+// Tags with their own runtime level; LOG_* calls with any other tag share the last one, "other"
+constexpr const char* kLogTags[] = {"Main", "WiFi", "MQTT", "Web", "wM-Bus", "PRIOS", "IZAR", "FSK Modem",
+                                    "Config", "GPIOExpander", "Hardware", "Display", "RawFwd", "Bench", "other"};
+constexpr uint8_t LOG_TAG_COUNT = sizeof(kLogTags) / sizeof(kLogTags[0]);
+
+constexpr bool logTagEquals(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+// Index of a tag in kLogTags, evaluated at compile time by the LOG_* macros
+constexpr uint8_t logTagId(const char* tag) {
+    for (uint8_t i = 0; i + 1 < LOG_TAG_COUNT; i++) {
+        if (logTagEquals(tag, kLogTags[i])) {
+            return i;
+        }
+    }
+    return LOG_TAG_COUNT - 1;
+}
+
+#define LOG_TAG_ID(tag) (std::integral_constant<uint8_t, logTagId(tag)>::value)
+
+// Runtime log level per tag, below the compile-time LOG_LEVEL ceiling. Set from the web log page, the MQTT
+// "loglevel" command or at boot from the config (NVS).
+class LogLevels {
+  public:
+    LogLevels();
+
+    // One load and compare in every LOG_* call, before its arguments are evaluated
+    bool isEnabled(uint8_t tagId, uint8_t level) const { return levels[tagId] >= level; }
+
+    // Apply "tag=level[,tag=level...]": tags as in kLogTags or "all", levels by name (none, error, warn, info,
+    // debug) or number; case-insensitive. False if any entry is invalid, the valid ones are applied.
+    bool apply(const char* spec);
+
+    // Levels that differ from LOG_LEVEL_DEFAULT as a spec for apply(), "all=" first when most tags share one
+    void getSpec(char* spec, size_t size) const;
+
+    // {"ceiling":4,"default":3,"tags":{"Main":3,...}}
+    String getJSON() const;
+
+#ifndef IZAR_HOST_BUILD
+    // Apply the levels stored in the config
+    void begin();
+
+    // Apply now and stage for the config, safe from any task (the loop task writes NVS)
+    bool update(const char* spec);
+#endif
+
+  private:
+    volatile uint8_t levels[LOG_TAG_COUNT];
+};
+
+extern LogLevels logLevels;
+
+#endif // LOG_LEVELS_H
@@ -0,0 +1,52 @@
+#ifndef LOG_QUEUE_H
+#define LOG_QUEUE_H
+
+#include <Arduino.h>
+#include <stdarg.h>
+#include <atomic>
+#include "config.h"
+
+// Lock-free multi-producer, single-consumer queue of log records on a byte ring. A producer reserves space with a
+// compare-and-swap on the reserve counter, copies its record in and publishes it by storing the header word last;
+// the consumer takes records in reservation order and stops at one that is still being written. Records are:
+//   header (uint32: committed bit, length << 8, level), timestamp ms (uint32), payload, padding to 4 bytes
+// When a record does not fit it is dropped and counted, producers never wait for the consumer.
+class LogQueue {
+  public:
+    // Any task; false when the queue is full
+    bool push(uint8_t level, uint32_t t, const void* data, uint16_t length);
+
+    // Text record, formatted now as "[tag] message"
+    bool vpushf(uint8_t level, const char* tag, const char* format, va_list args);
+
+    // Deferred record (see LogRecordWriter), formatted when read
+    template <typename... Args> bool pushDeferred(uint8_t level, const char* tag, const char* format, Args... args) {
+        LogRecordWriter writer(tag, format);
+        (writer.add(args), ...);
+        return push(level | WebLogger::kDeferred, millis(), writer.data, writer.length);
+    }
+
+    // Consumer only: the oldest record, false when the queue is empty or that record is not complete yet
+    bool pop(uint8_t& level, uint32_t& t, uint8_t* data, uint16_t& length);
+
+    bool isEmpty() const { return released.load(std::memory_order_acquire) == reserved.load(); }
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+  private:
+    static constexpr uint32_t kCommitted = 0x80000000;
+    static constexpr size_t kHeaderSize = 8;
+    static_assert((LOG_QUEUE_SIZE & (LOG_QUEUE_SIZE - 1)) == 0, "LOG_QUEUE_SIZE must be a power of two");
+    static_assert(LOG_QUEUE_SIZE >= 2 * (kHeaderSize + WEB_LOG_MAX_MESSAGE), "Queue must hold two longest records");
+
+    alignas(4) uint8_t buffer[LOG_QUEUE_SIZE]{};
+    std::atomic<uint32_t> reserved{0}; // Bytes ever reserved by producers (free running, wraps with the ring)
+    std::atomic<uint32_t> released{0}; // Bytes ever handed back by the consumer
+    std::atomic<uint32_t> dropped{0};
+
+    static size_t recordSize(uint16_t length) { return (kHeaderSize + length + 3) & ~static_cast<size_t>(3); }
+    uint32_t* word(uint32_t position) { return reinterpret_cast<uint32_t*>(buffer + position % LOG_QUEUE_SIZE); }
+    void write(uint32_t position, const void* data, size_t length);
+    void read(uint32_t position, void* data, size_t length) const;
+};
+
+#endif // LOG_QUEUE_H
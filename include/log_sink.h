@@ -0,0 +1,47 @@
+#ifndef LOG_SINK_H
+#define LOG_SINK_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "log_queue.h"
+
+#if !defined(IZAR_HOST_BUILD)
+#define LOG_SINK_ACTIVE 1
+#endif
+
+#ifdef LOG_SINK_ACTIVE
+// LOG_* calls from any task only queue their record; a low-priority task drains the queue every LOG_SINK_INTERVAL
+// into the web log ring and prints the lines to Serial, so no caller formats for or waits on Serial
+class LogSink {
+  public:
+    // Start the sink task, records queued before are kept
+    void begin();
+
+    void logf(uint8_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+    template <typename... Args> void logDeferred(uint8_t level, const char* tag, const char* format, Args... args) {
+        queue.pushDeferred(level, tag, format, args...);
+    }
+
+    // Drain now instead of at the next interval (LOG_ERROR and LOG_WARN)
+    void wake();
+
+    // Wait up to timeoutMs for the sink to print everything queued, e.g. before a restart
+    void flush(uint32_t timeoutMs);
+
+    uint32_t getDropped() const { return queue.getDropped(); }
+
+  private:
+    LogQueue queue;
+    TaskHandle_t task = nullptr;
+    volatile bool draining = false;
+    uint32_t reportedDrops = 0;
+
+    static void taskMain(void* arg);
+    void drain();
+};
+
+extern LogSink logSink;
+#endif // LOG_SINK_ACTIVE
+
+#endif // LOG_SINK_H
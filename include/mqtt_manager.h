@@ -6,6 +6,7 @@
 #include <PubSubClient.h>
 #include <WiFi.h>
 #include <ArduinoJson.h>
+#include "izar_handler.h"
 
 typedef void (*MqttCallbackFunction)(const char* topic, const byte* payload, unsigned int length);
 
@@ -16,10 +17,18 @@ class MqttManager {
     unsigned long lastReconnectAttempt = 0;
     MqttCallbackFunction externalCallback = nullptr;
     bool discoveryPublished = false;
+    bool everConnected = false;
+    uint32_t publishFailures = 0;
+    uint32_t reconnects = 0;
 
     char topicStatus[128]{};
     char topicReading[128]{};
     char topicCommand[128]{};
+    char topicRaw[128]{};
+    char topicBench[128]{};
+    char topicLatency[128]{};
+    char topicDiagnostics[128]{};
+    char topicBoot[128]{};
 
   public:
     MqttManager();
@@ -30,9 +39,16 @@ class MqttManager {
     void disconnect();
     void handle();
 
+    // Reconnect with changed broker settings on the next handle(); new topics also re-send discovery
+    void applyConfig(bool topicsChanged);
+
     // Publishing
     bool publish(const char* topic, const char* payload, bool retain = false);
     bool publish(const char* topic, const JsonDocument& doc, bool retain = false);
+    bool publish(const char* topic, const uint8_t* payload, size_t length, bool retain = false);
+
+    // Reading payload as published to <base>/reading
+    void buildReadingJson(const IzarReading* reading, float flowLph, JsonDocument& doc);
 
     // Subscription
     bool subscribe(const char* topic);
@@ -41,10 +57,19 @@ class MqttManager {
     const char* getTopicStatus() const;
     const char* getTopicReading() const;
     const char* getTopicCommand() const;
+    const char* getTopicRaw() const;
+    const char* getTopicBench() const;
+    const char* getTopicLatency() const;
+    const char* getTopicDiagnostics() const;
+    const char* getTopicBoot() const;
 
     // Callbacks
     void setCallback(MqttCallbackFunction callback);
 
+    // Statistics since boot
+    uint32_t getPublishFailures() const { return publishFailures; }
+    uint32_t getReconnects() const { return reconnects; }
+
   private:
     void mqttCallback(char* topic, byte* payload, unsigned int length);
     static void staticMqttCallback(char* topic, byte* payload, unsigned int length);
@@ -0,0 +1,100 @@
+#ifndef PIPELINE_LATENCY_H
+#define PIPELINE_LATENCY_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Boundaries a received frame passes on its way from the SX1262 IRQ to the MQTT broker, in order.
+// The segment ending at a boundary carries the boundary's name.
+enum class LatencyStage : uint8_t {
+    IRQ = 0,  // Packet IRQ (micros() captured in the ISR)
+    RECEIVE,  // FskModemManager::receive() picked the packet up
+    READ,     // Packet read out of the SX1262
+    DECODE,   // 3-out-of-6 decoded, CRCs verified, DLL header parsed
+    DECRYPT,  // PRIOS decryption done
+    PARSE,    // IZAR reading parsed, izarDataCallback() entered
+    PUBLISH,  // Reading handed to the MQTT client
+    COUNT
+};
+
+#if ENABLE_LATENCY_TRACE && !defined(IZAR_HOST_BUILD)
+#define LATENCY_TRACE_ACTIVE 1
+
+// Log-linear buckets: exact below 16 us, then 8 buckets per power of two (at most 12.5% relative error)
+// up to 2^24 us (16.8 s); slower samples land in the last bucket
+#define LATENCY_LINEAR_BUCKETS 16
+#define LATENCY_SUB_BUCKET_BITS 3
+#define LATENCY_MAX_EXPONENT 23
+#define LATENCY_BUCKETS                                                                                                \
+    (LATENCY_LINEAR_BUCKETS + (LATENCY_MAX_EXPONENT - 3) * (1 << LATENCY_SUB_BUCKET_BITS))
+
+class LatencyHistogram {
+  public:
+    void record(uint32_t us);
+    void clear();
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMin() const { return count ? minUs : 0; }
+    uint32_t getMax() const { return maxUs; }
+    uint32_t getMean() const { return count ? static_cast<uint32_t>(sumUs / count) : 0; }
+    uint64_t getSum() const { return sumUs; }
+    uint32_t getBucket(size_t index) const { return buckets[index]; }
+
+    // Upper bound of the bucket holding the given percentile, capped at the largest sample
+    uint32_t percentile(uint8_t percent) const;
+
+    static size_t bucketIndex(uint32_t us);
+    static uint32_t bucketUpperBound(size_t index);
+
+  private:
+    uint32_t buckets[LATENCY_BUCKETS]{};
+    uint32_t count = 0;
+    uint32_t minUs = UINT32_MAX;
+    uint32_t maxUs = 0;
+    uint64_t sumUs = 0;
+};
+
+// Timestamps the frame in flight at each stage boundary and records the time spent in each segment.
+// Frames are handled one at a time from the main loop, so one set of marks is enough. Frames that stop early
+// (other meters, discovery mode, decode errors) only contribute to the segments they completed.
+class PipelineLatency {
+  public:
+    // Start a frame at its ISR timestamp; marks RECEIVE
+    void begin(uint32_t irqTimestampUs);
+    void mark(LatencyStage stage);
+    void clear();
+
+    // Publish the summary to <base>/latency every LATENCY_PUBLISH_INTERVAL
+    void handle();
+
+    // Per-segment count, min, mean, p50/p90/p99 and max in us; with buckets, also every non-empty
+    // [upper bound, count] pair
+    String getJSON(bool withBuckets) const;
+
+    // Segment histogram (IRQ: end to end) and its name
+    const LatencyHistogram& getHistogram(LatencyStage stage) const { return histograms[static_cast<size_t>(stage)]; }
+    static const char* getSegmentName(LatencyStage stage);
+
+  private:
+    // One histogram per segment (indexed by its end boundary), slot IRQ holds IRQ -> PUBLISH end to end
+    LatencyHistogram histograms[static_cast<size_t>(LatencyStage::COUNT)];
+    uint32_t marks[static_cast<size_t>(LatencyStage::COUNT)]{};
+    LatencyStage lastStage = LatencyStage::IRQ;
+    bool inFlight = false;
+    unsigned long lastPublish = 0;
+};
+
+extern PipelineLatency pipelineLatency;
+
+#define LATENCY_BEGIN(irqTimestampUs) pipelineLatency.begin(irqTimestampUs)
+#define LATENCY_MARK(stage) pipelineLatency.mark(LatencyStage::stage)
+#else
+#define LATENCY_BEGIN(irqTimestampUs)                                                                                  \
+    do {                                                                                                               \
+    } while (0)
+#define LATENCY_MARK(stage)                                                                                            \
+    do {                                                                                                               \
+    } while (0)
+#endif
+
+#endif // PIPELINE_LATENCY_H
@@ -15,6 +15,7 @@
 #define PRIOS_DEFAULT_KEY PRIOS_DEFAULT_KEY1
 
 #define PRIOS_OFFSET_ENCRYPTED_DATA 5 // Start of encrypted data
+#define PRIOS_MIN_FRAME_LENGTH 16     // LFSR seed reads frame bytes 2-15 (M/A fields, CI and status)
 
 // PRIOS handler class
 class PriosHandler {
@@ -28,9 +29,22 @@ class PriosHandler {
     bool processPayload(const char* meterId, const uint8_t* fullFrame, uint8_t fullFrameLen, uint8_t* payload,
                         uint8_t payloadLen, int16_t rssi);
 
+    // Decrypt the PRIOS part of a TPL payload in-place with the default key; stateless, no error logging
+    static bool decryptPayload(const uint8_t* fullFrame, uint8_t fullFrameLen, uint8_t* payload, uint8_t payloadLen);
+
+    // XOR data with the LFSR keystream derived from key and frame bytes 2-15 (encrypts and decrypts)
+    static void applyKeystream(const uint8_t* key, uint8_t* data, uint8_t dataLen, const uint8_t* frame);
+
+    // Payloads processPayload() rejected: invalid lengths, or a decrypted marker byte other than 0x4B
+    uint32_t getDecryptFailures() const { return decryptFailures; }
+    uint32_t getMarkerFailures() const { return markerFailures; }
+
   private:
+    uint32_t decryptFailures = 0;
+    uint32_t markerFailures = 0;
+
     // Decrypt PRIOS data using LFSR (in-place decryption)
-    bool decryptData(const uint8_t* key, uint8_t* data, uint8_t dataLen, const uint8_t* frame);
+    static bool decryptData(const uint8_t* key, uint8_t* data, uint8_t dataLen, const uint8_t* frame);
 };
 
 // Global PRIOS handler instance
@@ -0,0 +1,54 @@
+#ifndef RAW_FRAME_FORWARDER_H
+#define RAW_FRAME_FORWARDER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Raw telegram output format (stored in Config::rawForwardMode)
+enum class RawForwardMode : uint8_t { OFF = 0, HEX = 1, BINARY = 2 };
+
+// What the on-device decoder made of the forwarded telegram
+enum class RawFrameVerdict : uint8_t {
+    SKIPPED = 0,       // Not decrypted (discovery mode or not the bound meter)
+    DECODED = 1,       // PRIOS decryption and IZAR parsing succeeded
+    DECODE_FAILED = 2, // PRIOS decryption or IZAR parsing failed
+    TPL_UNCHECKED = 3, // DLL CRC valid, TPL not verified (multi-block telegram), sent with its block CRCs
+};
+
+// Binary record layout (all multi-byte fields little-endian):
+//   [0] frame length, [1] mode (1 = T1), [2] verdict, [3..4] RSSI (int16), [5..8] ISR timestamp (us), [9..] frame
+#define RAW_FORWARD_BINARY_HEADER_SIZE 9
+#define RAW_FORWARD_MODE_T1 1
+
+// Batches DLL CRC-valid wM-Bus telegrams and publishes them to <base>/raw for central decoding
+class RawFrameForwarder {
+  public:
+    RawFrameForwarder();
+
+    // Queue a telegram: DLL header + TPL data, DLL CRC stripped and TPL CRC too unless TPL_UNCHECKED
+    void enqueue(const uint8_t* frame, uint8_t frameLen, int16_t rssi, uint32_t isrTimestampUs,
+                 RawFrameVerdict verdict);
+
+    // Publish the pending batch once its latency budget is used up
+    void handle();
+
+    bool isEnabled() const;
+    uint32_t getDroppedCount() const { return droppedFrames; }
+
+  private:
+    uint8_t batch[RAW_FORWARD_MAX_BATCH_BYTES]{};
+    size_t batchLen = 0;
+    uint8_t batchFrames = 0;
+    unsigned long batchStartTime = 0;
+    uint32_t droppedFrames = 0;
+
+    size_t encodeHex(uint8_t* out, size_t outSize, const uint8_t* frame, uint8_t frameLen, int16_t rssi,
+                     uint32_t isrTimestampUs, RawFrameVerdict verdict);
+    size_t encodeBinary(uint8_t* out, size_t outSize, const uint8_t* frame, uint8_t frameLen, int16_t rssi,
+                        uint32_t isrTimestampUs, RawFrameVerdict verdict);
+    void flush();
+};
+
+extern RawFrameForwarder rawFrameForwarder;
+
+#endif // RAW_FRAME_FORWARDER_H
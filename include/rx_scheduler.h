@@ -0,0 +1,48 @@
+#ifndef RX_SCHEDULER_H
+#define RX_SCHEDULER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+#define RX_SCHEDULE_LOCK_FRAMES 3     // Frames on time in a row before the radio may sleep
+#define RX_SCHEDULE_MIN_GUARD_MS 500  // Least listening time either side of a predicted frame
+#define RX_SCHEDULE_JITTER_FACTOR 3   // Guard = factor x largest recent deviation from the schedule
+#define RX_SCHEDULE_MIN_SLEEP_MS 2000 // Shorter gaps between windows are spent in continuous RX
+
+enum class RxMode : uint8_t {
+    CONTINUOUS, // Schedule unknown or lost, listen all the time
+    WINDOW,     // Inside the window around the predicted frame
+    SLEEP       // Between windows, radio asleep
+};
+
+// Predicts when the bound meter transmits next. IZAR meters send every radio_interval seconds plus some
+// jitter, so after a few frames the phase is known: the radio only has to listen in a window of
+// +-guard around lastFrame + interval, with the guard grown from the deviations seen so far. A window that
+// ends without a frame drops back to continuous RX until the meter is on schedule again.
+// Pure timing, the caller passes the time and switches the radio, so it runs on the host with a virtual clock.
+class RxScheduler {
+  public:
+    void reset(); // Forget the schedule (other meter bound), continuous RX
+
+    void setInterval(uint32_t intervalMs); // radio_interval of the bound meter, 0 while unknown
+    void recordFrame(uint32_t nowMs);      // Frame from the bound meter
+
+    // Mode for the radio at nowMs; counts a missed window once it has ended without a frame
+    RxMode update(uint32_t nowMs);
+
+    bool isLocked() const { return onTime >= RX_SCHEDULE_LOCK_FRAMES; }
+    uint32_t getGuardMs() const;
+    uint32_t getMissedWindows() const { return missedWindows; }
+
+  private:
+    uint32_t intervalMs = 0;
+    uint32_t lastFrameMs = 0;
+    bool haveFrame = false;
+    uint8_t onTime = 0;      // Consecutive frames within the guard of their predicted time
+    uint32_t jitterMs = 0;   // Largest recent deviation, decays by 1/8 per frame
+    uint32_t missedWindows = 0;
+};
+
+extern RxScheduler rxScheduler;
+
+#endif // RX_SCHEDULER_H
@@ -0,0 +1,40 @@
+#ifndef SELF_BENCHMARK_H
+#define SELF_BENCHMARK_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Stages of the receive chain timed by the self-benchmark, in chain order
+enum class BenchStage : uint8_t { DECODE = 0, DECRYPT, PARSE, SERIALIZE, TOTAL, COUNT };
+
+#define SELF_BENCH_RESULT_SIZE 1024
+
+// Runs the built-in frame corpus through decode -> decrypt -> parse -> serialize on the device and reports the
+// per-stage cycle distribution. Runs are requested from the web server or MQTT and executed from the main loop,
+// so the numbers include the interference of WiFi, AsyncTCP and the other managers.
+class SelfBenchmark {
+  public:
+    SelfBenchmark();
+
+    // Queue a run of `iterations` chain passes (clamped to SELF_BENCH_MAX_ITERATIONS); false if one is pending
+    bool request(uint16_t iterations, bool publishResult);
+
+    // Execute a pending run and publish its result to <base>/bench if requested over MQTT
+    void handle();
+
+    bool isBusy() const { return pendingIterations != 0; }
+
+    // Latest result as JSON ({"status":"idle"} before the first run)
+    const char* getResultJSON() const { return resultJson; }
+
+  private:
+    volatile uint16_t pendingIterations = 0;
+    volatile bool pendingPublish = false;
+    char resultJson[SELF_BENCH_RESULT_SIZE];
+
+    bool run(uint16_t iterations);
+};
+
+extern SelfBenchmark selfBenchmark;
+
+#endif // SELF_BENCHMARK_H
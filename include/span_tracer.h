@@ -0,0 +1,127 @@
+#ifndef SPAN_TRACER_H
+#define SPAN_TRACER_H
+
+#include <Arduino.h>
+#include "config.h"
+
+// Traced spans and ISR events. Spans before READ are main loop subsystems and only recorded when they take at
+// least SPAN_TRACE_MIN_US; receive pipeline spans and ISR events are always recorded.
+enum class TraceId : uint8_t {
+    LOOP = 0,        // One loop() iteration
+    WIFI,            // WiFiManager::handleWiFi()
+    WIFI_CONNECT,    // WiFi (re)connection attempt
+    MQTT,            // MqttManager::handle()
+    MQTT_CONNECT,    // MQTT (re)connection attempt
+    HA_DISCOVERY,    // Home Assistant discovery publish
+    WEB_SERVER,      // WebConfigServer::handle()
+    FSK_MODEM,       // FskModemManager::handle(), including the whole receive pipeline
+    RAW_FORWARD,     // RawFrameForwarder::handle()
+    SELF_BENCH,      // SelfBenchmark::handle()
+    LATENCY_PUBLISH, // PipelineLatency::handle()
+    DISPLAY_REFRESH, // updateDisplay()
+    BUTTON,          // handleButtonPress()
+    LOG,             // One LOG_* call (queued for the log sink)
+    LOG_SINK,        // Log sink task draining the log queue to Serial and the web log
+    READ,            // Packet read out of the SX1262
+    DECODE,          // 3-out-of-6 decode, CRCs and DLL header
+    DECRYPT,         // PRIOS decryption
+    PARSE,           // IZAR reading parse
+    PUBLISH,         // Reading JSON built and handed to the MQTT client
+    SX1262_IRQ,      // SX1262 packet IRQ (instant)
+    EXPANDER_IRQ,    // GPIO expander interrupt (instant)
+    COUNT
+};
+
+// Where an event was recorded, exported as the Chrome trace tid
+enum class TraceTrack : uint8_t { LOOP = 1, OTHER_TASK, ISR };
+
+// One completed span (durationUs 0 for instant events), 12 bytes
+struct TraceRecord {
+    uint32_t startUs;
+    uint32_t durationUs;
+    TraceId id;
+    TraceTrack track;
+};
+
+#if ENABLE_SPAN_TRACE && !defined(IZAR_HOST_BUILD)
+#define SPAN_TRACE_ACTIVE 1
+
+// Fixed-size ring of the last SPAN_TRACE_EVENTS records, safe to write from the loop, other tasks and ISRs.
+// Records are addressed by a running sequence number so a reader can tell when one was overwritten.
+class SpanTracer {
+  public:
+    // Remember the calling task as the loop track
+    void begin();
+
+    void record(TraceId id, uint32_t startUs, uint32_t durationUs);
+    void IRAM_ATTR instant(TraceId id);
+    void clear();
+
+    // Copy the record at sequence, first moving sequence past records already overwritten; false once it
+    // reaches the newest record
+    bool read(uint32_t& sequence, TraceRecord& out);
+    // Sequence numbers of the oldest record still held and one past the newest
+    void getRange(uint32_t& oldest, uint32_t& end);
+
+    static const char* getName(TraceId id);
+    static bool isPipeline(TraceId id) { return id >= TraceId::READ; }
+
+  private:
+    TraceRecord records[SPAN_TRACE_EVENTS]{};
+    uint32_t written = 0;
+    TaskHandle_t loopTask = nullptr;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    void IRAM_ATTR push(TraceId id, uint32_t startUs, uint32_t durationUs);
+};
+
+extern SpanTracer spanTracer;
+
+// Records a span from construction to the end of the enclosing scope
+class TraceScope {
+  public:
+    explicit TraceScope(TraceId id) : id(id), startUs(micros()) {}
+    ~TraceScope() { spanTracer.record(id, startUs, micros() - startUs); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+  private:
+    TraceId id;
+    uint32_t startUs;
+};
+
+// Streams the ring as Chrome trace-event JSON (Perfetto, chrome://tracing) a record at a time, for
+// AsyncWebServer chunked responses
+class TraceWriter {
+  public:
+    size_t read(uint8_t* buffer, size_t maxLen);
+
+  private:
+    enum class Part : uint8_t { HEADER, METADATA, EVENTS, FOOTER, DONE };
+
+    char line[160];
+    size_t lineLength = 0;
+    size_t lineOffset = 0;
+    Part part = Part::HEADER;
+    uint8_t item = 0;
+    uint32_t sequence = 0;
+    uint32_t endSequence = 0;
+
+    bool nextLine();
+    int formatRecord(const TraceRecord& record);
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SPAN(id) TraceScope TRACE_CONCAT(traceScope, __LINE__)(TraceId::id)
+#define TRACE_INSTANT(id) spanTracer.instant(TraceId::id)
+#else
+#define TRACE_SPAN(id)                                                                                                 \
+    do {                                                                                                               \
+    } while (0)
+#define TRACE_INSTANT(id)                                                                                              \
+    do {                                                                                                               \
+    } while (0)
+#endif
+
+#endif // SPAN_TRACER_H
@@ -0,0 +1,67 @@
+#ifndef SPI_BUS_ARBITER_H
+#define SPI_BUS_ARBITER_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "config.h"
+
+// Users of the SPI bus shared by the SX1262 and the SSD1306
+enum class SpiClient : uint8_t { RADIO, DISPLAY, COUNT };
+
+struct SpiHoldStats {
+    uint32_t acquisitions;
+    uint64_t totalUs; // Time the bus was held
+    uint32_t maxUs;   // Longest single hold
+};
+
+// Serializes access to the shared SPI bus with a FreeRTOS mutex (priority inheritance, interrupts stay enabled).
+// The radio has priority: while it waits for the bus or its packet IRQ is pending, radioPending() is true and
+// the display stops flushing at the next chunk boundary, leaving the rest for later.
+class SpiBusArbiter {
+  public:
+    void begin();
+
+    void acquire(SpiClient client);
+    void release(SpiClient client);
+
+    bool radioPending() const { return radioWaiting || radioIrq; }
+
+    // From the SX1262 packet ISR; cleared when the radio takes the bus
+    void notifyRadioIrq() { radioIrq = true; }
+
+    // Display flush stopped early for the radio
+    void recordPreemption() { preemptions++; }
+
+    // Statistics since boot
+    const SpiHoldStats& getHoldStats(SpiClient client) const { return hold[static_cast<size_t>(client)]; }
+    uint64_t getRadioWaitTotalUs() const { return radioWaitTotalUs; }
+    uint32_t getRadioWaitMaxUs() const { return radioWaitMaxUs; }
+    uint32_t getPreemptions() const { return preemptions; }
+
+  private:
+    SemaphoreHandle_t mutex = nullptr;
+    volatile bool radioWaiting = false;
+    volatile bool radioIrq = false;
+    uint32_t acquiredUs = 0;
+    SpiHoldStats hold[static_cast<size_t>(SpiClient::COUNT)]{};
+    uint64_t radioWaitTotalUs = 0;
+    uint32_t radioWaitMaxUs = 0;
+    uint32_t preemptions = 0;
+};
+
+extern SpiBusArbiter spiBus;
+
+// Holds the bus for its lifetime
+class SpiBusLock {
+  public:
+    explicit SpiBusLock(SpiClient client) : client(client) { spiBus.acquire(client); }
+    ~SpiBusLock() { spiBus.release(client); }
+    SpiBusLock(const SpiBusLock&) = delete;
+    SpiBusLock& operator=(const SpiBusLock&) = delete;
+
+  private:
+    SpiClient client;
+};
+
+#endif // SPI_BUS_ARBITER_H
@@ -2,30 +2,105 @@
 #define WEB_LOGGER_H
 
 #include <Arduino.h>
+#include <mutex>
+#include <type_traits>
 
-constexpr size_t WEB_LOG_ENTRY_MSG_SIZE = 1024;
+#ifndef WEB_LOG_BUFFER_SIZE
+#define WEB_LOG_BUFFER_SIZE 16384 // Bytes of log records kept for the web log viewer
+#endif
+#ifndef WEB_LOG_MAX_MESSAGE
+#define WEB_LOG_MAX_MESSAGE 256 // Longest stored line including "[tag] " (Serial gets the full line)
+#endif
 
-struct WebLogEntry {
-    uint32_t id;
-    uint32_t t;
-    uint8_t level;
-    char msg[WEB_LOG_ENTRY_MSG_SIZE];
+// Arguments stored in a deferred record, one type byte each followed by the value
+enum class LogArg : uint8_t {
+    INT32 = 1, // Integers up to 32 bits, 4 bytes
+    INT64,     // 8 bytes
+    DOUBLE,    // 8 bytes, float promoted
+    STRING,    // Length byte and the characters (copied, the pointer may not outlive the call)
+    POINTER,   // sizeof(void*) bytes
+    BYTES,     // Length byte and the bytes, printed by %s as hex
 };
 
+// Bytes logged by LOG_DEBUG_HEX, copied into the record
+struct LogHex {
+    const uint8_t* data;
+    size_t length;
+};
+
+// "0A 1B ...", as many bytes as fit, with "..." when some did not
+void formatLogHex(char* out, size_t size, const uint8_t* data, size_t length);
+
+// printf format checking for the deferred LOG_* macros, never called
+inline void __attribute__((format(printf, 1, 2))) logFormatCheck(const char*, ...) {}
+
+// Serializes a deferred record payload: tag and format pointers (both must be string literals), then the
+// arguments. Arguments that do not fit are dropped, strings are truncated.
+struct LogRecordWriter {
+    uint8_t data[WEB_LOG_MAX_MESSAGE];
+    uint16_t length = 0;
+    bool full = false;
+
+    LogRecordWriter(const char* tag, const char* format);
+
+    void put(LogArg type, const void* value, size_t size);
+    void putBlob(LogArg type, const void* value, size_t size); // Length byte, truncated to fit
+    void add(const char* value);
+    void add(char* value) { add(static_cast<const char*>(value)); }
+    void add(double value) { put(LogArg::DOUBLE, &value, sizeof(value)); }
+    void add(const LogHex& hex);
+    template <typename T> void add(T* value) {
+        const void* pointer = value;
+        put(LogArg::POINTER, &pointer, sizeof(pointer));
+    }
+    template <typename T, typename = std::enable_if_t<std::is_integral_v<T> || std::is_enum_v<T>>> void add(T value) {
+        if constexpr (sizeof(T) <= sizeof(uint32_t)) {
+            uint32_t bits = static_cast<uint32_t>(value);
+            put(LogArg::INT32, &bits, sizeof(bits));
+        } else {
+            uint64_t bits = static_cast<uint64_t>(value);
+            put(LogArg::INT64, &bits, sizeof(bits));
+        }
+    }
+};
+
+// Log lines for the web viewer, packed into a byte ring of variable-length records:
+//   id (uint32), timestamp ms (uint32), level (uint8), text length (uint16), text (no terminator)
+// Records may wrap around the end of the buffer; the oldest whole records are evicted to make room.
+// Deferred records set the kDeferred bit in the level and hold a LogRecordWriter payload instead of the text;
+// they are formatted only when read. All methods may be called from any task.
 class WebLogger {
   public:
-    void logf(uint8_t level, const char* tag, const char* format, ...);
+    static constexpr uint8_t kDeferred = 0x80;
+
+    // Format now and store the text
+    void logf(uint8_t level, const char* tag, const char* format, ...) __attribute__((format(printf, 4, 5)));
+
+    // Store a record as queued by LogQueue: text or, with kDeferred set in level, a LogRecordWriter payload
+    void append(uint8_t level, uint32_t t, const void* data, uint16_t length);
+
+    // Text of a record payload, "[tag] message"; returns its length
+    static size_t formatPayload(uint8_t level, const uint8_t* data, uint16_t length, char* out, size_t outSize);
+
     String getLogsJSON(uint32_t sinceId);
     void clear();
 
   private:
-    static constexpr size_t kMaxEntries = 200;
-    WebLogEntry entries[kMaxEntries]{};
-    size_t head = 0;
+    static constexpr size_t kHeaderSize = 11;
+    static_assert(WEB_LOG_MAX_MESSAGE <= UINT16_MAX, "Record length is 16 bits");
+    static_assert(kHeaderSize + WEB_LOG_MAX_MESSAGE <= WEB_LOG_BUFFER_SIZE, "Buffer must hold the longest record");
+
+    uint8_t buffer[WEB_LOG_BUFFER_SIZE]{};
+    size_t head = 0; // Offset of the oldest record
+    size_t used = 0; // Bytes held by records
     size_t count = 0;
     uint32_t nextId = 0;
+    std::mutex mutex; // Guards the ring: the log sink task appends while the web server reads
 
-    void appendEscaped(String& out, const char* text);
+    void write(size_t offset, const void* data, size_t length);
+    void read(size_t offset, void* data, size_t length) const;
+    void evictOldest();
+    static void appendEscaped(String& out, const char* text, size_t length);
 };
 
 extern WebLogger webLogger;
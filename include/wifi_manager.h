@@ -11,24 +11,36 @@ class WiFiManager {
     bool isConnected = false;
     bool apModeActive = false;
     bool mdnsStarted = false;
+    bool ntpStarted = false;
+    bool maxPowerSave = false;
+    bool associating = false; // Started by connect() or applyConfig(), handleWiFi() waits for it without blocking
+    unsigned long associateStart = 0;
     String apSsid;
 
   public:
     WiFiManager();
 
     bool init();
-    bool connect();
+    bool connect(); // Starts associating, true only if already connected
     bool isWiFiConnected();
     void reconnect();
     void handleWiFi();
     bool isApModeActive();
 
+    // Apply changed settings without restarting the radio: a new hostname restarts mDNS, new credentials
+    // re-associate in the background (leaving AP mode if the SSID is now configured)
+    void applyConfig(bool credentialsChanged);
+
     int getRSSI(); // Signal strength
 
+    // Modem sleep across several DTIM periods (less current, more latency) or the default minimum modem sleep
+    void setMaxPowerSave(bool enabled);
+
   private:
     void printWiFiStatus();
     void startAccessPoint();
     void startMdns();
+    void startNtp();
 };
 
 extern WiFiManager wifiManager;
@@ -26,6 +26,10 @@
 typedef void (*WmBusPacketCallback)(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
                                     uint8_t* tplData, uint8_t tplDataLen, int16_t rssi);
 
+// Callback for frames whose DLL CRC passed but whose single-block TPL CRC did not, such as multi-block format A
+// telegrams of other manufacturers: the whole format A frame, DLL CRC and block CRCs included
+typedef void (*WmBusUncheckedCallback)(const uint8_t* frame, uint8_t frameLen, int16_t rssi);
+
 // wM-Bus header structure (Mode T1) - stores parsed values only
 struct WmBusDataLinkLayerHeader {
     char meterId[16];     // String meter ID (as printed on the meter)
@@ -35,20 +39,41 @@ struct WmBusDataLinkLayerHeader {
     uint8_t cField;       // Control field (byte 1)
 };
 
+// Result of decoding one raw frame, in pipeline order
+enum class WmBusDecodeStatus : uint8_t {
+    OK,
+    INVALID_LENGTH,        // Null buffer, empty or oversized raw packet
+    L_FIELD_DECODE_FAILED, // First two raw bytes are not valid 3-out-of-6 code words
+    INSUFFICIENT_DATA,     // L-field announces more bytes than were received
+    DECODE_3OF6_FAILED,    // Invalid 3-out-of-6 code word in the body
+    TOO_SHORT,             // Decoded frame shorter than DLL header + CRC + TPL CRC
+    DLL_CRC_FAILED,        // Data Link Layer CRC mismatch
+    TPL_CRC_FAILED         // Transport Layer CRC mismatch
+};
+#define WM_BUS_DECODE_STATUS_COUNT 8 // Number of WmBusDecodeStatus values
+
+// Decoded, CRC-verified wM-Bus frame (DLL header + CRC, TPL data + CRC)
+struct WmBusFrame {
+    uint8_t data[WM_BUS_MAX_PAYLOAD];
+    uint8_t length;     // Decoded frame length including both CRCs
+    uint8_t tplDataLen; // Transport Layer data length without CRC
+    WmBusDataLinkLayerHeader header;
+
+    uint8_t* tplData() { return data + WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE; }
+    const uint8_t* tplData() const { return data + WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE; }
+};
+
 class WmBusHandler {
   private:
     WmBusPacketCallback packetCallback = nullptr;
+    WmBusUncheckedCallback uncheckedCallback = nullptr;
+    uint32_t statusCounts[WM_BUS_DECODE_STATUS_COUNT]{}; // processRawPacket() results
 
     // 3-out-of-6 decoding
-    uint8_t decode3outof6Nibble(uint8_t encoded);
-    bool decode3outof6(const uint8_t* encoded, uint8_t encodedLen, uint8_t* decoded, uint8_t* decodedLen);
+    static uint8_t decode3outof6Nibble(uint8_t encoded);
 
-    // CRC calculation
-    uint16_t calculateCRC16(const uint8_t* data, uint8_t length);
-    bool verifyCRC16(const uint8_t* data, uint8_t length, uint16_t expectedCRC);
-
-    // Header parsing
-    bool parseDataLinkLayerHeader(const uint8_t* data, uint8_t length, WmBusDataLinkLayerHeader* header);
+    // CRC verification
+    static bool verifyCRC16(const uint8_t* data, uint8_t length, uint16_t expectedCRC);
 
   public:
     WmBusHandler();
@@ -56,11 +81,28 @@ class WmBusHandler {
     // Initialize handler
     void init();
 
+    // 3-out-of-6 decoding of a whole buffer; fails on the first invalid code word
+    static bool decode3outof6(const uint8_t* encoded, uint8_t encodedLen, uint8_t* decoded, uint8_t* decodedLen);
+
+    // CRC-16 as used by EN 13757 (DLL header and TPL blocks)
+    static uint16_t calculateCRC16(const uint8_t* data, uint8_t length);
+
+    // Parse the DLL header of a decoded frame and verify its CRC
+    static bool parseDataLinkLayerHeader(const uint8_t* data, uint8_t length, WmBusDataLinkLayerHeader* header);
+
+    // Decode one raw packet without touching handler state (safe to call from several threads)
+    static WmBusDecodeStatus decodeFrame(const uint8_t* rawData, uint8_t rawLength, WmBusFrame* frame);
+    static const char* statusName(WmBusDecodeStatus status);
+
     // Process raw FSK modem data (3-out-of-6 encoded)
     bool processRawPacket(const uint8_t* rawData, uint8_t rawLength, int16_t rssi);
 
     // Set callback for parsed packets
     void setPacketCallback(WmBusPacketCallback callback);
+    void setUncheckedCallback(WmBusUncheckedCallback callback);
+
+    // Raw packets processed with the given result
+    uint32_t getStatusCount(WmBusDecodeStatus status) const { return statusCounts[static_cast<size_t>(status)]; }
 };
 
 extern WmBusHandler wmBusHandler;
@@ -0,0 +1,404 @@
+#include "bridge_metrics.h"
+#include "fsk_modem_manager.h"
+#include "izar_handler.h"
+#include "mqtt_manager.h"
+#include "prios_handler.h"
+#include "rx_scheduler.h"
+#include "spi_bus_arbiter.h"
+#include "wifi_manager.h"
+#include "wm_bus_handler.h"
+
+BridgeMetrics bridgeMetrics;
+
+namespace {
+// Exposition sections, in output order
+enum MetricsSection : uint8_t {
+    SECTION_FRAMES_RECEIVED,
+    SECTION_FRAMES_DECODED,
+    SECTION_FRAME_REJECTIONS,
+    SECTION_DECRYPT_FAILURES,
+    SECTION_READINGS_PUBLISHED,
+    SECTION_PUBLISH_FAILURES,
+    SECTION_MQTT_RECONNECTS,
+    SECTION_LOG_DROPPED,
+    SECTION_SPI_HOLD,
+    SECTION_SPI_HOLD_MAX,
+    SECTION_SPI_RADIO_WAIT,
+    SECTION_SPI_RADIO_WAIT_MAX,
+    SECTION_SPI_PREEMPTIONS,
+    SECTION_RX_SLEEP,
+    SECTION_RX_SCHEDULE_LOCKED,
+    SECTION_RX_MISSED_WINDOWS,
+    SECTION_LOOP_ITERATIONS,
+    SECTION_LOOP_DURATION,
+    SECTION_LOOP_DURATION_MAX,
+    SECTION_HEAP_FREE,
+    SECTION_HEAP_MIN_FREE,
+    SECTION_HEAP_LARGEST_BLOCK,
+    SECTION_WIFI_RSSI,
+    SECTION_UPTIME,
+    SECTION_BOOT_MILESTONE,
+    SECTION_METER_RSSI,
+    SECTION_METER_FRAMES,
+    SECTION_METER_LAST_SEEN,
+    SECTION_PIPELINE_LATENCY,
+    SECTION_EOF,
+    SECTION_COUNT
+};
+
+// Label values of izar_frame_rejections_total, indexed by WmBusDecodeStatus
+const char* const kRejectionReasons[WM_BUS_DECODE_STATUS_COUNT] = {
+    "ok", "invalid_length", "l_field_3of6", "insufficient_data", "body_3of6", "too_short", "dll_crc", "tpl_crc"};
+
+// Label values of the izar_spi_hold metrics, indexed by SpiClient
+const char* const kSpiClients[] = {"radio", "display"};
+static_assert(sizeof(kSpiClients) / sizeof(kSpiClients[0]) == static_cast<size_t>(SpiClient::COUNT),
+              "kSpiClients out of sync with SpiClient");
+
+// Label values of izar_boot_milestone_seconds, indexed by BootMilestone
+const char* const kBootMilestones[] = {"radio_ready", "first_rx", "first_publish"};
+static_assert(sizeof(kBootMilestones) / sizeof(kBootMilestones[0]) == static_cast<size_t>(BootMilestone::COUNT),
+              "kBootMilestones out of sync with BootMilestone");
+
+// Microseconds as exact decimal seconds
+int formatUs(char* out, size_t size, uint64_t us) {
+    return snprintf(out, size, "%llu.%06llu", static_cast<unsigned long long>(us / 1000000),
+                    static_cast<unsigned long long>(us % 1000000));
+}
+
+} // namespace
+
+void BridgeMetrics::recordLoop(uint32_t durationUs) {
+    unsigned long now = millis();
+    if (now - loopWindowStart >= METRICS_LOOP_MAX_WINDOW_MS) {
+        loopWindowStart = now;
+        previousLoopMaxUs = loopMaxUs;
+        loopMaxUs = 0;
+    }
+    loopIterations++;
+    loopTotalUs += durationUs;
+    if (durationUs > loopMaxUs) {
+        loopMaxUs = durationUs;
+    }
+}
+
+void BridgeMetrics::recordMeterFrame(const char* meterId, int16_t rssi) {
+    // Known meter, a free slot, or else the meter not heard from for the longest time
+    unsigned long now = millis();
+    MeterMetrics* slot = nullptr;
+    for (MeterMetrics& meter : meters) {
+        if (strcmp(meter.meterId, meterId) == 0) {
+            slot = &meter;
+            break;
+        }
+        if (!slot || (slot->meterId[0] && (!meter.meterId[0] || now - meter.lastSeenMs > now - slot->lastSeenMs))) {
+            slot = &meter;
+        }
+    }
+    if (strcmp(slot->meterId, meterId) != 0) {
+        strlcpy(slot->meterId, meterId, sizeof(slot->meterId));
+        slot->frames = 0;
+    }
+    slot->rssi = rssi;
+    slot->frames++;
+    slot->lastSeenMs = now;
+}
+
+void BridgeMetrics::markBoot(BootMilestone milestone) {
+    uint32_t& ms = bootMs[static_cast<size_t>(milestone)];
+    if (ms == 0) {
+        ms = std::max<uint32_t>(millis(), 1);
+    }
+}
+
+size_t MetricsWriter::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (lineOffset == lineLength) {
+            if (!nextLine()) {
+                break;
+            }
+            lineOffset = 0;
+        }
+        size_t chunk = std::min(lineLength - lineOffset, maxLen - written);
+        memcpy(buffer + written, line + lineOffset, chunk);
+        lineOffset += chunk;
+        written += chunk;
+    }
+    return written;
+}
+
+bool MetricsWriter::nextLine() {
+    while (section < SECTION_COUNT) {
+        size_t length = formatLine();
+        if (length > 0) {
+            item++;
+            line[length] = '\n';
+            lineLength = length + 1;
+            return true;
+        }
+        section++;
+        item = 0;
+    }
+    return false;
+}
+
+// One line of the current section (without newline), 0 once the section is complete
+size_t MetricsWriter::formatLine() {
+    switch (section) {
+    case SECTION_FRAMES_RECEIVED:
+        return formatScalar("izar_frames_received", "counter", "Packets read from the SX1262.", "_total",
+                            fskModemManager.getPacketCount());
+    case SECTION_FRAMES_DECODED:
+        return formatScalar("izar_frames_decoded", "counter", "Frames that passed 3-out-of-6 decoding and both CRCs.",
+                            "_total", wmBusHandler.getStatusCount(WmBusDecodeStatus::OK));
+    case SECTION_FRAME_REJECTIONS:
+        // Headers, one sample per decoder failure status from item 2 on (status 0 is OK), then PRIOS and IZAR
+        if (item < 2) {
+            return formatScalar("izar_frame_rejections", "counter", "Frames rejected by the decoder, by stage.",
+                                "_total", 0);
+        }
+        if (item - 1 < WM_BUS_DECODE_STATUS_COUNT) {
+            return finish(snprintf(line, kLineSize, "izar_frame_rejections_total{reason=\"%s\"} %lu",
+                                   kRejectionReasons[item - 1],
+                                   static_cast<unsigned long>(
+                                       wmBusHandler.getStatusCount(static_cast<WmBusDecodeStatus>(item - 1)))));
+        }
+        switch (item - 1 - WM_BUS_DECODE_STATUS_COUNT) {
+        case 0:
+            return finish(snprintf(line, kLineSize, "izar_frame_rejections_total{reason=\"prios_marker\"} %lu",
+                                   static_cast<unsigned long>(priosHandler.getMarkerFailures())));
+        case 1:
+            return finish(snprintf(line, kLineSize, "izar_frame_rejections_total{reason=\"izar_parse\"} %lu",
+                                   static_cast<unsigned long>(izarHandler.getParseFailures())));
+        default:
+            return 0;
+        }
+    case SECTION_DECRYPT_FAILURES:
+        return formatScalar("izar_decrypt_failures", "counter", "Bound-meter payloads too short to decrypt.",
+                            "_total", priosHandler.getDecryptFailures());
+    case SECTION_READINGS_PUBLISHED:
+        return formatScalar("izar_readings_published", "counter", "Readings accepted by the MQTT client.", "_total",
+                            bridgeMetrics.getReadingsPublished());
+    case SECTION_PUBLISH_FAILURES:
+        return formatScalar("izar_mqtt_publish_failures", "counter", "MQTT publishes the client rejected.", "_total",
+                            mqttManager.getPublishFailures());
+    case SECTION_MQTT_RECONNECTS:
+        return formatScalar("izar_mqtt_reconnects", "counter", "MQTT connections after the first one.", "_total",
+                            mqttManager.getReconnects());
+    case SECTION_LOG_DROPPED:
+        return formatScalar("izar_log_dropped", "counter", "Log lines dropped because the log queue was full.",
+                            "_total", logSink.getDropped());
+    case SECTION_SPI_HOLD:
+        return formatSpiHoldLine("izar_spi_hold_seconds", "counter", "Time the shared SPI bus was held, by client.",
+                                 "_total");
+    case SECTION_SPI_HOLD_MAX:
+        return formatSpiHoldLine("izar_spi_hold_max_seconds", "gauge", "Longest single SPI bus hold, by client.", "");
+    case SECTION_SPI_RADIO_WAIT:
+        return formatSeconds("izar_spi_radio_wait_seconds", "counter", "Time the radio waited for the SPI bus.",
+                             "_total", spiBus.getRadioWaitTotalUs());
+    case SECTION_SPI_RADIO_WAIT_MAX:
+        return formatSeconds("izar_spi_radio_wait_max_seconds", "gauge", "Longest radio wait for the SPI bus.", "",
+                             spiBus.getRadioWaitMaxUs());
+    case SECTION_SPI_PREEMPTIONS:
+        return formatScalar("izar_spi_display_preemptions", "counter",
+                            "Display flushes cut short at a chunk boundary for the radio.", "_total",
+                            spiBus.getPreemptions());
+    case SECTION_RX_SLEEP:
+        return formatSeconds("izar_rx_sleep_seconds", "counter", "Time the SX1262 slept between predicted frames.",
+                             "_total", fskModemManager.getSleepTotalMs() * 1000ULL);
+    case SECTION_RX_SCHEDULE_LOCKED:
+        return formatScalar("izar_rx_schedule_locked", "gauge", "1 while the bound meter's frames are on schedule.", "",
+                            rxScheduler.isLocked() ? 1 : 0);
+    case SECTION_RX_MISSED_WINDOWS:
+        return formatScalar("izar_rx_missed_windows", "counter",
+                            "Predicted RX windows that ended without a frame, each one resumes continuous RX.",
+                            "_total", rxScheduler.getMissedWindows());
+    case SECTION_LOOP_ITERATIONS:
+        return formatScalar("izar_loop_iterations", "counter", "Main loop iterations.", "_total",
+                            bridgeMetrics.getLoopIterations());
+    case SECTION_LOOP_DURATION:
+        return formatSeconds("izar_loop_duration_seconds", "counter", "Time spent in the main loop, without its delay.",
+                             "_total", bridgeMetrics.getLoopTotalUs());
+    case SECTION_LOOP_DURATION_MAX:
+        return formatSeconds("izar_loop_duration_max_seconds", "gauge", "Longest main loop iteration, last 1-2 min.",
+                             "", bridgeMetrics.getLoopMaxUs());
+    case SECTION_HEAP_FREE:
+        return formatScalar("izar_heap_free_bytes", "gauge", "Free heap.", "", ESP.getFreeHeap());
+    case SECTION_HEAP_MIN_FREE:
+        return formatScalar("izar_heap_min_free_bytes", "gauge", "Lowest free heap since boot.", "",
+                            ESP.getMinFreeHeap());
+    case SECTION_HEAP_LARGEST_BLOCK:
+        return formatScalar("izar_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block.", "",
+                            ESP.getMaxAllocHeap());
+    case SECTION_WIFI_RSSI:
+        return formatScalar("izar_wifi_rssi_dbm", "gauge", "WiFi signal strength.", "", wifiManager.getRSSI());
+    case SECTION_UPTIME:
+        return formatSeconds("izar_uptime_seconds", "gauge", "Time since boot.", "", millis() * 1000ULL);
+    case SECTION_BOOT_MILESTONE:
+        return formatBootLine();
+    case SECTION_METER_RSSI:
+        return formatMeterLine("izar_meter_rssi_dbm", "gauge", "Signal strength of the last frame from a meter.", "");
+    case SECTION_METER_FRAMES:
+        return formatMeterLine("izar_meter_frames", "counter", "Decoded frames per meter.", "_total");
+    case SECTION_METER_LAST_SEEN:
+        return formatMeterLine("izar_meter_last_frame_age_seconds", "gauge", "Time since the last frame from a meter.",
+                               "");
+    case SECTION_PIPELINE_LATENCY:
+#ifdef LATENCY_TRACE_ACTIVE
+        return formatLatencyLine();
+#else
+        return 0;
+#endif
+    case SECTION_EOF:
+        return item == 0 ? finish(snprintf(line, kLineSize, "# EOF")) : 0;
+    }
+    return 0;
+}
+
+// Length of what snprintf() wrote at line + offset, clamped like the output itself
+size_t MetricsWriter::finish(int length, size_t offset) const {
+    return length < 0 ? 0 : std::min(static_cast<size_t>(length), kLineSize - offset - 1);
+}
+
+size_t MetricsWriter::appendUs(size_t prefix, uint64_t us) {
+    return prefix + finish(formatUs(line + prefix, kLineSize - prefix, us), prefix);
+}
+
+// Lines 0 and 1 are the TYPE and HELP metadata, line 2 the sample
+size_t MetricsWriter::formatScalar(const char* name, const char* type, const char* help, const char* suffix,
+                                   int64_t value) {
+    int length = 0;
+    switch (item) {
+    case 0:
+        length = snprintf(line, kLineSize, "# TYPE %s %s", name, type);
+        break;
+    case 1:
+        length = snprintf(line, kLineSize, "# HELP %s %s", name, help);
+        break;
+    case 2:
+        length = snprintf(line, kLineSize, "%s%s %lld", name, suffix, static_cast<long long>(value));
+        break;
+    }
+    return finish(length);
+}
+
+size_t MetricsWriter::formatSeconds(const char* name, const char* type, const char* help, const char* suffix,
+                                    uint64_t us) {
+    if (item != 2) {
+        return formatScalar(name, type, help, suffix, 0);
+    }
+    size_t prefix = finish(snprintf(line, kLineSize, "%s%s ", name, suffix));
+    return appendUs(prefix, us);
+}
+
+// One sample per tracked meter; item walks the meter table from 2 on, skipping free slots
+size_t MetricsWriter::formatMeterLine(const char* name, const char* type, const char* help, const char* suffix) {
+    if (item < 2) {
+        return formatScalar(name, type, help, suffix, 0);
+    }
+    while (item - 2 < METRICS_MAX_METERS && bridgeMetrics.getMeter(item - 2).meterId[0] == '\0') {
+        item++;
+    }
+    if (item - 2 >= METRICS_MAX_METERS) {
+        return 0;
+    }
+
+    const MeterMetrics& meter = bridgeMetrics.getMeter(item - 2);
+    size_t prefix = finish(snprintf(line, kLineSize, "%s%s{meter=\"%s\"} ", name, suffix, meter.meterId));
+    switch (section) {
+    case SECTION_METER_RSSI:
+        return prefix + finish(snprintf(line + prefix, kLineSize - prefix, "%d", meter.rssi), prefix);
+    case SECTION_METER_FRAMES:
+        return prefix + finish(snprintf(line + prefix, kLineSize - prefix, "%lu",
+                                        static_cast<unsigned long>(meter.frames)),
+                               prefix);
+    default:
+        return appendUs(prefix, (millis() - meter.lastSeenMs) * 1000ULL);
+    }
+}
+
+// One sample per SPI client from item 2 on
+size_t MetricsWriter::formatSpiHoldLine(const char* name, const char* type, const char* help, const char* suffix) {
+    if (item < 2) {
+        return formatScalar(name, type, help, suffix, 0);
+    }
+    if (item >= 2 + static_cast<size_t>(SpiClient::COUNT)) {
+        return 0;
+    }
+    const SpiHoldStats& stats = spiBus.getHoldStats(static_cast<SpiClient>(item - 2));
+    size_t prefix = finish(snprintf(line, kLineSize, "%s%s{client=\"%s\"} ", name, suffix, kSpiClients[item - 2]));
+    return appendUs(prefix, section == SECTION_SPI_HOLD ? stats.totalUs : stats.maxUs);
+}
+
+// One sample per boot milestone reached, from item 2 on
+size_t MetricsWriter::formatBootLine() {
+    const char* name = "izar_boot_milestone_seconds";
+    if (item < 2) {
+        return formatScalar(name, "gauge", "Time from boot to each milestone reached.", "", 0);
+    }
+    while (item < 2 + static_cast<size_t>(BootMilestone::COUNT) &&
+           bridgeMetrics.getBootMs(static_cast<BootMilestone>(item - 2)) == 0) {
+        item++;
+    }
+    if (item >= 2 + static_cast<size_t>(BootMilestone::COUNT)) {
+        return 0;
+    }
+    uint32_t ms = bridgeMetrics.getBootMs(static_cast<BootMilestone>(item - 2));
+    size_t prefix = finish(snprintf(line, kLineSize, "%s{milestone=\"%s\"} ", name, kBootMilestones[item - 2]));
+    return appendUs(prefix, ms * 1000ULL);
+}
+
+#ifdef LATENCY_TRACE_ACTIVE
+// Cumulative non-empty buckets, +Inf, _count and _sum for each segment. bucket 0 means the segment's snapshot is
+// still to be taken, 1..LATENCY_BUCKETS walk the buckets, the three values after that are +Inf, _count and _sum.
+size_t MetricsWriter::formatLatencyLine() {
+    if (item < 2) {
+        return formatScalar("izar_pipeline_latency_seconds", "histogram",
+                            "Receive pipeline latency per segment, IRQ to MQTT publish.", "", 0);
+    }
+
+    while (segment < static_cast<uint8_t>(LatencyStage::COUNT)) {
+        LatencyStage stage = static_cast<LatencyStage>(segment);
+        const char* name = PipelineLatency::getSegmentName(stage);
+        if (bucket == 0) {
+            histogram = pipelineLatency.getHistogram(stage);
+            cumulative = 0;
+            bucket = 1;
+        }
+
+        while (bucket <= LATENCY_BUCKETS) {
+            size_t index = bucket++ - 1;
+            // The last bucket also holds everything slower than its bound, +Inf covers it
+            if (histogram.getBucket(index) == 0 || index == LATENCY_BUCKETS - 1) {
+                continue;
+            }
+            cumulative += histogram.getBucket(index);
+            char le[24];
+            formatUs(le, sizeof(le), LatencyHistogram::bucketUpperBound(index));
+            return finish(snprintf(line, kLineSize,
+                                   "izar_pipeline_latency_seconds_bucket{segment=\"%s\",le=\"%s\"} %lu", name, le,
+                                   static_cast<unsigned long>(cumulative)));
+        }
+
+        switch (bucket++) {
+        case LATENCY_BUCKETS + 1:
+            return finish(snprintf(line, kLineSize,
+                                   "izar_pipeline_latency_seconds_bucket{segment=\"%s\",le=\"+Inf\"} %lu", name,
+                                   static_cast<unsigned long>(histogram.getCount())));
+        case LATENCY_BUCKETS + 2:
+            return finish(snprintf(line, kLineSize, "izar_pipeline_latency_seconds_count{segment=\"%s\"} %lu", name,
+                                   static_cast<unsigned long>(histogram.getCount())));
+        case LATENCY_BUCKETS + 3:
+            return appendUs(
+                finish(snprintf(line, kLineSize, "izar_pipeline_latency_seconds_sum{segment=\"%s\"} ", name)),
+                histogram.getSum());
+        default:
+            segment++;
+            bucket = 0;
+            break;
+        }
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,95 @@
+#include "button_engine.h"
+
+void ButtonEngine::onLevel(bool pressed, uint32_t atMs) {
+    switch (state) {
+    case State::IDLE:
+        if (pressed) {
+            state = State::PRESSED;
+            pressMs = atMs;
+        }
+        break;
+    case State::PRESSED:
+        if (pressed) {
+            break;
+        }
+        if (atMs - pressMs < DEBOUNCE_MS) {
+            state = State::IDLE; // Glitch, not a press
+        } else if (atMs - pressMs >= LONG_PRESS_MS) {
+            push(ButtonEvent::BUTTON_EVENT_LONG_PRESS); // Released before poll() saw the hold
+            state = State::IDLE;
+        } else {
+            state = State::RELEASED;
+            releaseMs = atMs;
+        }
+        break;
+    case State::RELEASED:
+        if (!pressed) {
+            break;
+        }
+        if (atMs - releaseMs < DEBOUNCE_MS) {
+            state = State::PRESSED; // The release was contact bounce
+        } else {
+            state = State::SECOND_PRESSED;
+            pressMs = atMs;
+        }
+        break;
+    case State::SECOND_PRESSED:
+        if (pressed) {
+            break;
+        }
+        if (atMs - pressMs < DEBOUNCE_MS) {
+            state = State::RELEASED; // Glitch, keep waiting for the second press
+        } else {
+            push(ButtonEvent::BUTTON_EVENT_DOUBLE_PRESS);
+            state = State::IDLE;
+        }
+        break;
+    case State::WAIT_RELEASE:
+        if (!pressed) {
+            state = State::IDLE;
+        }
+        break;
+    }
+}
+
+void ButtonEngine::poll(uint32_t nowMs) {
+    switch (state) {
+    case State::PRESSED:
+        if (nowMs - pressMs >= LONG_PRESS_MS) {
+            push(ButtonEvent::BUTTON_EVENT_LONG_PRESS);
+            state = State::WAIT_RELEASE;
+        }
+        break;
+    case State::RELEASED:
+        if (nowMs - releaseMs >= DOUBLE_PRESS_GAP_MS) {
+            push(ButtonEvent::BUTTON_EVENT_SHORT_PRESS);
+            state = State::IDLE;
+        }
+        break;
+    case State::SECOND_PRESSED:
+        if (nowMs - pressMs >= DEBOUNCE_MS) {
+            push(ButtonEvent::BUTTON_EVENT_DOUBLE_PRESS);
+            state = State::WAIT_RELEASE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+ButtonEvent ButtonEngine::pop() {
+    if (queueCount == 0) {
+        return ButtonEvent::BUTTON_EVENT_NONE;
+    }
+    ButtonEvent event = queue[queueHead];
+    queueHead = (queueHead + 1) % QUEUE_SIZE;
+    queueCount--;
+    return event;
+}
+
+void ButtonEngine::push(ButtonEvent event) {
+    if (queueCount < QUEUE_SIZE) {
+        queue[(queueHead + queueCount) % QUEUE_SIZE] = event;
+        queueCount++;
+    }
+}
@@ -0,0 +1,223 @@
+#include "config_json_parser.h"
+#include <algorithm>
+#include <ctype.h>
+#include <stddef.h>
+#include "raw_frame_forwarder.h"
+
+namespace {
+constexpr uint8_t kTrim = 1 << 0;        // Strip surrounding whitespace
+constexpr uint8_t kKeepIfEmpty = 1 << 1; // Passwords: the portal never shows them, so empty keeps the stored one
+
+// Text settings accepted from the portal
+struct TextField {
+    const char* key;
+    size_t offset;
+    size_t size;
+    uint8_t flags;
+};
+
+#define CONFIG_TEXT_FIELD(name, flags) {#name, offsetof(Config, name), sizeof(Config::name), flags}
+const TextField kTextFields[] = {CONFIG_TEXT_FIELD(wifiSSID, kTrim),
+                                 CONFIG_TEXT_FIELD(wifiPassword, kKeepIfEmpty),
+                                 CONFIG_TEXT_FIELD(hostname, kTrim),
+                                 CONFIG_TEXT_FIELD(mqttBroker, 0),
+                                 CONFIG_TEXT_FIELD(mqttUsername, 0),
+                                 CONFIG_TEXT_FIELD(mqttPassword, kKeepIfEmpty),
+                                 CONFIG_TEXT_FIELD(mqttClientId, 0),
+                                 CONFIG_TEXT_FIELD(mqttBaseTopic, 0),
+                                 CONFIG_TEXT_FIELD(serialNumber, kTrim)};
+#undef CONFIG_TEXT_FIELD
+
+bool isLiteralChar(char c) {
+    return isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '+' || c == '.';
+}
+
+// Integer value or, for null and anything out of range, the fallback
+long parseNumber(const char* text, long maxValue, long fallback) {
+    char* end;
+    long number = strtol(text, &end, 10);
+    return end != text && *end == '\0' && number >= 0 && number <= maxValue ? number : fallback;
+}
+
+void copyTrimmed(char* out, size_t size, const char* text) {
+    while (isspace(static_cast<unsigned char>(*text))) {
+        text++;
+    }
+    size_t length = strlen(text);
+    while (length > 0 && isspace(static_cast<unsigned char>(text[length - 1]))) {
+        length--;
+    }
+    length = std::min(length, size - 1);
+    memcpy(out, text, length);
+    out[length] = '\0';
+}
+} // namespace
+
+bool ConfigJsonParser::feed(const uint8_t* data, size_t length) {
+    for (size_t i = 0; i < length && state != State::ERROR; i++) {
+        state = step(static_cast<char>(data[i]));
+    }
+    return state != State::ERROR;
+}
+
+ConfigJsonParser::State ConfigJsonParser::step(char c) {
+    bool space = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    switch (state) {
+    case State::START:
+        return space ? state : c == '{' ? State::KEY_OR_END : State::ERROR;
+    case State::KEY_OR_END:
+        if (space) {
+            return state;
+        }
+        if (c == '"') {
+            readingKey = true;
+            keyLength = 0;
+            return State::STRING;
+        }
+        return c == '}' && !afterComma ? State::DONE : State::ERROR;
+    case State::STRING:
+        if (escape) {
+            return stepEscape(c);
+        }
+        if (c == '\\') {
+            escape = 1;
+        } else if (c == '"') {
+            if (readingKey) {
+                key[keyLength] = '\0';
+                return State::COLON;
+            }
+            return assign(true) ? State::COMMA_OR_END : State::ERROR;
+        } else if (static_cast<uint8_t>(c) < 0x20) {
+            return State::ERROR;
+        } else {
+            append(c);
+        }
+        return state;
+    case State::COLON:
+        return space ? state : c == ':' ? State::VALUE : State::ERROR;
+    case State::VALUE:
+        if (space) {
+            return state;
+        }
+        readingKey = false;
+        valueLength = 0;
+        if (c == '"') {
+            return State::STRING;
+        }
+        if (!isLiteralChar(c)) {
+            return State::ERROR;
+        }
+        append(c);
+        return State::LITERAL;
+    case State::LITERAL:
+        if (isLiteralChar(c)) {
+            append(c);
+            return state;
+        }
+        if (!assign(false)) {
+            return State::ERROR;
+        }
+        state = State::COMMA_OR_END;
+        return step(c);
+    case State::COMMA_OR_END:
+        if (space) {
+            return state;
+        }
+        afterComma = c == ',';
+        return c == ',' ? State::KEY_OR_END : c == '}' ? State::DONE : State::ERROR;
+    case State::DONE:
+        return space ? state : State::ERROR;
+    case State::ERROR:
+        break;
+    }
+    return State::ERROR;
+}
+
+// \" \\ \/ \b \f \n \r \t and \uXXXX (written as UTF-8)
+ConfigJsonParser::State ConfigJsonParser::stepEscape(char c) {
+    if (escape == 1) {
+        const char* escapes = "\"\"\\\\//b\bf\fn\nr\rt\t";
+        escape = 0;
+        if (c == 'u') {
+            escape = 2;
+            unicode = 0;
+            return state;
+        }
+        for (const char* e = escapes; *e; e += 2) {
+            if (*e == c) {
+                append(e[1]);
+                return state;
+            }
+        }
+        return State::ERROR;
+    }
+    if (!isxdigit(static_cast<unsigned char>(c))) {
+        return State::ERROR;
+    }
+    unicode = unicode * 16 + (isdigit(static_cast<unsigned char>(c)) ? c - '0' : (tolower(c) - 'a' + 10));
+    if (++escape == 6) {
+        escape = 0;
+        if (unicode == 0 || (unicode >= 0xD800 && unicode < 0xE000)) {
+            append('?'); // NUL would end the string, surrogate pairs are not combined
+        } else if (unicode < 0x80) {
+            append(static_cast<char>(unicode));
+        } else if (unicode < 0x800) {
+            append(static_cast<char>(0xC0 | unicode >> 6));
+            append(static_cast<char>(0x80 | (unicode & 0x3F)));
+        } else {
+            append(static_cast<char>(0xE0 | unicode >> 12));
+            append(static_cast<char>(0x80 | ((unicode >> 6) & 0x3F)));
+            append(static_cast<char>(0x80 | (unicode & 0x3F)));
+        }
+    }
+    return state;
+}
+
+void ConfigJsonParser::append(char c) {
+    if (readingKey) {
+        if (keyLength < sizeof(key) - 1) {
+            key[keyLength++] = c;
+        }
+    } else if (valueLength < sizeof(value) - 1) {
+        value[valueLength++] = c;
+    }
+}
+
+bool ConfigJsonParser::assign(bool isString) {
+    value[valueLength] = '\0';
+    bool isNull = !isString && strcmp(value, "null") == 0;
+    if (!isString && !isNull && strcmp(value, "true") != 0 && strcmp(value, "false") != 0) {
+        char* end;
+        strtod(value, &end);
+        if (end == value || *end != '\0') {
+            return false;
+        }
+    }
+
+    if (strcmp(key, "mqttPort") == 0) {
+        config.mqttPort = parseNumber(value, UINT16_MAX, MQTT_PORT_DEFAULT);
+        return true;
+    }
+    if (strcmp(key, "rawForwardMode") == 0) {
+        config.rawForwardMode =
+            parseNumber(value, static_cast<long>(RawForwardMode::BINARY), RAW_FORWARD_MODE_DEFAULT);
+        return true;
+    }
+    for (const TextField& field : kTextFields) {
+        if (strcmp(key, field.key) != 0) {
+            continue;
+        }
+        const char* text = isNull ? "" : value;
+        if ((field.flags & kKeepIfEmpty) && text[0] == '\0') {
+            return true;
+        }
+        char* out = reinterpret_cast<char*>(&config) + field.offset;
+        if (field.flags & kTrim) {
+            copyTrimmed(out, field.size, text);
+        } else {
+            strlcpy(out, text, field.size);
+        }
+        return true;
+    }
+    return true;
+}
@@ -1,50 +1,182 @@
 #include "config_manager.h"
+#include <esp_rom_crc.h>
+#include <stddef.h>
 
 namespace {
-constexpr uint32_t kConfigVersion = 1;
+// Version 1 stored one NVS key per field, version 2 the Config blob
+constexpr uint16_t kConfigVersion = 2;
+constexpr uint32_t kLegacyConfigVersion = 1;
+
+const char* const kSlotKeys[] = {"cfg0", "cfg1"};
+const char* const kLegacyKeys[] = {"cfgVer",   "wifiSSID", "wifiPass",   "hostname", "mqttBroker", "mqttPort",
+                                   "mqttUser", "mqttPass", "mqttClient", "mqttBase", "rawFwd",     "serialNum",
+                                   "logLevels"};
+
+template <size_t N> void clearTail(char (&field)[N]) {
+    field[N - 1] = '\0';
+    size_t length = strlen(field);
+    memset(field + length, 0, N - length);
 }
+} // namespace
 
 ConfigManager configManager;
 
 void ConfigManager::begin() {
     prefs.begin("izar_cfg", false);
 
-    if (!prefs.isKey("cfgVer") || prefs.getUInt("cfgVer", 0) != kConfigVersion) {
-        applyDefaults();
-        save();
-    } else {
-        load();
+    if (loadBlob()) {
+        return;
+    }
+    if (prefs.isKey("cfgVer") && prefs.getUInt("cfgVer", 0) == kLegacyConfigVersion) {
+        migrateV1();
+        return;
     }
+    applyDefaults(config);
+    save();
 }
 
 Config& ConfigManager::getConfig() {
     return config;
 }
 
-void ConfigManager::save() {
-    prefs.putUInt("cfgVer", kConfigVersion);
-
-    prefs.putString("wifiSSID", config.wifiSSID);
-    prefs.putString("wifiPass", config.wifiPassword);
-    prefs.putString("hostname", config.hostname);
+bool ConfigManager::save() {
+    normalize(config);
+    if (storedValid && memcmp(&config, &stored, sizeof(Config)) == 0) {
+        LOG_DEBUG("Config", "Unchanged, not written");
+        return false;
+    }
 
-    prefs.putString("mqttBroker", config.mqttBroker);
-    prefs.putUInt("mqttPort", config.mqttPort);
-    prefs.putString("mqttUser", config.mqttUsername);
-    prefs.putString("mqttPass", config.mqttPassword);
-    prefs.putString("mqttClient", config.mqttClientId);
-    prefs.putString("mqttBase", config.mqttBaseTopic);
+    uint8_t blob[sizeof(BlobHeader) + sizeof(Config)];
+    BlobHeader header{kConfigVersion, sizeof(Config), sequence + 1, 0};
+    header.crc = blobCrc(header, reinterpret_cast<const uint8_t*>(&config));
+    memcpy(blob, &header, sizeof(header));
+    memcpy(blob + sizeof(header), &config, sizeof(Config));
 
-    prefs.putString("serialNum", config.serialNumber);
+    uint8_t slot = currentSlot ^ 1;
+    if (prefs.putBytes(kSlotKeys[slot], blob, sizeof(blob)) != sizeof(blob)) {
+        LOG_ERROR("Config", "Failed to write %s", kSlotKeys[slot]);
+        return false;
+    }
+    currentSlot = slot;
+    sequence = header.sequence;
+    stored = config;
+    storedValid = true;
+    LOG_DEBUG("Config", "Saved to %s (sequence %lu)", kSlotKeys[slot], static_cast<unsigned long>(sequence));
+    return true;
 }
 
 void ConfigManager::reset() {
     prefs.clear();
-    applyDefaults();
+    applyDefaults(config);
+    storedValid = false;
+    currentSlot = 1;
+    sequence = 0;
     save();
 }
 
-void ConfigManager::load() {
+void ConfigManager::requestUpdate(const Config& updated) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // A level change made after the portal took its snapshot must not be reverted by it
+    char levels[sizeof(pending.logLevels)];
+    strlcpy(levels, updatePending ? pending.logLevels : config.logLevels, sizeof(levels));
+    pending = updated;
+    strlcpy(pending.logLevels, levels, sizeof(pending.logLevels));
+    updateRequested = millis();
+    updatePending = true;
+}
+
+void ConfigManager::requestLogLevels(const char* spec) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!updatePending) {
+        pending = config;
+        updateRequested = millis();
+    }
+    strlcpy(pending.logLevels, spec, sizeof(pending.logLevels));
+    updatePending = true;
+}
+
+Config ConfigManager::getSnapshot() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return updatePending ? pending : config;
+}
+
+uint8_t ConfigManager::applyPending() {
+    if (!updatePending) {
+        return 0;
+    }
+    uint8_t changes;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (millis() - updateRequested < CONFIG_APPLY_DELAY) {
+            return 0;
+        }
+        changes = compare(config, pending);
+        config = pending;
+        updatePending = false;
+    }
+    save();
+    return changes;
+}
+
+// Newest valid slot; a shorter blob, written before fields were appended, keeps the defaults for the rest
+bool ConfigManager::loadBlob() {
+    bool found = false;
+    for (uint8_t slot = 0; slot < 2; slot++) {
+        BlobHeader header;
+        Config candidate{};
+        applyDefaults(candidate);
+        if (!readSlot(slot, header, candidate)) {
+            continue;
+        }
+        if (!found || static_cast<int32_t>(header.sequence - sequence) > 0) {
+            found = true;
+            config = candidate;
+            currentSlot = slot;
+            sequence = header.sequence;
+            storedValid = header.version == kConfigVersion && header.length == sizeof(Config);
+        }
+    }
+    if (found) {
+        normalize(config);
+        stored = config;
+    }
+    return found;
+}
+
+bool ConfigManager::readSlot(uint8_t slot, BlobHeader& header, Config& out) {
+    uint8_t blob[sizeof(BlobHeader) + sizeof(Config)];
+    size_t size = prefs.getBytesLength(kSlotKeys[slot]);
+    if (size == 0) {
+        return false;
+    }
+    if (size < sizeof(BlobHeader) || size > sizeof(blob) || prefs.getBytes(kSlotKeys[slot], blob, size) != size) {
+        LOG_WARN("Config", "Ignoring %s: bad size %u", kSlotKeys[slot], static_cast<unsigned>(size));
+        return false;
+    }
+    memcpy(&header, blob, sizeof(header));
+    const uint8_t* data = blob + sizeof(header);
+    if (header.version != kConfigVersion || header.length != size - sizeof(header) ||
+        header.crc != blobCrc(header, data)) {
+        LOG_WARN("Config", "Ignoring %s: version %u, bad length or CRC", kSlotKeys[slot], header.version);
+        return false;
+    }
+    memcpy(&out, data, header.length);
+    return true;
+}
+
+// Read the one-key-per-field layout, store it as a blob, then drop the old keys
+void ConfigManager::migrateV1() {
+    loadV1();
+    if (!save()) {
+        return;
+    }
+    for (const char* key : kLegacyKeys) {
+        prefs.remove(key);
+    }
+    LOG_INFO("Config", "Migrated from version %lu", static_cast<unsigned long>(kLegacyConfigVersion));
+}
+
+void ConfigManager::loadV1() {
     copyString(config.wifiSSID, sizeof(config.wifiSSID), prefs.getString("wifiSSID", WIFI_SSID_DEFAULT));
     copyString(config.wifiPassword, sizeof(config.wifiPassword), prefs.getString("wifiPass", WIFI_PASSWORD_DEFAULT));
     copyString(config.hostname, sizeof(config.hostname), prefs.getString("hostname", WIFI_HOSTNAME_DEFAULT));
@@ -56,26 +188,74 @@ void ConfigManager::load() {
     copyString(config.mqttClientId, sizeof(config.mqttClientId), prefs.getString("mqttClient", MQTT_CLIENT_ID_DEFAULT));
     copyString(config.mqttBaseTopic, sizeof(config.mqttBaseTopic),
                prefs.getString("mqttBase", MQTT_BASE_TOPIC_DEFAULT));
+    config.rawForwardMode = prefs.getUChar("rawFwd", RAW_FORWARD_MODE_DEFAULT);
 
     copyString(config.serialNumber, sizeof(config.serialNumber),
                prefs.getString("serialNum", IZAR_SERIAL_NUMBER_DEFAULT));
+
+    copyString(config.logLevels, sizeof(config.logLevels), prefs.getString("logLevels", ""));
 }
 
-void ConfigManager::applyDefaults() {
-    copyString(config.wifiSSID, sizeof(config.wifiSSID), WIFI_SSID_DEFAULT);
-    copyString(config.wifiPassword, sizeof(config.wifiPassword), WIFI_PASSWORD_DEFAULT);
-    copyString(config.hostname, sizeof(config.hostname), WIFI_HOSTNAME_DEFAULT);
+void ConfigManager::applyDefaults(Config& out) {
+    copyString(out.wifiSSID, sizeof(out.wifiSSID), WIFI_SSID_DEFAULT);
+    copyString(out.wifiPassword, sizeof(out.wifiPassword), WIFI_PASSWORD_DEFAULT);
+    copyString(out.hostname, sizeof(out.hostname), WIFI_HOSTNAME_DEFAULT);
+
+    copyString(out.mqttBroker, sizeof(out.mqttBroker), MQTT_BROKER_DEFAULT);
+    out.mqttPort = MQTT_PORT_DEFAULT;
+    copyString(out.mqttUsername, sizeof(out.mqttUsername), MQTT_USERNAME_DEFAULT);
+    copyString(out.mqttPassword, sizeof(out.mqttPassword), MQTT_PASSWORD_DEFAULT);
+    copyString(out.mqttClientId, sizeof(out.mqttClientId), MQTT_CLIENT_ID_DEFAULT);
+    copyString(out.mqttBaseTopic, sizeof(out.mqttBaseTopic), MQTT_BASE_TOPIC_DEFAULT);
+    out.rawForwardMode = RAW_FORWARD_MODE_DEFAULT;
 
-    copyString(config.mqttBroker, sizeof(config.mqttBroker), MQTT_BROKER_DEFAULT);
-    config.mqttPort = MQTT_PORT_DEFAULT;
-    copyString(config.mqttUsername, sizeof(config.mqttUsername), MQTT_USERNAME_DEFAULT);
-    copyString(config.mqttPassword, sizeof(config.mqttPassword), MQTT_PASSWORD_DEFAULT);
-    copyString(config.mqttClientId, sizeof(config.mqttClientId), MQTT_CLIENT_ID_DEFAULT);
-    copyString(config.mqttBaseTopic, sizeof(config.mqttBaseTopic), MQTT_BASE_TOPIC_DEFAULT);
+    copyString(out.serialNumber, sizeof(out.serialNumber), IZAR_SERIAL_NUMBER_DEFAULT);
 
-    copyString(config.serialNumber, sizeof(config.serialNumber), IZAR_SERIAL_NUMBER_DEFAULT);
+    out.logLevels[0] = '\0';
 }
 
 void ConfigManager::copyString(char* dest, size_t destSize, const String& src) {
     strlcpy(dest, src.c_str(), destSize);
 }
+
+void ConfigManager::normalize(Config& out) {
+    clearTail(out.wifiSSID);
+    clearTail(out.wifiPassword);
+    clearTail(out.hostname);
+    clearTail(out.mqttBroker);
+    clearTail(out.mqttUsername);
+    clearTail(out.mqttPassword);
+    clearTail(out.mqttClientId);
+    clearTail(out.mqttBaseTopic);
+    clearTail(out.serialNumber);
+    clearTail(out.logLevels);
+}
+
+uint8_t ConfigManager::compare(const Config& a, const Config& b) {
+    uint8_t changes = 0;
+    if (strcmp(a.wifiSSID, b.wifiSSID) != 0 || strcmp(a.wifiPassword, b.wifiPassword) != 0) {
+        changes |= CONFIG_CHANGE_WIFI;
+    }
+    if (strcmp(a.hostname, b.hostname) != 0) {
+        changes |= CONFIG_CHANGE_HOSTNAME;
+    }
+    if (strcmp(a.mqttBroker, b.mqttBroker) != 0 || a.mqttPort != b.mqttPort ||
+        strcmp(a.mqttUsername, b.mqttUsername) != 0 || strcmp(a.mqttPassword, b.mqttPassword) != 0) {
+        changes |= CONFIG_CHANGE_MQTT;
+    }
+    if (strcmp(a.mqttBaseTopic, b.mqttBaseTopic) != 0 || strcmp(a.mqttClientId, b.mqttClientId) != 0) {
+        changes |= CONFIG_CHANGE_MQTT_TOPICS;
+    }
+    if (strcmp(a.serialNumber, b.serialNumber) != 0) {
+        changes |= CONFIG_CHANGE_METER;
+    }
+    if (a.rawForwardMode != b.rawForwardMode) {
+        changes |= CONFIG_CHANGE_RAW_FORWARD;
+    }
+    return changes;
+}
+
+uint32_t ConfigManager::blobCrc(const BlobHeader& header, const uint8_t* data) {
+    uint32_t crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&header), offsetof(BlobHeader, crc));
+    return esp_rom_crc32_le(crc, data, header.length);
+}
@@ -1,4 +1,6 @@
 #include "display_manager.h"
+#include <algorithm>
+#include "spi_bus_arbiter.h"
 
 DisplayManager displayManager;
 
@@ -14,176 +16,199 @@ bool DisplayManager::init(SPIClass* sharedSPI) {
     LOG_INFO("Display", "Initializing display with M5GFX...");
     LOG_DEBUG("Display", "CS=%d, DC=%d, RST=%d", SSD1306_CS_PIN, SSD1306_DC_PIN, SSD1306_RST_PIN);
 
-    // Initialize M5GFX with auto-detection
-    if (!display.init()) {
-        LOG_ERROR("Display", "M5GFX initialization failed");
-        return false;
-    }
+    {
+        SpiBusLock lock(SpiClient::DISPLAY);
 
-    // Set rotation and clear
-    display.setRotation(0);
-    display.setBrightness(DISPLAY_BRIGHTNESS);
-    display.fillScreen(TFT_BLACK);
+        // Initialize M5GFX with auto-detection
+        if (!display.init()) {
+            LOG_ERROR("Display", "M5GFX initialization failed");
+            return false;
+        }
+
+        // Set rotation and clear
+        display.setRotation(0);
+        display.setBrightness(DISPLAY_BRIGHTNESS);
+        display.fillScreen(TFT_BLACK);
+    }
 
-    // Show welcome message
-    display.setTextColor(TFT_WHITE);
+    // Off-screen frame, all black like the panel now
+    frame.setColorDepth(1);
+    if (!frame.createSprite(DISPLAY_WIDTH, DISPLAY_HEIGHT)) {
+        LOG_ERROR("Display", "Failed to allocate the frame buffer");
+        return false;
+    }
+    frame.fillScreen(TFT_BLACK);
+    memset(shown, 0, sizeof(shown));
+    frameReady = true;
 
+    // Show welcome message, kept for DISPLAY_SPLASH_DURATION while the boot continues
     printAligned("IZAR RC868\nI W R4\nMQTT\nBRIDGE\nV " PROJECT_VERSION, HAlign::CENTER, VAlign::MIDDLE);
+    present();
+    splashStart = millis();
+    splashShown = true;
 
-    delay(5000);
     LOG_INFO("Display", "Display initialized successfully");
     LOG_DEBUG("Display", "Resolution: %dx%d pixels", display.width(), display.height());
 
     return true;
 }
 
+bool DisplayManager::isSplashShown() const {
+    return splashShown && millis() - splashStart < DISPLAY_SPLASH_DURATION;
+}
+
 void DisplayManager::clear() {
-    acquireSPIBus();
+    frame.fillScreen(TFT_BLACK);
+}
+
+void DisplayManager::present() {
+    if (!frameReady) {
+        return;
+    }
+    flushPending = false;
+    const uint8_t* pixels = static_cast<const uint8_t*>(frame.getBuffer());
+    for (int top = 0; top < DISPLAY_HEIGHT; top += kBandHeight) {
+        int bottom = std::min(top + kBandHeight, DISPLAY_HEIGHT);
+
+        // Changed byte columns in this band
+        int first = kStride;
+        int last = -1;
+        for (int y = top; y < bottom; y++) {
+            for (int column = 0; column < kStride; column++) {
+                if (pixels[y * kStride + column] != shown[y * kStride + column]) {
+                    first = std::min(first, column);
+                    last = std::max(last, column);
+                }
+            }
+        }
+        if (last < 0) {
+            continue;
+        }
 
-    display.fillScreen(TFT_BLACK);
+        // Radio first: the remaining bands stay dirty for handle()
+        if (spiBus.radioPending()) {
+            flushPending = true;
+            spiBus.recordPreemption();
+            return;
+        }
+        {
+            SpiBusLock lock(SpiClient::DISPLAY);
+            display.startWrite();
+            // The clip rectangle limits the push to the changed block
+            display.setClipRect(first * 8, top, (last - first + 1) * 8, bottom - top);
+            frame.pushSprite(&display, 0, 0);
+            display.clearClipRect();
+            display.endWrite();
+        }
+        for (int y = top; y < bottom; y++) {
+            memcpy(shown + y * kStride + first, pixels + y * kStride + first, last - first + 1);
+        }
+    }
+}
 
-    releaseSPIBus();
+void DisplayManager::handle() {
+    if (flushPending) {
+        present();
+    }
 }
 
 void DisplayManager::sleep() {
-    acquireSPIBus();
+    SpiBusLock lock(SpiClient::DISPLAY);
     display.setBrightness(0);
     display.sleep();
-    releaseSPIBus();
 }
 
 void DisplayManager::wake() {
-    acquireSPIBus();
+    SpiBusLock lock(SpiClient::DISPLAY);
     display.wakeup();
     display.setBrightness(DISPLAY_BRIGHTNESS);
-    releaseSPIBus();
 }
 
 void DisplayManager::printAligned(const char* text, HAlign hAlign, VAlign vAlign, int lineSpacing) {
     if (!text || strlen(text) == 0)
         return;
 
-    acquireSPIBus();
-
     // Get font metrics
-    int32_t fontH = display.fontHeight();
+    int32_t fontH = frame.fontHeight();
 
     // Use default line spacing if not specified (2px gap between lines)
     if (lineSpacing < 0) {
         lineSpacing = 2;
     }
 
-    // Split text into lines
-    String textStr = String(text);
-    std::vector<String> lines;
-    int startIdx = 0;
-    int newlineIdx;
-
-    while ((newlineIdx = textStr.indexOf('\n', startIdx)) != -1) {
-        lines.push_back(textStr.substring(startIdx, newlineIdx));
-        startIdx = newlineIdx + 1;
-    }
-    // Add last line
-    if (startIdx < textStr.length()) {
-        lines.push_back(textStr.substring(startIdx));
-    }
-
-    if (lines.empty()) {
-        releaseSPIBus();
-        return;
+    // Count lines, a trailing newline does not start another one
+    int32_t lineCount = 1;
+    for (const char* c = text; *c; c++) {
+        if (*c == '\n' && c[1] != '\0') {
+            lineCount++;
+        }
     }
 
     // Limit line spacing if it would make text exceed display height
-    if (lines.size() > 1) {
-        int32_t maxSpacing = (display.height() - (lines.size() * fontH)) / (lines.size() - 1);
+    if (lineCount > 1) {
+        int32_t maxSpacing = (DISPLAY_HEIGHT - (lineCount * fontH)) / (lineCount - 1);
         if (lineSpacing > maxSpacing) {
             lineSpacing = maxSpacing;
         }
     }
 
     // Calculate total block height: fontHeight per line + gap between lines
-    int32_t blockHeight = (lines.size() * fontH) + ((lines.size() - 1) * lineSpacing);
+    int32_t blockHeight = (lineCount * fontH) + ((lineCount - 1) * lineSpacing);
 
     // Calculate starting Y position based on vertical alignment
     int32_t startY = 0;
 
     if (vAlign == VAlign::MIDDLE) {
         // Center the entire block vertically
-        startY = (display.height() - blockHeight) / 2;
+        startY = (DISPLAY_HEIGHT - blockHeight) / 2;
     } else if (vAlign == VAlign::BOTTOM) {
         // Align block to bottom
-        startY = display.height() - blockHeight;
+        startY = DISPLAY_HEIGHT - blockHeight;
     }
     // TOP: startY = 0 (default)
 
-    // Draw each line
-    for (int i = 0; i < lines.size(); i++) {
-        if (lines[i].length() == 0)
-            continue;
-
-        // Calculate Y: each line is fontHeight + gap below previous line
-        int32_t y = startY + (i * (fontH + lineSpacing));
-
-        // Calculate X position based on horizontal alignment
-        int32_t x = 2; // Default left margin
-
-        if (hAlign == HAlign::CENTER) {
-            x = display.width() / 2;
-        } else if (hAlign == HAlign::RIGHT) {
-            x = display.width() - 2;
-        }
-
-        // Set text datum based on alignment
-        lgfx::v1::textdatum_t datum;
+    // Calculate X position and text datum based on horizontal alignment
+    int32_t x = 2; // Default left margin
+    lgfx::v1::textdatum_t datum = lgfx::v1::textdatum_t::top_left;
+    if (hAlign == HAlign::CENTER) {
+        x = DISPLAY_WIDTH / 2;
+        datum = lgfx::v1::textdatum_t::top_center;
+    } else if (hAlign == HAlign::RIGHT) {
+        x = DISPLAY_WIDTH - 2;
+        datum = lgfx::v1::textdatum_t::top_right;
+    }
+    frame.setTextColor(TFT_WHITE);
+    frame.setTextDatum(datum);
 
-        if (hAlign == HAlign::LEFT) {
-            datum = lgfx::v1::textdatum_t::top_left;
-        } else if (hAlign == HAlign::CENTER) {
-            datum = lgfx::v1::textdatum_t::top_center;
-        } else {
-            datum = lgfx::v1::textdatum_t::top_right;
+    // Draw each line
+    const char* line = text;
+    for (int32_t i = 0; i < lineCount; i++) {
+        const char* end = strchr(line, '\n');
+        size_t length = end ? end - line : strlen(line);
+        if (length > 0) {
+            char buffer[32];
+            length = std::min(length, sizeof(buffer) - 1);
+            memcpy(buffer, line, length);
+            buffer[length] = '\0';
+            // Y: each line is fontHeight + gap below previous line
+            frame.drawString(buffer, x, startY + (i * (fontH + lineSpacing)));
         }
-
-        // Set datum and draw
-        display.setTextColor(TFT_WHITE);
-        display.setTextDatum(datum);
-        display.drawString(lines[i].c_str(), x, y);
+        line = end ? end + 1 : line + length;
     }
 
     // Reset to default
-    display.setTextDatum(lgfx::v1::textdatum_t::top_left);
-
-    releaseSPIBus();
+    frame.setTextDatum(lgfx::v1::textdatum_t::top_left);
 }
 
 void DisplayManager::drawTimeoutLine(int height) {
     if (height <= 0)
         return;
 
-    acquireSPIBus();
-
     // Clamp height to display height
-    if (height > display.height()) {
-        height = display.height();
+    if (height > DISPLAY_HEIGHT) {
+        height = DISPLAY_HEIGHT;
     }
 
-    // Draw vertical line from bottom to top on left edge (x=0)
-    // Line goes from (0, display.height() - 1) up to (0, display.height() - height)
-    int startY = display.height() - 1;
-    int endY = display.height() - height;
-
-    display.drawLine(0, startY, 0, endY, TFT_WHITE);
-
-    releaseSPIBus();
-}
-
-void DisplayManager::acquireSPIBus() {
-    // For now, this is a placeholder for mutex/semaphore support
-    // if other threads access the SPI bus simultaneously
-    noInterrupts(); // Simple protection
-}
-
-void DisplayManager::releaseSPIBus() {
-    // Release SPI bus
-    interrupts(); // Re-enable interrupts
+    // Draw vertical line from bottom to top on left edge (x=0); present() sends only the pixels it grew by
+    frame.drawFastVLine(0, DISPLAY_HEIGHT - height, height, TFT_WHITE);
 }
@@ -1,10 +1,14 @@
 #include "fsk_modem_manager.h"
 #include "gpio_expander_manager.h"
+#include "pipeline_latency.h"
+#include "span_tracer.h"
+#include "spi_bus_arbiter.h"
 
 FskModemManager fskModemManager;
 
 // Define static member
 volatile bool FskModemManager::packetAvailable = false;
+volatile uint32_t FskModemManager::packetTimestampUs = 0;
 
 FskModemManager::FskModemManager()
     : radioModule(nullptr), radio(nullptr), packetBuffer{0}, packetLength(0), lastRSSI(0) {}
@@ -33,9 +37,10 @@ bool FskModemManager::init(SPIClass* sharedSPI) {
 
     // Release SX1262 from reset (set RST high)
     gpioExpanderManager.setSXReset(true);
-    delay(100); // Wait for reset
+    delay(5); // Startup after reset takes ~3.5 ms; RadioLib then waits on BUSY before each command
 
     // Initialize SX1262 in FSK mode
+    SpiBusLock lock(SpiClient::RADIO);
     int state = radio->beginFSK();
     if (state != RADIOLIB_ERR_NONE) {
         LOG_ERROR("FSK Modem", "Initialization failed with error code: %d", state);
@@ -144,11 +149,28 @@ void FskModemManager::receive() {
     }
 
     packetAvailable = false;
+    lastPacketTimestampUs = packetTimestampUs;
+    LATENCY_BEGIN(lastPacketTimestampUs);
+
+    // Hold the bus only for the SX1262 itself, the callback below may draw on the display
+    int state;
+    {
+        SpiBusLock lock(SpiClient::RADIO);
+        {
+            TRACE_SPAN(READ);
+            state = radio->readData(packetBuffer, FSK_MODEM_RX_MAX_LENGTH);
+        }
+        if (state == RADIOLIB_ERR_NONE) {
+            lastRSSI = radio->getRSSI();
+            LATENCY_MARK(READ);
+        }
 
-    int state = radio->readData(packetBuffer, FSK_MODEM_RX_MAX_LENGTH);
+        // Resume receiving, the packet is in packetBuffer now
+        radio->startReceive();
+    }
 
     if (state == RADIOLIB_ERR_NONE) {
-        lastRSSI = radio->getRSSI();
+        packetCount++;
 
         if (externalCallback != nullptr) {
             externalCallback(packetBuffer, FSK_MODEM_RX_MAX_LENGTH, lastRSSI);
@@ -156,18 +178,48 @@ void FskModemManager::receive() {
     } else {
         LOG_ERROR("FSK Modem", "Error reading data: %d", state);
     }
+}
+
+void FskModemManager::setListening(bool listening) {
+    if (!radio || listening != asleep) {
+        return; // Already in that state
+    }
+    if (!listening && packetAvailable) {
+        return; // Sleep would lose the FIFO, read the packet first
+    }
+
+    SpiBusLock lock(SpiClient::RADIO);
+    if (listening) {
+        // Any SPI command wakes the chip, RadioLib waits on BUSY until it is up
+        radio->standby();
+        int state = radio->startReceive();
+        if (state != RADIOLIB_ERR_NONE) {
+            LOG_ERROR("FSK Modem", "Failed to resume receive: %d", state);
+        }
+        asleep = false;
+        sleepTotalMs += millis() - sleepStartMs;
+    } else {
+        radio->sleep(true);
+        asleep = true;
+        sleepStartMs = millis();
+    }
+}
 
-    // Resume receiving
-    radio->startReceive();
+uint64_t FskModemManager::getSleepTotalMs() const {
+    return sleepTotalMs + (asleep ? millis() - sleepStartMs : 0);
 }
 
 void FskModemManager::handle() {
+    TRACE_SPAN(FSK_MODEM);
     receive();
 }
 
 // Static interrupt handler - called from ISR
 void FskModemManager::ReceiveInterruptHandler() {
+    fskModemManager.packetTimestampUs = micros();
     fskModemManager.packetAvailable = true;
+    spiBus.notifyRadioIrq();
+    TRACE_INSTANT(SX1262_IRQ);
 }
 
 void FskModemManager::setCallback(FskModemCallbackFunction callback) {
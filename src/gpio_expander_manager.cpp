@@ -1,7 +1,9 @@
 #include "gpio_expander_manager.h"
+#include "span_tracer.h"
 
 GPIOExpanderManager gpioExpanderManager;
 volatile bool GPIOExpanderManager::interruptFlag = false;
+volatile uint32_t GPIOExpanderManager::interruptMs = 0;
 
 GPIOExpanderManager::GPIOExpanderManager() {}
 
@@ -11,7 +13,6 @@ bool GPIOExpanderManager::init() {
     // Initialize I2C on the specified pins
     Wire.begin(GPIO_EXPANDER_SDA_PIN, GPIO_EXPANDER_SCL_PIN);
     Wire.setClock(GPIO_EXPANDER_I2C_CLOCK);
-    delay(100);
 
     // Check if device is responding
     Wire.beginTransmission(deviceAddress);
@@ -80,6 +81,12 @@ bool GPIOExpanderManager::init() {
     readRegister(REG_INT_STATUS, status);
     readRegister(REG_DEVICE_ID, status);
 
+    // Arm the interrupt for the button's current level, it may be held during boot
+    bool pressed;
+    if (readButtonLevel(pressed)) {
+        button.onLevel(pressed, millis());
+    }
+
     initialized = true;
     LOG_INFO("GPIOExpander", "Manager initialized successfully");
 
@@ -114,6 +121,7 @@ bool GPIOExpanderManager::reinit() {
     writeRegister(REG_PULL_SELECT, uint8_t(~CONFIG_MASK));
     writeRegister(REG_HIGH_Z, uint8_t(~CONFIG_MASK));
     writeRegister(REG_OUTPUT, portState);
+    interruptFlag = true; // Re-read the button level, which also re-arms its interrupt
 
     LOG_DEBUG("GPIOExpander", "Re-initialization complete");
     consecutiveErrors = 0;
@@ -121,9 +129,6 @@ bool GPIOExpanderManager::reinit() {
 }
 
 bool GPIOExpanderManager::readRegister(uint8_t reg, uint8_t& value) {
-    // Add small delay to prevent I2C bus overload
-    delayMicroseconds(100);
-
     Wire.beginTransmission(deviceAddress);
     Wire.write(reg);
     int error = Wire.endTransmission(false); // Don't release bus
@@ -169,61 +174,61 @@ bool GPIOExpanderManager::writeRegister(uint8_t reg, uint8_t value) {
     return true;
 }
 
+bool GPIOExpanderManager::readButtonLevel(bool& pressed) {
+    // Reading the status register releases the INT line
+    uint8_t status;
+    uint8_t inputState;
+    if (!readRegister(REG_INT_STATUS, status) || !readRegister(REG_INPUT, inputState)) {
+        return false;
+    }
+
+    // Button is active low (pressed = 0, released = 1)
+    pressed = (inputState & MASK_SYS_KEY1) == 0;
+
+    // The expander interrupts while an input differs from its default state. Making the current level the
+    // default arms it for the next edge in either direction; a change since the read above fires at once.
+    uint8_t inputDefault = uint8_t(~CONFIG_MASK);
+    if (pressed) {
+        inputDefault &= ~MASK_SYS_KEY1;
+    }
+    return writeRegister(REG_INPUT_DEFAULT, inputDefault);
+}
+
 // Static interrupt handler - MUST be minimal, no logging!
 void IRAM_ATTR GPIOExpanderManager::handleInterrupt() {
+    interruptMs = millis();
     interruptFlag = true;
+    TRACE_INSTANT(EXPANDER_IRQ);
 }
 
 ButtonEvent GPIOExpanderManager::getButtonEvent() {
     if (!initialized)
         return ButtonEvent::BUTTON_EVENT_NONE;
 
-    // Check for button press interrupt
-    if (interruptFlag && !buttonPressed) {
+    // I2C only after an edge. A low INT line without the flag means an interrupt that was never cleared
+    // (failed read), which no new falling edge would report.
+    bool edge = interruptFlag;
+    if (edge || (GPIO_EXPANDER_INT_PIN >= 0 && digitalRead(GPIO_EXPANDER_INT_PIN) == LOW)) {
         interruptFlag = false;
-        // Read interrupt status to clear the interrupt
-        uint8_t status;
-        if (!readRegister(REG_INT_STATUS, status)) {
-            LOG_ERROR("GPIOExpander", "Failed to read interrupt status");
-            return ButtonEvent::BUTTON_EVENT_NONE;
-        }
-
-        // Check if button interrupt occurred
-        if ((status & MASK_SYS_KEY1) != 0) {
-            buttonPressed = true;
-            buttonPressStartTime = millis();
-            LOG_DEBUG("GPIOExpander", "Button pressed");
+        uint32_t edgeMs = edge ? interruptMs : millis();
+        bool pressed;
+        if (readButtonLevel(pressed)) {
+            button.onLevel(pressed, edgeMs);
+        } else {
+            LOG_ERROR("GPIOExpander", "Failed to read button state");
         }
     }
 
-    // Poll button state if button was pressed
-    if (buttonPressed) {
-        // Read current input pin state
-        uint8_t inputState;
-        if (!readRegister(REG_INPUT, inputState)) {
-            LOG_ERROR("GPIOExpander", "Failed to read input state");
-            return ButtonEvent::BUTTON_EVENT_NONE;
-        }
-
-        // Button is active low (pressed = 0, released = 1)
-        bool currentlyPressed = ((inputState & MASK_SYS_KEY1) == 0);
-
-        if (!currentlyPressed) {
-            // Button released - determine event type
-            buttonPressed = false;
-            unsigned long pressDuration = millis() - buttonPressStartTime;
-
-            if (pressDuration >= LONG_PRESS_DURATION) {
-                LOG_DEBUG("GPIOExpander", "Long press detected (%lu ms)", pressDuration);
-                return ButtonEvent::BUTTON_EVENT_LONG_PRESS;
-            } else {
-                LOG_DEBUG("GPIOExpander", "Short press detected (%lu ms)", pressDuration);
-                return ButtonEvent::BUTTON_EVENT_SHORT_PRESS;
-            }
-        }
+    button.poll(millis());
+    ButtonEvent event = button.pop();
+    if (event == ButtonEvent::BUTTON_EVENT_SHORT_PRESS) {
+        LOG_DEBUG("GPIOExpander", "Short press detected");
+    } else if (event == ButtonEvent::BUTTON_EVENT_LONG_PRESS) {
+        LOG_DEBUG("GPIOExpander", "Long press detected");
+    } else if (event == ButtonEvent::BUTTON_EVENT_DOUBLE_PRESS) {
+        LOG_DEBUG("GPIOExpander", "Double press detected");
     }
-
-    return ButtonEvent::BUTTON_EVENT_NONE;
+    return event;
 }
 
 void GPIOExpanderManager::setSXLNAEnabled(bool enabled) {
@@ -1,5 +1,37 @@
 #include "hardware_manager.h"
 #include "gpio_expander_manager.h"
+#include "spi_bus_arbiter.h"
+
+namespace {
+// One step of an effect: tone (0 = silent) and LED color (0xRRGGBB, 0 = off) for durationMs
+struct EffectStep {
+    uint16_t toneHz;
+    uint32_t color;
+    uint16_t durationMs;
+};
+
+struct EffectPattern {
+    uint8_t priority; // A higher one preempts a lower one
+    uint8_t repeats;  // Times the steps are played
+    uint8_t stepCount;
+    const EffectStep* steps;
+};
+
+const EffectStep kSuccessSteps[] = {{1000, 0x00FF00, 100}, {1200, 0x00FF00, 100}, {1400, 0x00FF00, 100}};
+const EffectStep kFailureSteps[] = {{400, 0xFF0000, 200}, {0, 0, 100}, {400, 0xFF0000, 200}};
+const EffectStep kNewMeterSteps[] = {{2000, 0x0000FF, 50}, {0, 0, 50}, {2000, 0x0000FF, 50}};
+const EffectStep kLeakAlarmSteps[] = {{3000, 0xFF0000, 150}, {0, 0, 150}};
+
+#define EFFECT_PATTERN(priority, repeats, steps) {priority, repeats, sizeof(steps) / sizeof(steps[0]), steps}
+// Indexed by Effect
+const EffectPattern kEffects[] = {EFFECT_PATTERN(1, 1, kSuccessSteps), EFFECT_PATTERN(2, 1, kFailureSteps),
+                                  EFFECT_PATTERN(1, 1, kNewMeterSteps), EFFECT_PATTERN(3, 10, kLeakAlarmSteps)};
+#undef EFFECT_PATTERN
+
+const EffectPattern& patternOf(Effect effect) {
+    return kEffects[static_cast<size_t>(effect)];
+}
+} // namespace
 
 HardwareManager hardwareManager;
 
@@ -13,6 +45,7 @@ bool HardwareManager::init() {
     sharedSPI->setFrequency(SX1262_SSD1306_SPI_FREQUENCY);
     sharedSPI->setDataMode(SPI_MODE0);
     sharedSPI->setBitOrder(MSBFIRST);
+    spiBus.begin();
     LOG_DEBUG("Hardware", "Shared SPI initialized: SCK=%d, MOSI=%d, MISO=%d, Freq=%d MHz", SX1262_SSD1306_SCK_PIN,
               SX1262_SSD1306_MOSI_PIN, SX1262_SSD1306_MISO_PIN, SX1262_SSD1306_SPI_FREQUENCY / 1000000);
 
@@ -30,11 +63,15 @@ bool HardwareManager::init() {
         LOG_DEBUG("Hardware", "RGB LED (WS2812C) initialized on GPIO %d", RGB_LED_PIN);
     }
 
+    // Effect sequencer, its steps end on the esp_timer task
+    esp_timer_create_args_t timerArgs = {};
+    timerArgs.callback = onEffectTimer;
+    timerArgs.arg = this;
+    timerArgs.name = "effects";
+    esp_timer_create(&timerArgs, &effectTimer);
+
     // Test sound and LED
-    beepSuccess();
-    setRGBColor(0, 255, 0); // Green
-    delay(200);
-    rgbOff();
+    playEffect(Effect::SUCCESS);
 
     LOG_INFO("Hardware", "Manager initialized successfully");
     return true;
@@ -47,38 +84,119 @@ void HardwareManager::beep(int duration, int frequency) {
     tone(BUZZER_PIN, frequency, duration);
 }
 
-void HardwareManager::beepSuccess() {
-    beep(100, 1000);
-    delay(100);
-    beep(100, 1200);
-    delay(100);
-    beep(100, 1400);
+void HardwareManager::playEffect(Effect next) {
+    if ((!ENABLE_BUZZER && !ENABLE_RGB_LED) || effectTimer == nullptr)
+        return;
+
+    std::lock_guard<std::mutex> lock(effectMutex);
+    uint8_t priority = patternOf(next).priority;
+    if (!effectPlaying || priority > patternOf(effect).priority) {
+        startEffect(next);
+        return;
+    }
+
+    // Behind the waiting effects of the same or higher priority, dropped when the queue is full
+    if (effectQueueCount == EFFECT_QUEUE_SIZE) {
+        return;
+    }
+    uint8_t i = effectQueueCount++;
+    while (i > 0 && patternOf(effectQueue[i - 1]).priority < priority) {
+        effectQueue[i] = effectQueue[i - 1];
+        i--;
+    }
+    effectQueue[i] = next;
 }
 
-void HardwareManager::setRGBColor(uint8_t r, uint8_t g, uint8_t b) {
-    uint32_t color = strip.Color(r, g, b);
-    setRGBColor(color);
+// Runs on the esp_timer task at the end of each step
+void HardwareManager::onEffectTimer(void* arg) {
+    HardwareManager* self = static_cast<HardwareManager*>(arg);
+    std::lock_guard<std::mutex> lock(self->effectMutex);
+
+    // A preempting playEffect() may have re-armed the timer while this call waited for the mutex
+    if (!self->effectPlaying || esp_timer_get_time() < self->effectStepEndUs - 1000) {
+        return;
+    }
+    self->nextEffectStep();
 }
 
-void HardwareManager::setRGBColor(uint32_t color) {
-    if (!ENABLE_RGB_LED)
+// The effect* members below are only touched with effectMutex held
+void HardwareManager::startEffect(Effect next) {
+    effectPlaying = true;
+    effect = next;
+    effectStep = 0;
+    effectRepeat = 0;
+    showEffectStep();
+}
+
+void HardwareManager::nextEffectStep() {
+    const EffectPattern& pattern = patternOf(effect);
+    if (++effectStep < pattern.stepCount) {
+        showEffectStep();
         return;
+    }
+    effectStep = 0;
+    if (++effectRepeat < pattern.repeats) {
+        showEffectStep();
+        return;
+    }
 
-    rgbColor = color;
+    if (effectQueueCount > 0) {
+        Effect next = effectQueue[0];
+        effectQueueCount--;
+        memmove(effectQueue, effectQueue + 1, effectQueueCount * sizeof(Effect));
+        startEffect(next);
+        return;
+    }
+    effectPlaying = false;
+    if (ENABLE_BUZZER) {
+        noTone(BUZZER_PIN);
+    }
+    showLED(rgbColor);
+}
 
-    // Set pixel color and update
-    strip.setPixelColor(0, color);
-    strip.show();
+void HardwareManager::showEffectStep() {
+    const EffectStep& step = patternOf(effect).steps[effectStep];
+    if (ENABLE_BUZZER) {
+        if (step.toneHz > 0) {
+            tone(BUZZER_PIN, step.toneHz);
+        } else {
+            noTone(BUZZER_PIN);
+        }
+    }
+    showLED(step.color);
+
+    esp_timer_stop(effectTimer); // Fails harmlessly when the timer is not running
+    effectStepEndUs = esp_timer_get_time() + step.durationMs * 1000LL;
+    esp_timer_start_once(effectTimer, step.durationMs * 1000ULL);
 }
 
-void HardwareManager::rgbOff() {
+void HardwareManager::showLED(uint32_t color) {
     if (!ENABLE_RGB_LED)
         return;
 
-    strip.setPixelColor(0, strip.Color(0, 0, 0));
+    // Set pixel color and update
+    strip.setPixelColor(0, color);
     strip.show();
 }
 
+void HardwareManager::setRGBColor(uint8_t r, uint8_t g, uint8_t b) {
+    uint32_t color = strip.Color(r, g, b);
+    setRGBColor(color);
+}
+
+// Shown now, or once the playing effect ends
+void HardwareManager::setRGBColor(uint32_t color) {
+    std::lock_guard<std::mutex> lock(effectMutex);
+    rgbColor = color;
+    if (!effectPlaying) {
+        showLED(color);
+    }
+}
+
+void HardwareManager::rgbOff() {
+    setRGBColor(0);
+}
+
 ButtonEvent HardwareManager::getButtonEvent() {
     return gpioExpanderManager.getButtonEvent();
 }
@@ -0,0 +1,538 @@
+#include "history_store.h"
+#include <algorithm>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+HistoryStore historyStore;
+
+namespace {
+
+constexpr uint8_t TOKEN_FULL = 0xC0;
+constexpr uint8_t TOKEN_FULL_ALARMS = 0xC1;
+constexpr uint8_t TOKEN_KEYFRAME = 0xE0;
+constexpr int32_t COMPACT_DOD_MIN = -4;
+constexpr int32_t COMPACT_DOD_MAX = 3;
+constexpr int32_t COMPACT_DELTA_MAX = 15;
+constexpr size_t MAX_TOKEN = 1 + 3 * 5; // Token byte and three 32-bit varints
+
+size_t putVarint(uint8_t* out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(value);
+    return length;
+}
+
+uint32_t zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+int32_t unzigzag(uint32_t value) {
+    return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+}
+
+uint16_t alarmBits(const IzarAlarms& alarms) {
+    const bool flags[] = {alarms.general_alarm,          alarms.leakage_currently,
+                          alarms.leakage_previously,     alarms.meter_blocked,
+                          alarms.back_flow,              alarms.underflow,
+                          alarms.overflow,               alarms.submarine,
+                          alarms.sensor_fraud_currently, alarms.sensor_fraud_previously,
+                          alarms.mechanical_fraud_currently, alarms.mechanical_fraud_previously};
+    uint16_t bits = 0;
+    for (size_t i = 0; i < sizeof(flags) / sizeof(flags[0]); i++) {
+        if (flags[i]) {
+            bits |= 1 << i;
+        }
+    }
+    return bits;
+}
+
+// "<meterId>_<segment>.ts", the meter ID with anything but letters and digits replaced
+bool parseSegmentName(const char* name, char* meterId, size_t size, uint32_t& segment) {
+    const char* separator = strrchr(name, '_');
+    if (separator == nullptr || separator == name || static_cast<size_t>(separator - name) >= size) {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long value = strtoul(separator + 1, &end, 10);
+    if (end == separator + 1 || strcmp(end, ".ts") != 0) {
+        return false;
+    }
+    memcpy(meterId, name, separator - name);
+    meterId[separator - name] = '\0';
+    segment = value;
+    return true;
+}
+
+void formatLiters(char* out, size_t size, uint32_t liters) {
+    snprintf(out, size, "%lu.%03lu", static_cast<unsigned long>(liters / 1000),
+             static_cast<unsigned long>(liters % 1000));
+}
+
+} // namespace
+
+void HistoryStore::segmentPath(char* out, size_t size, const char* dir, const char* meterId, uint32_t segment) {
+    char safeId[16];
+    size_t i = 0;
+    for (; meterId[i] != '\0' && i < sizeof(safeId) - 1; i++) {
+        safeId[i] = isalnum(static_cast<unsigned char>(meterId[i])) ? meterId[i] : '-';
+    }
+    safeId[i] = '\0';
+    snprintf(out, size, "%s/%s_%lu.ts", dir, safeId, static_cast<unsigned long>(segment));
+}
+
+bool HistoryStore::begin(const char* path, uint32_t budget) {
+    strncpy(dir, path, sizeof(dir) - 1);
+    budgetBytes = budget;
+    usedBytes = 0;
+    ready = false;
+
+    if (mkdir(dir, 0755) != 0 && errno != EEXIST) {
+        LOG_ERROR("History", "Cannot create %s", dir);
+        return false;
+    }
+    DIR* handle = opendir(dir);
+    if (handle == nullptr) {
+        LOG_ERROR("History", "Cannot open %s", dir);
+        return false;
+    }
+    uint32_t files = 0;
+    char file[96];
+    while (struct dirent* entry = readdir(handle)) {
+        struct stat info;
+        int length = snprintf(file, sizeof(file), "%s/%s", dir, entry->d_name);
+        if (length < static_cast<int>(sizeof(file)) && strstr(entry->d_name, ".ts") != nullptr &&
+            stat(file, &info) == 0) {
+            usedBytes += info.st_size;
+            files++;
+        }
+    }
+    closedir(handle);
+
+    ready = true;
+    LOG_INFO("History", "%lu files, %lu of %lu bytes used", static_cast<unsigned long>(files),
+             static_cast<unsigned long>(usedBytes), static_cast<unsigned long>(budgetBytes));
+    enforceBudget(0);
+    return true;
+}
+
+HistoryStore::Series& HistoryStore::seriesFor(const char* meterId) {
+    Series* oldest = &series[0];
+    for (Series& entry : series) {
+        if (strcmp(entry.meterId, meterId) == 0) {
+            return entry;
+        }
+        if (entry.lastAppendMs < oldest->lastAppendMs || entry.meterId[0] == '\0') {
+            oldest = &entry;
+        }
+    }
+    // Reused slot: the next reading starts with a keyframe
+    memset(oldest, 0, sizeof(*oldest));
+    strncpy(oldest->meterId, meterId, sizeof(oldest->meterId) - 1);
+    return *oldest;
+}
+
+bool HistoryStore::append(const IzarReading& reading, uint32_t time) {
+    if (!ready || time < HISTORY_MIN_VALID_TIME) {
+        return false;
+    }
+    if (queueCount == HISTORY_QUEUE_SIZE) {
+        LOG_WARN("History", "Queue full, reading of %s dropped", reading.meterId);
+        return false;
+    }
+    if (queueCount == 0) {
+        firstQueuedMs = millis();
+    }
+    QueuedSample& queued = queue[queueCount++];
+    strncpy(queued.meterId, reading.meterId, sizeof(queued.meterId) - 1);
+    queued.meterId[sizeof(queued.meterId) - 1] = '\0';
+    queued.sample.time = time;
+    queued.sample.liters = static_cast<uint32_t>(lroundf(reading.current_reading * 1000.0f));
+    queued.sample.alarms = alarmBits(reading.alarms);
+    return true;
+}
+
+void HistoryStore::handle() {
+    if (queueCount >= HISTORY_FLUSH_READINGS || (queueCount > 0 && millis() - firstQueuedMs >= HISTORY_FLUSH_MS)) {
+        flush();
+    }
+}
+
+void HistoryStore::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Before encoding: a series whose file is removed restarts with a keyframe
+    if (activeReaders == 0) {
+        enforceBudget(queueCount * MAX_TOKEN);
+    }
+
+    // One pass per meter in arrival order, its tokens batched into a write per file
+    bool done[HISTORY_QUEUE_SIZE]{};
+    for (size_t i = 0; i < queueCount; i++) {
+        if (done[i]) {
+            continue;
+        }
+        Series& entry = seriesFor(queue[i].meterId);
+        entry.lastAppendMs = millis();
+        uint8_t batch[8 * MAX_TOKEN];
+        size_t length = 0;
+        for (size_t j = i; j < queueCount; j++) {
+            if (done[j] || strcmp(queue[j].meterId, entry.meterId) != 0) {
+                continue;
+            }
+            done[j] = true;
+            bool newSegment = queue[j].sample.time / HISTORY_SEGMENT_SECONDS != entry.segment;
+            if (length > 0 && (newSegment || length + MAX_TOKEN > sizeof(batch))) {
+                if (!write(entry, batch, length)) {
+                    entry.open = false;
+                }
+                length = 0;
+            }
+            length += encode(entry, queue[j].sample, batch + length);
+        }
+        if (length > 0 && !write(entry, batch, length)) {
+            entry.open = false;
+        }
+    }
+    queueCount = 0;
+}
+
+size_t HistoryStore::encode(Series& entry, const HistorySample& next, uint8_t* out) {
+    size_t length = 0;
+    uint32_t segment = next.time / HISTORY_SEGMENT_SECONDS;
+    if (entry.open && segment == entry.segment) {
+        if (next.time <= entry.last.time) {
+            return 0; // Repeated frame within the same second, or the clock stepped back
+        }
+        int32_t delta = static_cast<int32_t>(next.time - entry.last.time);
+        int32_t dod = delta - entry.lastDelta;
+        int32_t literDelta = static_cast<int32_t>(next.liters - entry.last.liters);
+        if (next.alarms == entry.last.alarms && dod >= COMPACT_DOD_MIN && dod <= COMPACT_DOD_MAX &&
+            literDelta >= 0 && literDelta <= COMPACT_DELTA_MAX) {
+            out[length++] = static_cast<uint8_t>(((dod - COMPACT_DOD_MIN) << 4) | literDelta);
+        } else {
+            bool alarmsChanged = next.alarms != entry.last.alarms;
+            out[length++] = alarmsChanged ? TOKEN_FULL_ALARMS : TOKEN_FULL;
+            length += putVarint(out + length, zigzag(dod));
+            length += putVarint(out + length, zigzag(literDelta));
+            if (alarmsChanged) {
+                length += putVarint(out + length, next.alarms);
+            }
+        }
+        entry.lastDelta = delta;
+    } else {
+        // New week, first reading since boot, the series slot was reused or its file evicted
+        out[length++] = TOKEN_KEYFRAME;
+        length += putVarint(out + length, next.time);
+        length += putVarint(out + length, next.liters);
+        length += putVarint(out + length, next.alarms);
+        entry.segment = segment;
+        entry.lastDelta = 0;
+    }
+    entry.open = true;
+    entry.last = next;
+    return length;
+}
+
+bool HistoryStore::write(Series& entry, const uint8_t* data, size_t length) {
+    char path[96];
+    segmentPath(path, sizeof(path), dir, entry.meterId, entry.segment);
+    FILE* file = fopen(path, "ab");
+    if (file == nullptr) {
+        LOG_ERROR("History", "Cannot open %s", path);
+        return false;
+    }
+    long start = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+    bool ok = start >= 0 && fwrite(data, 1, length, file) == length;
+    ok = fclose(file) == 0 && ok;
+    if (!ok) {
+        // Cut a partial append back off, the decoder would stop at it and lose everything written after it
+        LOG_ERROR("History", "Write to %s failed", path);
+        if (start < 0 || truncate(path, start) != 0) {
+            LOG_ERROR("History", "Cannot restore %s to %ld bytes", path, start);
+        }
+        return false;
+    }
+    usedBytes += length;
+    return true;
+}
+
+void HistoryStore::enforceBudget(size_t incoming) {
+    while (usedBytes + incoming > budgetBytes) {
+        // Oldest week of any meter; a series appending to it starts over with a keyframe
+        DIR* handle = opendir(dir);
+        if (handle == nullptr) {
+            return;
+        }
+        uint32_t oldest = UINT32_MAX;
+        while (struct dirent* entry = readdir(handle)) {
+            char meterId[16];
+            uint32_t segment;
+            if (parseSegmentName(entry->d_name, meterId, sizeof(meterId), segment) && segment < oldest) {
+                oldest = segment;
+            }
+        }
+        if (oldest == UINT32_MAX) {
+            closedir(handle);
+            return;
+        }
+        rewinddir(handle);
+        uint32_t freed = 0;
+        char path[96];
+        while (struct dirent* entry = readdir(handle)) {
+            char meterId[16];
+            uint32_t segment;
+            if (!parseSegmentName(entry->d_name, meterId, sizeof(meterId), segment) || segment != oldest) {
+                continue;
+            }
+            struct stat info;
+            int length = snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+            if (length < static_cast<int>(sizeof(path)) && stat(path, &info) == 0 && remove(path) == 0) {
+                freed += info.st_size;
+                LOG_INFO("History", "Budget reached, removed %s", entry->d_name);
+            }
+        }
+        closedir(handle);
+        for (Series& entry : series) {
+            if (entry.open && entry.segment == oldest) {
+                entry.open = false; // Its file is gone, restart with a keyframe
+            }
+        }
+        if (freed == 0) {
+            return;
+        }
+        usedBytes = freed > usedBytes ? 0 : usedBytes - freed;
+    }
+}
+
+HistoryWriter::HistoryWriter(HistoryStore& historyStore, const char* meter, uint32_t fromTime, uint32_t toTime,
+                             uint32_t stepSeconds)
+    : store(historyStore), from(fromTime), to(toTime), step(stepSeconds),
+      segment(fromTime / HISTORY_SEGMENT_SECONDS) {
+    // Same characters as the file names, which also keeps the ID safe to echo into the JSON
+    size_t i = 0;
+    for (; meter[i] != '\0' && i < sizeof(meterId) - 1; i++) {
+        meterId[i] = isalnum(static_cast<unsigned char>(meter[i])) ? meter[i] : '-';
+    }
+    meterId[i] = '\0';
+
+    std::lock_guard<std::mutex> lock(store.mutex);
+    store.activeReaders++;
+}
+
+HistoryWriter::~HistoryWriter() {
+    std::lock_guard<std::mutex> lock(store.mutex);
+    if (file != nullptr) {
+        fclose(file);
+    }
+    store.activeReaders--;
+}
+
+size_t HistoryWriter::read(uint8_t* buffer, size_t maxLen) {
+    std::lock_guard<std::mutex> lock(store.mutex); // Runs on the web server task
+    size_t written = 0;
+    while (written < maxLen) {
+        if (lineOffset == lineLength && !nextLine()) {
+            break;
+        }
+        size_t chunk = std::min(maxLen - written, lineLength - lineOffset);
+        memcpy(buffer + written, line + lineOffset, chunk);
+        lineOffset += chunk;
+        written += chunk;
+    }
+    return written;
+}
+
+bool HistoryWriter::nextLine() {
+    lineOffset = 0;
+    lineLength = 0;
+    if (stage == 0) {
+        lineLength = snprintf(line, sizeof(line),
+                              "{\"meter\":\"%s\",\"from\":%lu,\"to\":%lu,\"step\":%lu,\"buckets\":[", meterId,
+                              static_cast<unsigned long>(from), static_cast<unsigned long>(to),
+                              static_cast<unsigned long>(step));
+        stage = 1;
+        return true;
+    }
+    if (stage == 1) {
+        HistorySample next;
+        uint32_t consumed;
+        while (nextSample(next, consumed)) {
+            uint32_t start = from + (next.time - from) / step * step;
+            if (count > 0 && start != bucketStart) {
+                lineLength = formatBucket(); // Completed by the first sample of a later bucket
+                count = 0;
+            }
+            if (count == 0) {
+                bucketStart = start;
+                minLiters = next.liters;
+                maxLiters = next.liters;
+                consumption = 0;
+                alarms = 0;
+            }
+            count++;
+            minLiters = std::min(minLiters, next.liters);
+            maxLiters = std::max(maxLiters, next.liters);
+            lastLiters = next.liters;
+            consumption += consumed;
+            alarms |= next.alarms;
+            if (lineLength > 0) {
+                return true;
+            }
+        }
+        stage = 2;
+        if (count > 0) {
+            lineLength = formatBucket();
+            count = 0;
+            return true;
+        }
+    }
+    if (stage == 2) {
+        lineLength = snprintf(line, sizeof(line), "]}\n");
+        stage = 3;
+        return true;
+    }
+    return false;
+}
+
+size_t HistoryWriter::formatBucket() {
+    char minText[16];
+    char maxText[16];
+    char lastText[16];
+    char consumptionText[16];
+    formatLiters(minText, sizeof(minText), minLiters);
+    formatLiters(maxText, sizeof(maxText), maxLiters);
+    formatLiters(lastText, sizeof(lastText), lastLiters);
+    formatLiters(consumptionText, sizeof(consumptionText), consumption);
+    int length = snprintf(line, sizeof(line),
+                          "%s{\"t\":%lu,\"count\":%lu,\"min\":%s,\"max\":%s,\"last\":%s,\"consumption\":%s,"
+                          "\"alarms\":%u}",
+                          firstBucket ? "" : ",", static_cast<unsigned long>(bucketStart),
+                          static_cast<unsigned long>(count), minText, maxText, lastText, consumptionText,
+                          static_cast<unsigned>(alarms));
+    firstBucket = false;
+    return length > 0 ? std::min(static_cast<size_t>(length), sizeof(line) - 1) : 0;
+}
+
+bool HistoryWriter::openSegment() {
+    // The meter's next week that has a file, from one directory scan rather than a probe per week of the range
+    uint32_t lastSegment = (to - 1) / HISTORY_SEGMENT_SECONDS;
+    while (segment <= lastSegment) {
+        DIR* handle = opendir(store.dir);
+        if (handle == nullptr) {
+            return false;
+        }
+        uint32_t next = UINT32_MAX;
+        while (struct dirent* entry = readdir(handle)) {
+            char name[16];
+            uint32_t found;
+            if (parseSegmentName(entry->d_name, name, sizeof(name), found) && strcmp(name, meterId) == 0 &&
+                found >= segment && found <= lastSegment && found < next) {
+                next = found;
+            }
+        }
+        closedir(handle);
+        if (next == UINT32_MAX) {
+            segment = UINT32_MAX;
+            return false;
+        }
+
+        char path[96];
+        HistoryStore::segmentPath(path, sizeof(path), store.dir, meterId, next);
+        segment = next + 1;
+        file = fopen(path, "rb");
+        if (file != nullptr) {
+            inputLength = 0;
+            inputOffset = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryWriter::nextByte(uint8_t& value) {
+    if (inputOffset == inputLength) {
+        inputLength = fread(input, 1, sizeof(input), file);
+        inputOffset = 0;
+        if (inputLength == 0) {
+            return false;
+        }
+    }
+    value = input[inputOffset++];
+    return true;
+}
+
+bool HistoryWriter::nextVarint(uint32_t& value) {
+    value = 0;
+    for (uint8_t shift = 0; shift < 35; shift += 7) {
+        uint8_t byte;
+        if (!nextByte(byte)) {
+            return false;
+        }
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HistoryWriter::nextSample(HistorySample& out, uint32_t& consumed) {
+    while (true) {
+        if (file == nullptr && !openSegment()) {
+            return false;
+        }
+        uint8_t token;
+        HistorySample decoded = sample;
+        bool ok = nextByte(token);
+        if (ok && token < 0x80) {
+            int32_t delta = lastDelta + (token >> 4) + COMPACT_DOD_MIN;
+            decoded.time += delta;
+            decoded.liters += token & 0x0F;
+            lastDelta = delta;
+        } else if (ok && (token == TOKEN_FULL || token == TOKEN_FULL_ALARMS)) {
+            uint32_t dod;
+            uint32_t literDelta;
+            uint32_t bits = decoded.alarms;
+            ok = nextVarint(dod) && nextVarint(literDelta) && (token == TOKEN_FULL || nextVarint(bits));
+            int32_t delta = lastDelta + unzigzag(dod);
+            decoded.time += delta;
+            decoded.liters += unzigzag(literDelta);
+            decoded.alarms = bits;
+            lastDelta = delta;
+        } else if (ok && token == TOKEN_KEYFRAME) {
+            uint32_t bits;
+            ok = nextVarint(decoded.time) && nextVarint(decoded.liters) && nextVarint(bits);
+            decoded.alarms = bits;
+            lastDelta = 0;
+        } else {
+            ok = false; // End of the file, or an unknown token from a torn write: the rest of it is skipped
+        }
+        if (!ok) {
+            fclose(file);
+            file = nullptr;
+            continue;
+        }
+
+        // Consumption since the previous reading, whichever file it came from; a meter reset counts nothing
+        consumed = haveSample && decoded.liters > sample.liters ? decoded.liters - sample.liters : 0;
+        sample = decoded;
+        haveSample = true;
+        if (decoded.time >= to) {
+            fclose(file);
+            file = nullptr;
+            segment = UINT32_MAX; // Past the range, no further segments
+            return false;
+        }
+        if (decoded.time >= from) {
+            out = decoded;
+            return true;
+        }
+    }
+}
@@ -1,4 +1,5 @@
 #include "izar_handler.h"
+#include "span_tracer.h"
 
 IzarHandler izarHandler;
 
@@ -17,7 +18,7 @@ void IzarHandler::init() {
 bool IzarHandler::parseReading(const char* meterId, const uint8_t* data, uint8_t dataLen, int16_t rssi,
                                IzarReading* reading) {
     if (!data || !reading || dataLen < IZAR_MIN_DATA_LENGTH) {
-        LOG_ERROR("IZAR", "Insufficient data for parsing");
+        LOG_DEBUG("IZAR", "Insufficient data for parsing");
         return false;
     }
 
@@ -83,28 +84,30 @@ bool IzarHandler::parseReading(const char* meterId, const uint8_t* data, uint8_t
 bool IzarHandler::processData(const char* meterId, const uint8_t* data, uint8_t dataLen, int16_t rssi) {
     if (!data || dataLen < IZAR_MIN_DATA_LENGTH) {
         LOG_ERROR("IZAR", "Invalid data");
+        parseFailures++;
         return false;
     }
 
-    // Magic byte should be 0x4B (magic marker from PRIOS decryption)
+    // Magic byte should be 0x4B; PRIOS decryption already rejects (and counts) any other marker
     if (data[IZAR_OFFSET_MAGIC_BYTE] != 0x4B) {
         LOG_ERROR("IZAR", "Invalid magic byte: 0x%02X (expected 0x4B)", data[IZAR_OFFSET_MAGIC_BYTE]);
+        parseFailures++;
         return false;
     }
 
     LOG_DEBUG("IZAR", "Processing meter data for ID %s (%d bytes, RSSI=%d dBm)", meterId, dataLen, rssi);
-    LOG_DEBUG("IZAR", "Data: ");
-    for (uint8_t i = 0; i < dataLen && i < 32; i++) {
-        LOG_DEBUG("IZAR", "%02X ", data[i]);
-    }
-    if (dataLen > 32)
-        LOG_DEBUG("IZAR", "...");
-    LOG_DEBUG("IZAR", "");
+    LOG_DEBUG_HEX("IZAR", "Data", data, dataLen);
 
     // Parse the meter reading
     IzarReading reading;
-    if (!parseReading(meterId, data, dataLen, rssi, &reading)) {
+    bool parsed;
+    {
+        TRACE_SPAN(PARSE);
+        parsed = parseReading(meterId, data, dataLen, rssi, &reading);
+    }
+    if (!parsed) {
         LOG_ERROR("IZAR", "Failed to parse meter reading");
+        parseFailures++;
         return false;
     }
 
@@ -0,0 +1,243 @@
+#include "link_quality.h"
+#include <algorithm>
+#include "fsk_modem_manager.h"
+#include "izar_handler.h"
+#include "mqtt_manager.h"
+#include "prios_handler.h"
+#include "wm_bus_handler.h"
+
+LinkQuality linkQuality;
+
+namespace {
+// Decoder statuses reported as rejections, with their JSON keys
+struct RejectionKey {
+    WmBusDecodeStatus status;
+    const char* key;
+};
+const RejectionKey kDecodeRejections[] = {{WmBusDecodeStatus::INVALID_LENGTH, "invalid_length"},
+                                          {WmBusDecodeStatus::L_FIELD_DECODE_FAILED, "l_field_3of6"},
+                                          {WmBusDecodeStatus::INSUFFICIENT_DATA, "insufficient_data"},
+                                          {WmBusDecodeStatus::DECODE_3OF6_FAILED, "body_3of6"},
+                                          {WmBusDecodeStatus::TOO_SHORT, "too_short"},
+                                          {WmBusDecodeStatus::DLL_CRC_FAILED, "dll_crc"},
+                                          {WmBusDecodeStatus::TPL_CRC_FAILED, "tpl_crc"}};
+
+// Whole radio intervals in a gap, rounded to absorb the meter's transmit jitter
+uint32_t intervalsIn(unsigned long gapMs, uint16_t intervalS) {
+    uint32_t intervalMs = static_cast<uint32_t>(intervalS) * 1000;
+    return (gapMs + intervalMs / 2) / intervalMs;
+}
+
+uint16_t saturatingAdd(uint16_t value, uint32_t add) {
+    return static_cast<uint16_t>(std::min<uint32_t>(value + add, UINT16_MAX));
+}
+} // namespace
+
+void LinkQuality::recordFrame(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                              const uint8_t* tplData, uint8_t tplDataLen, int16_t rssi) {
+    unsigned long now = millis();
+    if (measurementStart == 0) {
+        measurementStart = now;
+        windowStart = now;
+    }
+    MeterLink* meter = findMeter(meterId);
+
+    // radio_interval is in the plain status byte, decrypting only confirms this is an IZAR frame
+    uint8_t payload[WM_BUS_MAX_PAYLOAD];
+    if (tplDataLen <= sizeof(payload)) {
+        memcpy(payload, tplData, tplDataLen);
+        IzarReading reading;
+        if (PriosHandler::decryptPayload(fullwMBusFrame, fullwMBusFrameLen, payload, tplDataLen) &&
+            IzarHandler::parseReading(meterId, payload, tplDataLen, rssi, &reading) && reading.radio_interval > 0) {
+            meter->intervalS = reading.radio_interval;
+        }
+    }
+
+    LinkWindow& window = meter->windows[currentWindow];
+    if (meter->lastFrameMs != 0 && meter->intervalS > 0) {
+        uint32_t intervals = intervalsIn(now - meter->lastFrameMs, meter->intervalS);
+        if (intervals == 0) {
+            // Repeated transmission of the same frame
+            return;
+        }
+        // One gap never adds more misses than a whole window can hold
+        uint32_t maxMissed = LINK_QUALITY_WINDOW_MS / (meter->intervalS * 1000UL);
+        window.missed = saturatingAdd(window.missed, std::min<uint32_t>(intervals - 1, maxMissed));
+    }
+    window.received = saturatingAdd(window.received, 1);
+    window.rssiSum += rssi;
+    meter->lastRssi = rssi;
+    meter->lastFrameMs = now;
+}
+
+MeterLink* LinkQuality::findMeter(const char* meterId) {
+    // Known meter, a free slot, or else the meter not heard from for the longest time
+    unsigned long now = millis();
+    MeterLink* slot = nullptr;
+    for (MeterLink& meter : meters) {
+        if (strcmp(meter.meterId, meterId) == 0) {
+            return &meter;
+        }
+        if (!slot || (slot->meterId[0] && (!meter.meterId[0] || now - meter.lastFrameMs > now - slot->lastFrameMs))) {
+            slot = &meter;
+        }
+    }
+    memset(slot, 0, sizeof(MeterLink));
+    strlcpy(slot->meterId, meterId, sizeof(slot->meterId));
+    return slot;
+}
+
+void LinkQuality::reset() {
+    memset(meters, 0, sizeof(meters));
+    currentWindow = 0;
+    measurementStart = 0;
+}
+
+void LinkQuality::rotateWindows() {
+    unsigned long now = millis();
+    while (measurementStart != 0 && now - windowStart >= LINK_QUALITY_WINDOW_MS) {
+        windowStart += LINK_QUALITY_WINDOW_MS;
+        currentWindow = (currentWindow + 1) % LINK_QUALITY_WINDOWS;
+        for (MeterLink& meter : meters) {
+            meter.windows[currentWindow] = LinkWindow{};
+        }
+    }
+}
+
+void LinkQuality::handle() {
+    if (resetPending) {
+        resetPending = false;
+        reset();
+    }
+    rotateWindows();
+
+    unsigned long now = millis();
+    if (now - lastPublish < LINK_QUALITY_PUBLISH_INTERVAL || !mqttManager.isConnected()) {
+        return;
+    }
+    lastPublish = now;
+    if (measurementStart != 0) {
+        mqttManager.publish(mqttManager.getTopicDiagnostics(), getJSON(LINK_QUALITY_MQTT_METERS).c_str());
+    }
+}
+
+void LinkQuality::getTotals(const MeterLink& meter, uint32_t& received, uint32_t& missed, int32_t& rssiSum) const {
+    received = 0;
+    missed = 0;
+    rssiSum = 0;
+    for (const LinkWindow& window : meter.windows) {
+        received += window.received;
+        missed += window.missed;
+        rssiSum += window.rssiSum;
+    }
+    // A meter that went silent keeps accumulating misses until it drops out of all windows
+    if (meter.intervalS > 0 && meter.lastFrameMs != 0) {
+        uint32_t openIntervals = intervalsIn(millis() - meter.lastFrameMs, meter.intervalS);
+        uint32_t maxMissed = LINK_QUALITY_WINDOW_MS * LINK_QUALITY_WINDOWS / (meter.intervalS * 1000UL);
+        missed += std::min<uint32_t>(openIntervals > 0 ? openIntervals - 1 : 0, maxMissed);
+    }
+}
+
+String LinkQuality::getJSON(size_t maxMeters) const {
+    String json = "{\"rejections\":{\"received\":";
+    json += fskModemManager.getPacketCount();
+    for (const RejectionKey& rejection : kDecodeRejections) {
+        json += ",\"";
+        json += rejection.key;
+        json += "\":";
+        json += wmBusHandler.getStatusCount(rejection.status);
+    }
+    json += ",\"decrypt\":";
+    json += priosHandler.getDecryptFailures();
+    json += ",\"prios_marker\":";
+    json += priosHandler.getMarkerFailures();
+    json += ",\"izar_parse\":";
+    json += izarHandler.getParseFailures();
+    json += "}";
+
+    // Rank meters worst first: known PER descending, then meters without PER, weaker signal first within each
+    struct Ranked {
+        const MeterLink* meter;
+        uint32_t received;
+        uint32_t missed;
+        int32_t rssiSum;
+        float per;
+    };
+    Ranked ranked[LINK_QUALITY_MAX_METERS];
+    size_t count = 0;
+    uint32_t totalReceived = 0;
+    uint32_t totalMissed = 0;
+    int64_t totalRssi = 0;
+    uint32_t rssiFrames = 0;
+    for (const MeterLink& meter : meters) {
+        if (!meter.meterId[0]) {
+            continue;
+        }
+        Ranked& entry = ranked[count++];
+        entry.meter = &meter;
+        getTotals(meter, entry.received, entry.missed, entry.rssiSum);
+        uint32_t expected = entry.received + entry.missed;
+        entry.per = meter.intervalS > 0 && expected > 0 ? static_cast<float>(entry.missed) / expected : -1.0f;
+        if (meter.intervalS > 0) {
+            totalReceived += entry.received;
+            totalMissed += entry.missed;
+        }
+        totalRssi += entry.rssiSum;
+        rssiFrames += entry.received;
+    }
+    std::sort(ranked, ranked + count, [](const Ranked& a, const Ranked& b) {
+        if (a.per != b.per) {
+            return a.per > b.per;
+        }
+        return a.meter->lastRssi < b.meter->lastRssi;
+    });
+
+    json += ",\"window_s\":";
+    json += LINK_QUALITY_WINDOW_MS / 1000;
+    json += ",\"measured_s\":";
+    json += measurementStart != 0 ? (millis() - measurementStart) / 1000 : 0;
+    json += ",\"overall\":{\"meters\":";
+    json += count;
+    json += ",\"received\":";
+    json += totalReceived;
+    json += ",\"missed\":";
+    json += totalMissed;
+    json += ",\"per\":";
+    uint32_t totalExpected = totalReceived + totalMissed;
+    json += String(totalExpected > 0 ? static_cast<float>(totalMissed) / totalExpected : 0.0f, 4);
+    json += ",\"mean_rssi\":";
+    json += String(rssiFrames > 0 ? static_cast<float>(totalRssi) / rssiFrames : 0.0f, 1);
+    json += "},\"meters\":[";
+
+    for (size_t i = 0; i < count && i < maxMeters; i++) {
+        const Ranked& entry = ranked[i];
+        if (i > 0) {
+            json += ",";
+        }
+        json += "{\"rank\":";
+        json += i + 1;
+        json += ",\"id\":\"";
+        json += entry.meter->meterId;
+        json += "\",\"interval_s\":";
+        json += entry.meter->intervalS;
+        json += ",\"received\":";
+        json += entry.received;
+        json += ",\"missed\":";
+        json += entry.missed;
+        json += ",\"per\":";
+        if (entry.per < 0) {
+            json += "null";
+        } else {
+            json += String(entry.per, 4);
+        }
+        json += ",\"rssi\":";
+        json += entry.meter->lastRssi;
+        json += ",\"mean_rssi\":";
+        json += String(entry.received > 0 ? static_cast<float>(entry.rssiSum) / entry.received : 0.0f, 1);
+        json += ",\"last_seen_s\":";
+        json += (millis() - entry.meter->lastFrameMs) / 1000;
+        json += "}";
+    }
+    json += "]}";
+    return json;
+}
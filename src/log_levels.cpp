@@ -0,0 +1,142 @@
+#include "log_levels.h"
+#include <algorithm>
+#ifndef IZAR_HOST_BUILD
+#include "config_manager.h"
+#endif
+
+LogLevels logLevels;
+
+namespace {
+const char* const kLevelNames[] = {"none", "error", "warn", "info", "debug"};
+
+// Level by name or number, -1 if unknown
+int parseLevel(const char* name) {
+    if (name[0] >= '0' && name[0] <= '9' && name[1] == '\0') {
+        return name[0] - '0' <= LOG_LEVEL_DEBUG ? name[0] - '0' : -1;
+    }
+    if (strcasecmp(name, "warning") == 0) {
+        return LOG_LEVEL_WARNING;
+    }
+    for (int level = LOG_LEVEL_NONE; level <= LOG_LEVEL_DEBUG; level++) {
+        if (strcasecmp(name, kLevelNames[level]) == 0) {
+            return level;
+        }
+    }
+    return -1;
+}
+
+// Copy of [start, end) without surrounding spaces
+void trimCopy(char* out, size_t size, const char* start, const char* end) {
+    while (start < end && *start == ' ') {
+        start++;
+    }
+    while (end > start && end[-1] == ' ') {
+        end--;
+    }
+    size_t length = std::min(static_cast<size_t>(end - start), size - 1);
+    memcpy(out, start, length);
+    out[length] = '\0';
+}
+} // namespace
+
+LogLevels::LogLevels() {
+    for (volatile uint8_t& level : levels) {
+        level = LOG_LEVEL_DEFAULT;
+    }
+}
+
+bool LogLevels::apply(const char* spec) {
+    bool valid = true;
+    const char* entry = spec;
+    while (*entry) {
+        const char* end = strchr(entry, ',');
+        if (!end) {
+            end = entry + strlen(entry);
+        }
+        const char* equals = static_cast<const char*>(memchr(entry, '=', end - entry));
+        char tag[24];
+        char levelName[12];
+        int level = -1;
+        if (equals) {
+            trimCopy(tag, sizeof(tag), entry, equals);
+            trimCopy(levelName, sizeof(levelName), equals + 1, end);
+            level = parseLevel(levelName);
+        }
+
+        bool applied = false;
+        if (level >= 0) {
+            for (uint8_t i = 0; i < LOG_TAG_COUNT; i++) {
+                if (strcasecmp(tag, "all") == 0 || strcasecmp(tag, kLogTags[i]) == 0) {
+                    levels[i] = level;
+                    applied = true;
+                }
+            }
+        }
+        valid = valid && applied;
+        entry = *end ? end + 1 : end;
+    }
+    return valid;
+}
+
+void LogLevels::getSpec(char* spec, size_t size) const {
+    // Base level shared by most tags, written as "all=" when it is not the default, then the exceptions
+    uint8_t counts[LOG_LEVEL_DEBUG + 1] = {};
+    for (uint8_t i = 0; i < LOG_TAG_COUNT; i++) {
+        counts[levels[i]]++;
+    }
+    uint8_t base = LOG_LEVEL_DEFAULT;
+    for (uint8_t level = LOG_LEVEL_NONE; level <= LOG_LEVEL_DEBUG; level++) {
+        if (counts[level] > counts[base]) {
+            base = level;
+        }
+    }
+
+    size_t length = 0;
+    spec[0] = '\0';
+    for (int i = base != LOG_LEVEL_DEFAULT ? -1 : 0; i < LOG_TAG_COUNT; i++) {
+        if (i >= 0 && levels[i] == base) {
+            continue;
+        }
+        int written = snprintf(spec + length, size - length, "%s%s=%s", length ? "," : "", i < 0 ? "all" : kLogTags[i],
+                               kLevelNames[i < 0 ? base : levels[i]]);
+        if (written < 0 || length + written >= size) {
+            spec[length] = '\0';
+            break;
+        }
+        length += written;
+    }
+}
+
+String LogLevels::getJSON() const {
+    String json = "{\"ceiling\":";
+    json += LOG_LEVEL;
+    json += ",\"default\":";
+    json += LOG_LEVEL_DEFAULT;
+    json += ",\"tags\":{";
+    for (uint8_t i = 0; i < LOG_TAG_COUNT; i++) {
+        if (i > 0) {
+            json += ",";
+        }
+        json += "\"";
+        json += kLogTags[i];
+        json += "\":";
+        json += levels[i];
+    }
+    json += "}}";
+    return json;
+}
+
+#ifndef IZAR_HOST_BUILD
+void LogLevels::begin() {
+    apply(configManager.getConfig().logLevels);
+}
+
+bool LogLevels::update(const char* spec) {
+    bool valid = apply(spec);
+    // Effective at once; stored by the loop task with the next ConfigManager::applyPending()
+    char stored[LOG_LEVELS_SPEC_SIZE];
+    getSpec(stored, sizeof(stored));
+    configManager.requestLogLevels(stored);
+    return valid;
+}
+#endif
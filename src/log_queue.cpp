@@ -0,0 +1,73 @@
+#include "log_queue.h"
+#include <algorithm>
+
+bool LogQueue::push(uint8_t level, uint32_t t, const void* data, uint16_t length) {
+    uint32_t size = recordSize(length);
+    uint32_t position = reserved.load(std::memory_order_relaxed);
+    do {
+        if (position + size - released.load(std::memory_order_acquire) > LOG_QUEUE_SIZE) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!reserved.compare_exchange_weak(position, position + size, std::memory_order_relaxed));
+
+    *word(position + 4) = t;
+    write(position + kHeaderSize, data, length);
+    uint32_t header = kCommitted | static_cast<uint32_t>(length) << 8 | level;
+    __atomic_store_n(word(position), header, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool LogQueue::vpushf(uint8_t level, const char* tag, const char* format, va_list args) {
+    char text[WEB_LOG_MAX_MESSAGE];
+    int prefixLen = snprintf(text, sizeof(text), "[%s] ", tag);
+    if (prefixLen < 0) {
+        text[0] = '\0';
+        prefixLen = 0;
+    }
+
+    if (static_cast<size_t>(prefixLen) < sizeof(text)) {
+        vsnprintf(text + prefixLen, sizeof(text) - static_cast<size_t>(prefixLen), format, args);
+    }
+    return push(level, millis(), text, strlen(text));
+}
+
+bool LogQueue::pop(uint8_t& level, uint32_t& t, uint8_t* data, uint16_t& length) {
+    uint32_t position = released.load(std::memory_order_relaxed);
+    if (position == reserved.load(std::memory_order_acquire)) {
+        return false;
+    }
+    uint32_t header = __atomic_load_n(word(position), __ATOMIC_ACQUIRE);
+    if (!(header & kCommitted)) {
+        return false;
+    }
+
+    level = header & 0xFF;
+    length = (header >> 8) & 0xFFFF;
+    t = *word(position + 4);
+    read(position + kHeaderSize, data, length);
+
+    // Zero the record so a header slot a producer has reserved but not written yet never looks committed
+    uint32_t size = recordSize(length);
+    uint32_t offset = position % LOG_QUEUE_SIZE;
+    uint32_t first = std::min<uint32_t>(size, LOG_QUEUE_SIZE - offset);
+    memset(buffer + offset, 0, first);
+    memset(buffer, 0, size - first);
+    released.store(position + size, std::memory_order_release);
+    return true;
+}
+
+// Copy into the ring at a free-running position, wrapping around the end
+void LogQueue::write(uint32_t position, const void* data, size_t length) {
+    size_t offset = position % LOG_QUEUE_SIZE;
+    size_t first = std::min(length, LOG_QUEUE_SIZE - offset);
+    memcpy(buffer + offset, data, first);
+    memcpy(buffer, static_cast<const uint8_t*>(data) + first, length - first);
+}
+
+void LogQueue::read(uint32_t position, void* data, size_t length) const {
+    size_t offset = position % LOG_QUEUE_SIZE;
+    size_t first = std::min(length, LOG_QUEUE_SIZE - offset);
+    memcpy(data, buffer + offset, first);
+    memcpy(static_cast<uint8_t*>(data) + first, buffer, length - first);
+}
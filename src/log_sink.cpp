@@ -0,0 +1,75 @@
+#include "log_sink.h"
+
+#ifdef LOG_SINK_ACTIVE
+LogSink logSink;
+
+namespace {
+// Serial line prefixes, indexed by level
+const char* const kLevelNames[] = {"", "ERROR", "WARN", "INFO", "DEBUG"};
+
+const char* levelName(uint8_t level) {
+    level &= ~WebLogger::kDeferred;
+    return level < sizeof(kLevelNames) / sizeof(kLevelNames[0]) ? kLevelNames[level] : "";
+}
+} // namespace
+
+void LogSink::begin() {
+    // Lowest application priority, like loop(): the sink only runs when nothing more urgent is ready
+    xTaskCreate(taskMain, "log_sink", LOG_SINK_STACK_SIZE, this, tskIDLE_PRIORITY + 1, &task);
+}
+
+void LogSink::logf(uint8_t level, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    queue.vpushf(level, tag, format, args);
+    va_end(args);
+}
+
+void LogSink::wake() {
+    if (task && !xPortInIsrContext()) {
+        xTaskNotifyGive(task);
+    }
+}
+
+void LogSink::flush(uint32_t timeoutMs) {
+    unsigned long start = millis();
+    wake();
+    while ((!queue.isEmpty() || draining) && millis() - start < timeoutMs) {
+        delay(1);
+    }
+}
+
+void LogSink::taskMain(void* arg) {
+    LogSink* sink = static_cast<LogSink*>(arg);
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(LOG_SINK_INTERVAL));
+        sink->drain();
+    }
+}
+
+void LogSink::drain() {
+    TRACE_SPAN(LOG_SINK);
+    draining = true;
+    uint8_t level;
+    uint32_t t;
+    uint8_t data[WEB_LOG_MAX_MESSAGE];
+    uint16_t length;
+    char text[WEB_LOG_MAX_MESSAGE];
+    while (queue.pop(level, t, data, length)) {
+        webLogger.append(level, t, data, length);
+        WebLogger::formatPayload(level, data, length, text, sizeof(text));
+        Serial.printf("[%s]%s\r\n", levelName(level), text);
+    }
+
+    // Lines lost while the queue was full are reported after the ones queued before them
+    uint32_t dropped = queue.getDropped();
+    if (dropped != reportedDrops) {
+        int textLength = snprintf(text, sizeof(text), "[Log] %lu lines dropped, queue full",
+                                  static_cast<unsigned long>(dropped - reportedDrops));
+        reportedDrops = dropped;
+        webLogger.append(LOG_LEVEL_WARNING, millis(), text, textLength);
+        Serial.printf("[%s]%s\r\n", levelName(LOG_LEVEL_WARNING), text);
+    }
+    draining = false;
+}
+#endif // LOG_SINK_ACTIVE
@@ -1,5 +1,7 @@
 #include <Arduino.h>
 #include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <esp_system.h>
 #include "config.h"
 #include "config_manager.h"
 #include "gpio_expander_manager.h"
@@ -12,6 +14,14 @@
 #include "izar_handler.h"
 #include "hardware_manager.h"
 #include "web_config_server.h"
+#include "raw_frame_forwarder.h"
+#include "self_benchmark.h"
+#include "pipeline_latency.h"
+#include "bridge_metrics.h"
+#include "span_tracer.h"
+#include "link_quality.h"
+#include "rx_scheduler.h"
+#include "history_store.h"
 
 // Timing variables
 unsigned long lastStatusPublish = 0;
@@ -38,149 +48,87 @@ void mqttMessageCallback(const char* topic, const byte* payload, unsigned int le
 void fskModemMessageCallback(const uint8_t* payload, uint8_t length, int rssi);
 void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
                          uint8_t* tplData, uint8_t tplDataLen, int16_t rssi);
+void wmBusUncheckedCallback(const uint8_t* frame, uint8_t frameLen, int16_t rssi);
+RawFrameVerdict handleMeterPacket(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                                  uint8_t* tplData, uint8_t tplDataLen, int16_t rssi);
 void izarDataCallback(const IzarReading* reading);
 void updateDisplay();
 void handleButtonPress();
+void applyBinding();
+void applyConfigChanges();
+void publishBootTimes();
+void applyRxSchedule();
+
+// Last `count` characters of a meter ID, what fits on a display line
+const char* meterIdTail(const char* meterId, size_t count = 10) {
+    size_t length = strlen(meterId);
+    return length > count ? meterId + length - count : meterId;
+}
 
 void updateDisplay() {
-    if (!ENABLE_DISPLAY)
+    TRACE_SPAN(DISPLAY_REFRESH);
+    if (!ENABLE_DISPLAY || displayManager.isSplashShown())
         return;
 
-    // Clear screen and prepare for aligned printing
+    // Render off-screen, present() sends only what changed since the last frame
     displayManager.clear();
+    char text[96];
 
     if (bindingState == METER_BINDING_STATE_DISCOVERY) {
         if (discoveredMeters.empty()) {
             // Scanning state
-            String display = "Scanning\nIZAR\nmeters";
-            displayManager.printAligned(display.c_str(), DisplayManager::HAlign::CENTER,
+            displayManager.printAligned("Scanning\nIZAR\nmeters", DisplayManager::HAlign::CENTER,
                                         DisplayManager::VAlign::MIDDLE);
         } else {
-            // Build multi-line display
-            String display = "Found IZAR\n";
-
-            // Meter ID - truncate to 10 chars if needed
-            String meterId = discoveredMeters[selectedMeterIndex];
-            if (meterId.length() > 10) {
-                meterId = meterId.substring(meterId.length() - 10);
-            }
-            display += meterId + "\n";
-
-            // RSSI
-            String rssiStr = String(discoveredRSSI[selectedMeterIndex]) + " dBm";
-            display += rssiStr + "\n";
-
-            // Instructions
-            display += "Hold->bind\n";
-
-            // Navigation with brackets
-            String pageNum = String(selectedMeterIndex + 1) + "/" + String(discoveredMeters.size());
-            String nav = "";
-            if (selectedMeterIndex == 0) {
-                nav += "[";
-            } else {
-                nav += "<";
-            }
-            nav += "   " + pageNum + "   ";
-            if (selectedMeterIndex == (int)discoveredMeters.size() - 1) {
-                nav += "]";
-            } else {
-                nav += ">";
-            }
-            display += nav;
-
-            displayManager.printAligned(display.c_str(), DisplayManager::HAlign::CENTER,
-                                        DisplayManager::VAlign::MIDDLE);
+            // Found meter, RSSI, instructions and navigation with brackets at the first and last meter
+            bool first = selectedMeterIndex == 0;
+            bool last = selectedMeterIndex == (int)discoveredMeters.size() - 1;
+            snprintf(text, sizeof(text), "Found IZAR\n%s\n%d dBm\nHold->bind\n%c   %d/%u   %c",
+                     meterIdTail(discoveredMeters[selectedMeterIndex].c_str()), discoveredRSSI[selectedMeterIndex],
+                     first ? '[' : '<', selectedMeterIndex + 1, static_cast<unsigned>(discoveredMeters.size()),
+                     last ? ']' : '>');
+            displayManager.printAligned(text, DisplayManager::HAlign::CENTER, DisplayManager::VAlign::MIDDLE);
         }
     } else {
         // Bound mode - show meter status
         if (!hasReading) {
             // Waiting for data
-            String display = "Awaiting\ndata from\n" +
-                             boundMeterId.substring(boundMeterId.length() > 10 ? boundMeterId.length() - 10 : 0);
-            displayManager.printAligned(display.c_str(), DisplayManager::HAlign::CENTER,
-                                        DisplayManager::VAlign::MIDDLE);
+            snprintf(text, sizeof(text), "Awaiting\ndata from\n%s", meterIdTail(boundMeterId.c_str()));
+            displayManager.printAligned(text, DisplayManager::HAlign::CENTER, DisplayManager::VAlign::MIDDLE);
         } else {
-            // Build status display with full meter info
-            String display = "";
-
-            // Line 1: Full meter ID (truncate if longer than 10 chars)
-            String meterId = String(latestReading.meterId);
-            if (meterId.length() > 10) {
-                meterId = meterId.substring(meterId.length() - 10);
-            }
-            display += meterId + "\n";
-
-            // Line 2: Current reading
-            char readingBuf[16];
-            snprintf(readingBuf, sizeof(readingBuf), "%.3f m3", latestReading.current_reading);
-            display += String(readingBuf) + "\n";
-
-            // Line 3: RSSI
-            display += String(latestReading.rssi) + " dBm\n";
-
-            // Line 4: Battery life
-            char batteryBuf[16];
-            snprintf(batteryBuf, sizeof(batteryBuf), "%.1f years", latestReading.remaining_battery_life);
-            display += String(batteryBuf) + "\n";
-
-            // Line 5: Alarms with lowercase/uppercase coding
-            // [GLBRUSFM]: General, Leakage, Blocked, backflow(R), Underflow, Submarine, sensor Fraud, Mechanical fraud
-            // Lowercase = no alarm, Uppercase = alarm active
-            display += "[";
-
-            // G - general alarm
-            display += latestReading.alarms.general_alarm ? 'G' : 'g';
-
-            // L - leakage alarm
-            display += latestReading.alarms.leakage_currently ? 'L' : 'l';
-
-            // B - blocked meter
-            display += latestReading.alarms.meter_blocked ? 'B' : 'b';
-
-            // R - backflow alarm
-            display += latestReading.alarms.back_flow ? 'R' : 'r';
-
-            // U - underflow alarm
-            display += latestReading.alarms.underflow ? 'U' : 'u';
-
-            // S - submarine alarm
-            display += latestReading.alarms.submarine ? 'S' : 's';
-
-            // F - sensor fraud
-            display += latestReading.alarms.sensor_fraud_currently ? 'F' : 'f';
-
-            // M - mechanical fraud
-            display += latestReading.alarms.mechanical_fraud_currently ? 'M' : 'm';
-
-            display += "]";
-
-            displayManager.printAligned(display.c_str(), DisplayManager::HAlign::CENTER,
-                                        DisplayManager::VAlign::MIDDLE);
+            // Meter ID, current reading, RSSI, battery life, then the alarms as [GLBRUSFM]: General, Leakage,
+            // Blocked, backflow(R), Underflow, Submarine, sensor Fraud, Mechanical fraud. Lowercase = no alarm,
+            // uppercase = alarm active
+            const IzarAlarms& alarms = latestReading.alarms;
+            snprintf(text, sizeof(text), "%s\n%.3f m3\n%d dBm\n%.1f years\n[%c%c%c%c%c%c%c%c]",
+                     meterIdTail(latestReading.meterId), latestReading.current_reading, latestReading.rssi,
+                     latestReading.remaining_battery_life, alarms.general_alarm ? 'G' : 'g',
+                     alarms.leakage_currently ? 'L' : 'l', alarms.meter_blocked ? 'B' : 'b',
+                     alarms.back_flow ? 'R' : 'r', alarms.underflow ? 'U' : 'u', alarms.submarine ? 'S' : 's',
+                     alarms.sensor_fraud_currently ? 'F' : 'f', alarms.mechanical_fraud_currently ? 'M' : 'm');
+            displayManager.printAligned(text, DisplayManager::HAlign::CENTER, DisplayManager::VAlign::MIDDLE);
 
             // Draw timeout indicator (vertical line on left side)
             // Max timeout is 200% of radio_interval
             unsigned long elapsedSeconds = (millis() - lastUpdateTime) / 1000;
             int maxTimeout = latestReading.radio_interval * 2; // 200% of update interval
 
-            // Calculate line height (48 pixels for display height)
-            int lineHeight = 0;
+            // Calculate line height, full display height once the timeout is exceeded
+            int lineHeight = DISPLAY_HEIGHT;
             if (elapsedSeconds <= maxTimeout && maxTimeout > 0) {
-                lineHeight = (elapsedSeconds * 48) / maxTimeout;
-                if (lineHeight > 48)
-                    lineHeight = 48;
-            } else {
-                // Timeout exceeded - draw full line
-                lineHeight = 48;
+                lineHeight = (elapsedSeconds * DISPLAY_HEIGHT) / maxTimeout;
             }
 
             // Draw vertical line from bottom to top on left edge (x=0)
             displayManager.drawTimeoutLine(lineHeight);
         }
     }
+
+    displayManager.present();
 }
 
 void handleButtonPress() {
+    TRACE_SPAN(BUTTON);
     ButtonEvent event = hardwareManager.getButtonEvent();
 
     // Wake display on any button activity
@@ -210,7 +158,8 @@ void handleButtonPress() {
         strlcpy(config.serialNumber, boundMeterId.c_str(), sizeof(config.serialNumber));
         configManager.save();
         LOG_INFO("Main", "Bound to meter: %s", boundMeterId.c_str());
-        hardwareManager.beepSuccess();
+        rxScheduler.reset();
+        hardwareManager.playEffect(Effect::SUCCESS);
         updateDisplay();
     } else if (event == ButtonEvent::BUTTON_EVENT_SHORT_PRESS) {
         // Scroll to next meter
@@ -218,6 +167,12 @@ void handleButtonPress() {
         LOG_DEBUG("Main", "Selected meter index: %d", selectedMeterIndex);
         hardwareManager.beep(50, 2000); // Short high beep
         updateDisplay();
+    } else if (event == ButtonEvent::BUTTON_EVENT_DOUBLE_PRESS) {
+        // Scroll back to previous meter
+        selectedMeterIndex = (selectedMeterIndex + discoveredMeters.size() - 1) % discoveredMeters.size();
+        LOG_DEBUG("Main", "Selected meter index: %d", selectedMeterIndex);
+        hardwareManager.beep(50, 1600); // Short lower beep
+        updateDisplay();
     }
 }
 
@@ -229,47 +184,39 @@ void setup() {
 #endif
 
     Serial.begin(115200);
-
-    // Wait for USB CDC connection (timeout after 3 seconds)
-    unsigned long start = millis();
-    while (!Serial && (millis() - start < 3000)) {
-        delay(10);
-    }
+#ifdef SPAN_TRACE_ACTIVE
+    spanTracer.begin();
+#endif
+    logSink.begin();
 
     LOG_INFO("Main", "=== M5 Stack Water Meter (Unit-C6L) ===");
     LOG_INFO("Main", "Starting initialization...");
 
     // Load configuration from flash
     configManager.begin();
+    logLevels.begin();
 
     // Apply binding state from config
-    const Config& config = configManager.getConfig();
-    if (strlen(config.serialNumber) > 0) {
-        boundMeterId = config.serialNumber;
-        bindingState = METER_BINDING_STATE_BOUND;
-        LOG_INFO("Main", "Configured meter: %s (bound mode)", boundMeterId.c_str());
-    } else {
-        bindingState = METER_BINDING_STATE_DISCOVERY;
-        boundMeterId = "";
-        LOG_INFO("Main", "No configured meter (discovery mode)");
-    }
+    applyBinding();
+
+    // Stage 1: radio and decoder. Nothing here waits on a fixed delay or on the network, so the radio
+    // listens a few hundred milliseconds after reset.
 
     // Initialize hardware (including shared SPI bus)
     hardwareManager.init();
-    delay(100);
 
-    // Initialize display with shared SPI
+    // Initialize display with shared SPI; the welcome screen stays up without holding the boot
     if (ENABLE_DISPLAY) {
         displayManager.init(hardwareManager.getSharedSPI());
     }
 
     // Initialize GPIO expander AFTER display (M5GFX interferes with I2C, so init I2C fresh here)
     gpioExpanderManager.init();
-    delay(100);
 
     // Initialize wM-Bus handler
     wmBusHandler.init();
     wmBusHandler.setPacketCallback(wmBusPacketCallback);
+    wmBusHandler.setUncheckedCallback(wmBusUncheckedCallback);
 
     // Initialize PRIOS handler
     priosHandler.init();
@@ -280,17 +227,30 @@ void setup() {
 
     // Initialize wireless receiver (FSK modem for meter reading)
     if (ENABLE_FSK_MODEM) {
-        fskModemManager.init(hardwareManager.getSharedSPI());
+        if (fskModemManager.init(hardwareManager.getSharedSPI())) {
+            bridgeMetrics.markBoot(BootMilestone::RADIO_READY);
+            LOG_INFO("Main", "Radio listening after %lu ms", millis());
+        } else {
+            hardwareManager.playEffect(Effect::FAILURE);
+        }
         fskModemManager.setCallback(fskModemMessageCallback);
     }
 
-    // Initialize WiFi and MQTT
+    // Stage 2: network. WiFi associates in the background and MQTT connects from loop() once it is up.
     wifiManager.init();
     wifiManager.connect();
 
     mqttManager.init();
     mqttManager.setCallback(mqttMessageCallback);
-    mqttManager.connect();
+
+    // Reading history, a quarter of the filesystem is left as headroom for LittleFS itself
+    if (ENABLE_HISTORY) {
+        if (LittleFS.begin(true)) {
+            historyStore.begin(HISTORY_DIR, LittleFS.totalBytes() * 3 / 4);
+        } else {
+            LOG_ERROR("Main", "LittleFS mount failed, no reading history");
+        }
+    }
 
     // Start web configuration server
     webConfigServer.begin();
@@ -299,15 +259,14 @@ void setup() {
 
     // Initialize activity timer
     lastActivityTime = millis();
-
-    // Initialize binding display
-    if (ENABLE_DISPLAY) {
-        updateDisplay();
-    }
 }
 
 void loop() {
     unsigned long now = millis();
+    uint32_t loopStartUs = micros();
+
+    // Settings saved from the web portal
+    applyConfigChanges();
 
     // Keep WiFi and MQTT connected
     wifiManager.handleWiFi();
@@ -319,6 +278,41 @@ void loop() {
         fskModemManager.handle();
     }
 
+    // Radio asleep between the bound meter's predicted frames
+    applyRxSchedule();
+
+    // Finish a display flush the radio interrupted, replace the welcome screen once its time is up
+    if (ENABLE_DISPLAY) {
+        displayManager.handle();
+        static bool splashPending = true;
+        if (splashPending && !displayManager.isSplashShown()) {
+            splashPending = false;
+            updateDisplay();
+        }
+    }
+
+    // Publish pending raw telegrams once their latency budget is used up
+    rawFrameForwarder.handle();
+
+    // Write queued readings to the history files
+    if (ENABLE_HISTORY) {
+        historyStore.handle();
+    }
+
+    // Run a requested self-benchmark
+    selfBenchmark.handle();
+
+    // Link quality windows and periodic diagnostics
+    linkQuality.handle();
+
+    // Boot timing, once the first reading is out
+    publishBootTimes();
+
+#ifdef LATENCY_TRACE_ACTIVE
+    // Periodic latency histogram summary
+    pipelineLatency.handle();
+#endif
+
     // Update display every second to refresh timeout indicator
     if (ENABLE_DISPLAY && bindingState == METER_BINDING_STATE_BOUND && hasReading) {
         static unsigned long lastDisplayUpdate = 0;
@@ -340,9 +334,112 @@ void loop() {
     // Button handling for meter binding
     handleButtonPress();
 
+    uint32_t loopDurationUs = micros() - loopStartUs;
+    bridgeMetrics.recordLoop(loopDurationUs);
+#ifdef SPAN_TRACE_ACTIVE
+    spanTracer.record(TraceId::LOOP, loopStartUs, loopDurationUs);
+#endif
     delay(10); // Small delay to prevent watchdog triggers
 }
 
+// Binding state from the configured meter serial number
+void applyBinding() {
+    rxScheduler.reset();
+    const Config& config = configManager.getConfig();
+    if (strlen(config.serialNumber) > 0) {
+        boundMeterId = config.serialNumber;
+        bindingState = METER_BINDING_STATE_BOUND;
+        LOG_INFO("Main", "Configured meter: %s (bound mode)", boundMeterId.c_str());
+    } else {
+        bindingState = METER_BINDING_STATE_DISCOVERY;
+        boundMeterId = "";
+        LOG_INFO("Main", "No configured meter (discovery mode)");
+    }
+}
+
+// Bound mode with ENABLE_RX_DUTY_CYCLE: the radio sleeps between the predicted frames of the meter and WiFi
+// uses max modem sleep while the schedule holds; anything unexpected means continuous RX
+void applyRxSchedule() {
+    if (!ENABLE_RX_DUTY_CYCLE || !ENABLE_FSK_MODEM) {
+        return;
+    }
+    static bool wasLocked = false;
+    RxMode mode = bindingState == METER_BINDING_STATE_BOUND ? rxScheduler.update(millis()) : RxMode::CONTINUOUS;
+    bool locked = mode != RxMode::CONTINUOUS;
+    if (locked != wasLocked) {
+        wasLocked = locked;
+        if (locked) {
+            LOG_INFO("Main", "Meter schedule locked, RX window +-%lu ms",
+                     static_cast<unsigned long>(rxScheduler.getGuardMs()));
+        } else {
+            LOG_INFO("Main", "Meter schedule lost (%lu missed windows), continuous RX",
+                     static_cast<unsigned long>(rxScheduler.getMissedWindows()));
+        }
+    }
+    fskModemManager.setListening(mode != RxMode::SLEEP);
+    wifiManager.setMaxPowerSave(locked);
+}
+
+// Apply a config posted from the web portal to the parts it affects; the radio keeps receiving throughout
+void applyConfigChanges() {
+    uint8_t changes = configManager.applyPending();
+    if (changes == 0) {
+        return;
+    }
+    LOG_INFO("Main", "Applying config changes (0x%02x)", changes);
+
+    if (changes & (CONFIG_CHANGE_WIFI | CONFIG_CHANGE_HOSTNAME)) {
+        wifiManager.applyConfig((changes & CONFIG_CHANGE_WIFI) != 0);
+    }
+    if (changes & (CONFIG_CHANGE_MQTT | CONFIG_CHANGE_MQTT_TOPICS)) {
+        mqttManager.applyConfig((changes & CONFIG_CHANGE_MQTT_TOPICS) != 0);
+    }
+    if (changes & CONFIG_CHANGE_METER) {
+        applyBinding();
+        hasReading = false; // The last reading belongs to the previous meter
+        if (ENABLE_DISPLAY) {
+            updateDisplay();
+        }
+    }
+}
+
+const char* resetReasonName(esp_reset_reason_t reason) {
+    switch (reason) {
+    case ESP_RST_POWERON:
+        return "power_on";
+    case ESP_RST_EXT:
+        return "external";
+    case ESP_RST_SW:
+        return "software"; // Including OTA and the reset command
+    case ESP_RST_PANIC:
+        return "panic";
+    case ESP_RST_INT_WDT:
+    case ESP_RST_TASK_WDT:
+    case ESP_RST_WDT:
+        return "watchdog";
+    case ESP_RST_DEEPSLEEP:
+        return "deep_sleep";
+    case ESP_RST_BROWNOUT:
+        return "brownout";
+    default:
+        return "other";
+    }
+}
+
+// Boot milestones, retained on <base>/boot once per boot after the first published reading
+void publishBootTimes() {
+    static bool published = false;
+    if (published || bridgeMetrics.getBootMs(BootMilestone::FIRST_PUBLISH) == 0 || !mqttManager.isConnected()) {
+        return;
+    }
+    StaticJsonDocument<192> doc;
+    doc["radio_ready_ms"] = bridgeMetrics.getBootMs(BootMilestone::RADIO_READY);
+    doc["first_rx_ms"] = bridgeMetrics.getBootMs(BootMilestone::FIRST_RX);
+    doc["first_publish_ms"] = bridgeMetrics.getBootMs(BootMilestone::FIRST_PUBLISH);
+    doc["reset_reason"] = resetReasonName(esp_reset_reason());
+    published = mqttManager.publish(mqttManager.getTopicBoot(), doc, true);
+}
+
 void mqttMessageCallback(const char* topic, const byte* payload, unsigned int length) {
     LOG_INFO("Main", "MQTT message on topic: %s", topic);
 
@@ -356,18 +453,36 @@ void mqttMessageCallback(const char* topic, const byte* payload, unsigned int le
     // Handle commands
     if (strcmp(topic, mqttManager.getTopicCommand()) == 0) {
         if (strcmp(message, "beep") == 0) {
-            hardwareManager.beepSuccess();
+            hardwareManager.playEffect(Effect::SUCCESS);
         } else if (strcmp(message, "reset") == 0) {
             LOG_INFO("Main", "Reset requested");
+            logSink.flush(500);
             ESP.restart();
         } else if (strcmp(message, "status") == 0) {
             mqttManager.publish(mqttManager.getTopicStatus(), "online", true);
+        } else if (strncmp(message, "bench", 5) == 0 && (message[5] == '\0' || message[5] == ' ')) {
+            // "bench" or "bench <iterations>", result goes to <base>/bench
+            uint16_t iterations = message[5] ? atoi(message + 6) : SELF_BENCH_DEFAULT_ITERATIONS;
+            if (!selfBenchmark.request(iterations, true)) {
+                LOG_WARN("Main", "Benchmark already pending");
+            }
+        } else if (strcmp(message, "diagnostics") == 0) {
+            mqttManager.publish(mqttManager.getTopicDiagnostics(),
+                                linkQuality.getJSON(LINK_QUALITY_MQTT_METERS).c_str());
+        } else if (strcmp(message, "diagnostics reset") == 0) {
+            linkQuality.requestReset();
+        } else if (strncmp(message, "loglevel ", 9) == 0) {
+            // "loglevel <tag>=<level>[,<tag>=<level>...]", stored in NVS
+            if (!logLevels.update(message + 9)) {
+                LOG_WARN("Main", "Invalid log level entry in: %s", message + 9);
+            }
         }
     }
 }
 
 void fskModemMessageCallback(const uint8_t* payload, uint8_t length, int rssi) {
     LOG_DEBUG("Main", "FSK modem packet received: %d bytes, RSSI=%d dBm", length, rssi);
+    bridgeMetrics.markBoot(BootMilestone::FIRST_RX);
 
     // Pass raw packet to wM-Bus handler for decoding and parsing
     if (length > 0) {
@@ -380,20 +495,57 @@ void fskModemMessageCallback(const uint8_t* payload, uint8_t length, int rssi) {
 // Callback for successfully parsed wM-Bus packets
 void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
                          uint8_t* tplData, uint8_t tplDataLen, int16_t rssi) {
+    LATENCY_MARK(DECODE);
+    bridgeMetrics.recordMeterFrame(meterId, rssi);
+    linkQuality.recordFrame(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
     LOG_INFO("Main", "wM-Bus packet parsed: meter=%s, wM-BusFrame=%d bytes, tplData=%d bytes, RSSI=%d dBm", meterId,
              fullwMBusFrameLen, tplDataLen, rssi);
 
+    if (!rawFrameForwarder.isEnabled()) {
+        handleMeterPacket(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
+        return;
+    }
+
+    // Keep a CRC-stripped copy of the telegram before PRIOS decrypts the TPL data in place
+    uint8_t telegram[WM_BUS_MAX_PAYLOAD];
+    uint8_t telegramLen = WM_BUS_HEADER_SIZE + tplDataLen;
+    memcpy(telegram, fullwMBusFrame, WM_BUS_HEADER_SIZE);
+    memcpy(telegram + WM_BUS_HEADER_SIZE, tplData, tplDataLen);
+
+    RawFrameVerdict verdict = handleMeterPacket(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
+    rawFrameForwarder.enqueue(telegram, telegramLen, rssi, fskModemManager.getLastPacketTimestamp(), verdict);
+}
+
+// DLL-valid frame that failed the single-block TPL check, forwarded for a central decoder to verify
+void wmBusUncheckedCallback(const uint8_t* frame, uint8_t frameLen, int16_t rssi) {
+    if (!rawFrameForwarder.isEnabled() || frameLen < WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE) {
+        return;
+    }
+
+    // Drop only the DLL CRC, the remaining blocks keep theirs
+    uint8_t telegram[WM_BUS_MAX_PAYLOAD];
+    uint8_t telegramLen = frameLen - WM_BUS_HEADER_CRC_SIZE;
+    memcpy(telegram, frame, WM_BUS_HEADER_SIZE);
+    memcpy(telegram + WM_BUS_HEADER_SIZE, frame + WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE,
+           telegramLen - WM_BUS_HEADER_SIZE);
+    rawFrameForwarder.enqueue(telegram, telegramLen, rssi, fskModemManager.getLastPacketTimestamp(),
+                              RawFrameVerdict::TPL_UNCHECKED);
+}
+
+// Discovery/binding state machine for a CRC-valid packet, returns what the decoder made of it
+RawFrameVerdict handleMeterPacket(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
+                                  uint8_t* tplData, uint8_t tplDataLen, int16_t rssi) {
     if (bindingState == METER_BINDING_STATE_DISCOVERY) {
         const Config& config = configManager.getConfig();
         if (strlen(config.serialNumber) > 0 && String(meterId) == String(config.serialNumber)) {
             boundMeterId = meterId;
             bindingState = METER_BINDING_STATE_BOUND;
             LOG_INFO("Main", "Auto-bound to configured meter: %s", boundMeterId.c_str());
-            hardwareManager.beepSuccess();
+            hardwareManager.playEffect(Effect::SUCCESS);
             if (ENABLE_DISPLAY) {
                 updateDisplay();
             }
-            return;
+            return RawFrameVerdict::SKIPPED;
         }
 
         // Discovery mode - add to list if new or update RSSI
@@ -412,6 +564,7 @@ void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uin
             discoveredMeters.push_back(meterIdStr);
             discoveredRSSI.push_back(rssi);
             LOG_INFO("Main", "New meter discovered: %s (total: %d)", meterId, discoveredMeters.size());
+            hardwareManager.playEffect(Effect::NEW_METER);
             if (ENABLE_DISPLAY) {
                 updateDisplay();
             }
@@ -425,31 +578,43 @@ void wmBusPacketCallback(const char* meterId, const uint8_t* fullwMBusFrame, uin
         }
 
         // Don't process packets in discovery mode
-        return;
+        return RawFrameVerdict::SKIPPED;
     }
 
     // Bound mode - filter by bound meter ID
     if (bindingState == METER_BINDING_STATE_BOUND && String(meterId) != boundMeterId) {
         LOG_DEBUG("Main", "Ignoring packet from non-bound meter: %s", meterId);
-        return;
+        return RawFrameVerdict::SKIPPED;
     }
 
     // Pass to PRIOS handler with full frame for proper LFSR initialization
-    if (tplDataLen > 0 && fullwMBusFrameLen >= 12) {
+    if (tplDataLen > 0 && fullwMBusFrameLen >= PRIOS_MIN_FRAME_LENGTH) {
         LOG_DEBUG("Main", "Passing to PRIOS handler...");
-        priosHandler.processPayload(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi);
+        if (priosHandler.processPayload(meterId, fullwMBusFrame, fullwMBusFrameLen, tplData, tplDataLen, rssi)) {
+            return RawFrameVerdict::DECODED;
+        }
     } else {
         LOG_DEBUG("Main", "Insufficient data for PRIOS decryption");
     }
+    return RawFrameVerdict::DECODE_FAILED;
 }
 
 // Callback for decoded IZAR meter data
 void izarDataCallback(const IzarReading* reading) {
+    LATENCY_MARK(PARSE);
     LOG_INFO("Main", "Water meter reading: ID=%s, Current=%.3f m³, H0=%.3f m³, RSSI=%d dBm", reading->meterId,
              reading->current_reading, reading->h0_reading, reading->rssi);
 
     // Store latest reading for display
     if (bindingState == METER_BINDING_STATE_BOUND) {
+        rxScheduler.setInterval(reading->radio_interval * 1000UL);
+        rxScheduler.recordFrame(millis());
+
+        // Sound the alarm when the meter starts reporting a leak
+        if (reading->alarms.leakage_currently && (!hasReading || !latestReading.alarms.leakage_currently)) {
+            LOG_WARN("Main", "Leak reported by meter %s", reading->meterId);
+            hardwareManager.playEffect(Effect::LEAK_ALARM);
+        }
         memcpy(&latestReading, reading, sizeof(IzarReading));
         hasReading = true;
         lastUpdateTime = millis(); // Reset timeout timer
@@ -466,6 +631,11 @@ void izarDataCallback(const IzarReading* reading) {
         }
     }
 
+    // History of every decoded meter, once NTP has set the clock
+    if (ENABLE_HISTORY) {
+        historyStore.append(*reading, time(nullptr));
+    }
+
     // Publish to MQTT if connected
     if (mqttManager.isConnected()) {
         constexpr size_t kFlowWindowSize = 9;
@@ -496,36 +666,13 @@ void izarDataCallback(const IzarReading* reading) {
             }
         }
 
+        TRACE_SPAN(PUBLISH);
         StaticJsonDocument<768> doc;
-        doc["meter_id"] = reading->meterId;
-        doc["current_reading"] = reading->current_reading;
-        doc["h0_reading"] = reading->h0_reading;
-        doc["unit"] = reading->unit_type == VOLUME_CUBIC_METER ? "m3" : "unknown";
-        doc["battery_years"] = reading->remaining_battery_life;
-        doc["radio_interval"] = reading->radio_interval;
-        doc["meter_rssi"] = reading->rssi;
-        doc["wifi_rssi"] = wifiManager.getRSSI();
-        doc["flow_rate"] = flowLph;
-        doc["free_heap_kb"] = ESP.getFreeHeap() / 1024.0f;
-
-        char h0Date[16];
-        snprintf(h0Date, sizeof(h0Date), "%04u-%02u-%02u", reading->h0_year, reading->h0_month, reading->h0_day);
-        doc["h0_date"] = h0Date;
-
-        JsonObject alarms = doc.createNestedObject("alarms");
-        alarms["general"] = reading->alarms.general_alarm;
-        alarms["leakage_current"] = reading->alarms.leakage_currently;
-        alarms["leakage_previous"] = reading->alarms.leakage_previously;
-        alarms["meter_blocked"] = reading->alarms.meter_blocked;
-        alarms["back_flow"] = reading->alarms.back_flow;
-        alarms["underflow"] = reading->alarms.underflow;
-        alarms["overflow"] = reading->alarms.overflow;
-        alarms["submarine"] = reading->alarms.submarine;
-        alarms["sensor_fraud_current"] = reading->alarms.sensor_fraud_currently;
-        alarms["sensor_fraud_previous"] = reading->alarms.sensor_fraud_previously;
-        alarms["mechanical_fraud_current"] = reading->alarms.mechanical_fraud_currently;
-        alarms["mechanical_fraud_previous"] = reading->alarms.mechanical_fraud_previously;
-
-        mqttManager.publish(mqttManager.getTopicReading(), doc);
+        mqttManager.buildReadingJson(reading, flowLph, doc);
+        if (mqttManager.publish(mqttManager.getTopicReading(), doc)) {
+            LATENCY_MARK(PUBLISH);
+            bridgeMetrics.countReadingPublished();
+            bridgeMetrics.markBoot(BootMilestone::FIRST_PUBLISH);
+        }
     }
 }
@@ -1,5 +1,6 @@
 #include "mqtt_manager.h"
 #include "wifi_manager.h"
+#include "span_tracer.h"
 #include "config_manager.h"
 #include <ESPmDNS.h>
 #include <WiFi.h>
@@ -29,6 +30,7 @@ bool MqttManager::connect() {
         return false;
     }
 
+    TRACE_SPAN(MQTT_CONNECT);
     const Config& config = configManager.getConfig();
 
     IPAddress resolvedIp;
@@ -71,6 +73,10 @@ bool MqttManager::connect() {
 
     if (connected) {
         LOG_INFO("MQTT", "Connected!");
+        if (everConnected) {
+            reconnects++;
+        }
+        everConnected = true;
         publish(getTopicStatus(), "online", true);
         subscribe(getTopicCommand());
         if (!discoveryPublished) {
@@ -95,10 +101,29 @@ void MqttManager::disconnect() {
     }
 }
 
+void MqttManager::applyConfig(bool topicsChanged) {
+    if (client.connected()) {
+        // A clean disconnect skips the will, so retract the retained "online" if the status topic moves
+        if (topicsChanged) {
+            publish(getTopicStatus(), "offline", true);
+        }
+        client.disconnect();
+    }
+    if (topicsChanged) {
+        updateTopics();
+        discoveryPublished = false;
+    }
+    lastReconnectAttempt = 0;
+    LOG_INFO("MQTT", "Settings changed, reconnecting");
+}
+
 void MqttManager::handle() {
+    TRACE_SPAN(MQTT);
     if (!client.connected()) {
+        // Attempts only count once WiFi is up, so the first connect after boot is not held back
         unsigned long now = millis();
-        if (now - lastReconnectAttempt > MQTT_RECONNECT_INTERVAL) {
+        if (wifiManager.isWiFiConnected() &&
+            (lastReconnectAttempt == 0 || now - lastReconnectAttempt > MQTT_RECONNECT_INTERVAL)) {
             lastReconnectAttempt = now;
             if (connect()) {
                 lastReconnectAttempt = 0;
@@ -119,6 +144,22 @@ bool MqttManager::publish(const char* topic, const char* payload, bool retain) {
         LOG_DEBUG("MQTT", "Published to %s: %s", topic, payload);
     } else {
         LOG_ERROR("MQTT", "Failed to publish to %s", topic);
+        publishFailures++;
+    }
+    return result;
+}
+
+bool MqttManager::publish(const char* topic, const uint8_t* payload, size_t length, bool retain) {
+    if (!client.connected()) {
+        return false;
+    }
+
+    bool result = client.publish(topic, payload, length, retain);
+    if (result) {
+        LOG_DEBUG("MQTT", "Published %u bytes to %s", static_cast<unsigned>(length), topic);
+    } else {
+        LOG_ERROR("MQTT", "Failed to publish to %s", topic);
+        publishFailures++;
     }
     return result;
 }
@@ -129,6 +170,37 @@ bool MqttManager::publish(const char* topic, const JsonDocument& doc, bool retai
     return publish(topic, payload.c_str(), retain);
 }
 
+void MqttManager::buildReadingJson(const IzarReading* reading, float flowLph, JsonDocument& doc) {
+    doc["meter_id"] = reading->meterId;
+    doc["current_reading"] = reading->current_reading;
+    doc["h0_reading"] = reading->h0_reading;
+    doc["unit"] = reading->unit_type == VOLUME_CUBIC_METER ? "m3" : "unknown";
+    doc["battery_years"] = reading->remaining_battery_life;
+    doc["radio_interval"] = reading->radio_interval;
+    doc["meter_rssi"] = reading->rssi;
+    doc["wifi_rssi"] = wifiManager.getRSSI();
+    doc["flow_rate"] = flowLph;
+    doc["free_heap_kb"] = ESP.getFreeHeap() / 1024.0f;
+
+    char h0Date[16];
+    snprintf(h0Date, sizeof(h0Date), "%04u-%02u-%02u", reading->h0_year, reading->h0_month, reading->h0_day);
+    doc["h0_date"] = h0Date;
+
+    JsonObject alarms = doc.createNestedObject("alarms");
+    alarms["general"] = reading->alarms.general_alarm;
+    alarms["leakage_current"] = reading->alarms.leakage_currently;
+    alarms["leakage_previous"] = reading->alarms.leakage_previously;
+    alarms["meter_blocked"] = reading->alarms.meter_blocked;
+    alarms["back_flow"] = reading->alarms.back_flow;
+    alarms["underflow"] = reading->alarms.underflow;
+    alarms["overflow"] = reading->alarms.overflow;
+    alarms["submarine"] = reading->alarms.submarine;
+    alarms["sensor_fraud_current"] = reading->alarms.sensor_fraud_currently;
+    alarms["sensor_fraud_previous"] = reading->alarms.sensor_fraud_previously;
+    alarms["mechanical_fraud_current"] = reading->alarms.mechanical_fraud_currently;
+    alarms["mechanical_fraud_previous"] = reading->alarms.mechanical_fraud_previously;
+}
+
 bool MqttManager::subscribe(const char* topic) {
     if (!client.connected()) {
         return false;
@@ -167,6 +239,11 @@ void MqttManager::updateTopics() {
     snprintf(topicStatus, sizeof(topicStatus), "%s/status", base.c_str());
     snprintf(topicReading, sizeof(topicReading), "%s/reading", base.c_str());
     snprintf(topicCommand, sizeof(topicCommand), "%s/cmd", base.c_str());
+    snprintf(topicRaw, sizeof(topicRaw), "%s/raw", base.c_str());
+    snprintf(topicBench, sizeof(topicBench), "%s/bench", base.c_str());
+    snprintf(topicLatency, sizeof(topicLatency), "%s/latency", base.c_str());
+    snprintf(topicDiagnostics, sizeof(topicDiagnostics), "%s/diagnostics", base.c_str());
+    snprintf(topicBoot, sizeof(topicBoot), "%s/boot", base.c_str());
 }
 
 bool MqttManager::publishDiscoveryEntity(const char* component, const char* objectId, const char* name,
@@ -229,6 +306,7 @@ bool MqttManager::publishDiscoveryEntity(const char* component, const char* obje
 }
 
 void MqttManager::publishDiscoveryAll() {
+    TRACE_SPAN(HA_DISCOVERY);
     publishDiscoveryEntity("sensor", "meter_id", "Meter ID", getTopicReading(), nullptr, nullptr, nullptr,
                            "{{ value_json.meter_id }}", "mdi:identifier");
 
@@ -326,3 +404,19 @@ const char* MqttManager::getTopicReading() const {
 const char* MqttManager::getTopicCommand() const {
     return topicCommand;
 }
+const char* MqttManager::getTopicRaw() const {
+    return topicRaw;
+}
+const char* MqttManager::getTopicBench() const {
+    return topicBench;
+}
+const char* MqttManager::getTopicLatency() const {
+    return topicLatency;
+}
+const char* MqttManager::getTopicDiagnostics() const {
+    return topicDiagnostics;
+}
+
+const char* MqttManager::getTopicBoot() const {
+    return topicBoot;
+}
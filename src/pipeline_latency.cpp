@@ -0,0 +1,169 @@
+#include "pipeline_latency.h"
+#include <algorithm>
+
+#ifdef LATENCY_TRACE_ACTIVE
+#include "mqtt_manager.h"
+#include "span_tracer.h"
+
+PipelineLatency pipelineLatency;
+
+namespace {
+// Segment names, indexed like PipelineLatency::histograms
+const char* const kSegmentNames[] = {"end_to_end", "receive", "read", "decode", "decrypt", "parse", "publish"};
+} // namespace
+
+size_t LatencyHistogram::bucketIndex(uint32_t us) {
+    if (us < LATENCY_LINEAR_BUCKETS) {
+        return us;
+    }
+    uint32_t exponent = 31 - __builtin_clz(us);
+    if (exponent > LATENCY_MAX_EXPONENT) {
+        return LATENCY_BUCKETS - 1;
+    }
+    uint32_t subBucket = (us >> (exponent - LATENCY_SUB_BUCKET_BITS)) & ((1 << LATENCY_SUB_BUCKET_BITS) - 1);
+    return LATENCY_LINEAR_BUCKETS + ((exponent - 4) << LATENCY_SUB_BUCKET_BITS) + subBucket;
+}
+
+uint32_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < LATENCY_LINEAR_BUCKETS) {
+        return index;
+    }
+    size_t offset = index - LATENCY_LINEAR_BUCKETS;
+    uint32_t shift = 1 + (offset >> LATENCY_SUB_BUCKET_BITS);
+    uint32_t lower = ((1u << LATENCY_SUB_BUCKET_BITS) + (offset & ((1 << LATENCY_SUB_BUCKET_BITS) - 1))) << shift;
+    return lower + (1u << shift) - 1;
+}
+
+void LatencyHistogram::record(uint32_t us) {
+    buckets[bucketIndex(us)]++;
+    count++;
+    sumUs += us;
+    if (us < minUs) {
+        minUs = us;
+    }
+    if (us > maxUs) {
+        maxUs = us;
+    }
+}
+
+void LatencyHistogram::clear() {
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    minUs = UINT32_MAX;
+    maxUs = 0;
+    sumUs = 0;
+}
+
+uint32_t LatencyHistogram::percentile(uint8_t percent) const {
+    if (count == 0) {
+        return 0;
+    }
+    // Nearest rank
+    uint32_t rank = (static_cast<uint64_t>(count) * percent + 99) / 100;
+    uint32_t seen = 0;
+    for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), maxUs);
+        }
+    }
+    return maxUs;
+}
+
+const char* PipelineLatency::getSegmentName(LatencyStage stage) {
+    return kSegmentNames[static_cast<size_t>(stage)];
+}
+
+void PipelineLatency::begin(uint32_t irqTimestampUs) {
+    marks[static_cast<size_t>(LatencyStage::IRQ)] = irqTimestampUs;
+    lastStage = LatencyStage::IRQ;
+    inFlight = true;
+    mark(LatencyStage::RECEIVE);
+}
+
+void PipelineLatency::mark(LatencyStage stage) {
+    if (!inFlight || stage <= lastStage) {
+        return;
+    }
+
+    uint32_t now = micros();
+    size_t index = static_cast<size_t>(stage);
+    marks[index] = now;
+    histograms[index].record(now - marks[static_cast<size_t>(lastStage)]);
+    lastStage = stage;
+
+    if (stage == LatencyStage::PUBLISH) {
+        size_t endToEnd = static_cast<size_t>(LatencyStage::IRQ);
+        histograms[endToEnd].record(now - marks[endToEnd]);
+        inFlight = false;
+    }
+}
+
+void PipelineLatency::clear() {
+    for (LatencyHistogram& histogram : histograms) {
+        histogram.clear();
+    }
+    inFlight = false;
+}
+
+void PipelineLatency::handle() {
+    TRACE_SPAN(LATENCY_PUBLISH);
+    unsigned long now = millis();
+    if (now - lastPublish < LATENCY_PUBLISH_INTERVAL || !mqttManager.isConnected()) {
+        return;
+    }
+    lastPublish = now;
+    if (histograms[static_cast<size_t>(LatencyStage::RECEIVE)].getCount() > 0) {
+        mqttManager.publish(mqttManager.getTopicLatency(), getJSON(false).c_str());
+    }
+}
+
+String PipelineLatency::getJSON(bool withBuckets) const {
+    String json = "{\"unit\":\"us\",\"segments\":{";
+    for (size_t s = 0; s < static_cast<size_t>(LatencyStage::COUNT); s++) {
+        const LatencyHistogram& histogram = histograms[s];
+        if (s > 0) {
+            json += ",";
+        }
+        json += "\"";
+        json += kSegmentNames[s];
+        json += "\":{\"count\":";
+        json += histogram.getCount();
+        json += ",\"min\":";
+        json += histogram.getMin();
+        json += ",\"mean\":";
+        json += histogram.getMean();
+        json += ",\"p50\":";
+        json += histogram.percentile(50);
+        json += ",\"p90\":";
+        json += histogram.percentile(90);
+        json += ",\"p99\":";
+        json += histogram.percentile(99);
+        json += ",\"max\":";
+        json += histogram.getMax();
+
+        if (withBuckets) {
+            json += ",\"buckets\":[";
+            bool first = true;
+            for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+                if (histogram.getBucket(i) == 0) {
+                    continue;
+                }
+                if (!first) {
+                    json += ",";
+                }
+                first = false;
+                json += "[";
+                json += LatencyHistogram::bucketUpperBound(i);
+                json += ",";
+                json += histogram.getBucket(i);
+                json += "]";
+            }
+            json += "]";
+        }
+        json += "}";
+    }
+    json += "}}";
+    return json;
+}
+#endif // LATENCY_TRACE_ACTIVE
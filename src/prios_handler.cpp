@@ -1,5 +1,7 @@
 #include "prios_handler.h"
 #include "izar_handler.h"
+#include "pipeline_latency.h"
+#include "span_tracer.h"
 
 PriosHandler priosHandler;
 
@@ -30,17 +32,11 @@ static uint32_t initializeLfsrKey(const uint8_t* key, const uint8_t* frame) {
     return lfsrKey;
 }
 
-// Decrypt PRIOS data using LFSR stream cipher (Diehl/IZAR algorithm) - in-place
-bool PriosHandler::decryptData(const uint8_t* key, uint8_t* data, uint8_t dataLen, const uint8_t* frame) {
-    if (!key || !data || !frame) {
-        LOG_ERROR("PRIOS", "Decryption failed: invalid parameters");
-        return false;
-    }
-
+// Apply the PRIOS LFSR keystream (Diehl/IZAR algorithm) in-place; encryption and decryption are the same XOR
+void PriosHandler::applyKeystream(const uint8_t* key, uint8_t* data, uint8_t dataLen, const uint8_t* frame) {
     // Initialize LFSR key from encryption key and frame header
     uint32_t lfsrKey = initializeLfsrKey(key, frame);
 
-    // Decrypt using LFSR (in-place)
     for (uint8_t i = 0; i < dataLen; i++) {
         // Evolve LFSR for 8 iterations (one byte)
         for (uint8_t j = 0; j < 8; j++) {
@@ -51,50 +47,73 @@ bool PriosHandler::decryptData(const uint8_t* key, uint8_t* data, uint8_t dataLe
             lfsrKey = (lfsrKey << 1) | bit;
         }
 
-        // XOR encrypted byte with low 8 bits of current LFSR state (in-place)
+        // XOR byte with low 8 bits of current LFSR state (in-place)
         data[i] ^= (lfsrKey & 0xFF);
+    }
+}
 
-        // Validate first byte should be 0x4B (magic marker for valid decryption)
-        if (i == 0 && data[0] != 0x4B) {
-            LOG_DEBUG("PRIOS", "Decryption validation failed: first byte is 0x%02X (expected 0x4B)", data[0]);
-            return false;
-        }
+// Decrypt PRIOS data using LFSR stream cipher - in-place
+bool PriosHandler::decryptData(const uint8_t* key, uint8_t* data, uint8_t dataLen, const uint8_t* frame) {
+    if (!key || !data || !frame) {
+        LOG_DEBUG("PRIOS", "Decryption failed: invalid parameters");
+        return false;
+    }
+
+    applyKeystream(key, data, dataLen, frame);
+
+    // Validate first byte should be 0x4B (magic marker for valid decryption)
+    if (dataLen > 0 && data[0] != 0x4B) {
+        LOG_DEBUG("PRIOS", "Decryption validation failed: first byte is 0x%02X (expected 0x4B)", data[0]);
+        return false;
     }
 
     LOG_DEBUG("PRIOS", "Successfully decrypted %d bytes using LFSR", dataLen);
     return true;
 }
 
+// Decrypt the PRIOS part of a TPL payload in-place
+bool PriosHandler::decryptPayload(const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen, uint8_t* payload,
+                                  uint8_t payloadLen) {
+    if (!fullwMBusFrame || !payload || payloadLen < PRIOS_OFFSET_ENCRYPTED_DATA ||
+        fullwMBusFrameLen < PRIOS_MIN_FRAME_LENGTH) {
+        return false;
+    }
+
+    // Use default PRIOS key for decryption
+    const uint8_t defaultKey[PRIOS_KEY_SIZE] = PRIOS_DEFAULT_KEY;
+
+    // Decrypt data in-place using full wM-Bus frame for LFSR initialization
+    return decryptData(defaultKey, payload + PRIOS_OFFSET_ENCRYPTED_DATA, payloadLen - PRIOS_OFFSET_ENCRYPTED_DATA,
+                       fullwMBusFrame);
+}
+
 // Process wM-Bus payload (PRIOS encrypted data)
 bool PriosHandler::processPayload(const char* meterId, const uint8_t* fullwMBusFrame, uint8_t fullwMBusFrameLen,
                                   uint8_t* payload, uint8_t payloadLen, int16_t rssi) {
-    if (!fullwMBusFrame || !payload || payloadLen < PRIOS_OFFSET_ENCRYPTED_DATA || fullwMBusFrameLen < 12) {
+    if (!fullwMBusFrame || !payload || payloadLen < PRIOS_OFFSET_ENCRYPTED_DATA ||
+        fullwMBusFrameLen < PRIOS_MIN_FRAME_LENGTH) {
         LOG_ERROR("PRIOS", "Invalid frame or payload");
+        decryptFailures++;
         return false;
     }
 
     LOG_DEBUG("PRIOS", "Processing payload (%d bytes) for meter %s (RSSI=%d dBm)", payloadLen, meterId, rssi);
 
-    // Calculate encrypted data length
-    uint8_t encryptedLen = payloadLen - PRIOS_OFFSET_ENCRYPTED_DATA;
-    uint8_t* encryptedData = payload + PRIOS_OFFSET_ENCRYPTED_DATA;
-
-    // Use default PRIOS key for decryption
-    const uint8_t defaultKey[PRIOS_KEY_SIZE] = PRIOS_DEFAULT_KEY;
-
-    // Decrypt data in-place using full wM-Bus frame for LFSR initialization
-    if (!decryptData(defaultKey, encryptedData, encryptedLen, fullwMBusFrame)) {
-        LOG_ERROR("PRIOS", "Decryption failed");
+    bool decrypted;
+    {
+        TRACE_SPAN(DECRYPT);
+        decrypted = decryptPayload(fullwMBusFrame, fullwMBusFrameLen, payload, payloadLen);
+    }
+    if (!decrypted) {
+        // Lengths were checked above, so the marker byte did not match (wrong key or not a PRIOS payload)
+        LOG_ERROR("PRIOS", "Decryption failed: invalid marker byte");
+        markerFailures++;
         return false;
     }
+    LATENCY_MARK(DECRYPT);
 
-    LOG_DEBUG("PRIOS", "Decrypted data: ");
-    for (uint8_t i = 0; i < encryptedLen && i < 32; i++) {
-        LOG_DEBUG("PRIOS", "%02X ", encryptedData[i]);
-    }
-    if (encryptedLen > 32)
-        LOG_DEBUG("PRIOS", "...");
-    LOG_DEBUG("PRIOS", "");
+    LOG_DEBUG_HEX("PRIOS", "Decrypted data", payload + PRIOS_OFFSET_ENCRYPTED_DATA,
+                  payloadLen - PRIOS_OFFSET_ENCRYPTED_DATA);
 
     // Pass payload with plain and decrypted data to IZAR handler for meter-specific parsing
     return izarHandler.processData(meterId, payload, payloadLen, rssi);
@@ -0,0 +1,129 @@
+#include "raw_frame_forwarder.h"
+#include "config_manager.h"
+#include "mqtt_manager.h"
+#include "wm_bus_handler.h"
+#include "span_tracer.h"
+
+RawFrameForwarder rawFrameForwarder;
+
+namespace {
+// Largest single record: hex line with every frame byte expanded to two characters
+constexpr size_t kMaxRecordSize = 64 + 2 * WM_BUS_MAX_PAYLOAD;
+} // namespace
+
+RawFrameForwarder::RawFrameForwarder() {}
+
+bool RawFrameForwarder::isEnabled() const {
+    return static_cast<RawForwardMode>(configManager.getConfig().rawForwardMode) != RawForwardMode::OFF;
+}
+
+// rtl_wmbus line format, accepted by wmbusmeters' rtlwmbus input, which hex-decodes everything after "0x" up to
+// the end of the line. The verdict is therefore carried only in binary mode, here it sets <crc ok>:
+// T1;<crc ok>;<3of6 ok>;<ISR timestamp us>;<packet RSSI>;<current RSSI>;<A-field id>;0x<telegram hex>
+size_t RawFrameForwarder::encodeHex(uint8_t* out, size_t outSize, const uint8_t* frame, uint8_t frameLen, int16_t rssi,
+                                    uint32_t isrTimestampUs, RawFrameVerdict verdict) {
+    static const char hexDigits[] = "0123456789abcdef";
+    char* line = reinterpret_cast<char*>(out);
+
+    int prefixLen = snprintf(line, outSize, "T1;%d;1;%lu;%d;%d;%02x%02x%02x%02x;0x",
+                             verdict == RawFrameVerdict::TPL_UNCHECKED ? 0 : 1,
+                             static_cast<unsigned long>(isrTimestampUs), rssi, rssi,
+                             frame[WM_BUS_OFFSET_A_FIELD + 3], frame[WM_BUS_OFFSET_A_FIELD + 2],
+                             frame[WM_BUS_OFFSET_A_FIELD + 1], frame[WM_BUS_OFFSET_A_FIELD]);
+    if (prefixLen < 0 || static_cast<size_t>(prefixLen) + 2 * frameLen + 1 > outSize) {
+        return 0;
+    }
+
+    size_t len = static_cast<size_t>(prefixLen);
+    for (uint8_t i = 0; i < frameLen; i++) {
+        line[len++] = hexDigits[frame[i] >> 4];
+        line[len++] = hexDigits[frame[i] & 0x0F];
+    }
+    line[len++] = '\n';
+    return len;
+}
+
+size_t RawFrameForwarder::encodeBinary(uint8_t* out, size_t outSize, const uint8_t* frame, uint8_t frameLen,
+                                       int16_t rssi, uint32_t isrTimestampUs, RawFrameVerdict verdict) {
+    if (RAW_FORWARD_BINARY_HEADER_SIZE + static_cast<size_t>(frameLen) > outSize) {
+        return 0;
+    }
+
+    out[0] = frameLen;
+    out[1] = RAW_FORWARD_MODE_T1;
+    out[2] = static_cast<uint8_t>(verdict);
+    out[3] = static_cast<uint16_t>(rssi) & 0xFF;
+    out[4] = static_cast<uint16_t>(rssi) >> 8;
+    out[5] = isrTimestampUs & 0xFF;
+    out[6] = (isrTimestampUs >> 8) & 0xFF;
+    out[7] = (isrTimestampUs >> 16) & 0xFF;
+    out[8] = (isrTimestampUs >> 24) & 0xFF;
+    memcpy(out + RAW_FORWARD_BINARY_HEADER_SIZE, frame, frameLen);
+    return RAW_FORWARD_BINARY_HEADER_SIZE + frameLen;
+}
+
+void RawFrameForwarder::enqueue(const uint8_t* frame, uint8_t frameLen, int16_t rssi, uint32_t isrTimestampUs,
+                                RawFrameVerdict verdict) {
+    const RawForwardMode mode = static_cast<RawForwardMode>(configManager.getConfig().rawForwardMode);
+    if (mode == RawForwardMode::OFF || !frame || frameLen < WM_BUS_HEADER_SIZE) {
+        return;
+    }
+
+    // Same backpressure as readings: nothing is buffered while the broker is unreachable
+    if (!mqttManager.isConnected()) {
+        droppedFrames += batchFrames + 1;
+        batchLen = 0;
+        batchFrames = 0;
+        return;
+    }
+
+    uint8_t record[kMaxRecordSize];
+    size_t recordLen = 0;
+    if (mode == RawForwardMode::BINARY) {
+        recordLen = encodeBinary(record, sizeof(record), frame, frameLen, rssi, isrTimestampUs, verdict);
+    } else {
+        recordLen = encodeHex(record, sizeof(record), frame, frameLen, rssi, isrTimestampUs, verdict);
+    }
+    if (recordLen == 0 || recordLen > RAW_FORWARD_MAX_BATCH_BYTES) {
+        LOG_WARN("RawFwd", "Telegram does not fit a batch (%d bytes)", frameLen);
+        droppedFrames++;
+        return;
+    }
+
+    if (batchLen + recordLen > RAW_FORWARD_MAX_BATCH_BYTES) {
+        flush();
+    }
+
+    if (batchFrames == 0) {
+        batchStartTime = millis();
+    }
+    memcpy(batch + batchLen, record, recordLen);
+    batchLen += recordLen;
+    batchFrames++;
+
+    if (batchFrames >= RAW_FORWARD_MAX_BATCH_FRAMES) {
+        flush();
+    }
+}
+
+void RawFrameForwarder::handle() {
+    TRACE_SPAN(RAW_FORWARD);
+    if (batchFrames > 0 && millis() - batchStartTime >= RAW_FORWARD_MAX_LATENCY_MS) {
+        flush();
+    }
+}
+
+void RawFrameForwarder::flush() {
+    if (batchFrames == 0) {
+        return;
+    }
+
+    if (!mqttManager.publish(mqttManager.getTopicRaw(), batch, batchLen)) {
+        droppedFrames += batchFrames;
+    } else {
+        LOG_DEBUG("RawFwd", "Forwarded %d telegrams (%u bytes)", batchFrames, static_cast<unsigned>(batchLen));
+    }
+
+    batchLen = 0;
+    batchFrames = 0;
+}
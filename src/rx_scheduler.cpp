@@ -0,0 +1,65 @@
+#include "rx_scheduler.h"
+#include <algorithm>
+
+RxScheduler rxScheduler;
+
+void RxScheduler::reset() {
+    intervalMs = 0;
+    haveFrame = false;
+    onTime = 0;
+    jitterMs = 0;
+}
+
+void RxScheduler::setInterval(uint32_t interval) {
+    if (interval != intervalMs) {
+        intervalMs = interval;
+        onTime = 0; // Relearn the phase against the new interval
+    }
+}
+
+uint32_t RxScheduler::getGuardMs() const {
+    return std::max<uint32_t>(RX_SCHEDULE_MIN_GUARD_MS, jitterMs * RX_SCHEDULE_JITTER_FACTOR);
+}
+
+void RxScheduler::recordFrame(uint32_t nowMs) {
+    if (haveFrame && intervalMs > 0) {
+        // Missed frames in between only scale the expected gap
+        uint32_t gap = nowMs - lastFrameMs;
+        uint32_t intervals = (gap + intervalMs / 2) / intervalMs;
+        if (intervals == 0) {
+            return; // Repeat within the same transmission slot, keep the phase of the first one
+        }
+        uint32_t expected = intervals * intervalMs;
+        uint32_t deviation = gap > expected ? gap - expected : expected - gap;
+
+        if (deviation <= getGuardMs()) {
+            if (onTime < RX_SCHEDULE_LOCK_FRAMES) {
+                onTime++;
+            }
+        } else {
+            onTime = 0;
+        }
+        jitterMs = std::max(deviation, jitterMs - jitterMs / 8);
+    }
+    lastFrameMs = nowMs;
+    haveFrame = true;
+}
+
+RxMode RxScheduler::update(uint32_t nowMs) {
+    if (!haveFrame || intervalMs == 0 || !isLocked()) {
+        return RxMode::CONTINUOUS;
+    }
+
+    uint32_t guard = getGuardMs();
+    uint32_t sinceFrame = nowMs - lastFrameMs;
+    if (sinceFrame > intervalMs + guard) {
+        // The window closed without a frame: listen continuously until the meter is back on schedule
+        missedWindows++;
+        onTime = 0;
+        return RxMode::CONTINUOUS;
+    }
+    if (intervalMs < 2 * guard + RX_SCHEDULE_MIN_SLEEP_MS) {
+        return RxMode::CONTINUOUS; // Not worth sleeping
+    }
+    return sinceFrame + guard >= intervalMs ? RxMode::WINDOW : RxMode::SLEEP;
+}
@@ -0,0 +1,314 @@
+#include "self_benchmark.h"
+#include <ArduinoJson.h>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include "mqtt_manager.h"
+#include "wm_bus_handler.h"
+#include "prios_handler.h"
+#include "izar_handler.h"
+#include "log_queue.h"
+#include "span_tracer.h"
+
+SelfBenchmark selfBenchmark;
+
+namespace {
+// Raw T1 telegrams as the SX1262 delivers them (3-out-of-6 encoded, before zero padding), one per meter:
+// O05FS649426 at 12.345 m3 with the leakage_previously alarm, followed by seven meters from `izar-encode -s 7`
+constexpr uint8_t kCorpusFrameLength = 45;
+const uint8_t kCorpus[][kCorpusFrameLength] PROGMEM = {
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x34, 0xE2, 0xDC, 0x65, 0xA6, 0x96, 0x96, 0x65, 0x93,
+     0xD1, 0x36, 0x72, 0x98, 0xD5, 0x8B, 0x73, 0x45, 0x96, 0x34, 0xB2, 0xF1, 0x2C, 0xB7, 0x31,
+     0x99, 0x69, 0x65, 0x68, 0xD9, 0x53, 0xB2, 0xC9, 0xA9, 0xC9, 0x9B, 0x2C, 0x8D, 0x3D, 0x0E},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x95, 0x36, 0x8B, 0x2D, 0x9C, 0x8B, 0x2F, 0x25, 0xAC,
+     0x36, 0xC6, 0x59, 0x98, 0xD5, 0x8B, 0x36, 0x65, 0x96, 0x34, 0xB3, 0xB1, 0x70, 0xE2, 0xE6,
+     0xA7, 0x4B, 0x31, 0x39, 0x68, 0xEC, 0xA6, 0x64, 0xF1, 0x71, 0xCD, 0x16, 0x39, 0x98, 0xE9},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x9B, 0x45, 0xA6, 0xC6, 0x5D, 0x0E, 0x34, 0xD5, 0xB1,
+     0x68, 0xD4, 0xE3, 0x98, 0xD3, 0x4B, 0x36, 0x65, 0x96, 0x34, 0xB5, 0xA6, 0xA6, 0x99, 0x59,
+     0x4E, 0x3B, 0x34, 0x5A, 0x9A, 0x56, 0x72, 0x38, 0xF2, 0xB1, 0x99, 0x93, 0x99, 0xA6, 0xA3},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0xC7, 0x43, 0x66, 0xB0, 0xB3, 0x8E, 0xD1, 0x65, 0xA6,
+     0x5B, 0x27, 0x31, 0x98, 0xD2, 0xCB, 0x36, 0x65, 0x96, 0x34, 0xB4, 0xD6, 0x2E, 0x53, 0x8D,
+     0x38, 0xEA, 0x4B, 0x65, 0xA9, 0xB2, 0x59, 0x3D, 0x0B, 0x8D, 0xCC, 0x74, 0x2E, 0x36, 0x69},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x69, 0xA8, 0xD3, 0x35, 0xC7, 0x0D, 0x64, 0xE5, 0x9A,
+     0xD2, 0xC2, 0xF4, 0x98, 0xD3, 0x4B, 0x59, 0x35, 0x96, 0x34, 0xBC, 0xAC, 0xB1, 0x6D, 0x23,
+     0x4C, 0xD6, 0x5A, 0x2D, 0xCC, 0x99, 0x69, 0x96, 0x5A, 0x2F, 0x46, 0xB4, 0x35, 0xC9, 0x66},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0xA5, 0x3D, 0x32, 0x4C, 0xB6, 0x8D, 0xC8, 0xE5, 0xB4,
+     0x72, 0x3A, 0x74, 0x98, 0xD3, 0x8B, 0x36, 0x55, 0x96, 0x34, 0xBC, 0x4D, 0xD1, 0x33, 0x59,
+     0x2E, 0x3B, 0x2C, 0x35, 0x67, 0x16, 0xCA, 0x6C, 0x8D, 0x4D, 0xA8, 0xEC, 0x69, 0x66, 0x4D},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x66, 0x66, 0x53, 0x68, 0xD5, 0x8E, 0xB1, 0x35, 0x9A,
+     0xCB, 0x43, 0x71, 0x98, 0xD2, 0xCB, 0x36, 0x35, 0x96, 0x34, 0xBD, 0x32, 0x96, 0x5C, 0xA9,
+     0xCB, 0x45, 0xAC, 0x4E, 0x54, 0xCB, 0xD2, 0x32, 0xEC, 0xC6, 0x36, 0x72, 0x5A, 0x6C, 0x66},
+    {0x36, 0x57, 0x1C, 0x2D, 0x67, 0x34, 0x6A, 0x39, 0xB1, 0xC6, 0x35, 0x96, 0x95, 0x95, 0xB4,
+     0x9B, 0x4C, 0x71, 0x98, 0xD5, 0x8B, 0x37, 0x25, 0x96, 0x34, 0xB2, 0xEC, 0xC9, 0xA5, 0xB1,
+     0x68, 0xB5, 0xB4, 0x66, 0xC6, 0x72, 0x38, 0xB2, 0xD3, 0xC6, 0x5C, 0x93, 0x59, 0x63, 0xAC},
+};
+constexpr size_t kCorpusFrames = sizeof(kCorpus) / sizeof(kCorpus[0]);
+
+const char* const kStageNames[] = {"decode", "decrypt", "parse", "serialize", "total"};
+constexpr size_t kStageCount = static_cast<size_t>(BenchStage::COUNT);
+constexpr size_t kTimedStages = static_cast<size_t>(BenchStage::TOTAL);
+constexpr size_t kResultCapacity = 1536;
+
+// Heap observed across one stage call: only allocations still held when the stage returns (or made by other tasks
+// meanwhile) move the free heap, allocations freed within the stage are not visible
+struct HeapObservation {
+    uint32_t allocations = 0;
+    uint32_t bytes = 0;
+
+    void record(uint32_t freeBefore, uint32_t freeAfter) {
+        if (freeAfter < freeBefore) {
+            allocations++;
+            bytes += freeBefore - freeAfter;
+        }
+    }
+};
+
+// Nearest-rank percentile of sorted samples
+uint32_t percentile(const uint32_t* sorted, uint16_t count, uint8_t percent) {
+    size_t rank = (static_cast<size_t>(count) * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+// Discards Serial output, so the immediate log path is timed without waiting for the UART
+class NullPrint : public Print {
+  public:
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t*, size_t size) override { return size; }
+};
+
+// Median cycles per log call of `logLines` (two calls), timed `iterations` times; `settle` runs untimed after each
+template <typename LogLines, typename Settle>
+uint32_t medianLogCycles(uint16_t iterations, uint32_t* samples, LogLines logLines, Settle settle) {
+    for (uint16_t i = 0; i < iterations; i++) {
+        uint32_t start = ESP.getCycleCount();
+        logLines();
+        samples[i] = (ESP.getCycleCount() - start) / 2;
+        settle();
+        if (i % 100 == 99) {
+            yield();
+        }
+    }
+    std::sort(samples, samples + iterations);
+    return percentile(samples, iterations, 50);
+}
+
+// What LogSink::logf() queues with ENABLE_DEFERRED_LOG 0
+bool queueText(LogQueue& queue, uint8_t level, const char* tag, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+bool queueText(LogQueue& queue, uint8_t level, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    bool queued = queue.vpushf(level, tag, format, args);
+    va_end(args);
+    return queued;
+}
+} // namespace
+
+SelfBenchmark::SelfBenchmark() {
+    strlcpy(resultJson, "{\"status\":\"idle\"}", sizeof(resultJson));
+}
+
+bool SelfBenchmark::request(uint16_t iterations, bool publishResult) {
+    if (pendingIterations != 0) {
+        return false;
+    }
+    if (iterations == 0) {
+        iterations = SELF_BENCH_DEFAULT_ITERATIONS;
+    }
+    pendingPublish = publishResult;
+    pendingIterations = std::min<uint16_t>(iterations, SELF_BENCH_MAX_ITERATIONS);
+    return true;
+}
+
+void SelfBenchmark::handle() {
+    TRACE_SPAN(SELF_BENCH);
+    if (pendingIterations == 0) {
+        return;
+    }
+
+    LOG_INFO("Bench", "Running %u iterations over %u corpus frames", pendingIterations,
+             static_cast<unsigned>(kCorpusFrames));
+    if (!run(pendingIterations)) {
+        LOG_ERROR("Bench", "Benchmark failed");
+    }
+    if (pendingPublish) {
+        mqttManager.publish(mqttManager.getTopicBench(), resultJson);
+    }
+    pendingIterations = 0;
+}
+
+bool SelfBenchmark::run(uint16_t iterations) {
+    // One sample buffer per stage, so each can be sorted on its own
+    uint32_t* samples = static_cast<uint32_t*>(malloc(sizeof(uint32_t) * kStageCount * iterations));
+    if (!samples) {
+        snprintf(resultJson, sizeof(resultJson), "{\"status\":\"failed\",\"error\":\"out of memory\"}");
+        return false;
+    }
+
+    HeapObservation heap[kTimedStages];
+    const char* failedStage = nullptr;
+    uint16_t failedFrame = 0;
+    uint32_t freeHeapBefore = ESP.getFreeHeap();
+    unsigned long startMs = millis();
+
+    static char payload[MQTT_MAX_PACKET_SIZE];
+    size_t payloadLength = 0;
+    IzarReading lastReading{};
+    for (uint16_t i = 0; i < iterations; i++) {
+        // Fresh zero-padded copy each pass: decryption works in place
+        uint8_t raw[FSK_MODEM_RX_MAX_LENGTH]{};
+        memcpy_P(raw, kCorpus[i % kCorpusFrames], kCorpusFrameLength);
+        WmBusFrame frame;
+        IzarReading reading;
+        uint32_t cycles[kTimedStages]{};
+        size_t passed = 0; // Stages that accepted the frame
+
+        uint32_t freeBefore = ESP.getFreeHeap();
+        uint32_t start = ESP.getCycleCount();
+        bool ok = WmBusHandler::decodeFrame(raw, sizeof(raw), &frame) == WmBusDecodeStatus::OK;
+        cycles[0] = ESP.getCycleCount() - start;
+        heap[0].record(freeBefore, ESP.getFreeHeap());
+        passed += ok;
+
+        if (ok) {
+            freeBefore = ESP.getFreeHeap();
+            start = ESP.getCycleCount();
+            ok = PriosHandler::decryptPayload(frame.data, frame.length, frame.tplData(), frame.tplDataLen);
+            cycles[1] = ESP.getCycleCount() - start;
+            heap[1].record(freeBefore, ESP.getFreeHeap());
+            passed += ok;
+        }
+
+        if (ok) {
+            freeBefore = ESP.getFreeHeap();
+            start = ESP.getCycleCount();
+            ok = IzarHandler::parseReading(frame.header.meterId, frame.tplData(), frame.tplDataLen, -80, &reading);
+            cycles[2] = ESP.getCycleCount() - start;
+            heap[2].record(freeBefore, ESP.getFreeHeap());
+            passed += ok;
+        }
+
+        if (ok) {
+            freeBefore = ESP.getFreeHeap();
+            start = ESP.getCycleCount();
+            StaticJsonDocument<768> doc;
+            mqttManager.buildReadingJson(&reading, 0.0f, doc);
+            payloadLength = serializeJson(doc, payload, sizeof(payload));
+            cycles[3] = ESP.getCycleCount() - start;
+            heap[3].record(freeBefore, ESP.getFreeHeap());
+            passed += payloadLength > 0;
+            lastReading = reading;
+        }
+
+        // The corpus is fixed, so any rejection means the build under test is broken
+        if (passed < kTimedStages) {
+            failedStage = kStageNames[passed];
+            failedFrame = i % kCorpusFrames;
+            break;
+        }
+
+        uint32_t total = 0;
+        for (size_t s = 0; s < kTimedStages; s++) {
+            samples[s * iterations + i] = cycles[s];
+            total += cycles[s];
+        }
+        samples[kTimedStages * iterations + i] = total;
+
+        // Let WiFi and AsyncTCP run between passes, outside the timed sections
+        if (i % 100 == 99) {
+            yield();
+        }
+    }
+    unsigned long durationMs = millis() - startMs;
+
+    if (failedStage) {
+        free(samples);
+        snprintf(resultJson, sizeof(resultJson), "{\"status\":\"failed\",\"error\":\"corpus frame %u rejected by %s\"}",
+                 failedFrame, failedStage);
+        return false;
+    }
+
+    StaticJsonDocument<kResultCapacity> doc;
+    doc["status"] = "ok";
+    doc["version"] = PROJECT_VERSION;
+    doc["build"] = __DATE__ " " __TIME__;
+    doc["cpu_mhz"] = getCpuFrequencyMhz();
+    doc["iterations"] = iterations;
+    doc["corpus_frames"] = kCorpusFrames;
+    doc["duration_ms"] = durationMs;
+    doc["payload_bytes"] = payloadLength;
+    doc["free_heap"] = freeHeapBefore;
+    doc["min_free_heap"] = ESP.getMinFreeHeap();
+
+    JsonObject stages = doc.createNestedObject("stages");
+    for (size_t s = 0; s < kStageCount; s++) {
+        uint32_t* sorted = samples + s * iterations;
+        std::sort(sorted, sorted + iterations);
+
+        JsonObject stage = stages.createNestedObject(kStageNames[s]);
+        stage["min"] = sorted[0];
+        stage["median"] = percentile(sorted, iterations, 50);
+        stage["p99"] = percentile(sorted, iterations, 99);
+        stage["max"] = sorted[iterations - 1];
+        if (s < kTimedStages) {
+            stage["heap_allocs"] = heap[s].allocations;
+            stage["heap_bytes"] = heap[s].bytes;
+        }
+    }
+
+    // Two of the lines IzarHandler::processData logs per reading, into scratch buffers so the logs keep their lines:
+    // immediate is what the LOG_* macros cost before the log sink (Serial formatting and the web log text), text
+    // queues the formatted line (ENABLE_DEFERRED_LOG 0), deferred queues the arguments only. The sink's work is
+    // left out, it runs on its own task.
+    std::unique_ptr<WebLogger> logger(new (std::nothrow) WebLogger());
+    std::unique_ptr<LogQueue> queue(new (std::nothrow) LogQueue());
+    if (logger && queue) {
+        NullPrint serial;
+        uint8_t level;
+        uint32_t t;
+        uint8_t data[WEB_LOG_MAX_MESSAGE];
+        uint16_t length;
+        auto emptyQueue = [&] {
+            while (queue->pop(level, t, data, length)) {
+            }
+        };
+
+        JsonObject logCycles = doc.createNestedObject("log_cycles");
+        logCycles["immediate"] = medianLogCycles(
+            iterations, samples,
+            [&] {
+                serial.printf("[INFO][%s] ", "IZAR");
+                serial.printf("Meter ID: %s", lastReading.meterId);
+                serial.println();
+                logger->logf(LOG_LEVEL_INFO, "IZAR", "Meter ID: %s", lastReading.meterId);
+                serial.printf("[INFO][%s] ", "IZAR");
+                serial.printf("Current reading: %.3f m³", lastReading.current_reading);
+                serial.println();
+                logger->logf(LOG_LEVEL_INFO, "IZAR", "Current reading: %.3f m³", lastReading.current_reading);
+            },
+            [] {});
+        logCycles["text"] = medianLogCycles(
+            iterations, samples,
+            [&] {
+                queueText(*queue, LOG_LEVEL_INFO, "IZAR", "Meter ID: %s", lastReading.meterId);
+                queueText(*queue, LOG_LEVEL_INFO, "IZAR", "Current reading: %.3f m³", lastReading.current_reading);
+            },
+            emptyQueue);
+        logCycles["deferred"] = medianLogCycles(
+            iterations, samples,
+            [&] {
+                queue->pushDeferred(LOG_LEVEL_INFO, "IZAR", "Meter ID: %s", lastReading.meterId);
+                queue->pushDeferred(LOG_LEVEL_INFO, "IZAR", "Current reading: %.3f m³", lastReading.current_reading);
+            },
+            emptyQueue);
+    }
+    free(samples);
+
+    if (doc.overflowed() || serializeJson(doc, resultJson, sizeof(resultJson)) >= sizeof(resultJson) - 1) {
+        snprintf(resultJson, sizeof(resultJson), "{\"status\":\"failed\",\"error\":\"result too large\"}");
+        return false;
+    }
+    LOG_INFO("Bench", "%u iterations in %lu ms, chain median %lu cycles", iterations, durationMs,
+             static_cast<unsigned long>(stages["total"]["median"].as<uint32_t>()));
+    return true;
+}
@@ -0,0 +1,163 @@
+#include "span_tracer.h"
+#include <algorithm>
+
+#ifdef SPAN_TRACE_ACTIVE
+SpanTracer spanTracer;
+
+namespace {
+// Event names, indexed by TraceId
+const char* const kTraceNames[] = {"loop",         "wifi",         "wifi_connect",    "mqtt",
+                                   "mqtt_connect", "ha_discovery", "web_server",      "fsk_modem",
+                                   "raw_forward",  "self_bench",   "latency_publish", "display",
+                                   "button",       "log",          "log_sink",        "read",
+                                   "decode",       "decrypt",      "parse",           "publish",
+                                   "sx1262_irq",   "expander_irq"};
+static_assert(sizeof(kTraceNames) / sizeof(kTraceNames[0]) == static_cast<size_t>(TraceId::COUNT),
+              "kTraceNames out of sync with TraceId");
+
+// Chrome trace thread names, indexed by TraceTrack - 1
+const char* const kTrackNames[] = {"loop", "other tasks", "isr"};
+} // namespace
+
+void SpanTracer::begin() {
+    loopTask = xTaskGetCurrentTaskHandle();
+}
+
+void SpanTracer::record(TraceId id, uint32_t startUs, uint32_t durationUs) {
+    if (durationUs < SPAN_TRACE_MIN_US && !isPipeline(id)) {
+        return;
+    }
+    push(id, startUs, durationUs);
+}
+
+void IRAM_ATTR SpanTracer::instant(TraceId id) {
+    push(id, micros(), 0);
+}
+
+void IRAM_ATTR SpanTracer::push(TraceId id, uint32_t startUs, uint32_t durationUs) {
+    TraceTrack track = TraceTrack::ISR;
+    if (!xPortInIsrContext()) {
+        track = xTaskGetCurrentTaskHandle() == loopTask ? TraceTrack::LOOP : TraceTrack::OTHER_TASK;
+    }
+
+    portENTER_CRITICAL_SAFE(&mux);
+    TraceRecord& record = records[written % SPAN_TRACE_EVENTS];
+    record.startUs = startUs;
+    record.durationUs = durationUs;
+    record.id = id;
+    record.track = track;
+    written++;
+    portEXIT_CRITICAL_SAFE(&mux);
+}
+
+void SpanTracer::clear() {
+    portENTER_CRITICAL(&mux);
+    written = 0;
+    portEXIT_CRITICAL(&mux);
+}
+
+void SpanTracer::getRange(uint32_t& oldest, uint32_t& end) {
+    portENTER_CRITICAL(&mux);
+    oldest = written > SPAN_TRACE_EVENTS ? written - SPAN_TRACE_EVENTS : 0;
+    end = written;
+    portEXIT_CRITICAL(&mux);
+}
+
+bool SpanTracer::read(uint32_t& sequence, TraceRecord& out) {
+    portENTER_CRITICAL(&mux);
+    bool available = sequence < written;
+    if (available) {
+        if (written - sequence > SPAN_TRACE_EVENTS) {
+            sequence = written - SPAN_TRACE_EVENTS;
+        }
+        out = records[sequence % SPAN_TRACE_EVENTS];
+    }
+    portEXIT_CRITICAL(&mux);
+    return available;
+}
+
+const char* SpanTracer::getName(TraceId id) {
+    return kTraceNames[static_cast<size_t>(id)];
+}
+
+size_t TraceWriter::read(uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (lineOffset == lineLength) {
+            if (!nextLine()) {
+                break;
+            }
+            lineOffset = 0;
+        }
+        size_t chunk = std::min(lineLength - lineOffset, maxLen - written);
+        memcpy(buffer + written, line + lineOffset, chunk);
+        lineOffset += chunk;
+        written += chunk;
+    }
+    return written;
+}
+
+// Header, process and thread names, the records oldest first, footer. The dump ends at the newest record when it
+// started, records added while it streams are left for the next one.
+bool TraceWriter::nextLine() {
+    int length = -1;
+    while (length < 0) {
+        switch (part) {
+        case Part::HEADER:
+            length = snprintf(line, sizeof(line), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+            spanTracer.getRange(sequence, endSequence);
+            part = Part::METADATA;
+            break;
+        case Part::METADATA:
+            if (item == 0) {
+                length = snprintf(line, sizeof(line),
+                                  "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"%s\"}}",
+                                  PROJECT_NAME);
+            } else if (item <= sizeof(kTrackNames) / sizeof(kTrackNames[0])) {
+                length = snprintf(line, sizeof(line),
+                                  ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,"
+                                  "\"args\":{\"name\":\"%s\"}}",
+                                  item, kTrackNames[item - 1]);
+            } else {
+                part = Part::EVENTS;
+                break;
+            }
+            item++;
+            break;
+        case Part::EVENTS: {
+            TraceRecord record;
+            if (sequence < endSequence && spanTracer.read(sequence, record)) {
+                sequence++;
+                length = formatRecord(record);
+            } else {
+                part = Part::FOOTER;
+            }
+            break;
+        }
+        case Part::FOOTER:
+            length = snprintf(line, sizeof(line), "\n]}\n");
+            part = Part::DONE;
+            break;
+        case Part::DONE:
+            return false;
+        }
+    }
+    lineLength = std::min(static_cast<size_t>(length), sizeof(line) - 1);
+    return true;
+}
+
+// Spans become complete ("X") events, ISR events thread-scoped instants ("i")
+int TraceWriter::formatRecord(const TraceRecord& record) {
+    const char* category = SpanTracer::isPipeline(record.id) ? "pipeline" : "loop";
+    if (record.track == TraceTrack::ISR) {
+        return snprintf(line, sizeof(line),
+                        ",\n{\"name\":\"%s\",\"cat\":\"isr\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%lu,\"pid\":1,\"tid\":%u}",
+                        SpanTracer::getName(record.id), static_cast<unsigned long>(record.startUs),
+                        static_cast<unsigned>(record.track));
+    }
+    return snprintf(line, sizeof(line),
+                    ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%lu,\"dur\":%lu,\"pid\":1,\"tid\":%u}",
+                    SpanTracer::getName(record.id), category, static_cast<unsigned long>(record.startUs),
+                    static_cast<unsigned long>(record.durationUs), static_cast<unsigned>(record.track));
+}
+#endif // SPAN_TRACE_ACTIVE
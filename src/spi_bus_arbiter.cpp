@@ -0,0 +1,43 @@
+#include "spi_bus_arbiter.h"
+
+SpiBusArbiter spiBus;
+
+void SpiBusArbiter::begin() {
+    if (!mutex) {
+        mutex = xSemaphoreCreateMutex();
+    }
+}
+
+void SpiBusArbiter::acquire(SpiClient client) {
+    uint32_t requestedUs = micros();
+    if (client == SpiClient::RADIO) {
+        radioWaiting = true;
+    }
+    if (mutex) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+    }
+    acquiredUs = micros();
+
+    if (client == SpiClient::RADIO) {
+        radioWaiting = false;
+        radioIrq = false;
+        uint32_t waitUs = acquiredUs - requestedUs;
+        radioWaitTotalUs += waitUs;
+        if (waitUs > radioWaitMaxUs) {
+            radioWaitMaxUs = waitUs;
+        }
+    }
+}
+
+void SpiBusArbiter::release(SpiClient client) {
+    uint32_t heldUs = micros() - acquiredUs;
+    SpiHoldStats& stats = hold[static_cast<size_t>(client)];
+    stats.acquisitions++;
+    stats.totalUs += heldUs;
+    if (heldUs > stats.maxUs) {
+        stats.maxUs = heldUs;
+    }
+    if (mutex) {
+        xSemaphoreGive(mutex);
+    }
+}
@@ -2,8 +2,18 @@
 #include <DNSServer.h>
 #include <WiFi.h>
 #include <Update.h>
+#include <memory>
+#include <new>
 #include "wifi_manager.h"
+#include "config_json_parser.h"
 #include "web_logger.h"
+#include "raw_frame_forwarder.h"
+#include "self_benchmark.h"
+#include "pipeline_latency.h"
+#include "bridge_metrics.h"
+#include "span_tracer.h"
+#include "link_quality.h"
+#include "history_store.h"
 
 WebConfigServer webConfigServer(&configManager);
 
@@ -63,7 +73,7 @@ const char CONFIG_HTML[] PROGMEM = R"rawliteral(
             color: #333;
             margin-bottom: 6px;
         }
-        input {
+        input, select {
             width: 100%;
             padding: 10px;
             border: 2px solid #e0e0e0;
@@ -150,6 +160,14 @@ const char CONFIG_HTML[] PROGMEM = R"rawliteral(
                         <label for="mqttBaseTopic">Base MQTT Topic</label>
                         <input type="text" id="mqttBaseTopic" name="mqttBaseTopic" required>
                     </div>
+                    <div class="form-group">
+                        <label for="rawForwardMode">Raw Telegram Forwarding (&lt;base&gt;/raw)</label>
+                        <select id="rawForwardMode" name="rawForwardMode">
+                            <option value="0">Off</option>
+                            <option value="1">Hex (rtl_wmbus lines for wmbusmeters)</option>
+                            <option value="2">Binary records</option>
+                        </select>
+                    </div>
                 </div>
 
                 <div class="section">
@@ -198,6 +216,7 @@ const char CONFIG_HTML[] PROGMEM = R"rawliteral(
             const formData = new FormData(e.target);
             const config = Object.fromEntries(formData.entries());
             config.mqttPort = parseInt(config.mqttPort);
+            config.rawForwardMode = parseInt(config.rawForwardMode);
 
             try {
                 const response = await fetch('/api/config', {
@@ -208,13 +227,6 @@ const char CONFIG_HTML[] PROGMEM = R"rawliteral(
 
                 const result = await response.json();
                 showStatus(result.success ? 'success' : 'error', result.message);
-
-                if (result.success) {
-                    setTimeout(() => {
-                        showStatus('success', 'Rebooting device...');
-                        setTimeout(() => location.reload(), 3000);
-                    }, 1000);
-                }
             } catch (err) {
                 showStatus('error', 'Failed to save configuration: ' + err.message);
             }
@@ -256,6 +268,12 @@ void WebConfigServer::begin() {
 }
 
 void WebConfigServer::handle() {
+    TRACE_SPAN(WEB_SERVER);
+    if (dnsStarted && !wifiManager.isApModeActive()) {
+        dnsServer.stop();
+        dnsStarted = false;
+        LOG_INFO("Web", "DNS captive portal stopped");
+    }
     startDnsIfNeeded();
     if (dnsStarted) {
         dnsServer.processNextRequest();
@@ -282,7 +300,8 @@ void WebConfigServer::setupRoutes() {
     });
 
     server.on("/api/config", HTTP_GET, [this](AsyncWebServerRequest* request) {
-        const Config& config = configManager->getConfig();
+        // Copied under the lock, the loop may be applying a saved configuration right now
+        const Config config = configManager->getSnapshot();
 
         StaticJsonDocument<768> doc;
         doc["wifiSSID"] = config.wifiSSID;
@@ -295,6 +314,7 @@ void WebConfigServer::setupRoutes() {
         doc["mqttPassword"] = "";
         doc["mqttClientId"] = config.mqttClientId;
         doc["mqttBaseTopic"] = config.mqttBaseTopic;
+        doc["rawForwardMode"] = config.rawForwardMode;
         doc["serialNumber"] = config.serialNumber;
 
         String response;
@@ -303,77 +323,39 @@ void WebConfigServer::setupRoutes() {
     });
 
     server.on(
-        "/api/config", HTTP_POST, [](AsyncWebServerRequest* request) {}, nullptr,
-        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
-            if (index == 0) {
-                request->_tempObject = new String();
-                static_cast<String*>(request->_tempObject)->reserve(total);
-            }
-
-            String* body = static_cast<String*>(request->_tempObject);
-            body->concat(reinterpret_cast<char*>(data), len);
-
-            if (index + len != total) {
+        "/api/config", HTTP_POST,
+        [this](AsyncWebServerRequest* request) {
+            // Runs once the whole body went through the parser; the only place this request is answered
+            ConfigJsonParser* parser = static_cast<ConfigJsonParser*>(request->_tempObject);
+            if (!parser && request->contentLength() > 0) {
+                request->send(500, "application/json", "{\"success\":false,\"message\":\"Out of memory\"}");
                 return;
             }
-
-            StaticJsonDocument<768> doc;
-            DeserializationError error = deserializeJson(doc, *body);
-            delete body;
-            request->_tempObject = nullptr;
-
-            if (error) {
+            if (!parser || !parser->isComplete()) {
                 request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid JSON\"}");
                 return;
             }
-
-            Config& config = configManager->getConfig();
-
-            if (doc.containsKey("wifiSSID")) {
-                String ssid = String(doc["wifiSSID"] | "");
-                ssid.trim();
-                strlcpy(config.wifiSSID, ssid.c_str(), sizeof(config.wifiSSID));
-            }
-            if (doc.containsKey("wifiPassword")) {
-                const char* wifiPassword = doc["wifiPassword"] | "";
-                if (strlen(wifiPassword) > 0) {
-                    strlcpy(config.wifiPassword, wifiPassword, sizeof(config.wifiPassword));
-                }
-            }
-            if (doc.containsKey("hostname")) {
-                String hostname = String(doc["hostname"] | "");
-                hostname.trim();
-                strlcpy(config.hostname, hostname.c_str(), sizeof(config.hostname));
-            }
-
-            if (doc.containsKey("mqttBroker"))
-                strlcpy(config.mqttBroker, doc["mqttBroker"] | "", sizeof(config.mqttBroker));
-            if (doc.containsKey("mqttPort"))
-                config.mqttPort = doc["mqttPort"] | MQTT_PORT_DEFAULT;
-            if (doc.containsKey("mqttUsername"))
-                strlcpy(config.mqttUsername, doc["mqttUsername"] | "", sizeof(config.mqttUsername));
-            if (doc.containsKey("mqttPassword")) {
-                const char* mqttPassword = doc["mqttPassword"] | "";
-                if (strlen(mqttPassword) > 0) {
-                    strlcpy(config.mqttPassword, mqttPassword, sizeof(config.mqttPassword));
+            // Applied by the main loop once this reply is out, without a reboot
+            configManager->requestUpdate(parser->getConfig());
+            request->send(200, "application/json",
+                          "{\"success\":true,\"message\":\"Configuration saved and applied\"}");
+        },
+        nullptr,
+        [this](AsyncWebServerRequest* request, uint8_t* data, size_t len, size_t index, size_t total) {
+            // Parsed chunk by chunk; the request frees the parser (trivially destructible) when it ends. Without
+            // memory for it the body is ignored and the request handler answers 500.
+            if (index == 0) {
+                void* memory = malloc(sizeof(ConfigJsonParser));
+                if (!memory) {
+                    LOG_WARN("Web", "No memory for the configuration parser");
+                    return;
                 }
+                request->_tempObject = new (memory) ConfigJsonParser(configManager->getSnapshot());
             }
-            if (doc.containsKey("mqttClientId"))
-                strlcpy(config.mqttClientId, doc["mqttClientId"] | "", sizeof(config.mqttClientId));
-            if (doc.containsKey("mqttBaseTopic"))
-                strlcpy(config.mqttBaseTopic, doc["mqttBaseTopic"] | "", sizeof(config.mqttBaseTopic));
-
-            if (doc.containsKey("serialNumber")) {
-                String serial = String(doc["serialNumber"] | "");
-                serial.trim();
-                strlcpy(config.serialNumber, serial.c_str(), sizeof(config.serialNumber));
+            ConfigJsonParser* parser = static_cast<ConfigJsonParser*>(request->_tempObject);
+            if (parser) {
+                parser->feed(data, len);
             }
-
-            configManager->save();
-
-            request->send(200, "application/json", "{\"success\":true,\"message\":\"Configuration saved\"}");
-            delay(1000);
-            ESP.restart();
         });
 
     server.on("/api/reset", HTTP_POST, [this](AsyncWebServerRequest* request) {
@@ -419,6 +401,15 @@ void WebConfigServer::setupRoutes() {
             <a href="/" class="back-link">← Back to Config</a>
         </div>
         <div class="controls">
+            <select class="btn" id="levelTag"></select>
+            <select class="btn" id="levelValue">
+                <option value="0">NONE</option>
+                <option value="1">ERROR</option>
+                <option value="2">WARN</option>
+                <option value="3">INFO</option>
+                <option value="4">DEBUG</option>
+            </select>
+            <button class="btn" id="levelBtn">Set level</button>
             <button class="btn" id="autoScrollBtn">Auto-scroll: ON</button>
             <button class="btn" id="clearBtn">Clear</button>
         </div>
@@ -438,6 +429,33 @@ void WebConfigServer::setupRoutes() {
             if (autoScroll) logContainer.scrollTop = logContainer.scrollHeight;
         });
 
+        // Runtime level per log tag, stored on the device
+        const levelTag = document.getElementById('levelTag');
+        const levelValue = document.getElementById('levelValue');
+        let tagLevels = {};
+
+        async function fetchLevels() {
+            try {
+                const response = await fetch('/api/logs/levels');
+                tagLevels = (await response.json()).tags;
+                const selected = levelTag.value;
+                levelTag.innerHTML = '';
+                Object.keys(tagLevels).forEach(tag => levelTag.add(new Option(tag, tag)));
+                if (selected) levelTag.value = selected;
+                levelValue.value = tagLevels[levelTag.value];
+            } catch (err) {
+                // ignore
+            }
+        }
+
+        levelTag.addEventListener('change', () => { levelValue.value = tagLevels[levelTag.value]; });
+
+        document.getElementById('levelBtn').addEventListener('click', async () => {
+            const spec = levelTag.value + '=' + levelValue.value;
+            await fetch('/api/logs/levels?levels=' + encodeURIComponent(spec), { method: 'POST' });
+            fetchLevels();
+        });
+
         clearBtn.addEventListener('click', async () => {
             await fetch('/api/logs/clear', { method: 'POST' });
             logContainer.innerHTML = '';
@@ -488,12 +506,27 @@ void WebConfigServer::setupRoutes() {
 
         setInterval(fetchLogs, 1000);
         fetchLogs();
+        fetchLevels();
     </script>
 </body>
 </html>
         )rawliteral");
     });
 
+    // Runtime log level per tag; POST ?levels=<tag>=<level>[,...] changes and stores them. Registered before
+    // /api/logs, which would also match these URLs.
+    server.on("/api/logs/levels", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", logLevels.getJSON());
+    });
+
+    server.on("/api/logs/levels", HTTP_POST, [](AsyncWebServerRequest* request) {
+        if (!request->hasParam("levels") || !logLevels.update(request->getParam("levels")->value().c_str())) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid log level\"}");
+            return;
+        }
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
     server.on("/api/logs", HTTP_GET, [](AsyncWebServerRequest* request) {
         uint32_t sinceId = 0;
         if (request->hasParam("since_id")) {
@@ -508,6 +541,110 @@ void WebConfigServer::setupRoutes() {
         request->send(200, "application/json", "{\"success\":true}");
     });
 
+    // Latest self-benchmark result; POST queues a run of ?iterations=N chain passes
+    server.on("/api/bench", HTTP_GET, [](AsyncWebServerRequest* request) {
+        if (selfBenchmark.isBusy()) {
+            request->send(200, "application/json", "{\"status\":\"running\"}");
+            return;
+        }
+        request->send(200, "application/json", selfBenchmark.getResultJSON());
+    });
+
+    server.on("/api/bench", HTTP_POST, [](AsyncWebServerRequest* request) {
+        uint16_t iterations = SELF_BENCH_DEFAULT_ITERATIONS;
+        if (request->hasParam("iterations")) {
+            iterations = request->getParam("iterations")->value().toInt();
+        }
+        if (!selfBenchmark.request(iterations, false)) {
+            request->send(409, "application/json", "{\"success\":false,\"message\":\"Benchmark already running\"}");
+            return;
+        }
+        request->send(202, "application/json", "{\"success\":true}");
+    });
+
+    // Rejection counters per stage and per-meter packet error rate, all meters ranked worst first
+    server.on("/api/diagnostics", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", linkQuality.getJSON(LINK_QUALITY_MAX_METERS));
+    });
+
+    server.on("/api/diagnostics/reset", HTTP_POST, [](AsyncWebServerRequest* request) {
+        linkQuality.requestReset();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+
+#ifdef LATENCY_TRACE_ACTIVE
+    // Per-segment latency histograms of the receive pipeline, IRQ to MQTT publish
+    server.on("/api/latency", HTTP_GET, [](AsyncWebServerRequest* request) {
+        request->send(200, "application/json", pipelineLatency.getJSON(true));
+    });
+
+    server.on("/api/latency/clear", HTTP_POST, [](AsyncWebServerRequest* request) {
+        pipelineLatency.clear();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+#endif
+
+    // OpenMetrics exposition, streamed a line at a time so a scrape never builds the whole text
+    server.on("/metrics", HTTP_GET, [](AsyncWebServerRequest* request) {
+        std::shared_ptr<MetricsWriter> writer = std::make_shared<MetricsWriter>();
+        AsyncWebServerResponse* response =
+            request->beginChunkedResponse("application/openmetrics-text; version=1.0.0; charset=utf-8",
+                                          [writer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                                              return writer->read(buffer, maxLen);
+                                          });
+        request->send(response);
+    });
+
+#ifdef SPAN_TRACE_ACTIVE
+    // Span ring as Chrome trace-event JSON, open in Perfetto (ui.perfetto.dev) or chrome://tracing
+    server.on("/api/trace", HTTP_GET, [](AsyncWebServerRequest* request) {
+        std::shared_ptr<TraceWriter> writer = std::make_shared<TraceWriter>();
+        AsyncWebServerResponse* response = request->beginChunkedResponse(
+            "application/json", [writer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return writer->read(buffer, maxLen);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=\"izar-trace.json\"");
+        request->send(response);
+    });
+
+    server.on("/api/trace/clear", HTTP_POST, [](AsyncWebServerRequest* request) {
+        spanTracer.clear();
+        request->send(200, "application/json", "{\"success\":true}");
+    });
+#endif
+
+    // Stored readings of ?meter= in [from, to) (unix seconds, default the last day) as step-second buckets
+    server.on("/api/history", HTTP_GET, [](AsyncWebServerRequest* request) {
+        if (!historyStore.isReady()) {
+            request->send(503, "application/json", "{\"success\":false,\"message\":\"History not available\"}");
+            return;
+        }
+        if (!request->hasParam("meter")) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Missing meter\"}");
+            return;
+        }
+        uint32_t to = request->hasParam("to") ? strtoul(request->getParam("to")->value().c_str(), nullptr, 10)
+                                              : static_cast<uint32_t>(time(nullptr)) + 1;
+        uint32_t from = request->hasParam("from")
+                            ? strtoul(request->getParam("from")->value().c_str(), nullptr, 10)
+                            : (to > 86400 ? to - 86400 : 0);
+        uint32_t step = request->hasParam("step")
+                            ? strtoul(request->getParam("step")->value().c_str(), nullptr, 10)
+                            : 3600;
+        if (to <= from || step < HISTORY_MIN_STEP || (to - from - 1) / step >= HISTORY_MAX_BUCKETS) {
+            request->send(400, "application/json", "{\"success\":false,\"message\":\"Invalid range or step\"}");
+            return;
+        }
+
+        std::shared_ptr<HistoryWriter> writer = std::make_shared<HistoryWriter>(
+            historyStore, request->getParam("meter")->value().c_str(), from, to, step);
+        AsyncWebServerResponse* response = request->beginChunkedResponse(
+            "application/json", [writer](uint8_t* buffer, size_t maxLen, size_t index) -> size_t {
+                return writer->read(buffer, maxLen);
+            });
+        request->send(response);
+    });
+
     server.on("/update", HTTP_GET, [](AsyncWebServerRequest* request) {
         request->send(200, "text/html", R"rawliteral(
 <!DOCTYPE html>
@@ -1,45 +1,340 @@
 #include "web_logger.h"
 #include <stdarg.h>
+#include <algorithm>
 
 WebLogger webLogger;
 
+namespace {
+// Walks the arguments of a deferred record
+class ArgReader {
+  public:
+    ArgReader(const uint8_t* data, size_t length, size_t offset) : data(data), length(length), offset(offset) {}
+
+    // Next argument, false once all are consumed
+    bool next(LogArg& type, const uint8_t*& value, size_t& size) {
+        if (offset >= length) {
+            return false;
+        }
+        type = static_cast<LogArg>(data[offset++]);
+        switch (type) {
+        case LogArg::INT32:
+            size = sizeof(uint32_t);
+            break;
+        case LogArg::INT64:
+        case LogArg::DOUBLE:
+            size = sizeof(uint64_t);
+            break;
+        case LogArg::STRING:
+        case LogArg::BYTES:
+            size = offset < length ? data[offset++] : 0;
+            break;
+        case LogArg::POINTER:
+            size = sizeof(void*);
+            break;
+        default:
+            return false;
+        }
+        if (offset + size > length) {
+            return false;
+        }
+        value = data + offset;
+        offset += size;
+        return true;
+    }
+
+  private:
+    const uint8_t* data;
+    size_t length;
+    size_t offset;
+};
+
+// Integer argument as the conversion sees it: cut to the width of its length modifier, then sign-extended for
+// d and i, so a negative int prints the same through %x as it did through printf
+uint64_t integerValue(LogArg type, const uint8_t* value, const char* modifier, char conversion) {
+    uint64_t bits = 0;
+    if (type == LogArg::INT32) {
+        uint32_t narrow;
+        memcpy(&narrow, value, sizeof(narrow));
+        bits = narrow;
+    } else if (type == LogArg::INT64) {
+        memcpy(&bits, value, sizeof(bits));
+    }
+
+    unsigned width = 32;
+    if (strcmp(modifier, "hh") == 0) {
+        width = 8;
+    } else if (strcmp(modifier, "h") == 0) {
+        width = 16;
+    } else if (strcmp(modifier, "l") == 0) {
+        width = sizeof(long) * 8;
+    } else if (strcmp(modifier, "ll") == 0 || strcmp(modifier, "j") == 0) {
+        width = 64;
+    } else if (strcmp(modifier, "z") == 0 || strcmp(modifier, "t") == 0) {
+        width = sizeof(size_t) * 8;
+    }
+    if (width < 64) {
+        uint64_t mask = (1ULL << width) - 1;
+        bits &= mask;
+        if ((conversion == 'd' || conversion == 'i') && (bits >> (width - 1)) != 0) {
+            bits |= ~mask;
+        }
+    }
+    return bits;
+}
+
+// printf() for a deferred record: each conversion is formatted on its own with the stored argument, integers
+// widened to long long. An argument of the wrong type prints "?"; formatting stops at a missing argument or an
+// unsupported conversion ('*' width or precision, %n).
+size_t formatArgs(const char* format, ArgReader& args, char* out, size_t outSize) {
+    size_t pos = 0;
+    const char* p = format;
+    while (*p && pos + 1 < outSize) {
+        if (*p != '%') {
+            out[pos++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[pos++] = '%';
+            p += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion, rebuilt without the length modifier
+        const char* start = p++;
+        p += strspn(p, "-+ #0");
+        p += strspn(p, "0123456789");
+        if (*p == '.') {
+            p++;
+            p += strspn(p, "0123456789");
+        }
+        char spec[24];
+        size_t specLength = p - start;
+        size_t modifierLength = strspn(p, "hljztL");
+        char modifier[3]{};
+        char conversion = p[modifierLength];
+        if (specLength + 3 >= sizeof(spec) || modifierLength >= sizeof(modifier) || !conversion) {
+            break;
+        }
+        memcpy(spec, start, specLength);
+        memcpy(modifier, p, modifierLength);
+        p += modifierLength + 1;
+
+        LogArg type;
+        const uint8_t* value;
+        size_t size;
+        if (!args.next(type, value, size)) {
+            break;
+        }
+
+        size_t remaining = outSize - pos;
+        int length = -1;
+        switch (conversion) {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            if (type == LogArg::INT32 || type == LogArg::INT64) {
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                length = snprintf(out + pos, remaining, spec,
+                                  static_cast<unsigned long long>(integerValue(type, value, modifier, conversion)));
+            }
+            break;
+        case 'c':
+            if (type == LogArg::INT32) {
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                length = snprintf(out + pos, remaining, spec,
+                                  static_cast<int>(integerValue(type, value, modifier, conversion)));
+            }
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (type == LogArg::DOUBLE) {
+                double number;
+                memcpy(&number, value, sizeof(number));
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                length = snprintf(out + pos, remaining, spec, number);
+            }
+            break;
+        case 's':
+            if (type == LogArg::BYTES) {
+                formatLogHex(out + pos, remaining, value, size);
+                length = strlen(out + pos);
+            } else if (type == LogArg::STRING) {
+                char text[UINT8_MAX + 1];
+                memcpy(text, value, size);
+                text[size] = '\0';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                length = snprintf(out + pos, remaining, spec, text);
+            }
+            break;
+        case 'p':
+            if (type == LogArg::POINTER) {
+                void* pointer;
+                memcpy(&pointer, value, sizeof(pointer));
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                length = snprintf(out + pos, remaining, spec, pointer);
+            }
+            break;
+        default:
+            out[pos] = '\0';
+            return pos;
+        }
+        if (length < 0) {
+            out[pos++] = '?';
+        } else {
+            pos += std::min(static_cast<size_t>(length), remaining - 1);
+        }
+    }
+    out[pos] = '\0';
+    return pos;
+}
+} // namespace
+
+LogRecordWriter::LogRecordWriter(const char* tag, const char* format) {
+    memcpy(data, &tag, sizeof(tag));
+    memcpy(data + sizeof(tag), &format, sizeof(format));
+    length = sizeof(tag) + sizeof(format);
+}
+
+void LogRecordWriter::put(LogArg type, const void* value, size_t size) {
+    if (full || length + 1 + size > sizeof(data)) {
+        full = true;
+        return;
+    }
+    data[length++] = static_cast<uint8_t>(type);
+    memcpy(data + length, value, size);
+    length += size;
+}
+
+void LogRecordWriter::add(const char* value) {
+    if (!value) {
+        value = "(null)";
+    }
+    putBlob(LogArg::STRING, value, strlen(value));
+}
+
+void LogRecordWriter::add(const LogHex& hex) {
+    // Three characters per byte, more would not fit into the formatted line anyway
+    putBlob(LogArg::BYTES, hex.data, std::min<size_t>(hex.length, WEB_LOG_MAX_MESSAGE / 3));
+}
+
+void LogRecordWriter::putBlob(LogArg type, const void* value, size_t size) {
+    if (full || sizeof(data) - length < 2) {
+        full = true;
+        return;
+    }
+    size = std::min({size, sizeof(data) - length - 2, static_cast<size_t>(UINT8_MAX)});
+    data[length++] = static_cast<uint8_t>(type);
+    data[length++] = static_cast<uint8_t>(size);
+    memcpy(data + length, value, size);
+    length += size;
+}
+
+void formatLogHex(char* out, size_t size, const uint8_t* data, size_t length) {
+    size_t pos = 0;
+    out[0] = '\0';
+    for (size_t i = 0; i < length; i++) {
+        // This byte, the " ..." that has to fit unless it is the last one, and the terminator
+        size_t needed = (i > 0 ? 3 : 2) + (i + 1 < length ? 4 : 0) + 1;
+        if (pos + needed > size) {
+            strlcpy(out + pos, i > 0 ? " ..." : "...", size - pos);
+            return;
+        }
+        pos += snprintf(out + pos, size - pos, i > 0 ? " %02X" : "%02X", data[i]);
+    }
+}
+
 void WebLogger::logf(uint8_t level, const char* tag, const char* format, ...) {
-    WebLogEntry& entry = entries[head];
-    entry.id = ++nextId;
-    entry.t = millis();
-    entry.level = level;
-    int prefixLen = snprintf(entry.msg, sizeof(entry.msg), "[%s] ", tag);
+    char text[WEB_LOG_MAX_MESSAGE];
+    int prefixLen = snprintf(text, sizeof(text), "[%s] ", tag);
     if (prefixLen < 0) {
-        entry.msg[0] = '\0';
+        text[0] = '\0';
         prefixLen = 0;
     }
 
-    if (static_cast<size_t>(prefixLen) < sizeof(entry.msg)) {
+    if (static_cast<size_t>(prefixLen) < sizeof(text)) {
         va_list args;
         va_start(args, format);
-        vsnprintf(entry.msg + prefixLen, sizeof(entry.msg) - static_cast<size_t>(prefixLen), format, args);
+        vsnprintf(text + prefixLen, sizeof(text) - static_cast<size_t>(prefixLen), format, args);
         va_end(args);
     }
 
-    head = (head + 1) % kMaxEntries;
-    if (count < kMaxEntries) {
-        count++;
+    append(level, millis(), text, strlen(text));
+}
+
+void WebLogger::append(uint8_t level, uint32_t t, const void* data, uint16_t length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    size_t recordSize = kHeaderSize + length;
+    while (WEB_LOG_BUFFER_SIZE - used < recordSize) {
+        evictOldest();
+    }
+
+    uint32_t id = ++nextId;
+    size_t offset = (head + used) % WEB_LOG_BUFFER_SIZE;
+    write(offset, &id, sizeof(id));
+    write(offset + 4, &t, sizeof(t));
+    write(offset + 8, &level, sizeof(level));
+    write(offset + 9, &length, sizeof(length));
+    write(offset + kHeaderSize, data, length);
+    used += recordSize;
+    count++;
+}
+
+size_t WebLogger::formatPayload(uint8_t level, const uint8_t* data, uint16_t length, char* out, size_t outSize) {
+    if (!(level & kDeferred)) {
+        size_t textLength = std::min<size_t>(length, outSize - 1);
+        memcpy(out, data, textLength);
+        out[textLength] = '\0';
+        return textLength;
+    }
+
+    const char* tag;
+    const char* format;
+    memcpy(&tag, data, sizeof(tag));
+    memcpy(&format, data + sizeof(tag), sizeof(format));
+    int prefixLen = snprintf(out, outSize, "[%s] ", tag);
+    if (prefixLen < 0 || static_cast<size_t>(prefixLen) >= outSize) {
+        return strlen(out);
     }
+    ArgReader args(data, length, sizeof(tag) + sizeof(format));
+    return prefixLen + formatArgs(format, args, out + prefixLen, outSize - prefixLen);
 }
 
 String WebLogger::getLogsJSON(uint32_t sinceId) {
+    std::lock_guard<std::mutex> lock(mutex);
     String json = "[";
     bool first = true;
 
-    if (count == 0) {
-        json += "]";
-        return json;
-    }
-
-    size_t start = (head + kMaxEntries - count) % kMaxEntries;
+    uint8_t data[WEB_LOG_MAX_MESSAGE];
+    char text[WEB_LOG_MAX_MESSAGE];
+    size_t offset = head;
     for (size_t i = 0; i < count; i++) {
-        const WebLogEntry& entry = entries[(start + i) % kMaxEntries];
-        if (entry.id <= sinceId) {
+        uint32_t id;
+        uint32_t t;
+        uint8_t level;
+        uint16_t length;
+        read(offset, &id, sizeof(id));
+        read(offset + 4, &t, sizeof(t));
+        read(offset + 8, &level, sizeof(level));
+        read(offset + 9, &length, sizeof(length));
+        size_t textOffset = offset + kHeaderSize;
+        offset = (textOffset + length) % WEB_LOG_BUFFER_SIZE;
+        if (id <= sinceId) {
             continue;
         }
 
@@ -49,13 +344,14 @@ String WebLogger::getLogsJSON(uint32_t sinceId) {
         first = false;
 
         json += "{\"i\":";
-        json += entry.id;
+        json += id;
         json += ",\"t\":";
-        json += entry.t;
+        json += t;
         json += ",\"l\":";
-        json += entry.level;
+        json += static_cast<uint8_t>(level & ~kDeferred);
         json += ",\"m\":\"";
-        appendEscaped(json, entry.msg);
+        read(textOffset, data, length);
+        appendEscaped(json, text, formatPayload(level, data, length, text, sizeof(text)));
         json += "\"}";
     }
 
@@ -64,14 +360,40 @@ String WebLogger::getLogsJSON(uint32_t sinceId) {
 }
 
 void WebLogger::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
     head = 0;
+    used = 0;
     count = 0;
     nextId = 0;
 }
 
-void WebLogger::appendEscaped(String& out, const char* text) {
-    for (const char* p = text; *p; ++p) {
-        char c = *p;
+// Copy into the ring at offset (taken modulo the buffer size), wrapping around the end
+void WebLogger::write(size_t offset, const void* data, size_t length) {
+    offset %= WEB_LOG_BUFFER_SIZE;
+    size_t first = std::min(length, WEB_LOG_BUFFER_SIZE - offset);
+    memcpy(buffer + offset, data, first);
+    memcpy(buffer, static_cast<const uint8_t*>(data) + first, length - first);
+}
+
+void WebLogger::read(size_t offset, void* data, size_t length) const {
+    offset %= WEB_LOG_BUFFER_SIZE;
+    size_t first = std::min(length, WEB_LOG_BUFFER_SIZE - offset);
+    memcpy(data, buffer + offset, first);
+    memcpy(static_cast<uint8_t*>(data) + first, buffer, length - first);
+}
+
+void WebLogger::evictOldest() {
+    uint16_t length;
+    read(head + 9, &length, sizeof(length));
+    size_t recordSize = kHeaderSize + length;
+    head = (head + recordSize) % WEB_LOG_BUFFER_SIZE;
+    used -= recordSize;
+    count--;
+}
+
+void WebLogger::appendEscaped(String& out, const char* text, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        char c = text[i];
         switch (c) {
         case '\\':
             out += "\\\\";
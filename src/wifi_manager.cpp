@@ -1,5 +1,6 @@
 #include "wifi_manager.h"
 #include "config_manager.h"
+#include "span_tracer.h"
 #include <ESPmDNS.h>
 
 WiFiManager wifiManager;
@@ -29,7 +30,7 @@ bool WiFiManager::connect() {
     }
 
     unsigned long now = millis();
-    if (now - lastConnectAttempt < 5000) {
+    if (lastConnectAttempt != 0 && now - lastConnectAttempt < 5000) {
         return false; // Too soon to retry
     }
 
@@ -39,26 +40,13 @@ bool WiFiManager::connect() {
         WiFi.setHostname(config.hostname);
     }
 
+    TRACE_SPAN(WIFI_CONNECT);
     LOG_INFO("WiFi", "Connecting to %s", config.wifiSSID);
     WiFi.begin(config.wifiSSID, config.wifiPassword);
 
-    unsigned long start = millis();
-    while (WiFi.status() != WL_CONNECTED && millis() - start < WIFI_CONNECTION_TIMEOUT) {
-        delay(500);
-        LOG_DEBUG("WiFi", ".");
-    }
-
-    if (WiFi.status() == WL_CONNECTED) {
-        isConnected = true;
-        apModeActive = false;
-        printWiFiStatus();
-        startMdns();
-        return true;
-    }
-
-    isConnected = false;
-    LOG_ERROR("WiFi", "Connection failed");
-    startAccessPoint();
+    // handleWiFi() waits for the association, AP mode after WIFI_CONNECTION_TIMEOUT
+    associating = true;
+    associateStart = now;
     return false;
 }
 
@@ -77,19 +65,69 @@ void WiFiManager::reconnect() {
 }
 
 void WiFiManager::handleWiFi() {
+    TRACE_SPAN(WIFI);
     if (apModeActive) {
         return;
     }
 
     if (!isWiFiConnected()) {
         isConnected = false;
+        if (associating) {
+            if (millis() - associateStart < WIFI_CONNECTION_TIMEOUT) {
+                return;
+            }
+            associating = false;
+            LOG_ERROR("WiFi", "Connection failed");
+            startAccessPoint();
+            return;
+        }
         reconnect();
     } else {
+        if (associating) {
+            associating = false;
+            printWiFiStatus();
+        }
         isConnected = true;
         startMdns();
+        startNtp();
     }
 }
 
+void WiFiManager::applyConfig(bool credentialsChanged) {
+    const Config& config = configManager.getConfig();
+    if (strlen(config.hostname) > 0) {
+        WiFi.setHostname(config.hostname); // DHCP uses it from the next association
+    }
+    if (mdnsStarted) {
+        MDNS.end();
+        mdnsStarted = false; // Restarted by handleWiFi() under the new hostname
+    }
+    if (!credentialsChanged) {
+        return;
+    }
+
+    if (strlen(config.wifiSSID) == 0 || strcmp(config.wifiSSID, WIFI_SSID_DEFAULT) == 0) {
+        LOG_INFO("WiFi", "WiFi SSID not configured - starting AP for configuration");
+        WiFi.disconnect();
+        isConnected = false;
+        startAccessPoint();
+        return;
+    }
+    if (apModeActive) {
+        WiFi.softAPdisconnect(true);
+        WiFi.mode(WIFI_STA);
+        apModeActive = false;
+        LOG_INFO("WiFi", "AP stopped");
+    }
+
+    LOG_INFO("WiFi", "Settings changed, connecting to %s", config.wifiSSID);
+    WiFi.disconnect();
+    WiFi.begin(config.wifiSSID, config.wifiPassword);
+    isConnected = false;
+    associating = true;
+    associateStart = millis();
+}
+
 bool WiFiManager::isApModeActive() {
     return apModeActive;
 }
@@ -98,6 +136,15 @@ int WiFiManager::getRSSI() {
     return WiFi.RSSI();
 }
 
+void WiFiManager::setMaxPowerSave(bool enabled) {
+    if (enabled == maxPowerSave) {
+        return;
+    }
+    maxPowerSave = enabled;
+    WiFi.setSleep(enabled ? WIFI_PS_MAX_MODEM : WIFI_PS_MIN_MODEM);
+    LOG_DEBUG("WiFi", "Modem sleep: %s", enabled ? "max" : "min");
+}
+
 void WiFiManager::printWiFiStatus() {
     LOG_INFO("WiFi", "Connected!");
     LOG_INFO("WiFi", "IP: %s", WiFi.localIP().toString().c_str());
@@ -126,6 +173,16 @@ void WiFiManager::startAccessPoint() {
     }
 }
 
+void WiFiManager::startNtp() {
+    if (ntpStarted) {
+        return;
+    }
+    // SNTP keeps resyncing in the background, time(nullptr) is valid after the first answer
+    configTime(0, 0, NTP_SERVER);
+    ntpStarted = true;
+    LOG_INFO("WiFi", "NTP sync started: %s", NTP_SERVER);
+}
+
 void WiFiManager::startMdns() {
     if (mdnsStarted) {
         return;
@@ -1,4 +1,5 @@
 #include "wm_bus_handler.h"
+#include "span_tracer.h"
 
 WmBusHandler wmBusHandler;
 
@@ -139,7 +140,7 @@ bool WmBusHandler::verifyCRC16(const uint8_t* data, uint8_t length, uint16_t exp
     uint16_t calculatedCRC = calculateCRC16(data, length);
 
     if (calculatedCRC != expectedCRC) {
-        LOG_ERROR("wM-Bus", "CRC mismatch: calculated=0x%04X, expected=0x%04X", calculatedCRC, expectedCRC);
+        LOG_DEBUG("wM-Bus", "CRC mismatch: calculated=0x%04X, expected=0x%04X", calculatedCRC, expectedCRC);
         return false;
     }
 
@@ -148,9 +149,9 @@ bool WmBusHandler::verifyCRC16(const uint8_t* data, uint8_t length, uint16_t exp
 
 // Parse wM-Bus header
 bool WmBusHandler::parseDataLinkLayerHeader(const uint8_t* data, uint8_t length, WmBusDataLinkLayerHeader* header) {
-    if (!data || !header || length < WM_BUS_HEADER_SIZE) {
-        LOG_ERROR("wM-Bus", "Invalid Data Link Layer header length: %d (expected at least %d)", length,
-                  WM_BUS_HEADER_SIZE);
+    if (!data || !header || length < WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE) {
+        LOG_DEBUG("wM-Bus", "Invalid Data Link Layer header length: %d (expected at least %d)", length,
+                  WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE);
         return false;
     }
 
@@ -201,142 +202,156 @@ bool WmBusHandler::parseDataLinkLayerHeader(const uint8_t* data, uint8_t length,
     LOG_DEBUG("wM-Bus", "Data Link Layer header parsed successfully:");
     LOG_DEBUG("wM-Bus", "  L-field: 0x%02X (%d bytes)", header->lField, header->lField);
     LOG_DEBUG("wM-Bus", "  C-field: 0x%02X", header->cField);
-    LOG_DEBUG("wM-Bus", "  M-field: 0x%04X (%s)", header->manufacturer, mfgString);
+    LOG_DEBUG("wM-Bus", "  M-field: 0x%04X (%s)", mField, header->manufacturer);
     LOG_DEBUG("wM-Bus", "  Meter ID: %s", header->meterId);
     LOG_DEBUG("wM-Bus", "  DLL CRC: 0x%04X (valid)", header->crcHeader);
 
     return true;
 }
 
-// Process raw FSK modem packet (3-out-of-6 encoded)
-bool WmBusHandler::processRawPacket(const uint8_t* rawData, uint8_t rawLength, int16_t rssi) {
-    if (!rawData || rawLength == 0) {
-        LOG_ERROR("wM-Bus", "Invalid raw packet");
-        return false;
-    }
-
-    if (rawLength > WM_BUS_MAX_PAYLOAD) {
-        LOG_ERROR("wM-Bus", "Packet too large: %d bytes (max %d)", rawLength, WM_BUS_MAX_PAYLOAD);
-        return false;
+// Human-readable name of a decode status, used in logs and diagnostics
+const char* WmBusHandler::statusName(WmBusDecodeStatus status) {
+    switch (status) {
+    case WmBusDecodeStatus::OK:
+        return "ok";
+    case WmBusDecodeStatus::INVALID_LENGTH:
+        return "invalid length";
+    case WmBusDecodeStatus::L_FIELD_DECODE_FAILED:
+        return "L-field 3-out-of-6 decoding failed";
+    case WmBusDecodeStatus::INSUFFICIENT_DATA:
+        return "insufficient raw data for L-field";
+    case WmBusDecodeStatus::DECODE_3OF6_FAILED:
+        return "3-out-of-6 decoding failed";
+    case WmBusDecodeStatus::TOO_SHORT:
+        return "packet too short";
+    case WmBusDecodeStatus::DLL_CRC_FAILED:
+        return "Data Link Layer CRC verification failed";
+    case WmBusDecodeStatus::TPL_CRC_FAILED:
+        return "Transport Layer CRC verification failed";
     }
+    return "unknown";
+}
 
-    LOG_DEBUG("wM-Bus", "Processing raw packet (%d bytes)", rawLength);
-    LOG_DEBUG("wM-Bus", "Raw: ");
-    for (uint8_t i = 0; i < rawLength && i < 32; i++) {
-        LOG_DEBUG("wM-Bus", "%02X ", rawData[i]);
+// Decode a raw FSK modem packet (3-out-of-6 encoded) into a CRC-verified frame.
+// Stateless and free of error logging so it can run on any thread; processRawPacket() reports failures.
+WmBusDecodeStatus WmBusHandler::decodeFrame(const uint8_t* rawData, uint8_t rawLength, WmBusFrame* frame) {
+    if (!rawData || !frame || rawLength == 0 || rawLength > WM_BUS_MAX_PAYLOAD) {
+        return WmBusDecodeStatus::INVALID_LENGTH;
     }
-    if (rawLength > 32)
-        LOG_DEBUG("wM-Bus", "...");
-    LOG_DEBUG("wM-Bus", "");
 
     // First, decode just the L-field (first byte) to determine actual packet length
     // L-field is 1 byte (8 bits = 2 nibbles), which requires 12 bits (2 × 6 bits) encoded
     // So we need at least 2 bytes of raw data to decode the L-field
     if (rawLength < 2) {
-        LOG_ERROR("wM-Bus", "Raw packet too short to contain L-field");
-        return false;
+        return WmBusDecodeStatus::INVALID_LENGTH;
     }
 
     uint8_t lFieldDecoded[1];
     uint8_t lFieldDecodedLen = 0;
-
-    if (!decode3outof6(rawData, 2, lFieldDecoded, &lFieldDecodedLen)) {
-        LOG_ERROR("wM-Bus", "Failed to decode L-field");
-        return false;
-    }
-
-    if (lFieldDecodedLen < 1) {
-        LOG_ERROR("wM-Bus", "L-field decoding produced no data");
+    if (!decode3outof6(rawData, 2, lFieldDecoded, &lFieldDecodedLen) || lFieldDecodedLen < 1) {
+        return WmBusDecodeStatus::L_FIELD_DECODE_FAILED;
     }
 
     uint8_t lField = lFieldDecoded[0];
-    uint8_t expectedDecodedLen =
+    uint16_t expectedDecodedLen =
         lField + 1 + 2 * WM_BUS_HEADER_CRC_SIZE; // L-field = total length - 1 + DLL CRC + TPL CRC
 
-    LOG_DEBUG("wM-Bus", "L-field: 0x%02X (expected decoded length: %d bytes)", lField, expectedDecodedLen);
-
     // Calculate required encoded bytes for the full packet
     // 3-out-of-6 encoding: 1 decoded byte → 1.5 encoded bytes
     // encoded_bytes = decoded_bytes * 3 / 2
     uint16_t requiredEncodedBytes = (expectedDecodedLen * 3 + 1) / 2; // Round up
 
-    LOG_DEBUG("wM-Bus", "Required encoded bytes: %d, available: %d", requiredEncodedBytes, rawLength);
+    LOG_DEBUG("wM-Bus", "L-field: 0x%02X (expected decoded length: %d bytes, encoded: %d of %d bytes)", lField,
+              expectedDecodedLen, requiredEncodedBytes, rawLength);
 
     if (requiredEncodedBytes > rawLength) {
-        LOG_ERROR("wM-Bus", "Insufficient raw data: need %d bytes, have %d", requiredEncodedBytes, rawLength);
-        return false;
+        return WmBusDecodeStatus::INSUFFICIENT_DATA;
     }
 
     // Now decode the full packet using only the required bytes
-    uint8_t decoded[WM_BUS_MAX_PAYLOAD];
     uint8_t decodedLen = 0;
-
-    if (!decode3outof6(rawData, requiredEncodedBytes, decoded, &decodedLen)) {
-        LOG_DEBUG("wM-Bus", "3-out-of-6 decoding failed");
-        return false;
+    if (!decode3outof6(rawData, requiredEncodedBytes, frame->data, &decodedLen)) {
+        return WmBusDecodeStatus::DECODE_3OF6_FAILED;
     }
 
-    LOG_DEBUG("wM-Bus", "Decoded %d bytes (expected %d)", decodedLen, expectedDecodedLen);
-
-    // Verify decoded length matches expected
-    if (decodedLen < expectedDecodedLen) {
-        LOG_WARN("wM-Bus", "Decoded fewer bytes than expected (%d < %d)", decodedLen, expectedDecodedLen);
-    } else if (decodedLen > expectedDecodedLen) {
-        LOG_WARN("wM-Bus", "Decoded more bytes than expected (%d > %d), truncating", decodedLen, expectedDecodedLen);
-        decodedLen = expectedDecodedLen; // Use only expected length
+    // Odd decoded lengths carry a padding nibble, use only the expected length
+    if (decodedLen > expectedDecodedLen) {
+        decodedLen = expectedDecodedLen;
     }
-    LOG_DEBUG("wM-Bus", "Decoded: ");
-    for (uint8_t i = 0; i < decodedLen && i < 32; i++) {
-        LOG_DEBUG("wM-Bus", "%02X ", decoded[i]);
-    }
-    if (decodedLen > 32)
-        LOG_DEBUG("wM-Bus", "...");
-    LOG_DEBUG("wM-Bus", "");
+    frame->length = decodedLen;
 
     // Check minimum length for header
     if (decodedLen < WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE) {
-        LOG_ERROR("wM-Bus", "Packet too short: %d bytes (need at least %d)", decodedLen,
-                  WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE);
-        return false;
+        return WmBusDecodeStatus::TOO_SHORT;
     }
 
-    // Parse header
-    WmBusDataLinkLayerHeader header;
-    if (!parseDataLinkLayerHeader(decoded, decodedLen, &header)) {
-        LOG_ERROR("wM-Bus", "Data Link Layer header parsing failed");
-        return false;
+    // Parse header (verifies Data Link Layer CRC)
+    if (!parseDataLinkLayerHeader(frame->data, decodedLen, &frame->header)) {
+        return WmBusDecodeStatus::DLL_CRC_FAILED;
     }
 
-    // Extract Transport Layer data (after DLL header + DLL CRC, before TPL CRC)
+    // Transport Layer data follows DLL header + DLL CRC and ends with the TPL CRC
     uint8_t tplTotalLen = decodedLen - (WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE);
-    uint8_t* tplData = decoded + WM_BUS_HEADER_SIZE + WM_BUS_HEADER_CRC_SIZE;
-
-    // Check for TPL CRC (last 2 bytes of TPL data)
     if (tplTotalLen < WM_BUS_HEADER_CRC_SIZE) {
-        LOG_ERROR("wM-Bus", "No Transport Layer data");
-        return false;
+        return WmBusDecodeStatus::TOO_SHORT;
     }
 
+    uint8_t* tplData = frame->tplData();
     uint8_t tplDataLen = tplTotalLen - WM_BUS_HEADER_CRC_SIZE;
     uint16_t tplCrc = (tplData[tplDataLen] << 8) | tplData[tplDataLen + 1];
 
     // Verify Transport Layer CRC
     if (!verifyCRC16(tplData, tplDataLen, tplCrc)) {
-        LOG_ERROR("wM-Bus", "Transport Layer CRC verification failed");
-        return false;
+        return WmBusDecodeStatus::TPL_CRC_FAILED;
     }
 
-    LOG_DEBUG("wM-Bus", "Transport Layer CRC: 0x%04X (valid)", tplCrc);
+    frame->tplDataLen = tplDataLen;
+    LOG_DEBUG("wM-Bus", "Transport Layer data (%d bytes), CRC: 0x%04X (valid)", tplDataLen, tplCrc);
+
+    return WmBusDecodeStatus::OK;
+}
+
+// Process raw FSK modem packet (3-out-of-6 encoded)
+bool WmBusHandler::processRawPacket(const uint8_t* rawData, uint8_t rawLength, int16_t rssi) {
+    if (rawData) {
+        LOG_DEBUG_HEX("wM-Bus", "Processing raw packet", rawData, rawLength);
+    }
 
-    if (tplDataLen > 0) {
-        LOG_DEBUG("wM-Bus", "Transport Layer data (%d bytes)", tplDataLen);
-    } else {
-        LOG_DEBUG("wM-Bus", "No Transport Layer data");
+    WmBusFrame frame;
+    WmBusDecodeStatus status;
+    {
+        TRACE_SPAN(DECODE);
+        status = decodeFrame(rawData, rawLength, &frame);
+    }
+    statusCounts[static_cast<size_t>(status)]++;
+    if (status == WmBusDecodeStatus::TPL_CRC_FAILED && uncheckedCallback != nullptr) {
+        // Re-decode at the format A length: 10-byte first block, then 16-byte blocks, each with its own CRC
+        uint8_t lField = frame.data[0];
+        uint16_t blocks = 1 + (lField > 9 ? (lField - 9 + 15) / 16 : 0);
+        uint16_t formatALength = lField + 1 + WM_BUS_HEADER_CRC_SIZE * blocks;
+        uint16_t encodedLength = (formatALength * 3 + 1) / 2;
+        uint8_t decodedLength = 0;
+        if (formatALength < WM_BUS_MAX_PAYLOAD && encodedLength <= rawLength &&
+            decode3outof6(rawData, encodedLength, frame.data, &decodedLength) && decodedLength >= formatALength) {
+            uncheckedCallback(frame.data, formatALength, rssi);
+        }
+    }
+    if (status == WmBusDecodeStatus::INVALID_LENGTH) {
+        // The modem never hands over an empty or oversized packet
+        LOG_ERROR("wM-Bus", "Invalid raw packet (%d bytes): %s", rawLength, statusName(status));
+        return false;
     }
+    if (status != WmBusDecodeStatus::OK) {
+        // RF noise and other meters' telegrams, already counted in statusCounts
+        LOG_DEBUG("wM-Bus", "Invalid raw packet (%d bytes): %s", rawLength, statusName(status));
+        return false;
+    }
+
+    LOG_DEBUG_HEX("wM-Bus", "Decoded", frame.data, frame.length);
 
     // Call user callback if registered (pass full decoded frame and TPL data without CRC)
     if (packetCallback != nullptr) {
-        packetCallback(header.meterId, decoded, decodedLen, tplData, tplDataLen, rssi);
+        packetCallback(frame.header.meterId, frame.data, frame.length, frame.tplData(), frame.tplDataLen, rssi);
     }
 
     return true;
@@ -346,3 +361,7 @@ bool WmBusHandler::processRawPacket(const uint8_t* rawData, uint8_t rawLength, i
 void WmBusHandler::setPacketCallback(WmBusPacketCallback callback) {
     packetCallback = callback;
 }
+
+void WmBusHandler::setUncheckedCallback(WmBusUncheckedCallback callback) {
+    uncheckedCallback = callback;
+}
@@ -0,0 +1,23 @@
+#ifndef CONFIG_MANAGER_H
+#define CONFIG_MANAGER_H
+
+// Host stand-in for the NVS-backed configuration: only the settings the modules under test read
+
+#include <Arduino.h>
+#include "config.h"
+
+struct Config {
+    uint8_t rawForwardMode; // RawForwardMode: 0 = off, 1 = hex, 2 = binary
+};
+
+class ConfigManager {
+  public:
+    Config& getConfig() { return config; }
+
+  private:
+    Config config{};
+};
+
+extern ConfigManager configManager;
+
+#endif // CONFIG_MANAGER_H
@@ -0,0 +1,17 @@
+#ifndef FSK_MODEM_MANAGER_H
+#define FSK_MODEM_MANAGER_H
+
+// Host stand-in for the SX1262 modem: only the packet counter the diagnostics report
+
+#include <Arduino.h>
+
+class FskModemManager {
+  public:
+    uint32_t getPacketCount() const { return packetCount; }
+
+    uint32_t packetCount = 0;
+};
+
+extern FskModemManager fskModemManager;
+
+#endif // FSK_MODEM_MANAGER_H
@@ -0,0 +1,38 @@
+#ifndef MQTT_MANAGER_H
+#define MQTT_MANAGER_H
+
+// Host stand-in for the PubSubClient wrapper: records what would be published
+
+#include <Arduino.h>
+#include <string>
+#include "config.h"
+
+class MqttManager {
+  public:
+    bool isConnected() { return connected; }
+    bool publish(const char* topic, const char* payload, bool retain = false) {
+        (void)retain;
+        lastTopic = topic;
+        lastPayload = payload;
+        publishCount++;
+        return true;
+    }
+    bool publish(const char* topic, const uint8_t* payload, size_t length, bool retain = false) {
+        (void)retain;
+        lastTopic = topic;
+        lastPayload.assign(reinterpret_cast<const char*>(payload), length);
+        publishCount++;
+        return true;
+    }
+    const char* getTopicDiagnostics() const { return "izar/diagnostics"; }
+    const char* getTopicRaw() const { return "izar/raw"; }
+
+    bool connected = false;
+    std::string lastTopic;
+    std::string lastPayload;
+    uint32_t publishCount = 0;
+};
+
+extern MqttManager mqttManager;
+
+#endif // MQTT_MANAGER_H
@@ -0,0 +1,104 @@
+// Button debounce and gesture state machine, fed edge timestamps the way the expander interrupt delivers them
+
+#include <vector>
+#include "button_engine.h"
+#include "test_support.h"
+
+namespace {
+
+struct Edge {
+    uint32_t atMs;
+    bool pressed;
+};
+
+// Simulated expander: delivers each edge at its time and polls every 10 ms like loop(), until untilMs
+std::vector<ButtonEvent> run(const std::vector<Edge>& edges, uint32_t untilMs) {
+    ButtonEngine engine;
+    std::vector<ButtonEvent> events;
+    size_t next = 0;
+    for (uint32_t now = 0; now <= untilMs; now += 10) {
+        while (next < edges.size() && edges[next].atMs <= now) {
+            engine.onLevel(edges[next].pressed, edges[next].atMs);
+            next++;
+        }
+        engine.poll(now);
+        for (ButtonEvent event = engine.pop(); event != ButtonEvent::BUTTON_EVENT_NONE; event = engine.pop()) {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+
+const ButtonEvent SHORT = ButtonEvent::BUTTON_EVENT_SHORT_PRESS;
+const ButtonEvent LONG = ButtonEvent::BUTTON_EVENT_LONG_PRESS;
+const ButtonEvent DOUBLE = ButtonEvent::BUTTON_EVENT_DOUBLE_PRESS;
+
+} // namespace
+
+TEST_CASE(shortPressAfterDoublePressGap) {
+    CHECK(run({{0, true}, {100, false}}, 390).empty()); // A second press could still follow
+    CHECK(run({{0, true}, {100, false}}, 400) == std::vector<ButtonEvent>{SHORT});
+}
+
+TEST_CASE(pulseShorterThanDebounceIsIgnored) {
+    CHECK(run({{0, true}, {ButtonEngine::DEBOUNCE_MS - 1, false}}, 3000).empty());
+}
+
+TEST_CASE(bouncingPressGivesOneShortPress) {
+    // Contact bounce on both edges, every pulse and gap shorter than the debounce time
+    std::vector<Edge> edges = {{0, true}, {5, false}, {8, true}, {150, false}, {160, true}, {165, false}};
+    CHECK(run(edges, 1000) == std::vector<ButtonEvent>{SHORT});
+}
+
+TEST_CASE(longPressReportedWhileHeld) {
+    CHECK(run({{0, true}}, ButtonEngine::LONG_PRESS_MS - 10).empty());
+    CHECK(run({{0, true}}, ButtonEngine::LONG_PRESS_MS) == std::vector<ButtonEvent>{LONG});
+    // Nothing more when it is finally released
+    CHECK(run({{0, true}, {3000, false}}, 4000) == std::vector<ButtonEvent>{LONG});
+}
+
+TEST_CASE(longPressReleasedBeforePoll) {
+    ButtonEngine engine;
+    engine.onLevel(true, 0);
+    engine.onLevel(false, 2500);
+    CHECK(engine.pop() == LONG);
+    CHECK(engine.pop() == ButtonEvent::BUTTON_EVENT_NONE);
+}
+
+TEST_CASE(doublePressWithinGap) {
+    std::vector<Edge> edges = {{0, true}, {100, false}, {100 + ButtonEngine::DOUBLE_PRESS_GAP_MS - 20, true},
+                               {500, false}};
+    CHECK(run(edges, 1500) == std::vector<ButtonEvent>{DOUBLE});
+}
+
+TEST_CASE(heldSecondPressReportsDoubleOnce) {
+    std::vector<Edge> edges = {{0, true}, {100, false}, {200, true}, {3000, false}};
+    CHECK(run(edges, 4000) == std::vector<ButtonEvent>{DOUBLE});
+}
+
+TEST_CASE(secondPressAfterGapIsAnotherShortPress) {
+    std::vector<Edge> edges = {{0, true}, {100, false}, {100 + ButtonEngine::DOUBLE_PRESS_GAP_MS + 50, true},
+                               {550, false}};
+    CHECK(run(edges, 1500) == (std::vector<ButtonEvent>{SHORT, SHORT}));
+}
+
+TEST_CASE(bounceOnSecondPressKeepsWaiting) {
+    // A glitch shorter than the debounce inside the gap is not a second press
+    std::vector<Edge> edges = {{0, true}, {100, false}, {200, true}, {210, false}};
+    CHECK(run(edges, 1000) == std::vector<ButtonEvent>{SHORT});
+}
+
+TEST_CASE(queueDropsEventsWhenFull) {
+    ButtonEngine engine;
+    for (uint32_t i = 0; i < 6; i++) {
+        engine.onLevel(true, i * 3000);
+        engine.onLevel(false, i * 3000 + 2500); // Long press each time
+    }
+    int count = 0;
+    while (engine.pop() != ButtonEvent::BUTTON_EVENT_NONE) {
+        count++;
+    }
+    CHECK(count == 4);
+}
+
+TEST_MAIN()
@@ -0,0 +1,398 @@
+// Reading history on a temporary directory standing in for LittleFS: token encoding, weekly segments, budget
+// eviction, torn writes and the /api/history bucket stream
+
+#include <dirent.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "history_store.h"
+#include "test_support.h"
+
+namespace {
+
+constexpr uint32_t kWeek = HISTORY_SEGMENT_SECONDS;
+constexpr uint32_t kSegment = 2910;              // Week of 2025-10-09
+constexpr uint32_t kBoundary = (kSegment + 1) * kWeek;
+constexpr uint32_t kStart = kSegment * kWeek + 1000;
+
+// Fresh directory per case, removed with its files at the end
+struct TempDir {
+    char path[32];
+    TempDir() {
+        strcpy(path, "/tmp/izar-history-XXXXXX");
+        CHECK(mkdtemp(path) != nullptr);
+    }
+    ~TempDir() {
+        DIR* handle = opendir(path);
+        while (struct dirent* entry = handle ? readdir(handle) : nullptr) {
+            std::string file = std::string(path) + "/" + entry->d_name;
+            if (entry->d_name[0] != '.') {
+                unlink(file.c_str());
+            }
+        }
+        if (handle) {
+            closedir(handle);
+        }
+        rmdir(path);
+    }
+};
+
+IzarReading reading(const char* meterId, uint32_t liters, bool leakage = false) {
+    IzarReading result = {};
+    snprintf(result.meterId, sizeof(result.meterId), "%s", meterId);
+    result.current_reading = liters / 1000.0f;
+    result.alarms.leakage_currently = leakage;
+    return result;
+}
+
+std::vector<uint8_t> fileBytes(const char* dir, const char* meterId, uint32_t segment) {
+    char path[96];
+    HistoryStore::segmentPath(path, sizeof(path), dir, meterId, segment);
+    std::vector<uint8_t> bytes;
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return bytes;
+    }
+    for (int c = fgetc(file); c != EOF; c = fgetc(file)) {
+        bytes.push_back(static_cast<uint8_t>(c));
+    }
+    fclose(file);
+    return bytes;
+}
+
+void appendRaw(const char* dir, const char* meterId, uint32_t segment, const std::vector<uint8_t>& bytes) {
+    char path[96];
+    HistoryStore::segmentPath(path, sizeof(path), dir, meterId, segment);
+    FILE* file = fopen(path, "ab");
+    CHECK(file != nullptr);
+    fwrite(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+}
+
+// The chunked response body, pulled chunk bytes at a time like the web server does
+std::string query(HistoryStore& store, const char* meterId, uint32_t from, uint32_t to, uint32_t step,
+                  size_t chunk = 512) {
+    HistoryWriter writer(store, meterId, from, to, step);
+    std::string json;
+    std::vector<uint8_t> buffer(chunk);
+    for (size_t length = writer.read(buffer.data(), chunk); length > 0; length = writer.read(buffer.data(), chunk)) {
+        json.append(reinterpret_cast<const char*>(buffer.data()), length);
+    }
+    return json;
+}
+
+std::string header(const char* meterId, uint32_t from, uint32_t to, uint32_t step) {
+    return "{\"meter\":\"" + std::string(meterId) + "\",\"from\":" + std::to_string(from) +
+           ",\"to\":" + std::to_string(to) + ",\"step\":" + std::to_string(step) + ",\"buckets\":[";
+}
+
+size_t bucketCount(const std::string& json) {
+    size_t count = 0;
+    for (size_t at = json.find("\"t\":"); at != std::string::npos; at = json.find("\"t\":", at + 1)) {
+        count++;
+    }
+    return count;
+}
+
+} // namespace
+
+TEST_CASE(tokenRoundTrip) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    CHECK(store.append(reading("21-12345678", 100000), kStart));             // Keyframe
+    CHECK(store.append(reading("21-12345678", 100003), kStart + 32));        // FULL: first interval, dod 32
+    CHECK(store.append(reading("21-12345678", 100008), kStart + 64));        // Compact: dod 0, 5 L
+    CHECK(store.append(reading("21-12345678", 100008, true), kStart + 97));  // FULL with the new alarms
+    CHECK(store.append(reading("21-12345678", 100010, true), kStart + 130)); // Compact: dod 0, 2 L
+    CHECK(store.append(reading("21-12345678", 100011, true), kStart + 130)); // Same second, not stored
+    store.flush();
+
+    const std::vector<uint8_t> expected = {
+        0xE0, 0xE8, 0xFD, 0x9B, 0xC7, 0x06, 0xA0, 0x8D, 0x06, 0x00, // Keyframe: time, liters, alarms
+        0xC0, 0x40, 0x06,                                           // dod +32, +3 L
+        0x45,                                                       // dod 0, +5 L
+        0xC1, 0x02, 0x00, 0x02,                                     // dod +1, +0 L, alarms 0x002
+        0x42};                                                      // dod 0, +2 L
+    CHECK(fileBytes(dir.path, "21-12345678", kSegment) == expected);
+    CHECK(store.getUsedBytes() == expected.size());
+
+    std::string json = query(store, "21-12345678", kStart, kStart + 3600, 3600);
+    CHECK(json == header("21-12345678", kStart, kStart + 3600, 3600) +
+                      "{\"t\":" + std::to_string(kStart) +
+                      ",\"count\":5,\"min\":100.000,\"max\":100.010,\"last\":100.010,\"consumption\":0.010,"
+                      "\"alarms\":2}]}\n");
+}
+
+TEST_CASE(rebootStartsWithKeyframe) {
+    TempDir dir;
+    {
+        HistoryStore store;
+        CHECK(store.begin(dir.path, 65536));
+        CHECK(store.append(reading("21-12345678", 5000), kStart));
+        CHECK(store.append(reading("21-12345678", 5001), kStart + 32));
+        store.flush();
+    }
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    size_t before = store.getUsedBytes();
+    CHECK(before == fileBytes(dir.path, "21-12345678", kSegment).size());
+    CHECK(store.append(reading("21-12345678", 5002), kStart + 64));
+    store.flush();
+    std::vector<uint8_t> bytes = fileBytes(dir.path, "21-12345678", kSegment);
+    CHECK(bytes.size() > before && bytes[before] == 0xE0);
+
+    std::string json = query(store, "21-12345678", kStart, kStart + 3600, 3600);
+    CHECK(json.find("\"count\":3,\"min\":5.000,\"max\":5.002,\"last\":5.002,\"consumption\":0.002") !=
+          std::string::npos);
+}
+
+TEST_CASE(weeklySegmentRollover) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    // One flush across the boundary: each week gets its own file, each starting with a keyframe
+    CHECK(store.append(reading("21-12345678", 200000), kBoundary - 64));
+    CHECK(store.append(reading("21-12345678", 200002), kBoundary - 32));
+    CHECK(store.append(reading("21-12345678", 200004), kBoundary));
+    CHECK(store.append(reading("21-12345678", 200006), kBoundary + 32));
+    store.flush();
+
+    std::vector<uint8_t> oldWeek = fileBytes(dir.path, "21-12345678", kSegment);
+    std::vector<uint8_t> newWeek = fileBytes(dir.path, "21-12345678", kSegment + 1);
+    CHECK(!oldWeek.empty() && oldWeek[0] == 0xE0);
+    CHECK(!newWeek.empty() && newWeek[0] == 0xE0);
+
+    // Consumption carries across the files
+    std::string json = query(store, "21-12345678", kBoundary - 3600, kBoundary + 3600, 3600);
+    CHECK(json == header("21-12345678", kBoundary - 3600, kBoundary + 3600, 3600) +
+                      "{\"t\":" + std::to_string(kBoundary - 3600) +
+                      ",\"count\":2,\"min\":200.000,\"max\":200.002,\"last\":200.002,\"consumption\":0.002,"
+                      "\"alarms\":0},{\"t\":" + std::to_string(kBoundary) +
+                      ",\"count\":2,\"min\":200.004,\"max\":200.006,\"last\":200.006,\"consumption\":0.004,"
+                      "\"alarms\":0}]}\n");
+}
+
+TEST_CASE(budgetEvictionReopensWithKeyframe) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 64));
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(store.append(reading("A1", 1000 + i), kStart + 32 * i));
+    }
+    store.flush();
+    CHECK(!fileBytes(dir.path, "A1", kSegment).empty());
+
+    // A newer week of another meter pushes the store over its budget: the oldest week goes
+    for (uint32_t i = 0; i < 4; i++) {
+        CHECK(store.append(reading("B2", 7000 + i), kBoundary + 32 * i));
+    }
+    store.flush();
+    CHECK(fileBytes(dir.path, "A1", kSegment).empty());
+    CHECK(store.getUsedBytes() == fileBytes(dir.path, "B2", kSegment + 1).size());
+
+    // A1 keeps appending to the same week, which must start over with a keyframe rather than a delta
+    CHECK(store.append(reading("A1", 1010), kStart + 96));
+    store.flush();
+    std::vector<uint8_t> bytes = fileBytes(dir.path, "A1", kSegment);
+    CHECK(!bytes.empty() && bytes[0] == 0xE0);
+    std::string json = query(store, "A1", kStart, kStart + 3600, 3600);
+    CHECK(json.find("\"count\":1,\"min\":1.010,\"max\":1.010,\"last\":1.010,\"consumption\":0.000") !=
+          std::string::npos);
+}
+
+TEST_CASE(evictionWaitsForReaders) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 64));
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(store.append(reading("A1", 1000 + i), kStart + 32 * i));
+    }
+    store.flush();
+
+    {
+        // A response still streaming A1's week: its file stays until the response is done
+        HistoryWriter writer(store, "A1", kStart, kStart + 3600, 3600);
+        uint8_t buffer[16];
+        CHECK(writer.read(buffer, sizeof(buffer)) == sizeof(buffer));
+        for (uint32_t i = 0; i < 4; i++) {
+            CHECK(store.append(reading("B2", 7000 + i), kBoundary + 32 * i));
+        }
+        store.flush();
+        CHECK(!fileBytes(dir.path, "A1", kSegment).empty());
+        std::string rest;
+        for (size_t length = writer.read(buffer, sizeof(buffer)); length > 0;
+             length = writer.read(buffer, sizeof(buffer))) {
+            rest.append(reinterpret_cast<const char*>(buffer), length);
+        }
+        CHECK(rest.find("\"count\":3") != std::string::npos);
+    }
+
+    for (uint32_t i = 4; i < 8; i++) {
+        CHECK(store.append(reading("B2", 7000 + i), kBoundary + 32 * i));
+    }
+    store.flush();
+    CHECK(fileBytes(dir.path, "A1", kSegment).empty());
+}
+
+TEST_CASE(tornTrailingToken) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(store.append(reading("21-12345678", 3000 + i), kBoundary - 3000 + 32 * i));
+    }
+    store.flush();
+    appendRaw(dir.path, "21-12345678", kSegment, {0xC1, 0x80}); // Power lost inside a varint
+    CHECK(store.append(reading("21-12345678", 3010), kBoundary + 100));
+    CHECK(store.append(reading("21-12345678", 3011), kBoundary + 132));
+    store.flush();
+
+    std::string json = query(store, "21-12345678", kBoundary - 3600, kBoundary + 3600, 3600);
+    CHECK(json == header("21-12345678", kBoundary - 3600, kBoundary + 3600, 3600) +
+                      "{\"t\":" + std::to_string(kBoundary - 3600) +
+                      ",\"count\":3,\"min\":3.000,\"max\":3.002,\"last\":3.002,\"consumption\":0.002,"
+                      "\"alarms\":0},{\"t\":" + std::to_string(kBoundary) +
+                      ",\"count\":2,\"min\":3.010,\"max\":3.011,\"last\":3.011,\"consumption\":0.009,"
+                      "\"alarms\":0}]}\n");
+
+    // An unknown token skips the rest of its file too
+    appendRaw(dir.path, "21-12345678", kSegment + 1, {0xF5, 0x01, 0x02});
+    json = query(store, "21-12345678", kBoundary, kBoundary + 3600, 3600);
+    CHECK(json.find("\"count\":2,") != std::string::npos);
+}
+
+TEST_CASE(failedAppendIsCutBackOff) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    for (uint32_t i = 0; i < 3; i++) {
+        CHECK(store.append(reading("21-12345678", 4000 + i), kStart + 32 * i));
+    }
+    store.flush();
+    size_t before = fileBytes(dir.path, "21-12345678", kSegment).size();
+
+    // Flash full two bytes into the next batch: the write comes up short
+    struct rlimit limit;
+    getrlimit(RLIMIT_FSIZE, &limit);
+    struct rlimit full = limit;
+    full.rlim_cur = before + 2;
+    signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &full);
+    CHECK(store.append(reading("21-12345678", 4100), kStart + 200));
+    CHECK(store.append(reading("21-12345678", 4200), kStart + 400));
+    store.flush();
+    setrlimit(RLIMIT_FSIZE, &limit);
+    CHECK(fileBytes(dir.path, "21-12345678", kSegment).size() == before);
+    CHECK(store.getUsedBytes() == before);
+
+    // Readings after the failure are still returned, the lost batch simply is not there
+    CHECK(store.append(reading("21-12345678", 4300), kStart + 600));
+    CHECK(store.append(reading("21-12345678", 4301), kStart + 632));
+    store.flush();
+    std::string json = query(store, "21-12345678", kStart, kStart + 3600, 3600);
+    CHECK(json.find("\"count\":5,\"min\":4.000,\"max\":4.301,\"last\":4.301,\"consumption\":0.301") !=
+          std::string::npos);
+}
+
+TEST_CASE(bucketAggregation) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    const uint32_t from = kStart;
+    CHECK(store.append(reading("21-12345678", 50000), from - 30)); // Before the range: consumption base only
+    CHECK(store.append(reading("21-12345678", 50004), from + 10));
+    CHECK(store.append(reading("21-12345678", 50003), from + 70)); // Counter went back: nothing consumed
+    CHECK(store.append(reading("21-12345678", 50009, true), from + 75));
+    CHECK(store.append(reading("21-12345678", 50020), from + 250)); // Bucket 120-180 stays out of the list
+    CHECK(store.append(reading("21-12345678", 50030), from + 300)); // At to: excluded
+    store.flush();
+
+    std::string expected = header("21-12345678", from, from + 300, HISTORY_MIN_STEP) + "{\"t\":" +
+                           std::to_string(from) +
+                           ",\"count\":1,\"min\":50.004,\"max\":50.004,\"last\":50.004,\"consumption\":0.004,"
+                           "\"alarms\":0},{\"t\":" + std::to_string(from + 60) +
+                           ",\"count\":2,\"min\":50.003,\"max\":50.009,\"last\":50.009,\"consumption\":0.006,"
+                           "\"alarms\":2},{\"t\":" + std::to_string(from + 240) +
+                           ",\"count\":1,\"min\":50.020,\"max\":50.020,\"last\":50.020,\"consumption\":0.011,"
+                           "\"alarms\":0}]}\n";
+    CHECK(query(store, "21-12345678", from, from + 300, HISTORY_MIN_STEP) == expected);
+    // Chunks smaller than a line give the same document
+    CHECK(query(store, "21-12345678", from, from + 300, HISTORY_MIN_STEP, 7) == expected);
+    CHECK(query(store, "21-12345678", from, from + 300, HISTORY_MIN_STEP, 1) == expected);
+
+    // Unknown meter: an empty list
+    CHECK(query(store, "99-00000000", from, from + 300, HISTORY_MIN_STEP) ==
+          header("99-00000000", from, from + 300, HISTORY_MIN_STEP) + "]}\n");
+}
+
+TEST_CASE(widestRangeVisitsOnlyExistingFiles) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    CHECK(store.append(reading("21-12345678", 9000), kStart));
+    CHECK(store.append(reading("21-12345678", 9001), kBoundary + 10 * kWeek));
+    CHECK(store.append(reading("99-00000000", 1), kStart));
+    store.flush();
+
+    // Largest range /api/history accepts: about 6,600 weeks, of which two have a file for this meter
+    const uint32_t step = 2000000;
+    std::string json = query(store, "21-12345678", 0, 4000000000u, step);
+    CHECK(bucketCount(json) == 2);
+    CHECK(json.find("\"t\":" + std::to_string(kStart / step * step) + ",\"count\":1,\"min\":9.000") !=
+          std::string::npos);
+    CHECK(json.find("\"count\":1,\"min\":9.001,\"max\":9.001,\"last\":9.001,\"consumption\":0.001") !=
+          std::string::npos);
+}
+
+TEST_CASE(interleavedMeters) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(store.begin(dir.path, 65536));
+    const char* meters[] = {"M1", "M2", "M3", "M4", "M5", "M6"}; // More than HISTORY_MAX_METERS
+    for (uint32_t round = 0; round < 4; round++) {
+        for (uint32_t m = 0; m < 6; m++) {
+            CHECK(store.append(reading(meters[m], 1000 * m + round), kStart + 32 * round + m));
+        }
+        store.flush();
+    }
+    for (uint32_t m = 0; m < 6; m++) {
+        std::string json = query(store, meters[m], kStart, kStart + 3600, 3600);
+        CHECK(bucketCount(json) == 1);
+        CHECK(json.find("\"count\":4,") != std::string::npos);
+    }
+}
+
+TEST_CASE(queueAndFlushTriggers) {
+    TempDir dir;
+    HistoryStore store;
+    CHECK(!store.append(reading("21-12345678", 1), kStart)); // Not begun
+    CHECK(store.begin(dir.path, 65536));
+    CHECK(!store.append(reading("21-12345678", 1), HISTORY_MIN_VALID_TIME - 1)); // Clock not set yet
+
+    for (uint32_t i = 0; i < HISTORY_FLUSH_READINGS - 1; i++) {
+        CHECK(store.append(reading("21-12345678", 1000 + i), kStart + 32 * i));
+    }
+    store.handle();
+    CHECK(store.getQueuedCount() == HISTORY_FLUSH_READINGS - 1);
+    CHECK(fileBytes(dir.path, "21-12345678", kSegment).empty());
+    CHECK(store.append(reading("21-12345678", 2000), kStart + 32 * HISTORY_FLUSH_READINGS));
+    store.handle();
+    CHECK(store.getQueuedCount() == 0);
+    CHECK(!fileBytes(dir.path, "21-12345678", kSegment).empty());
+
+    // The loop stalled: readings beyond the queue are dropped
+    for (uint32_t i = 0; i < HISTORY_QUEUE_SIZE; i++) {
+        CHECK(store.append(reading("21-12345678", 3000 + i), kStart + 3600 + 32 * i));
+    }
+    CHECK(!store.append(reading("21-12345678", 4000), kStart + 7200));
+    store.flush();
+    std::string json = query(store, "21-12345678", kStart, kStart + 7200, 3600);
+    CHECK(json.find("\"count\":" + std::to_string(HISTORY_QUEUE_SIZE) + ",") != std::string::npos);
+}
+
+TEST_MAIN()
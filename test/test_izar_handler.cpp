@@ -0,0 +1,48 @@
+// IZAR payload parsing: counters, H0 date, status bits and alarms
+
+#include "golden_frame.h"
+#include "izar_handler.h"
+#include "test_support.h"
+
+TEST_CASE(parseGoldenReading) {
+    IzarReading reading;
+    CHECK(IzarHandler::parseReading(kGoldenMeterId, kGoldenPlainTpl, kTplLength, -70, &reading));
+    CHECK(strcmp(reading.meterId, kGoldenMeterId) == 0);
+    CHECK(reading.current_reading == 12.345f);
+    CHECK(reading.h0_reading == 10.0f);
+    CHECK(reading.unit_type == VOLUME_CUBIC_METER);
+    CHECK(reading.h0_year == 2024 && reading.h0_month == 12 && reading.h0_day == 31);
+    CHECK(reading.radio_interval == 32);
+    CHECK(reading.remaining_battery_life == 6.0f);
+    CHECK(reading.rssi == -70);
+}
+
+TEST_CASE(parseAlarmBits) {
+    IzarReading reading;
+    CHECK(IzarHandler::parseReading(kGoldenMeterId, kGoldenPlainTpl, kTplLength, 0, &reading));
+    CHECK(reading.alarms.leakage_previously);
+    CHECK(!reading.alarms.leakage_currently);
+    CHECK(!reading.alarms.general_alarm);
+
+    uint8_t data[kTplLength];
+    memcpy(data, kGoldenPlainTpl, kTplLength);
+    data[IZAR_OFFSET_STATUS_1] |= 0x80;
+    data[IZAR_OFFSET_STATUS_2] |= 0x80;
+    CHECK(IzarHandler::parseReading(kGoldenMeterId, data, kTplLength, 0, &reading));
+    CHECK(reading.alarms.leakage_currently);
+    CHECK(reading.alarms.back_flow);
+}
+
+TEST_CASE(parseRejectsShortPayload) {
+    IzarReading reading;
+    CHECK(!IzarHandler::parseReading(kGoldenMeterId, kGoldenPlainTpl, IZAR_MIN_DATA_LENGTH - 1, 0, &reading));
+    CHECK(!IzarHandler::parseReading(kGoldenMeterId, nullptr, kTplLength, 0, &reading));
+}
+
+TEST_CASE(meterIdIsTruncatedSafely) {
+    IzarReading reading;
+    CHECK(IzarHandler::parseReading("ABCDEFGHIJKLMNOPQRSTUVWXYZ", kGoldenPlainTpl, kTplLength, 0, &reading));
+    CHECK(strlen(reading.meterId) == sizeof(reading.meterId) - 1);
+}
+
+TEST_MAIN()
@@ -0,0 +1,97 @@
+// Link quality diagnostics: the <base>/diagnostics message must fit the MQTT client buffer with every counter at
+// its widest, or PubSubClient drops it and only publishFailures goes up
+
+#include <string>
+#include "fsk_modem_manager.h"
+#include "golden_frame.h"
+#include "link_quality.h"
+#include "mqtt_manager.h"
+#include "test_support.h"
+
+FskModemManager fskModemManager;
+MqttManager mqttManager;
+
+namespace {
+
+constexpr size_t kMqttMaxHeaderSize = 5;                           // PubSubClient MQTT_MAX_HEADER_SIZE
+constexpr size_t kMaxTopicLength = 64 + sizeof("/diagnostics") - 1; // mqttBaseTopic[65] plus the suffix
+
+struct FieldWidth {
+    const char* key;
+    size_t width;
+};
+
+// Widest text of each numeric field: uint32 counters, 32-bit millis() in seconds, int16 RSSI, PER to 4 places
+const FieldWidth kWidths[] = {
+    {"received", 10},   {"missed", 10},       {"invalid_length", 10}, {"l_field_3of6", 10}, {"body_3of6", 10},
+    {"too_short", 10},  {"dll_crc", 10},      {"tpl_crc", 10},        {"decrypt", 10},      {"prios_marker", 10},
+    {"izar_parse", 10}, {"insufficient_data", 10}, {"measured_s", 7}, {"last_seen_s", 7},   {"meters", 2},
+    {"rank", 2},        {"interval_s", 5},    {"per", 6},             {"rssi", 6},          {"mean_rssi", 8}};
+
+// Length of json with every known numeric field padded to its widest text
+size_t worstCaseLength(const std::string& json, size_t& fields) {
+    size_t length = json.size();
+    fields = 0;
+    for (size_t at = json.find("\":"); at != std::string::npos; at = json.find("\":", at + 2)) {
+        size_t keyStart = json.rfind('"', at - 1) + 1;
+        std::string key = json.substr(keyStart, at - keyStart);
+        if (json[at + 2] == '{' || json[at + 2] == '[' || json[at + 2] == '"') {
+            continue; // Objects, arrays and strings
+        }
+        size_t valueEnd = json.find_first_of(",}", at + 2);
+        size_t valueLength = valueEnd - (at + 2);
+        for (const FieldWidth& field : kWidths) {
+            if (key == field.key) {
+                length += valueLength < field.width ? field.width - valueLength : 0;
+                fields++;
+            }
+        }
+    }
+    return length;
+}
+
+size_t countOf(const std::string& json, const char* needle) {
+    size_t count = 0;
+    for (size_t at = json.find(needle); at != std::string::npos; at = json.find(needle, at + 1)) {
+        count++;
+    }
+    return count;
+}
+
+// Every slot taken by a meter with the longest ID, all decrypting to a known radio_interval
+void fillMeters() {
+    for (int i = 0; i < LINK_QUALITY_MAX_METERS; i++) {
+        char meterId[16];
+        snprintf(meterId, sizeof(meterId), "O05FS6494%06d", i);
+        linkQuality.recordFrame(meterId, kGoldenDecoded, sizeof(kGoldenDecoded), kGoldenDecoded + kTplOffset,
+                                kTplLength, -128);
+    }
+}
+
+} // namespace
+
+TEST_CASE(diagnosticsFitMqttPacket) {
+    fillMeters();
+    std::string json = linkQuality.getJSON(LINK_QUALITY_MQTT_METERS).c_str();
+    CHECK(countOf(json, "\"rank\":") == LINK_QUALITY_MQTT_METERS);
+
+    size_t fields;
+    size_t payload = worstCaseLength(json, fields);
+    CHECK(fields == 17 + 8 * LINK_QUALITY_MQTT_METERS); // Every numeric field was widened
+    printf("worst case %zu bytes for %d meters, limit %zu\n", payload, LINK_QUALITY_MQTT_METERS,
+           MQTT_MAX_PACKET_SIZE - kMqttMaxHeaderSize - 2 - kMaxTopicLength);
+    CHECK(kMqttMaxHeaderSize + 2 + kMaxTopicLength + payload <= MQTT_MAX_PACKET_SIZE);
+
+    // The cap is no lower than it has to be
+    std::string more = linkQuality.getJSON(LINK_QUALITY_MQTT_METERS + 1).c_str();
+    CHECK(kMqttMaxHeaderSize + 2 + kMaxTopicLength + worstCaseLength(more, fields) > MQTT_MAX_PACKET_SIZE);
+}
+
+TEST_CASE(webDiagnosticsListEveryMeter) {
+    fillMeters();
+    std::string json = linkQuality.getJSON(LINK_QUALITY_MAX_METERS).c_str();
+    CHECK(countOf(json, "\"rank\":") == LINK_QUALITY_MAX_METERS);
+    CHECK(countOf(json, "\"interval_s\":32,") == LINK_QUALITY_MAX_METERS);
+}
+
+TEST_MAIN()
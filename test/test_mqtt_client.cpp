@@ -0,0 +1,232 @@
+// Host MQTT client against a loopback broker stand-in: CONNECT fields, CONNACK handling, PUBLISH framing with the
+// retain flag and DISCONNECT
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mqtt_client.h"
+#include "test_support.h"
+
+namespace {
+
+struct Packet {
+    uint8_t header = 0;
+    std::vector<uint8_t> body;
+};
+
+// Accepts one connection on an ephemeral loopback port, answers CONNECT with returnCode and records every packet
+// until the client disconnects or closes the socket
+class StubBroker {
+  public:
+    explicit StubBroker(uint8_t returnCode) : returnCode(returnCode) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+        socklen_t length = sizeof(address);
+        getsockname(listenFd, reinterpret_cast<sockaddr*>(&address), &length);
+        port = ntohs(address.sin_port);
+        listen(listenFd, 1);
+        thread = std::thread([this] { serve(); });
+    }
+
+    ~StubBroker() { join(); }
+
+    void join() {
+        if (thread.joinable()) {
+            thread.join();
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            listenFd = -1;
+        }
+    }
+
+    uint16_t port = 0;
+    std::vector<Packet> packets;
+
+  private:
+    uint8_t returnCode;
+    int listenFd = -1;
+    std::thread thread;
+
+    static bool readExact(int fd, uint8_t* out, size_t length) {
+        while (length > 0) {
+            ssize_t received = recv(fd, out, length, 0);
+            if (received <= 0) {
+                return false;
+            }
+            out += received;
+            length -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+    static bool readPacket(int fd, Packet& packet) {
+        if (!readExact(fd, &packet.header, 1)) {
+            return false;
+        }
+        size_t remaining = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t encoded;
+            if (shift > 21 || !readExact(fd, &encoded, 1)) {
+                return false;
+            }
+            remaining |= static_cast<size_t>(encoded & 0x7F) << shift;
+            if ((encoded & 0x80) == 0) {
+                break;
+            }
+        }
+        packet.body.resize(remaining);
+        return remaining == 0 || readExact(fd, packet.body.data(), remaining);
+    }
+
+    void serve() {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        Packet packet;
+        while (readPacket(fd, packet)) {
+            packets.push_back(packet);
+            if (packet.header == 0x10) {
+                const uint8_t connack[] = {0x20, 0x02, 0x00, returnCode};
+                send(fd, connack, sizeof(connack), MSG_NOSIGNAL);
+            }
+            if (packet.header == 0xE0) {
+                break;
+            }
+        }
+        close(fd);
+    }
+};
+
+// Length-prefixed MQTT string at offset, advancing it
+std::string readString(const std::vector<uint8_t>& body, size_t& offset) {
+    if (offset + 2 > body.size()) {
+        return "";
+    }
+    size_t length = (body[offset] << 8) | body[offset + 1];
+    offset += 2;
+    if (offset + length > body.size()) {
+        return "";
+    }
+    std::string text(body.begin() + offset, body.begin() + offset + length);
+    offset += length;
+    return text;
+}
+
+MqttClientOptions optionsFor(uint16_t port) {
+    MqttClientOptions options;
+    options.host = "127.0.0.1";
+    options.port = port;
+    options.clientId = "izar-test";
+    options.username = "user";
+    options.password = "secret";
+    options.willTopic = "izar/status";
+    options.willMessage = "offline";
+    options.keepAliveSeconds = 45;
+    return options;
+}
+
+} // namespace
+
+TEST_CASE(connectSendsCredentialsAndRetainedWill) {
+    StubBroker broker(0);
+    MqttClient client;
+    CHECK(client.connect(optionsFor(broker.port)));
+    CHECK(client.isConnected());
+    client.disconnect();
+    broker.join();
+
+    CHECK(broker.packets.size() == 2);
+    if (broker.packets.size() != 2) {
+        return;
+    }
+    const std::vector<uint8_t>& body = broker.packets[0].body;
+    size_t offset = 0;
+    CHECK(broker.packets[0].header == 0x10);
+    CHECK(readString(body, offset) == "MQTT");
+    CHECK(body.size() > offset + 3);
+    CHECK(body[offset] == 4); // Protocol level 3.1.1
+    // Username, password, will retain, will QoS 1, will flag, clean session
+    CHECK(body[offset + 1] == (0x80 | 0x40 | 0x20 | 0x08 | 0x04 | 0x02));
+    CHECK(((body[offset + 2] << 8) | body[offset + 3]) == 45);
+    offset += 4;
+    CHECK(readString(body, offset) == "izar-test");
+    CHECK(readString(body, offset) == "izar/status");
+    CHECK(readString(body, offset) == "offline");
+    CHECK(readString(body, offset) == "user");
+    CHECK(readString(body, offset) == "secret");
+    CHECK(offset == body.size());
+
+    CHECK(broker.packets[1].header == 0xE0);
+    CHECK(broker.packets[1].body.empty());
+}
+
+TEST_CASE(refusedConnectionIsClosed) {
+    StubBroker broker(5); // Not authorised
+    MqttClient client;
+    CHECK(!client.connect(optionsFor(broker.port)));
+    CHECK(!client.isConnected());
+    CHECK(!client.publish("izar/reading", "{}"));
+    broker.join();
+    CHECK(broker.packets.size() == 1);
+}
+
+TEST_CASE(publishFramesTopicPayloadAndRetainFlag) {
+    StubBroker broker(0);
+    MqttClient client;
+    CHECK(client.connect(optionsFor(broker.port)));
+    CHECK(client.publish("izar/reading", "{\"v\":1}"));
+    CHECK(client.publish("izar/status", "online", true));
+
+    // Over 127 bytes of body, the remaining length takes two bytes
+    std::vector<uint8_t> large(300);
+    for (size_t i = 0; i < large.size(); i++) {
+        large[i] = static_cast<uint8_t>(i);
+    }
+    CHECK(client.publish("izar/raw", large.data(), large.size()));
+    client.disconnect();
+    broker.join();
+
+    CHECK(broker.packets.size() == 5);
+    if (broker.packets.size() != 5) {
+        return;
+    }
+    size_t offset = 0;
+    CHECK(broker.packets[1].header == 0x30);
+    CHECK(readString(broker.packets[1].body, offset) == "izar/reading");
+    CHECK(std::string(broker.packets[1].body.begin() + offset, broker.packets[1].body.end()) == "{\"v\":1}");
+
+    offset = 0;
+    CHECK(broker.packets[2].header == 0x31);
+    CHECK(readString(broker.packets[2].body, offset) == "izar/status");
+    CHECK(std::string(broker.packets[2].body.begin() + offset, broker.packets[2].body.end()) == "online");
+
+    offset = 0;
+    CHECK(broker.packets[3].header == 0x30);
+    CHECK(readString(broker.packets[3].body, offset) == "izar/raw");
+    CHECK(std::vector<uint8_t>(broker.packets[3].body.begin() + offset, broker.packets[3].body.end()) == large);
+}
+
+TEST_CASE(unreachableBrokerFails) {
+    StubBroker broker(0);
+    uint16_t port = broker.port;
+    {
+        // Take the only connection the stub accepts, then close it so the port is free
+        MqttClient first;
+        CHECK(first.connect(optionsFor(port)));
+    }
+    broker.join();
+    MqttClient client;
+    CHECK(!client.connect(optionsFor(port)));
+    CHECK(!client.isConnected());
+}
+
+TEST_MAIN()
@@ -0,0 +1,60 @@
+// PRIOS decryption: LFSR keystream seeded from the frame, validated by the 0x4B marker
+
+#include "golden_frame.h"
+#include "prios_handler.h"
+#include "test_support.h"
+
+TEST_CASE(decryptGoldenPayload) {
+    uint8_t tpl[kTplLength];
+    memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+    CHECK(PriosHandler::decryptPayload(kGoldenDecoded, sizeof(kGoldenDecoded), tpl, kTplLength));
+    CHECK(memcmp(tpl, kGoldenPlainTpl, kTplLength) == 0);
+}
+
+TEST_CASE(keystreamIsItsOwnInverse) {
+    const uint8_t key[PRIOS_KEY_SIZE] = PRIOS_DEFAULT_KEY;
+    uint8_t data[kTplLength - PRIOS_OFFSET_ENCRYPTED_DATA];
+    memcpy(data, kGoldenPlainTpl + PRIOS_OFFSET_ENCRYPTED_DATA, sizeof(data));
+    PriosHandler::applyKeystream(key, data, sizeof(data), kGoldenDecoded);
+    CHECK(memcmp(data, kGoldenDecoded + kTplOffset + PRIOS_OFFSET_ENCRYPTED_DATA, sizeof(data)) == 0);
+    PriosHandler::applyKeystream(key, data, sizeof(data), kGoldenDecoded);
+    CHECK(memcmp(data, kGoldenPlainTpl + PRIOS_OFFSET_ENCRYPTED_DATA, sizeof(data)) == 0);
+}
+
+TEST_CASE(decryptRejectsWrongFrameSeed) {
+    // The keystream depends on the M/A fields, another meter's header does not yield the marker byte
+    uint8_t frame[sizeof(kGoldenDecoded)];
+    memcpy(frame, kGoldenDecoded, sizeof(frame));
+    frame[WM_BUS_OFFSET_A_FIELD] ^= 0x01;
+    uint8_t tpl[kTplLength];
+    memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+    CHECK(!PriosHandler::decryptPayload(frame, sizeof(frame), tpl, kTplLength));
+}
+
+TEST_CASE(decryptRejectsShortInput) {
+    uint8_t tpl[kTplLength];
+    memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+    CHECK(!PriosHandler::decryptPayload(kGoldenDecoded, PRIOS_MIN_FRAME_LENGTH - 1, tpl, kTplLength));
+    CHECK(!PriosHandler::decryptPayload(kGoldenDecoded, sizeof(kGoldenDecoded), tpl, PRIOS_OFFSET_ENCRYPTED_DATA - 1));
+    CHECK(!PriosHandler::decryptPayload(nullptr, sizeof(kGoldenDecoded), tpl, kTplLength));
+}
+
+TEST_CASE(processPayloadCountsRejectionsByStage) {
+    PriosHandler handler;
+    uint8_t frame[sizeof(kGoldenDecoded)];
+    memcpy(frame, kGoldenDecoded, sizeof(frame));
+    frame[WM_BUS_OFFSET_A_FIELD] ^= 0x01;
+    uint8_t tpl[kTplLength];
+    memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+    CHECK(!handler.processPayload("test", frame, sizeof(frame), tpl, kTplLength, -70));
+    CHECK(handler.getMarkerFailures() == 1);
+    CHECK(handler.getDecryptFailures() == 0);
+
+    memcpy(tpl, kGoldenDecoded + kTplOffset, kTplLength);
+    CHECK(!handler.processPayload("test", kGoldenDecoded, sizeof(kGoldenDecoded), tpl, PRIOS_OFFSET_ENCRYPTED_DATA - 1,
+                                  -70));
+    CHECK(handler.getMarkerFailures() == 1);
+    CHECK(handler.getDecryptFailures() == 1);
+}
+
+TEST_MAIN()
@@ -0,0 +1,93 @@
+// Raw telegram forwarding: exact rtl_wmbus hex lines (what wmbusmeters' rtlwmbus input parses) and binary records
+
+#include <string>
+#include <vector>
+#include "config_manager.h"
+#include "mqtt_manager.h"
+#include "raw_frame_forwarder.h"
+#include "test_support.h"
+
+ConfigManager configManager;
+MqttManager mqttManager;
+
+namespace {
+
+// DLL header of a Diehl meter 12345678 (CRCs stripped) and three TPL bytes
+const uint8_t kFrame[] = {0x13, 0x44, 0xA5, 0x11, 0x78, 0x56, 0x34, 0x12, 0x18, 0x07, 0xA1, 0x01, 0x02, 0x03};
+
+std::vector<std::string> splitLines(const std::string& payload) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    for (size_t end = payload.find('\n'); end != std::string::npos; end = payload.find('\n', start)) {
+        lines.push_back(payload.substr(start, end - start));
+        start = end + 1;
+    }
+    CHECK(start == payload.size()); // Every record is newline-terminated
+    return lines;
+}
+
+// Telegrams queued until the first batch goes out; its payload
+std::string firstBatch(RawForwardMode mode, RawFrameVerdict verdict) {
+    configManager.getConfig().rawForwardMode = static_cast<uint8_t>(mode);
+    mqttManager.connected = true;
+    mqttManager.publishCount = 0;
+    RawFrameForwarder forwarder;
+    for (int i = 0; i < RAW_FORWARD_MAX_BATCH_FRAMES && mqttManager.publishCount == 0; i++) {
+        forwarder.enqueue(kFrame, sizeof(kFrame), -71, 123456, verdict);
+    }
+    CHECK(mqttManager.publishCount == 1);
+    CHECK(mqttManager.lastTopic == "izar/raw");
+    return mqttManager.lastPayload;
+}
+
+} // namespace
+
+TEST_CASE(hexLineIsRtlWmbus) {
+    std::vector<std::string> lines = splitLines(firstBatch(RawForwardMode::HEX, RawFrameVerdict::DECODED));
+    CHECK(!lines.empty());
+    for (const std::string& line : lines) {
+        CHECK(line == "T1;1;1;123456;-71;-71;12345678;0x1344a511785634121807a1010203");
+    }
+}
+
+TEST_CASE(hexTelegramIsLastField) {
+    // wmbusmeters hex-decodes everything after "0x": no verdict or other field may follow
+    const RawFrameVerdict verdicts[] = {RawFrameVerdict::SKIPPED, RawFrameVerdict::DECODED,
+                                        RawFrameVerdict::DECODE_FAILED, RawFrameVerdict::TPL_UNCHECKED};
+    for (RawFrameVerdict verdict : verdicts) {
+        for (const std::string& line : splitLines(firstBatch(RawForwardMode::HEX, verdict))) {
+            size_t hex = line.find(";0x");
+            CHECK(hex != std::string::npos);
+            CHECK(line.find_first_not_of("0123456789abcdef", hex + 3) == std::string::npos);
+            CHECK(line.size() - hex - 3 == 2 * sizeof(kFrame));
+        }
+    }
+}
+
+TEST_CASE(uncheckedTelegramClearsCrcOk) {
+    std::vector<std::string> lines = splitLines(firstBatch(RawForwardMode::HEX, RawFrameVerdict::TPL_UNCHECKED));
+    CHECK(!lines.empty() && lines[0] == "T1;0;1;123456;-71;-71;12345678;0x1344a511785634121807a1010203");
+}
+
+TEST_CASE(binaryRecordCarriesVerdict) {
+    std::string payload = firstBatch(RawForwardMode::BINARY, RawFrameVerdict::DECODE_FAILED);
+    const size_t recordSize = RAW_FORWARD_BINARY_HEADER_SIZE + sizeof(kFrame);
+    CHECK(payload.size() % recordSize == 0);
+    const uint8_t header[RAW_FORWARD_BINARY_HEADER_SIZE] = {sizeof(kFrame), RAW_FORWARD_MODE_T1, 2,    0xB9, 0xFF,
+                                                             0x40,          0xE2,                0x01, 0x00};
+    CHECK(memcmp(payload.data(), header, sizeof(header)) == 0);
+    CHECK(memcmp(payload.data() + sizeof(header), kFrame, sizeof(kFrame)) == 0);
+}
+
+TEST_CASE(droppedWhileDisconnected) {
+    configManager.getConfig().rawForwardMode = static_cast<uint8_t>(RawForwardMode::HEX);
+    mqttManager.connected = false;
+    mqttManager.publishCount = 0;
+    RawFrameForwarder forwarder;
+    forwarder.enqueue(kFrame, sizeof(kFrame), -71, 123456, RawFrameVerdict::DECODED);
+    forwarder.enqueue(kFrame, sizeof(kFrame), -71, 123456, RawFrameVerdict::DECODED);
+    CHECK(forwarder.getDroppedCount() == 2);
+    CHECK(mqttManager.publishCount == 0);
+}
+
+TEST_MAIN()
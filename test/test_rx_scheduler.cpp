@@ -0,0 +1,140 @@
+// Bound-meter RX schedule on a virtual clock: locking, missed frames, window fallback, guard growth, relearning
+
+#include "rx_scheduler.h"
+#include "test_support.h"
+
+namespace {
+
+constexpr uint32_t kInterval = 32000; // radio_interval of 32 s in ms
+
+// Frames exactly on schedule from startMs; returns the time of the last one
+uint32_t feedOnTime(RxScheduler& scheduler, uint32_t startMs, int frames) {
+    uint32_t at = startMs;
+    for (int i = 0; i < frames; i++) {
+        at = startMs + i * kInterval;
+        scheduler.recordFrame(at);
+    }
+    return at;
+}
+
+} // namespace
+
+TEST_CASE(continuousUntilLocked) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    CHECK(scheduler.update(0) == RxMode::CONTINUOUS);
+    // The first frame sets the phase, each further one on time counts towards the lock
+    feedOnTime(scheduler, 1000, RX_SCHEDULE_LOCK_FRAMES);
+    CHECK(!scheduler.isLocked());
+    CHECK(scheduler.update(1000 + (RX_SCHEDULE_LOCK_FRAMES - 1) * kInterval + 5000) == RxMode::CONTINUOUS);
+    scheduler.recordFrame(1000 + RX_SCHEDULE_LOCK_FRAMES * kInterval);
+    CHECK(scheduler.isLocked());
+}
+
+TEST_CASE(sleepsBetweenWindows) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    uint32_t last = feedOnTime(scheduler, 0, RX_SCHEDULE_LOCK_FRAMES + 1);
+    uint32_t guard = scheduler.getGuardMs();
+    CHECK(guard == RX_SCHEDULE_MIN_GUARD_MS);
+    CHECK(scheduler.update(last + 1000) == RxMode::SLEEP);
+    CHECK(scheduler.update(last + kInterval - guard - 1) == RxMode::SLEEP);
+    CHECK(scheduler.update(last + kInterval - guard) == RxMode::WINDOW);
+    CHECK(scheduler.update(last + kInterval + guard) == RxMode::WINDOW);
+    CHECK(scheduler.getMissedWindows() == 0);
+}
+
+TEST_CASE(missedFramesScaleTheExpectedGap) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    scheduler.recordFrame(0);
+    scheduler.recordFrame(kInterval);
+    scheduler.recordFrame(3 * kInterval + 200); // One frame lost, then 200 ms late
+    scheduler.recordFrame(6 * kInterval);       // Two lost
+    CHECK(scheduler.isLocked());
+}
+
+TEST_CASE(repeatInSameSlotKeepsPhase) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    uint32_t last = feedOnTime(scheduler, 0, RX_SCHEDULE_LOCK_FRAMES + 1);
+    scheduler.recordFrame(last + 50); // Repeated telegram
+    CHECK(scheduler.isLocked());
+    CHECK(scheduler.update(last + kInterval - scheduler.getGuardMs()) == RxMode::WINDOW);
+}
+
+TEST_CASE(missedWindowFallsBackToContinuous) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    uint32_t last = feedOnTime(scheduler, 0, RX_SCHEDULE_LOCK_FRAMES + 1);
+    uint32_t guard = scheduler.getGuardMs();
+    CHECK(scheduler.update(last + kInterval + guard + 1) == RxMode::CONTINUOUS);
+    CHECK(scheduler.getMissedWindows() == 1);
+    CHECK(!scheduler.isLocked());
+    CHECK(scheduler.update(last + kInterval + guard + 1000) == RxMode::CONTINUOUS);
+    CHECK(scheduler.getMissedWindows() == 1); // Counted once, the lock is gone
+
+    // Back on schedule: locks again after enough frames on time
+    feedOnTime(scheduler, last + 2 * kInterval, RX_SCHEDULE_LOCK_FRAMES);
+    CHECK(scheduler.isLocked());
+}
+
+TEST_CASE(guardGrowsWithJitterAndDecays) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    scheduler.recordFrame(0);
+    scheduler.recordFrame(kInterval + 400); // 400 ms late: guard = 3 x 400
+    CHECK(scheduler.getGuardMs() == 400 * RX_SCHEDULE_JITTER_FACTOR);
+    scheduler.recordFrame(2 * kInterval + 400); // On time again, the jitter decays by 1/8
+    CHECK(scheduler.getGuardMs() == (400 - 400 / 8) * RX_SCHEDULE_JITTER_FACTOR);
+
+    // A deviation beyond the grown guard breaks the lock count
+    RxScheduler jumpy;
+    jumpy.setInterval(kInterval);
+    feedOnTime(jumpy, 0, RX_SCHEDULE_LOCK_FRAMES + 1);
+    jumpy.recordFrame((RX_SCHEDULE_LOCK_FRAMES + 1) * kInterval + 5000);
+    CHECK(!jumpy.isLocked());
+    CHECK(jumpy.getGuardMs() == 5000 * RX_SCHEDULE_JITTER_FACTOR);
+}
+
+TEST_CASE(newIntervalRelearnsThePhase) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    uint32_t last = feedOnTime(scheduler, 0, RX_SCHEDULE_LOCK_FRAMES + 1);
+    scheduler.setInterval(kInterval); // Same interval: keeps the lock
+    CHECK(scheduler.isLocked());
+    scheduler.setInterval(kInterval / 2);
+    CHECK(!scheduler.isLocked());
+    CHECK(scheduler.update(last + 1000) == RxMode::CONTINUOUS);
+}
+
+TEST_CASE(shortIntervalNeverSleeps) {
+    RxScheduler scheduler;
+    const uint32_t interval = 2 * RX_SCHEDULE_MIN_GUARD_MS + RX_SCHEDULE_MIN_SLEEP_MS - 100;
+    scheduler.setInterval(interval);
+    for (int i = 0; i <= RX_SCHEDULE_LOCK_FRAMES; i++) {
+        scheduler.recordFrame(i * interval);
+    }
+    CHECK(scheduler.isLocked());
+    CHECK(scheduler.update(RX_SCHEDULE_LOCK_FRAMES * interval + interval / 2) == RxMode::CONTINUOUS);
+}
+
+TEST_CASE(resetForgetsTheSchedule) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    uint32_t last = feedOnTime(scheduler, 0, RX_SCHEDULE_LOCK_FRAMES + 1);
+    scheduler.reset();
+    CHECK(!scheduler.isLocked());
+    CHECK(scheduler.update(last + 1000) == RxMode::CONTINUOUS);
+}
+
+TEST_CASE(millisWrapAround) {
+    RxScheduler scheduler;
+    scheduler.setInterval(kInterval);
+    uint32_t start = UINT32_MAX - 2 * kInterval;
+    uint32_t last = feedOnTime(scheduler, start, RX_SCHEDULE_LOCK_FRAMES + 1); // Wraps past zero
+    CHECK(scheduler.isLocked());
+    CHECK(scheduler.update(last + 1000) == RxMode::SLEEP);
+}
+
+TEST_MAIN()
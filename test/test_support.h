@@ -0,0 +1,59 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <stdio.h>
+#include <vector>
+
+// Minimal host unit test support: TEST_CASE registers a function, CHECK records a failure and carries on, and
+// TEST_MAIN runs every case and exits non-zero if any check failed, which is what ctest looks at.
+struct TestCase {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<TestCase>& testCases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar {
+    TestRegistrar(const char* name, void (*run)()) { testCases().push_back({name, run}); }
+};
+
+#define TEST_CASE(name)                                                                                            \
+    static void name();                                                                                            \
+    static TestRegistrar name##Registrar(#name, name);                                                             \
+    static void name()
+
+#define CHECK(condition)                                                                                           \
+    do {                                                                                                           \
+        if (!(condition)) {                                                                                        \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);                        \
+            testFailures()++;                                                                                      \
+        }                                                                                                          \
+    } while (0)
+
+inline int runTests() {
+    int failedCases = 0;
+    for (const TestCase& test : testCases()) {
+        int before = testFailures();
+        test.run();
+        bool ok = testFailures() == before;
+        printf("[%s] %s\n", ok ? " OK " : "FAIL", test.name);
+        failedCases += ok ? 0 : 1;
+    }
+    printf("%zu cases, %d failed\n", testCases().size(), failedCases);
+    return failedCases == 0 ? 0 : 1;
+}
+
+#define TEST_MAIN()                                                                                                \
+    int main() {                                                                                                   \
+        return runTests();                                                                                         \
+    }
+
+#endif // TEST_SUPPORT_H
@@ -0,0 +1,77 @@
+// wM-Bus T1 link layer: 3-out-of-6 decoding, CRC-16/EN-13757, DLL header parsing and whole-frame decoding
+
+#include "golden_frame.h"
+#include "test_support.h"
+#include "wm_bus_handler.h"
+
+TEST_CASE(crcMatchesCatalogueCheckValue) {
+    CHECK(WmBusHandler::calculateCRC16(kCrcCheckInput, sizeof(kCrcCheckInput)) == kCrcCheckValue);
+}
+
+TEST_CASE(crcOfGoldenBlocks) {
+    CHECK(WmBusHandler::calculateCRC16(kGoldenDecoded, WM_BUS_HEADER_SIZE) == 0xC75E);
+    CHECK(WmBusHandler::calculateCRC16(kGoldenDecoded + kTplOffset, kTplLength) == 0xB7C2);
+}
+
+TEST_CASE(decode3outof6GoldenFrame) {
+    uint8_t decoded[WM_BUS_MAX_PAYLOAD];
+    uint8_t decodedLen = 0;
+    CHECK(WmBusHandler::decode3outof6(kGoldenRaw, sizeof(kGoldenRaw), decoded, &decodedLen));
+    CHECK(decodedLen == sizeof(kGoldenDecoded));
+    CHECK(memcmp(decoded, kGoldenDecoded, sizeof(kGoldenDecoded)) == 0);
+}
+
+TEST_CASE(decode3outof6RejectsInvalidCodeWord) {
+    const uint8_t invalidCode[] = {0x36, 0x00};
+    uint8_t decoded[4];
+    uint8_t decodedLen = 0;
+    CHECK(!WmBusHandler::decode3outof6(invalidCode, sizeof(invalidCode), decoded, &decodedLen));
+}
+
+TEST_CASE(parseHeaderOfGoldenFrame) {
+    WmBusDataLinkLayerHeader header;
+    CHECK(WmBusHandler::parseDataLinkLayerHeader(kGoldenDecoded, sizeof(kGoldenDecoded), &header));
+    CHECK(strcmp(header.meterId, kGoldenMeterId) == 0);
+    CHECK(strcmp(header.manufacturer, "SAP") == 0);
+    CHECK(header.lField == 0x19);
+    CHECK(header.cField == 0x44);
+    CHECK(header.crcHeader == 0xC75E);
+}
+
+TEST_CASE(parseHeaderRejectsBadCrcAndShortInput) {
+    uint8_t frame[sizeof(kGoldenDecoded)];
+    memcpy(frame, kGoldenDecoded, sizeof(frame));
+    frame[5] ^= 0x10;
+    WmBusDataLinkLayerHeader header;
+    CHECK(!WmBusHandler::parseDataLinkLayerHeader(frame, sizeof(frame), &header));
+    CHECK(!WmBusHandler::parseDataLinkLayerHeader(kGoldenDecoded, WM_BUS_HEADER_SIZE, &header));
+}
+
+TEST_CASE(decodeFrameGolden) {
+    uint8_t raw[FSK_MODEM_RX_MAX_LENGTH] = {0};
+    memcpy(raw, kGoldenRaw, sizeof(kGoldenRaw));
+    WmBusFrame frame;
+    CHECK(WmBusHandler::decodeFrame(raw, sizeof(raw), &frame) == WmBusDecodeStatus::OK);
+    CHECK(frame.length == sizeof(kGoldenDecoded));
+    CHECK(frame.tplDataLen == kTplLength);
+    CHECK(memcmp(frame.tplData(), kGoldenDecoded + kTplOffset, kTplLength) == 0);
+}
+
+TEST_CASE(decodeFrameReportsEachRejection) {
+    uint8_t raw[FSK_MODEM_RX_MAX_LENGTH] = {0};
+    memcpy(raw, kGoldenRaw, sizeof(kGoldenRaw));
+    WmBusFrame frame;
+    CHECK(WmBusHandler::decodeFrame(raw, 0, &frame) == WmBusDecodeStatus::INVALID_LENGTH);
+    CHECK(WmBusHandler::decodeFrame(raw, sizeof(kGoldenRaw) - 2, &frame) == WmBusDecodeStatus::INSUFFICIENT_DATA);
+
+    uint8_t broken[FSK_MODEM_RX_MAX_LENGTH];
+    memcpy(broken, raw, sizeof(raw));
+    broken[0] = 0x00;
+    CHECK(WmBusHandler::decodeFrame(broken, sizeof(broken), &frame) == WmBusDecodeStatus::L_FIELD_DECODE_FAILED);
+
+    memcpy(broken, raw, sizeof(raw));
+    broken[20] ^= 0x01;
+    CHECK(WmBusHandler::decodeFrame(broken, sizeof(broken), &frame) != WmBusDecodeStatus::OK);
+}
+
+TEST_MAIN()